@@ -51,6 +51,7 @@
  **/
 
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 #include <math.h>
 #include "core.h"
@@ -59,6 +60,12 @@
 #include "eeprom_spi.h"
 #include "utilities.h"
 #include "sensors.h"
+#include "psychro.h"
+#include "recpack.h"
+#include "recagg.h"
+#include "recdelta.h"
+#include "crc16.h"
+#include "telemetry.h"
 
 #ifdef ON_QT_PLATFORM
 struct STIM1 stim;
@@ -93,18 +100,22 @@ static volatile uint32 sec_ctr = 0;
 //                      - memory size = 3 sections * 3 sets * 110 points * 2bytes = 1800bytes -> 0x708 
 //                      we will use 4bit aligned ending (16 byte packs): 0x710
 //          - OFFS_FLIP1:
-//          - OFFS_FLIP2:   - 256 bytes of flip buffers. One is read from NVram, the other is processed to fill the RAWDISP
+//          - OFFS_FLIP2:   - 512 bytes of flip buffers. One is read from NVram, the other is processed to fill the RAWDISP
+//          - OFFS_CACHE:   - graph views displayed lately, in the space left before RAWDISP and in the RAWDISP sections of
+//                            the parameters not in the task - see local_recording_cache_request()
 // 
 // 2. For Serial data transfer:
 //          - OFFS_FLIP1:
-//          - OFFS_FLIP2:   - 256 bytes of flip buffers. One is read from NVram, the other is transmitted on UART
+//          - OFFS_FLIP2:   - 512 bytes of flip buffers. One is read from NVram, the other is transmitted on UART
 
 
 #define WB_FLIPB_SIZE       0x200
 
 #define WB_OFFS_FLIP1       0x000                               // 512 bytes transfer buffer F1
 #define WB_OFFS_FLIP2       WB_FLIPB_SIZE                       // 512 bytes transfer buffer F2
-#define WB_OFFS_RAWDISP     (WB_OFFS_FLIP2 + WB_FLIPB_SIZE)     // from 0x200 -> 0x910  - 710 bytes display graph memory: 110 samples * 2 bps * 3 (low/high/avg) * 3 params (T/RH/P)
+#define WB_OFFS_CACHE       (WB_OFFS_FLIP2 + WB_FLIPB_SIZE)     // graph view cache area - what the flip buffers leave free before the graph memory
+#define WB_OFFS_RAWDISP     0x400                               // from 0x400 -> 0xBBC - display graph memory: 110 samples * 2 bps * 3 (low/high/avg) * 3 params (T/RH/P)
+#define WB_CACHE_SIZE       (WB_OFFS_RAWDISP - WB_OFFS_CACHE)   // 0 with 512 byte flip buffers - the views are kept in the graph memory of the parameters not in the task only
 
 #define WB_OFFS_TEMP        (WB_OFFS_RAWDISP)
 #define WB_OFFS_TEMP_MIN    (WB_OFFS_TEMP)
@@ -123,18 +134,52 @@ static volatile uint32 sec_ctr = 0;
 
 #define WB_SIZE             (WB_OFFS_P_AVG + WB_DISPPOINT*2)     // all of these must be 4byte aligned
 
+// the flip buffers must not run into the graph memory - fails to compile if they do
+typedef char wb_cache_check[ (WB_OFFS_CACHE <= WB_OFFS_RAWDISP) ? 1 : -1 ];
+
 
 static uint8    workbuff[ WB_SIZE ];
 
 
 #define EEADDR_SETUP    0x00
 #define EEADDR_OPS      (EEADDR_SETUP + sizeof(struct SCoreSetup))
-#define EEADDR_RECORD   (EEADDR_OPS + sizeof(struct SCoreOperation))
-#define EEADDR_CK_SETUP (EEADDR_RECORD + sizeof(struct SCoreNonVolatileRec))
+#define EEADDR_RECORD   (EEADDR_OPS + sizeof(struct SCoreOperation))                 // 2 slots for the recording structure
+#define EEADDR_CK_SETUP (EEADDR_RECORD + 2 * sizeof(struct SCoreNonVolatileRec))
 #define EEADDR_CK_OPS   (EEADDR_CK_SETUP + 2)
-#define EEADDR_CK_REC   (EEADDR_CK_OPS + 2)
+#define EEADDR_CK_REC   (EEADDR_CK_OPS + 2)                                         // 2 checksums for the recording slots
 #define EEADDR_STORAGE  CORE_RECMEM_PAGESIZE       // leave the first page for setup - the rest is for recording
 
+// the structures and their checksums must fit in the first page - fails to compile if they grow over it
+typedef char eeaddr_page_check[ ((EEADDR_CK_REC + 4) <= EEADDR_STORAGE) ? 1 : -1 ];
+
+// Differential save of the nonvolatile structures - setup, operation and the recording record are handled in blocks.
+// Each block has a fingerprint of its content in FRAM: a 32 bit hash of the words, with invertible steps - a change
+// of a single word always changes it, other changes are missed with 2^-32 probability.
+// The fingerprints are taken at load, at save only the blocks with changed fingerprint are written.
+// The structures are protected by their CRC16 ( see crc16.h ), it is calculated block by block with the fingerprints,
+// at load while the next chunk is read. The additive checksums of the older firmware do not pass - its FRAM is loaded
+// as not initialized: setup defaults, no recordings.
+#define EENV_BLOCK          32
+#define EENV_BLOCKS( size ) ( ((size) + EENV_BLOCK - 1) / EENV_BLOCK )
+#define EENV_RDCHUNK        4               // blocks read in one FRAM transfer at load
+#define EENV_IDX_OPS        EENV_BLOCKS( sizeof(struct SCoreSetup) )
+#define EENV_IDX_REC        ( EENV_IDX_OPS + EENV_BLOCKS( sizeof(struct SCoreOperation) ) )
+#define EENV_TOTAL          ( EENV_IDX_REC + EENV_BLOCKS( sizeof(struct SCoreNonVolatileRec) ) )
+#define EENV_REC_ALL        ( (1 << EENV_BLOCKS( sizeof(struct SCoreNonVolatileRec) )) - 1 )
+#define EENV_REC_VALID      0x8000          // SCoreNonVolatileRec::wmask is set - the other slot is the previous commit
+
+static struct
+{
+    uint32  print[EENV_TOTAL];      // fingerprints of the FRAM content: setup, operation, the newer recording slot
+    uint32  known;                  // bitmask of the valid fingerprints
+    bool    rec_history;            // the older recording slot holds the commit before the newer one - it differs in nvrec.wmask blocks
+} eenv;
+
+struct SNvCheck
+{
+    uint16  crc;                    // running CRC16 of the structure
+};
+
 static uint32   RTCclock;           // user level RTC clock - when entering in core loop with 0.5sec event the RTC clock is copied, and this value is used till the next call
 
 
@@ -383,38 +428,12 @@ static void local_update_battery()
 
 static void local_calculate_dewpoint_abshum( uint32 temp, uint32 rh, uint32 *p_abs_hum, uint32 *p_dew )
 {
-    // TODO: optimize this, currently it executes in 524us
-
-    #define CT_A    6.116441        // constant set for -20*C <--> + 50*C with max error 0.08%
-    #define CT_m    7.591386        //
-    #define CT_Tn   240.7263        // 
-    #define CT_C    2.16679         //
-
-    double Pw;
-    double T;
-
-    T =  ( ( ((int)temp * 100) >> TEMP_FP ) - 4000 ) / 100.0;
-    rh = ((rh * 100) >> RH_FP);
-    Pw = ( CT_A * (rh / 100.0) * pow( 10, ((CT_m * T) / (T + CT_Tn)) ) ) / 100.0;
-
+    // fixed point table interpolation - see psychro.c
     if ( p_abs_hum )
-    {
-        //  A = C  Pw/T 
-        double Abs;
-
-        Abs = (CT_C * Pw * 100) / (T + 273.15);
-        *p_abs_hum = (uint32)(Abs * 100);               // return x100 g/mm3
-    }
+        *p_abs_hum = psychro_abs_humidity( temp, rh );  // return x100 g/m3
 
     if ( p_dew )
-    {
-        double Td; 
-
-        Td = CT_Tn / (  (CT_m / log10(Pw/CT_A)) - 1 );
-        if ( Td < -39.99 )
-            Td = 39.99;
-        *p_dew = (uint16)((Td + 40.0) * (1<< TEMP_FP)); // return temperature in 6fp9+40*C
-    }
+        *p_dew = psychro_dewpoint( temp, rh );          // return temperature in 16fp9+40*C
 }
 
 static void local_minmax_compare_and_update( uint32 entry, uint32 value )
@@ -473,48 +492,11 @@ static void local_tendency_restart( uint32 entry )
 
 inline static void internal_recording_get_minmax_from_raw( uint32 taks_elem, enum ESensorSelect param, uint32 *valmin, uint32 *valmax )
 {
-    switch ( core.readout.taks_elem )
-    {
-        case rtt_t:
-        case rtt_h:
-        case rtt_p:
-            *valmin = core.readout.v1min_total;
-            *valmax = core.readout.v1max_total;
-            break;
-        case rtt_th:
-        case rtt_tp:
-        case rtt_hp:
-            if ( ( (core.readout.taks_elem == rtt_th) && (param == ss_thermo) ) ||
-                 ( (core.readout.taks_elem == rtt_tp) && (param == ss_thermo) ) ||
-                 ( (core.readout.taks_elem == rtt_hp) && (param == ss_rh) )         )
-            {
-                *valmin = core.readout.v1min_total;
-                *valmax = core.readout.v1max_total;
-            }
-            else
-            {
-                *valmin = core.readout.v2min_total;
-                *valmax = core.readout.v2max_total;
-            }
-            break;
-        default:
-            if ( param == ss_thermo )
-            {
-                *valmin = core.readout.v1min_total;
-                *valmax = core.readout.v1max_total;
-            }
-            else if ( param == ss_rh )
-            {
-                *valmin = core.readout.v2min_total;
-                *valmax = core.readout.v2max_total;
-            }
-            else
-            {
-                *valmin = core.readout.v3min_total;
-                *valmax = core.readout.v3max_total;
-            }
-            break;
-    }
+    // the global min/max values are kept in packed channel order
+    uint32 ch = RECPACK_CHANNEL_IDX( taks_elem, CORE_BM_TEMP << (param - ss_thermo) );
+
+    *valmin = core.readout.agg.tmin[ch];
+    *valmax = core.readout.agg.tmax[ch];
 }
 
 static void internal_recording_normalize_temp_minmax( uint32 *pvalmin, uint32 *pvalmax, int *phigh, int *plow )
@@ -596,6 +578,23 @@ static inline uint32 internal_recording_prepare( uint32 *pvalmin, uint32 *pvalma
 }
 
 
+// Deadband tasks ( see recdelta.h ) keep the state of the block under write at the end of the staging buffer:
+//      [ codes of the staged elements ][ byte offset of stage[0] in its block ][ codec state at the first staged element ]
+// At a block start the offset is the length of the block before. The element under collection is staged with its
+// 12bit values after the codes, it is coded when it is complete.
+#define REC_DB_STGSIZE      (CORE_REC_STAGE - RECDELTA_STATE - 1)       // bytes for the codes
+#define REC_DB_BOFFS        REC_DB_STGSIZE
+#define REC_DB_STATE        (CORE_REC_STAGE - RECDELTA_STATE)
+
+static void internal_recording_drop_block( struct SRecTaskInternals *pfunc )
+{
+    // delete the elements of the oldest block of a deadband task - the block's place is taken by a new one
+    pfunc->c -= RECDELTA_BLOCK - (pfunc->r & (RECDELTA_BLOCK - 1));
+    pfunc->r = (pfunc->r | (RECDELTA_BLOCK - 1)) + 1;
+    if ( pfunc->r >= pfunc->wrap )
+        pfunc->r = 0;
+}
+
 static void local_recording_pushdata( uint32 task_idx, enum ESensorSelect sensor, uint32 value )
 {
     // value is in 16bit format ( 16fp9+40* for temp, 16fp8 0-100% for RH, 16bit Pascals for pressure )
@@ -620,91 +619,88 @@ static void local_recording_pushdata( uint32 task_idx, enum ESensorSelect sensor
         {
             // calculate the average and convert it to 12bit
             uint32 rval = (pfunc->avg_sum[sensor-1] / pfunc->avg_cnt[sensor-1]) >> 4;
+            uint32 nch = RECPACK_CHANNELS( task.task_elems );
+            uint32 nibble = 0;
+            struct SRecDelta dlt;
             pfunc->avg_sum[sensor-1] = 0;
             pfunc->avg_cnt[sensor-1] = 0;
             pfunc->elem_mask |= smask;              // mark that item is registered in the recording element
 
+            // record the item in the staging buffer - channel position in the element is given by the T -> H -> P order
+            if ( task.deadband )
+            {
+                // after the coded elements - the codes depend on the values before, decode the staged elements from the saved state
+                recdelta_start( &dlt, nch, task.deadband, 0, pfunc->w - pfunc->stg_cnt );
+                recdelta_load( &dlt, pfunc->stage + REC_DB_STATE );
+                nibble = recdelta_decode( &dlt, pfunc->stage, pfunc->stg_shift, NULL, pfunc->stg_cnt );
+                recpack_put( pfunc->stage, nibble + 3 * RECPACK_CHANNEL_IDX( task.task_elems, smask ), rval );
+            }
+            else
+                recpack_put( pfunc->stage, pfunc->stg_shift + RECPACK_ELSIZEX2( task.task_elems ) * pfunc->stg_cnt + 3 * RECPACK_CHANNEL_IDX( task.task_elems, smask ), rval );
+
             // check if the set is collected
             if ( pfunc->elem_mask == task.task_elems )
             {
+                if ( task.deadband )
+                {
+                    // code the element in place of its values
+                    uint16 val[RECDELTA_MAXCH];
+                    uint32 ch;
+
+                    recpack_decode( pfunc->stage, nibble, val, nch );
+                    for ( ch=0; ch<nch; ch++ )
+                        val[ch] >>= 4;
+                    nibble = recdelta_put( &dlt, pfunc->stage, nibble, val );
+                }
+
                 pfunc->shedule += 2 * core_utils_timeunit2seconds( task.sample_rate );      // reschedule
-                pfunc->elem_mask = CORE_ELEM_TO_RECORD;                                     // mark for non-volatile writing4
                 pfunc->last_timestamp = RTCclock;
-                core.vstatus.int_op.f.core_bsy = 1;
-                core.vstatus.int_op.f.op_recsave = 1;
-            }
+                pfunc->elem_mask = 0;
+                pfunc->stg_cnt++;
 
-            // record the item
-            if( (task.task_elems == rtt_t) ||
-                (task.task_elems == rtt_h) || 
-                (task.task_elems == rtt_p) )    
-            {
-                // in this case sensor is for sure the one to be recorded first
-                if ( pfunc->elem_shift )
+                // advance the write pointer
+                pfunc->w++;
+                if ( pfunc->w == pfunc->wrap )
                 {
-                    pfunc->element[0] |= rval >> 8;         // [oooo xxxx]              -- leaves the old MSB at start
-                    pfunc->element[1] = rval & 0xff;        //            [xxxx xxxx]
+                    pfunc->w = 0;
+                    pfunc->elem_mask = CORE_ELEM_TO_RECORD;     // write the staging buffer at wrap around - staged elements are continuous in storage
                 }
-                else
+
+                // delete the oldest record if needed
+                if ( task.deadband )
                 {
-                    pfunc->element[0] = rval >> 4;          // [xxxx xxxx]
-                    pfunc->element[1] = (rval << 4) & 0xff; //            [xxxx 0000]   -- clears the terminating LSB
+                    // a new block takes the directory entry of the oldest elements - their block is deleted
+                    uint32 last = ( pfunc->w ? pfunc->w : pfunc->wrap ) - 1;
+
+                    if ( ((last & (RECDELTA_BLOCK - 1)) == 0) && pfunc->c && ((pfunc->r >> RECDELTA_BLKSHIFT) == (last >> RECDELTA_BLKSHIFT)) )
+                        internal_recording_drop_block( pfunc );
+                    pfunc->c++;
                 }
-            } 
-            else if ( ( (sensor == ss_thermo) &&                                                // thermo sensor can be at start only in 2 cases: TH, TP
-                        ((task.task_elems == rtt_th) || (task.task_elems == rtt_tp)) ) ||       
-                      ( (sensor == ss_rh) &&                                                    // hygro sensor can be at start only in 1 case: HP
-                        (task.task_elems == rtt_hp) ) )
-            {
-                pfunc->element[0] = rval >> 4;              // [tttt tttt]
-                pfunc->element[1] |= (rval << 4) & 0xff;    //            [tttt oooo]  
-            }
-            else if ( ( (sensor == ss_rh) &&                                                    // hygro sensor can be at end only in 1 case: TH
-                        (task.task_elems == rtt_th)  ) || 
-                      ( (sensor == ss_pressure) &&                                              // pressure sensor can be at end only in 2 cases: TP, HP
-                        ((task.task_elems == rtt_tp) || (task.task_elems == rtt_hp)) ) )
-            {
-                pfunc->element[1] |= rval >> 8;             //            [oooo hhhh]
-                pfunc->element[2] = rval & 0xff;            //                       [hhhh hhhh]
-            }
-            else 
-            {
-                // only THP can get here
-                if ( pfunc->elem_shift )
+                else if ( pfunc->w == pfunc->r )
                 {
-                    if ( sensor == ss_thermo )
-                    {
-                        pfunc->element[0] |= rval >> 8;         // [oooo tttt]
-                        pfunc->element[1] = rval & 0xff;        //            [tttt tttt]
-                    }
-                    else if ( sensor == ss_rh )
-                    {
-                        pfunc->element[2] = rval >> 4;          //                      [hhhh hhhh]
-                        pfunc->element[3] |= (rval << 4) & 0xff;//                                 [hhhh oooo]  
-                    }
-                    else
-                    {
-                        pfunc->element[3] |= rval >> 8;         //                                 [oooo pppp]
-                        pfunc->element[4] = rval & 0xff;        //                                            [pppp pppp]
-                    }
+                    pfunc->r++;
+                    if ( pfunc->r == pfunc->wrap )
+                        pfunc->r = 0;
                 }
                 else
+                    pfunc->c++;
+
+                core.nvrec.dirty = true;
+
+                // write the staging buffer to storage if the next element doesn't fit in it - deadband tasks write every
+                // block when it is complete, the next block is placed after it
+                if ( task.deadband )
                 {
-                    if ( sensor == ss_thermo )
-                    {
-                        pfunc->element[0] = rval >> 4;          // [tttt tttt]
-                        pfunc->element[1] |= (rval << 4) & 0xff;//            [tttt oooo]  
-                    }
-                    else if ( sensor == ss_rh )
-                    {
-                        pfunc->element[1] |= rval >> 8;         //            [oooo hhhh]
-                        pfunc->element[2] = rval & 0xff;        //                       [hhhh hhhh]
-                    }
-                    else
-                    {
-                        pfunc->element[3] = rval >> 4;          //                                  [pppp pppp]
-                        pfunc->element[4] = (rval << 4) & 0xff; //                                             [pppp 0000]  
-                    }
+                    if ( ((pfunc->w & (RECDELTA_BLOCK - 1)) == 0) || ((nibble + RECDELTA_ELMAXX2( nch )) > (REC_DB_STGSIZE * 2)) )
+                        pfunc->elem_mask = CORE_ELEM_TO_RECORD;
+                }
+                else if ( (pfunc->stg_shift + RECPACK_ELSIZEX2( task.task_elems ) * (pfunc->stg_cnt + 1)) > (CORE_REC_STAGE * 2) )
+                    pfunc->elem_mask = CORE_ELEM_TO_RECORD;
+
+                if ( pfunc->elem_mask == CORE_ELEM_TO_RECORD )
+                {
+                    core.vstatus.int_op.f.core_bsy = 1;
+                    core.vstatus.int_op.f.op_recsave = 1;
                 }
             }
         }
@@ -716,24 +712,7 @@ static uint32 internal_recording_get_address( uint32 elem_ptr, enum ERecordingTa
 {
     uint32 ival;
 
-    switch ( elem_type )
-    {
-        case rtt_t:
-        case rtt_h:
-        case rtt_p:
-            ival = 3;
-            break;
-        case rtt_th:
-        case rtt_tp:
-        case rtt_hp:
-            ival = 6;
-            break;
-        default:
-            ival = 9;
-            break;
-    }
-
-    ival *= elem_ptr;
+    ival = RECPACK_ELSIZEX2( elem_type ) * elem_ptr;
     if ( shift )
     {
         if ( ival & 0x01 )
@@ -755,592 +734,852 @@ static uint32 internal_recording_get_address( uint32 elem_ptr, enum ERecordingTa
 // for rtt_thp:                     [e0][e1][e2][e3][e4]:   [0 0][0 0][0 0][0 0][0 1][1 1][1 1][1 1][1 1][2 2][2 2][2 2][2 2][2 3][3 3][3 3][3 3][3 3][4 4][4 4][4 4][4 4][4 X]
 //              0 -> 0,     1 -> 4 + shift,     2 -> 9,     3 -> 13 + shift,        4 -> 18
 
-static void local_recording_savedata(void)
+// Task memory layout:   [ elements: wrap ][ level 1: wrap/16 entries ][ level 2: wrap/256 entries ]
+// A summary entry holds the min / max / avg of 16 entries of the level below for each value of the element,
+// packed in the same 12bit stream:  [T min][T max][T avg][RH min][RH max][RH avg]...
+// Levels are used only if the task can hold more elements than the display points on that level - small tasks
+// have no summary. wrap is a multiple of the largest group, so the entries follow the element ring.
+//
+// Deadband tasks ( see recdelta.h ):    [ directory: wrap/16 entries ][ data ring ][ level 1: wrap/256 entries ]
+// The elements are coded in blocks of 16 with variable length. A directory entry holds the start of its block in the
+// data ring in units of 1 << RECDELTA_USHIFT() bytes, a block is written after the block before - at the ring start
+// if the largest block does not fit in the rest. wrap is sized for blocks without change, a changing signal fills the
+// data ring first and the oldest blocks are deleted when the ring is full. A level of 16 elements would take more
+// memory than the blocks, so the first level summarizes 256 elements.
+static inline uint32 internal_recording_group_shift( uint32 deadband, uint32 level )
 {
-    int i;
+    // log2 of the elements summarized in an entry of the level
+    return CORE_REC_SUMSHIFT * ( deadband ? (level + 1) : level );
+}
 
-    // check if NVRAM is free
-    if ( eeprom_is_operation_finished() == false )
-        return;
+static uint32 internal_recording_get_layout( uint32 mem_len, uint32 task_elems, uint32 deadband, uint32 *levels, uint32 *offs )
+{
+    uint32 elsizeX2;
+    uint32 blkX2;
+    uint32 wrap;
+    uint32 lev;
+    uint32 grp;
+    uint32 cost;
+    uint32 i;
 
-    // enable and 
-    eeprom_enable( true );
-    if ( eeprom_is_operation_finished() == false )
-        return;
+    *levels = 0;
+    elsizeX2 = RECPACK_ELSIZEX2( task_elems );
+    if ( elsizeX2 == 0 )
+        return 0;
 
-    for (i=0; i<STORAGE_RECTASK; i++)
+    // size of 16 elements in nibbles - for deadband tasks a block without change on the unit and its directory entry
+    if ( deadband )
     {
-        struct SRecTaskInternals *pfunc;
+        i = (1 << RECDELTA_USHIFT( mem_len )) - 1;
+        blkX2 = (((RECDELTA_BLKFLAT( RECPACK_CHANNELS( task_elems ) ) + i) & ~i) + 2) * 2;
+    }
+    else
+        blkX2 = elsizeX2 << CORE_REC_SUMSHIFT;
+
+    wrap = ((mem_len * 2) << CORE_REC_SUMSHIFT) / blkX2;
 
-        pfunc = &core.nvrec.func[i];
+    lev = 0;
+    while ( (lev < CORE_REC_SUMLEVELS) && (wrap > (WB_DISPPOINT << internal_recording_group_shift( deadband, lev + 1 ))) )
+        lev++;
 
-        if ( pfunc->elem_mask == CORE_ELEM_TO_RECORD )
+    if ( lev )
+    {
+        // size of a group of elements with all the summary entries for it - in nibbles
+        grp  = 1 << internal_recording_group_shift( deadband, lev );
+        cost = (grp >> CORE_REC_SUMSHIFT) * blkX2;
+        for ( i=1; i<=lev; i++ )
+            cost += 3 * elsizeX2 * (grp >> internal_recording_group_shift( deadband, i ));
+
+        wrap = ((mem_len * 2 - 2 * lev) / cost) * grp;                  // every level starts at byte boundary
+        if ( wrap > 0xffff )
+            wrap = 0x10000 - grp;                                       // do not exceed 16 bit spaces
+    }
+    else if ( deadband )
+    {
+        wrap &= ~(RECDELTA_BLOCK - 1);                                  // whole blocks
+        if ( wrap > 0xffff )
+            wrap = 0x10000 - RECDELTA_BLOCK;
+    }
+    else if ( wrap > 0xffff )
+        wrap = 0xffff;                                                  // do not exceed 16 bit spaces
+
+    if ( offs )
+    {
+        // deadband tasks: offs[0] is the data ring, the levels are at the end of the memory - the ring gets the rest
+        offs[0] = 0;
+        if ( deadband )
         {
-            // task has an element to be saved
-            uint32 ee_addr;
-            uint32 ee_len;
+            offs[0] = RECDELTA_DIRSIZE( wrap );
+            offs[1] = mem_len;
+            for ( i=1; i<=lev; i++ )
+                offs[1] -= ((wrap >> internal_recording_group_shift( deadband, i )) * elsizeX2 * 3 + 1) >> 1;
+        }
+        else if ( lev )
+            offs[1] = (wrap * elsizeX2 + 1) >> 1;
+        for ( i=2; i<=lev; i++ )
+            offs[i] = offs[i-1] + (((wrap >> internal_recording_group_shift( deadband, i-1 )) * elsizeX2 * 3 + 1) >> 1);
+    }
+
+    *levels = lev;
+    return wrap;
+}
+
+static uint32 internal_recording_get_ring( const struct SRecTaskInstance *task, uint32 *ring_offs )
+{
+    // data ring of a deadband task after the block directory - returns its size in bytes, a multiple of the unit
+    uint32 offs[CORE_REC_SUMLEVELS + 1];
+    uint32 mem_len = task->size * CORE_RECMEM_PAGESIZE;
+    uint32 levels;
+
+    internal_recording_get_layout( mem_len, task->task_elems, task->deadband, &levels, offs );
+    *ring_offs = offs[0];
+    return ( (levels ? offs[1] : mem_len) - offs[0] ) & ~((1 << RECDELTA_USHIFT( mem_len )) - 1);
+}
+
+static uint32 internal_recording_dir_read( uint32 task_addr, uint32 blk )
+{
+    // start of a block of a deadband task in units - NVRAM should be enabled
+    uint16 start;
+
+    eeprom_read( task_addr + blk * 2, 2, (uint8*)&start, false );
+    while ( eeprom_is_operation_finished() == false );
+    return start;
+}
+
+static void internal_recording_summarize( uint32 task_addr, const uint32 *offs, const struct SRecTaskInstance *task, uint32 level, uint32 entry, uint16 *res )
+{
+    // builds a summary entry of the given level from the entries of the level below - NVRAM should be enabled
+    // res gets the values of the entry - min/max/avg for each channel
+    uint8  buff[ RECDELTA_BLKMAX( RECDELTA_MAXCH ) + 1 ];       // a deadband block with the decoder reserve - a packed chunk with the shift fits also
+    uint16 dec[RECPACK_CHUNK];
+    struct SRecDelta dlt;
+    uint16 vmin[3];
+    uint16 vmax[3];
+    uint32 vsum[3];
+    uint16 *pdec;
+    uint32 elems = task->task_elems;
+    uint32 nch;
+    uint32 k;                                       // values / channel in the source: 1 - elements, 3 - summary entries
+    uint32 srcsize;
+    uint32 shift;                                   // log2 of the source entries
+    uint32 nibble;
+    uint32 addr;
+    uint32 len;
+    uint32 cnt;
+    uint32 i;
+    uint32 ch;
+
+    nch = RECPACK_CHANNELS( elems );
+    k = (level > 1) ? 3 : 1;
+    srcsize = RECPACK_ELSIZEX2( elems ) * k;
 
-            // calculate the nvram address and data length
-            switch ( core.nvrec.task[i].task_elems )
+    for ( ch=0; ch<nch; ch++ )
+    {
+        vmin[ch] = 0xffff;
+        vmax[ch] = 0;
+        vsum[ch] = 0;
+    }
+
+    // the first level of a deadband task is built from the blocks of its group, found in the directory
+    shift = CORE_REC_SUMSHIFT;
+    dlt.band = 0;
+    if ( task->deadband && (level == 1) )
+    {
+        shift = internal_recording_group_shift( task->deadband, 1 );
+        recdelta_start( &dlt, nch, task->deadband, 0, 0 );
+    }
+
+    // read the source entries by chunks
+    nibble = (entry << CORE_REC_SUMSHIFT) * srcsize;
+    addr = task_addr + offs[level - 1];
+    i = 1 << shift;
+    while ( i )
+    {
+        cnt = RECPACK_CHUNK / (nch * k);
+        if ( cnt > i )
+            cnt = i;
+        if ( dlt.band )
+        {
+            if ( dlt.pos == 0 )
             {
-                case rtt_t:
-                case rtt_h:
-                case rtt_p:
-                    ee_addr = (3 * (uint32)pfunc->w) >> 1;
-                    ee_len = 2;
-                    break;
-                case rtt_th:
-                case rtt_tp:
-                case rtt_hp:
-                    ee_addr = (6 * (uint32)pfunc->w) >> 1;
-                    ee_len = 3;
-                    break;
-                default:
-                    ee_addr = (9 * (uint32)pfunc->w) >> 1;
-                    ee_len = 5;
-                    break;
+                eeprom_read( addr + (internal_recording_dir_read( task_addr, ((entry << shift) + (1 << shift) - i) >> RECDELTA_BLKSHIFT ) <<
+                             RECDELTA_USHIFT( task->size * CORE_RECMEM_PAGESIZE )), RECDELTA_BLKMAX( nch ) + 1, buff, false );
+                while ( eeprom_is_operation_finished() == false );
+                nibble = 0;
             }
-            
-            // write to the storage
-            ee_addr = ee_addr + EEADDR_STORAGE + (uint32)core.nvrec.task[i].mempage * CORE_RECMEM_PAGESIZE;
-            DBG_recsave_savedata( i, ee_addr, ee_len, pfunc->element );
-            eeprom_write( ee_addr, pfunc->element, ee_len, false );
+            if ( cnt > (uint32)(RECDELTA_BLOCK - dlt.pos) )
+                cnt = RECDELTA_BLOCK - dlt.pos;
+            nibble = recdelta_decode( &dlt, buff, nibble, dec, cnt );
+        }
+        else
+        {
+            len = ((nibble & 0x01) + cnt * srcsize + 1) >> 1;
+            eeprom_read( addr + (nibble >> 1), len + 1, buff, false );
             while ( eeprom_is_operation_finished() == false );
+            recpack_decode( buff, nibble & 0x01, dec, cnt * nch * k );
+            nibble += cnt * srcsize;
+        }
+        i -= cnt;
 
-            // prepare task for the next aquisition
-            if ( (ee_len != 3) &&                       // If element is a non byte complete type (1 or 3 items -> 1.5 or 4.5 bytes)
-                 (pfunc->elem_shift == 0) )             // and no shift was made at the prew. operation                     
-            {
-                // save the last half byte from the prew. write
-                if ( ee_len == 2 )
-                    pfunc->element[0] = pfunc->element[1];          // for 1.5 bytes  
-                else
-                    pfunc->element[0] = pfunc->element[4];          // for 4.5 bytes
-                // mark the shift
-                pfunc->elem_shift = 1;
-                pfunc->element[1] = 0;
-                pfunc->element[2] = 0;
-                pfunc->element[3] = 0;
-                pfunc->element[4] = 0;
-            }
-            else
+        pdec = dec;
+        while ( cnt-- )
+        {
+            for ( ch=0; ch<nch; ch++ )
             {
-                memset( pfunc->element, 0, 5 );
-                pfunc->elem_shift = 0;
+                if ( vmin[ch] > pdec[0] )
+                    vmin[ch] = pdec[0];
+                if ( vmax[ch] < pdec[k >> 1] )
+                    vmax[ch] = pdec[k >> 1];
+                vsum[ch] += pdec[k - 1];
+                pdec += k;
             }
-            pfunc->elem_mask = 0;           // clear the elem mask
+        }
+    }
 
-            // advance the write pointer
-            pfunc->w++;
-            if ( pfunc->w == pfunc->wrap )
-            {
-                pfunc->elem_shift = 0;      // after wrap arround do not shift
-                pfunc->element[0] = 0;
-                pfunc->w = 0;
-            }
-                
-            // delete the oldest record if needed
-            if ( pfunc->w == pfunc->r )
+    for ( ch=0; ch<nch; ch++ )
+    {
+        res[ch*3]     = vmin[ch];
+        res[ch*3 + 1] = vmax[ch];
+        res[ch*3 + 2] = vsum[ch] >> shift;
+    }
+
+    // write the entry - it can share the first / last byte with the neighbours, so merge it in the existing content
+    srcsize = 3 * RECPACK_ELSIZEX2( elems );
+    nibble = entry * srcsize;
+    addr = task_addr + offs[level] + (nibble >> 1);
+    len = ((nibble & 0x01) + srcsize + 1) >> 1;
+    eeprom_read( addr, len, buff, false );
+    while ( eeprom_is_operation_finished() == false );
+    recpack_encode( buff, nibble & 0x01, res, 3 * nch );
+    eeprom_write( addr, buff, len, false );
+    while ( eeprom_is_operation_finished() == false );
+}
+
+static void local_recording_graph_extend( uint32 task_idx, uint32 level, uint32 index, const uint16 *val )
+{
+    // continues a live graph with a new element ( level 0 ) or summary entry - val holds the values in packed order
+    // the right-most display point is updated till it covers its share of entries, then the graph is shifted with one point
+    static const uint16 ch_offs[3] = { WB_OFFS_TEMP, WB_OFFS_RH, WB_OFFS_P };
+    struct SRecAgg *agg = &core.readout.agg;
+    uint16 *buff;
+    uint16 *pmin;
+    uint16 *pmax;
+    uint32 k;
+    uint32 ch;
+    uint32 pt;
+    uint32 i;
+    uint32 j;
+    bool simple;
+    bool shift;
+
+    if ( (core.readout.live == 0) || (core.readout.task_idx != task_idx) || (core.readout.level != level) ||
+         (core.vstatus.int_op.f.graph_ok == 0) )
+        return;
+
+    if ( index != core.readout.to_ptr )             // data was saved during the readout - the graph can not be continued
+    {
+        core.readout.live = 0;
+        return;
+    }
+    core.readout.to_ptr++;
+    if ( core.readout.to_ptr >= core.readout.wrap )
+        core.readout.to_ptr = 0;
+
+    k = level ? 3 : 1;
+    simple = (core.readout.total_read <= WB_DISPPOINT);
+    if ( simple )
+    {
+        // every element is a display point - fill up the display, then shift
+        shift = (core.readout.total_read == WB_DISPPOINT);
+        pt = shift ? (WB_DISPPOINT - 1) : core.readout.total_read++;
+    }
+    else
+    {
+        shift = (agg->ctr == 0);                    // the right-most point is complete - start a new one
+        pt = WB_DISPPOINT - 1;
+    }
+
+    ch = 0;
+    for ( i=0; i<3; i++ )
+    {
+        if ( (core.readout.taks_elem & (CORE_BM_TEMP << i)) == 0 )
+            continue;
+
+        buff = (uint16*)(workbuff + ch_offs[i]);    // min / max / avg arrays follow each other
+        if ( shift )
+        {
+            memmove( buff, buff + 1, (WB_DISPPOINT * 3 - 1) * 2 );     // the last point of each array is rewritten below
+            buff[pt] = 0xffff;
+            buff[pt + WB_DISPPOINT] = 0;
+            agg->vsum[ch] = 0;
+        }
+
+        if ( simple )
+        {
+            buff[pt] = val[ch];
+            buff[pt + WB_DISPPOINT] = val[ch];
+            buff[pt + WB_DISPPOINT*2] = val[ch];
+        }
+        else
+        {
+            if ( buff[pt] > val[ch*k] )
+                buff[pt] = val[ch*k];
+            if ( buff[pt + WB_DISPPOINT] < val[ch*k + (k >> 1)] )
+                buff[pt + WB_DISPPOINT] = val[ch*k + (k >> 1)];
+            agg->vsum[ch] += val[ch*k + k - 1];
+            buff[pt + WB_DISPPOINT*2] = agg->vsum[ch] / (agg->ctr + 1);
+        }
+
+        // global min/max - recalculate if a point was dropped ( in simple graph only the averages are valid )
+        if ( shift )
+        {
+            pmin = simple ? (buff + WB_DISPPOINT*2) : buff;
+            pmax = simple ? (buff + WB_DISPPOINT*2) : (buff + WB_DISPPOINT);
+            agg->tmin[ch] = 0xffff;
+            agg->tmax[ch] = 0;
+            for ( j=0; j<WB_DISPPOINT; j++ )
             {
-                pfunc->r++;
-                if ( pfunc->r == pfunc->wrap )
-                    pfunc->r = 0;
+                if ( agg->tmin[ch] > pmin[j] )
+                    agg->tmin[ch] = pmin[j];
+                if ( agg->tmax[ch] < pmax[j] )
+                    agg->tmax[ch] = pmax[j];
             }
-            else
-                pfunc->c++;
+        }
+        else
+        {
+            if ( agg->tmin[ch] > buff[pt] )
+                agg->tmin[ch] = buff[pt];
+            if ( agg->tmax[ch] < buff[pt + WB_DISPPOINT] )
+                agg->tmax[ch] = buff[pt + WB_DISPPOINT];
+        }
+        ch++;
+    }
 
-            core.nvrec.dirty = true;
+    if ( simple == false )
+    {
+        // advance the display step the same way as the readout
+        agg->ctr++;
+        agg->dispctr += agg->dispstep;
+        if ( (agg->dispctr >> 16) != agg->dispprev )
+        {
+            agg->dispprev = (agg->dispctr >> 16);
+            agg->ctr = 0;
         }
     }
 
-    core.vstatus.int_op.f.op_recsave = 0;      // everythign is saved
+    core.readout.last_timestamp = core.nvrec.func[task_idx].last_timestamp;
+    core.readout.req_length = 0;                    // the graph is not the requested view anymore
+    core.measure.dirty.b.upd_rec_graph = 1;
 }
 
-static void local_recording_all_pushdata( enum ESensorSelect sensor, uint32 value )
+// graph view cache: the pieces of a cached view in the workbuffer - see internal_recording_cache_place()
+struct SCoreGraphCacheView
 {
-    int i;
-    for ( i=0; i<STORAGE_RECTASK; i++ )
+    uint16  readout;                        // readout state of the view
+    uint16  avg[3];                         // avg arrays of the channels in packed order - 16bit values
+    uint16  minmax[3];                      // min and max arrays of the channels - 12bit packed values, aggregated views only
+};
+
+static bool internal_recording_cache_place( uint32 taks_elem, uint32 slot, struct SCoreGraphCacheView *view )
+{
+    // places the pieces of the views up to 'slot' one after the other in the cache area, then in the graph memory blocks of
+    // the parameters not in the task - returns false if the view does not fit
+    uint16 *piece[7];
+    uint32 start[4];
+    uint32 end[4];
+    uint32 areas = 1;
+    uint32 area = 0;
+    uint32 nch = RECPACK_CHANNELS( taks_elem );
+    uint32 pos = WB_OFFS_CACHE;
+    uint32 size;
+    uint32 i;
+
+    start[0] = WB_OFFS_CACHE;
+    end[0]   = WB_OFFS_RAWDISP;
+    for ( i=0; i<3; i++ )
     {
-        if ( core.nvrec.running & (1<<i) )
-            local_recording_pushdata( i, sensor, value );
+        if ( (taks_elem & (CORE_BM_TEMP << i)) == 0 )
+        {
+            start[areas] = WB_OFFS_RAWDISP + i * (WB_DISPPOINT * 6);
+            end[areas]   = start[areas] + WB_DISPPOINT * 6;
+            areas++;
+        }
     }
-}
 
+    piece[0] = &view->readout;
+    for ( i=0; i<nch; i++ )
+    {
+        piece[1 + i]       = &view->avg[i];
+        piece[1 + nch + i] = &view->minmax[i];
+    }
 
-static void local_recording_task_reset( uint32 task_idx )
-{
-    uint32 wrap;
-    memset( &core.nvrec.func[task_idx], 0, sizeof(struct SRecTaskInternals) );
+    do
+    {
+        for ( i=0; i<(1 + 2 * nch); i++ )
+        {
+            if ( i == 0 )
+            {
+                pos  = (pos + 3) & ~3;                              // readout state is accessed as a structure
+                size = sizeof(struct SCoreNVreadout);
+            }
+            else if ( i <= nch )
+            {
+                pos  = (pos + 1) & ~1;
+                size = WB_DISPPOINT * 2;
+            }
+            else
+                size = (WB_DISPPOINT * 2 * 3) / 2;                  // min and max in 12 bits
 
-    // wrap arround pointer is the max. elem. count of the current task
-    wrap = core_op_recording_get_total_samplenr( core.nvrec.task[task_idx].size * CORE_RECMEM_PAGESIZE, core.nvrec.task[task_idx].task_elems );
+            if ( (pos + size) > end[area] )
+            {
+                if ( ++area == areas )
+                    return false;
+                pos = start[area];
+            }
+            *piece[i] = (uint16)pos;
+            pos += size;
+        }
+    } while ( slot-- );
 
-    core.nvrec.func[task_idx].shedule = CORE_SCHED_NONE;
-    core.nvrec.func[task_idx].wrap = wrap;
+    return true;
 }
 
-static void local_recording_task_stop( uint32 task_idx )
+static inline uint32 internal_recording_cache_views( uint32 taks_elem )
 {
-    // just disable the clock
-    core.nvrec.func[task_idx].shedule = CORE_SCHED_NONE;
+    // views fitting in the cache area and the graph memory blocks of the parameters not in the task
+    struct SCoreGraphCacheView view;
+    uint32 views = 0;
+
+    while ( (views < CORE_GRCACHE_VIEWS) && internal_recording_cache_place( taks_elem, views, &view ) )
+        views++;
+    return views;
 }
 
-static void local_recording_task_start( uint32 task_idx )
+static inline struct SCoreNVreadout *internal_recording_cache_readout( uint32 slot )
 {
-    core.nvrec.func[task_idx].shedule = RTCclock + 2 * core_utils_timeunit2seconds( core.nvrec.task[task_idx].sample_rate );
-}
+    // readout state of a cached view
+    struct SCoreGraphCacheView view;
 
+    internal_recording_cache_place( core.grcache.taks_elem, slot, &view );
+    return (struct SCoreNVreadout*)(workbuff + view.readout);
+}
 
-static inline void internal_recording_read_process_simple( uint8 *wbuff, uint32 smp_proc, uint32 shifted )
+static bool internal_recording_cache_packable( void )
 {
-    // Do not try to optimize this - it should work as quick as possible
-    int i;
-    uint32 disp_ptr;
+    // min / max arrays of the displayed graph are kept in 12 bits - samples and summary entries have the 4 LSB clear
+    uint16 *graph = (uint16*)(workbuff + WB_OFFS_RAWDISP);
+    uint32 bits = 0;
+    uint32 i;
+    uint32 j;
 
-    disp_ptr = core.readout.raw_ptr << 1;
+    if ( core.readout.agg.dispstep == 0 )
+        return true;                                                // copied samples - only the avg arrays are used
 
-    switch ( core.readout.taks_elem )
+    for ( i=0; i<3; i++ )
     {
-        case rtt_t:
-        case rtt_p:
-        case rtt_h:
-            {
-                uint16 *rawbuff;
-                uint32 val;
+        if ( core.readout.taks_elem & (CORE_BM_TEMP << i) )
+        {
+            for ( j=0; j<(WB_DISPPOINT * 2); j++ )
+                bits |= graph[i * (WB_DISPPOINT * 3) + j];
+        }
+    }
+    return ( (bits & 0x0f) == 0 );
+}
 
-                if ( core.readout.taks_elem == rtt_t )
-                    rawbuff = (uint16*)(workbuff + WB_OFFS_TEMP_AVG + disp_ptr);
-                else if ( core.readout.taks_elem == rtt_h )
-                    rawbuff = (uint16*)(workbuff + WB_OFFS_RH_AVG + disp_ptr);
-                else
-                    rawbuff = (uint16*)(workbuff + WB_OFFS_P_AVG + disp_ptr);
+static void local_recording_cache_exchange( uint32 slot, bool swap )
+{
+    // stores the displayed graph in a cache slot ( swap == false ) or exchanges them, the readout state goes with the graph
+    // the slot's pieces are taken to the flip buffers before they are overwritten - no readout is in progress
+    struct SCoreGraphCacheView view;
+    uint8 *tmp = workbuff + WB_OFFS_FLIP1;
+    uint8 *graph;
+    bool store_mm;
+    bool load_mm = false;
+    uint32 ch = 0;
+    uint32 i;
 
-                for ( i=0; i<smp_proc; i++ )
-                {
-                    // get the 12bit value
-                    if ( shifted )
-                    {   
-                        val = ( ( ((uint32)(wbuff[0]) << 8) | wbuff[1] ) & 0x0fff) << 4;    // [xxxx tttt][tttt tttt]
-                        shifted = 0;
-                        wbuff += 2;
-                    }
-                    else
-                    {
-                        val = ( ((uint32)(wbuff[0]) << 4) | (wbuff[1] >> 4) ) << 4;      // [tttt tttt][tttt xxxx]
-                        shifted = 1;
-                        wbuff += 1;
-                    }
-                    // save
-                    *rawbuff = val;
+    internal_recording_cache_place( core.grcache.taks_elem, slot, &view );
 
-                    // save the global min/max values
-                    if ( core.readout.v1max_total < val )
-                        core.readout.v1max_total = val;
-                    if ( core.readout.v1min_total > val )
-                        core.readout.v1min_total = val;
+    // min / max arrays are used by the aggregated views only
+    store_mm = ( core.readout.agg.dispstep != 0 );
+    if ( swap )
+    {
+        memcpy( tmp, workbuff + view.readout, sizeof(struct SCoreNVreadout) );
+        load_mm = ( ((struct SCoreNVreadout*)tmp)->agg.dispstep != 0 );
+    }
+    memcpy( workbuff + view.readout, &core.readout, sizeof(struct SCoreNVreadout) );
+    if ( swap )
+        memcpy( &core.readout, tmp, sizeof(struct SCoreNVreadout) );
 
-                    rawbuff++;
-                }
-            }
-            break;
-        case rtt_th:
-        case rtt_tp:
-        case rtt_hp:
-            {
-                uint16 *rawbuff1;
-                uint16 *rawbuff2;
-                uint32 val1;
-                uint32 val2;
+    for ( i=0; i<3; i++ )
+    {
+        if ( (core.grcache.taks_elem & (CORE_BM_TEMP << i)) == 0 )
+            continue;
 
-                if ( core.readout.taks_elem == rtt_th )
-                {
-                    rawbuff1 = (uint16*)(workbuff + WB_OFFS_TEMP_AVG + disp_ptr);
-                    rawbuff2 = (uint16*)(workbuff + WB_OFFS_RH_AVG + disp_ptr);
-                }
-                else if ( core.readout.taks_elem == rtt_tp )
-                {
-                    rawbuff1 = (uint16*)(workbuff + WB_OFFS_TEMP_AVG + disp_ptr);
-                    rawbuff2 = (uint16*)(workbuff + WB_OFFS_P_AVG + disp_ptr);
-                }
-                else
-                {
-                    rawbuff1 = (uint16*)(workbuff + WB_OFFS_RH_AVG + disp_ptr);
-                    rawbuff2 = (uint16*)(workbuff + WB_OFFS_P_AVG + disp_ptr);
-                }
+        graph = workbuff + WB_OFFS_RAWDISP + i * (WB_DISPPOINT * 6);       // min / max / avg arrays of a parameter
 
-                for ( i=0; i<smp_proc; i++ )
-                {
-                    // get the 12bit value - no shift in this case
-                    val1 = ( ((uint32)(wbuff[0]) << 4) | (wbuff[1] >> 4) ) << 4;        // [tttt tttt][tttt hhhh][hhhh hhhh]
-                    val2 = ( ( ((uint32)(wbuff[1]) << 8) | wbuff[2] ) & 0x0fff ) << 4;
-                    wbuff += 3;
-
-                    // save
-                    *rawbuff1 = val1;
-                    *rawbuff2 = val2;
-                    rawbuff1++;
-                    rawbuff2++;
-
-                    // save the global min/max values
-                    if ( core.readout.v1max_total < val1 )
-                        core.readout.v1max_total = val1;
-                    if ( core.readout.v1min_total > val1 )
-                        core.readout.v1min_total = val1;
-
-                    if ( core.readout.v2max_total < val2 )
-                        core.readout.v2max_total = val2;
-                    if ( core.readout.v2min_total > val2 )
-                        core.readout.v2min_total = val2;
-                }
-            }
-            break;
-        default:
+        if ( swap )
+            memcpy( tmp, workbuff + view.avg[ch], WB_DISPPOINT * 2 );
+        memcpy( workbuff + view.avg[ch], graph + WB_DISPPOINT * 4, WB_DISPPOINT * 2 );
+        if ( swap )
+            memcpy( graph + WB_DISPPOINT * 4, tmp, WB_DISPPOINT * 2 );
+
+        if ( load_mm )
+            memcpy( tmp, workbuff + view.minmax[ch], (WB_DISPPOINT * 2 * 3) / 2 );
+        if ( store_mm )
+        {
+            // packed in place - the output stays behind the values to be read, the avg array is not touched
+            recpack_encode( graph, 0, (uint16*)graph, WB_DISPPOINT * 2 );
+            memcpy( workbuff + view.minmax[ch], graph, (WB_DISPPOINT * 2 * 3) / 2 );
+        }
+        if ( load_mm )
+            recpack_decode( tmp, 0, (uint16*)graph, WB_DISPPOINT * 2 );
+        ch++;
+    }
+}
+
+static void local_recording_cache_drop( uint32 task_idx )
+{
+    // task data is reset - forget its views
+    uint32 i;
+
+    for ( i=0; i<CORE_GRCACHE_VIEWS; i++ )
+    {
+        if ( core.grcache.used[i] && (internal_recording_cache_readout( i )->task_idx == task_idx) )
+            core.grcache.used[i] = 0;
+    }
+}
+
+static bool local_recording_cache_request( uint32 task_idx, uint32 smpl_depth, uint32 length )
+{
+    // keeps the displayed graph for the case the viewer returns to it, and serves the requested view if it is kept
+    // returns true if the view is served - no readout needed
+    struct SCoreGraphCache *cache = &core.grcache;
+    struct SCoreNVreadout *view;
+    uint32 elems = core.nvrec.task[task_idx].task_elems;
+    uint32 views = internal_recording_cache_views( elems );
+    uint32 slot = 0;
+    uint32 i;
+    bool keep;
+
+    // the displayed graph can be kept if it is complete, not changed since read and its task has no new data
+    keep = core.vstatus.int_op.f.graph_ok && core.readout.req_length && (core.readout.taks_elem == elems) &&
+           (core.readout.last_timestamp == core.nvrec.func[core.readout.task_idx].last_timestamp) &&
+           internal_recording_cache_packable();
+
+    if ( cache->taks_elem != elems )
+    {
+        // the views of a different layout are placed differently - the views kept are lost
+        memset( cache->used, 0, sizeof(cache->used) );
+        cache->taks_elem = elems;
+    }
+    if ( views == 0 )
+        return false;
+
+    if ( ++cache->stamp == 0 )
+    {
+        // counter wrap - renumber the views keeping their order
+        uint8 rank[CORE_GRCACHE_VIEWS];
+        uint32 j;
+
+        for ( i=0; i<CORE_GRCACHE_VIEWS; i++ )
+        {
+            rank[i] = 0;
+            for ( j=0; (j<CORE_GRCACHE_VIEWS) && cache->used[i]; j++ )
             {
-                uint16 *rawbuff1 = (uint16*)(workbuff + WB_OFFS_TEMP_AVG + disp_ptr);
-                uint16 *rawbuff2 = (uint16*)(workbuff + WB_OFFS_RH_AVG + disp_ptr);
-                uint16 *rawbuff3 = (uint16*)(workbuff + WB_OFFS_P_AVG + disp_ptr);
-                uint32 val1;
-                uint32 val2;
-                uint32 val3;
-                for ( i=0; i<smp_proc; i++ )
-                {
-                    // get the 12bit value
-                    if ( shifted )
-                    {                                                                       //      0          1          2          3          4
-                        val1 = ( ( ((uint32)(wbuff[0]) << 8) | wbuff[1] ) & 0x0fff) << 4;   // [xxxx tttt][tttt tttt][hhhh hhhh][hhhh pppp][pppp pppp]
-                        val2 = ( ((uint32)(wbuff[2]) << 4) | (wbuff[3] >> 4) ) << 4;
-                        val3 = ( ( ((uint32)(wbuff[3]) << 8) | wbuff[4] ) & 0x0fff) << 4;
-                        shifted = 0;
-                        wbuff += 5;
-                    }
-                    else
-                    {
-                        val1 = ( ((uint32)(wbuff[0]) << 4) | (wbuff[1] >> 4) ) << 4;        // [tttt tttt][tttt hhhh][hhhh hhhh][pppp pppp][pppp xxxx]
-                        val2 = ( ( ((uint32)(wbuff[1]) << 8) | wbuff[2] ) & 0x0fff) << 4;
-                        val3 = ( ((uint32)(wbuff[3]) << 4) | (wbuff[4] >> 4) ) << 4; 
-                        shifted = 1;
-                        wbuff += 4;
-                    }
-                    // convert to 16bit and save
-                    *rawbuff1 = val1;
-                    *rawbuff2 = val2;
-                    *rawbuff3 = val3;
-                    rawbuff1++;
-                    rawbuff2++;
-                    rawbuff3++;
-
-                    // save the global min/max values
-                    if ( core.readout.v1max_total < val1 )
-                        core.readout.v1max_total = val1;
-                    if ( core.readout.v1min_total > val1 )
-                        core.readout.v1min_total = val1;
-
-                    if ( core.readout.v2max_total < val2 )
-                        core.readout.v2max_total = val2;
-                    if ( core.readout.v2min_total > val2 )
-                        core.readout.v2min_total = val2;
-
-                    if ( core.readout.v3max_total < val3 )
-                        core.readout.v3max_total = val3;
-                    if ( core.readout.v3min_total > val3 )
-                        core.readout.v3min_total = val3;
-                }
+                if ( cache->used[j] && (cache->used[j] <= cache->used[i]) )
+                    rank[i]++;
             }
-            break;
+        }
+        memcpy( cache->used, rank, sizeof(rank) );
+        cache->stamp = CORE_GRCACHE_VIEWS + 1;
+    }
+
+    for ( i=0; i<views; i++ )
+    {
+        if ( cache->used[i] == 0 )
+            continue;
+
+        view = internal_recording_cache_readout( i );
+        if ( (view->task_idx == task_idx) &&
+             (view->req_depth == smpl_depth) &&
+             (view->req_length == length) &&
+             (view->last_timestamp == core.nvrec.func[task_idx].last_timestamp) )
+        {
+            // hit - the displayed graph takes the place of the requested one
+            local_recording_cache_exchange( i, true );
+            cache->used[i] = keep ? cache->stamp : 0;
+
+            core.readout.live = (smpl_depth == length);
+            core.measure.dirty.b.upd_rec_graph = 0;
+            core.vstatus.int_op.f.graph_ok = 1;
+            return true;
+        }
+    }
+
+    if ( keep )
+    {
+        // miss - keep the displayed graph in place of the least recently used view
+        for ( i=1; i<views; i++ )
+        {
+            if ( cache->used[i] < cache->used[slot] )
+                slot = i;
+        }
+        local_recording_cache_exchange( slot, false );
+        cache->used[slot] = cache->stamp;
     }
-    core.readout.raw_ptr += smp_proc;
+    return false;
 }
 
-static inline void internal_recording_read_process_minmaxavg( uint8 *wbuff, uint32 smp_proc, uint32 shifted, bool last )
+static void local_recording_flush_deadband( uint32 task_idx, uint32 task_addr, uint32 elem )
 {
-    int i;
-    uint32 disp_ptr;
+    // writes the staged elements of a deadband task to its data ring - NVRAM should be enabled for write
+    // a new block is placed after the block before and gets its directory entry, the oldest blocks in its way are deleted
+    struct SRecTaskInternals *pfunc = &core.nvrec.func[task_idx];
+    struct SRecTaskInstance *task = &core.nvrec.task[task_idx];
+    struct SRecDelta dlt;
+    uint32 nch = RECPACK_CHANNELS( task->task_elems );
+    uint32 ushift = RECDELTA_USHIFT( task->size * CORE_RECMEM_PAGESIZE );
+    uint32 unit = (1 << ushift) - 1;
+    uint32 blk = elem >> RECDELTA_BLKSHIFT;
+    uint32 boffs = pfunc->stage[REC_DB_BOFFS];
+    uint32 ring_offs;
+    uint32 ring;
+    uint32 start;
+    uint32 nibbles;
+    uint32 ee_addr;
+    uint32 ee_len;
+
+    ring = internal_recording_get_ring( task, &ring_offs );
+
+    if ( (elem & (RECDELTA_BLOCK - 1)) == 0 )
+    {
+        uint32 need = RECDELTA_BLKMAX( nch );
+        uint32 pos = 0;
+        uint16 entry;
+
+        // after the block before - boffs is its length
+        if ( pfunc->c > pfunc->stg_cnt )
+            pos = ((internal_recording_dir_read( task_addr, (blk ? blk : (pfunc->wrap >> RECDELTA_BLKSHIFT)) - 1 ) << ushift) + boffs + unit) & ~unit;
+        start = pos;
+        if ( (pos + need) > ring )
+        {
+            start = 0;
+            need += ring - pos;
+        }
+
+        // delete the oldest blocks starting in the space the new one can take
+        while ( (pfunc->c > pfunc->stg_cnt) &&
+                ((((internal_recording_dir_read( task_addr, pfunc->r >> RECDELTA_BLKSHIFT ) << ushift) + ring - pos) % ring) < need) )
+            internal_recording_drop_block( pfunc );
 
-    register uint32 dispctr  = core.readout.dispctr;
-    register uint32 dispprev = core.readout.dispprev;
-    register uint32 dispstep = core.readout.dispstep;
+        entry = (uint16)(start >> ushift);
+        eeprom_write( task_addr + blk * 2, (uint8*)&entry, 2, false );
+        while ( eeprom_is_operation_finished() == false );
+        boffs = 0;
+    }
+    else
+        start = internal_recording_dir_read( task_addr, blk ) << ushift;
 
-    disp_ptr = (dispctr >> 15) & (~0x01);       // use the disp counter's integer part, but x2
+    // end of the codes - the codec state after them is kept for the next staged element
+    recdelta_start( &dlt, nch, task->deadband, 0, elem );
+    recdelta_load( &dlt, pfunc->stage + REC_DB_STATE );
+    nibbles = recdelta_decode( &dlt, pfunc->stage, pfunc->stg_shift, NULL, pfunc->stg_cnt );
+    ee_addr = task_addr + ring_offs + start + boffs;
+    ee_len  = (nibbles + 1) >> 1;
 
-    switch ( core.readout.taks_elem )
+    DBG_recsave_savedata( task_idx, ee_addr, ee_len, pfunc->stage );
+    eeprom_write( ee_addr, pfunc->stage, ee_len, false );
+    while ( eeprom_is_operation_finished() == false );
+
+    // continue the live graph with the new elements
+    if ( core.readout.live && (core.readout.task_idx == task_idx) && (core.readout.level == 0) )
     {
-        case rtt_t:
-        case rtt_p:
-        case rtt_h:
-            {
-                uint16 *rawbuff;
-                register uint32 val;
+        struct SRecDelta gdlt;
+        uint16 res[RECDELTA_MAXCH];
+        uint32 nibble = pfunc->stg_shift;
+        uint32 i;
+
+        recdelta_start( &gdlt, nch, task->deadband, 0, elem );
+        recdelta_load( &gdlt, pfunc->stage + REC_DB_STATE );
+        for ( i=0; i<pfunc->stg_cnt; i++ )
+        {
+            nibble = recdelta_decode( &gdlt, pfunc->stage, nibble, res, 1 );
+            local_recording_graph_extend( task_idx, 0, elem + i, res );
+        }
+    }
 
-                if ( core.readout.taks_elem == rtt_t )
-                    rawbuff = (uint16*)(workbuff + WB_OFFS_TEMP + disp_ptr);
-                else if ( core.readout.taks_elem == rtt_h )
-                    rawbuff = (uint16*)(workbuff + WB_OFFS_RH + disp_ptr);
-                else
-                    rawbuff = (uint16*)(workbuff + WB_OFFS_P + disp_ptr);
+    // prepare the buffer for the next aquisition
+    recdelta_save( &dlt, pfunc->stage + REC_DB_STATE );
+    if ( ((elem + pfunc->stg_cnt) & (RECDELTA_BLOCK - 1)) == 0 )
+    {
+        pfunc->stage[REC_DB_BOFFS] = (uint8)(boffs + ee_len);      // block end - the next block starts on a new unit
+        pfunc->stage[0] = 0;
+        pfunc->stg_shift = 0;
+    }
+    else
+    {
+        pfunc->stage[REC_DB_BOFFS] = (uint8)(boffs + (nibbles >> 1));
+        if ( nibbles & 0x01 )                           // the last element ends on a half byte - keep it for the next write
+        {
+            pfunc->stage[0] = pfunc->stage[nibbles >> 1];
+            pfunc->stg_shift = 1;
+        }
+        else
+        {
+            pfunc->stage[0] = 0;
+            pfunc->stg_shift = 0;
+        }
+    }
+    memset( pfunc->stage + 1, 0, REC_DB_STGSIZE - 1 );
+}
 
-                for ( i=0; i<smp_proc; i++ )
-                {
-                    // get the 12bit value
-                    if ( shifted )
-                    {   
-                        val = (( ((uint32)(wbuff[0]) << 8) | wbuff[1] ) & 0x0fff) << 4;    // [xxxx tttt][tttt tttt]
-                        shifted = 0;
-                        wbuff += 2;
-                    }
-                    else
-                    {
-                        val = ( ((uint32)(wbuff[0]) << 4) | (wbuff[1] >> 4) ) << 4;      // [tttt tttt][tttt xxxx]
-                        shifted = 1;
-                        wbuff += 1;
-                    }
+static void local_recording_flush( uint32 task_idx )
+{
+    // writes the staged elements of a task to storage - NVRAM should be enabled for write
+    struct SRecTaskInternals *pfunc;
+    struct SRecTaskInstance *task;
+    uint32 nibbles;
+    uint32 task_addr;
+    uint32 elem;
+    uint32 ee_addr;
+    uint32 ee_len;
+    uint32 offs[CORE_REC_SUMLEVELS + 1];
+    uint32 levels;
+    uint32 lev;
+    uint32 shift;
+    uint32 nch;
+    uint32 i;
+    uint16 res[RECPACK_CHUNK];                          // decoded elements / summary entry
 
-                    // check min/max and sum for average
-                    if ( core.readout.v1min > val )
-                        core.readout.v1min = val;
-                    if ( core.readout.v1max < val )
-                        core.readout.v1max = val;
-                    core.readout.v1ctr++;
-                    core.readout.v1sum += val;
-
-                    // see if should proceed with the next point
-                    dispctr += dispstep;
-                    if ( ((dispctr >> 16) != dispprev) ||
-                         (last && (i==smp_proc-1) && (core.readout.raw_ptr < WB_DISPPOINT)) )
-                    {
-                        dispprev = (dispctr >> 16);
-
-                        val = core.readout.v1sum / core.readout.v1ctr;
-                        *rawbuff        = core.readout.v1min;
-                        *(rawbuff+WB_DISPPOINT)  = core.readout.v1max;
-                        *(rawbuff+WB_DISPPOINT*2)  = val;
-
-                        // save the global min/max values
-                        if ( core.readout.v1max_total < core.readout.v1max )
-                            core.readout.v1max_total = core.readout.v1max;
-                        if ( core.readout.v1min_total > core.readout.v1min )
-                            core.readout.v1min_total = core.readout.v1min;
-
-                        core.readout.v1min = 0xffff;
-                        core.readout.v1max = 0;
-                        core.readout.v1sum = 0;
-                        core.readout.v1ctr = 0;
-
-                        rawbuff++;
-                        core.readout.raw_ptr++;
-                    }
-                }
-            }
-            break;
-        case rtt_th:
-        case rtt_tp:
-        case rtt_hp:
+    pfunc = &core.nvrec.func[task_idx];
+    task  = &core.nvrec.task[task_idx];
+
+    if ( pfunc->stg_cnt )
+    {
+        nch = RECPACK_CHANNELS( task->task_elems );
+        task_addr = EEADDR_STORAGE + (uint32)task->mempage * CORE_RECMEM_PAGESIZE;
+
+        // address of the first staged element - the buffer is written at wrap around, so staged elements never cross it
+        elem    = ( pfunc->w ? pfunc->w : pfunc->wrap ) - pfunc->stg_cnt;
+
+        if ( task->deadband )
+            local_recording_flush_deadband( task_idx, task_addr, elem );
+        else
+        {
+            nibbles = pfunc->stg_shift + RECPACK_ELSIZEX2( task->task_elems ) * pfunc->stg_cnt;
+            ee_addr = task_addr + ((RECPACK_ELSIZEX2( task->task_elems ) * elem) >> 1);
+            ee_len  = (nibbles + 1) >> 1;               // compensate for the half byte at the end
+
+            // write to the storage
+            DBG_recsave_savedata( task_idx, ee_addr, ee_len, pfunc->stage );
+            eeprom_write( ee_addr, pfunc->stage, ee_len, false );
+            while ( eeprom_is_operation_finished() == false );
+
+            // continue the live graph with the new elements
+            if ( core.readout.live && (core.readout.task_idx == task_idx) && (core.readout.level == 0) )
             {
-                uint16 *rawbuff1;
-                uint16 *rawbuff2;
-                register uint32 val1;
-                register uint32 val2;
+                uint8 stage[CORE_REC_STAGE + 1];        // copy with the decoder reserve
 
-                if ( core.readout.taks_elem == rtt_th )
-                {
-                    rawbuff1 = (uint16*)(workbuff + WB_OFFS_TEMP + disp_ptr);
-                    rawbuff2 = (uint16*)(workbuff + WB_OFFS_RH + disp_ptr);
-                }
-                else if ( core.readout.taks_elem == rtt_tp )
-                {
-                    rawbuff1 = (uint16*)(workbuff + WB_OFFS_TEMP + disp_ptr);
-                    rawbuff2 = (uint16*)(workbuff + WB_OFFS_P + disp_ptr);
-                }
-                else
-                {
-                    rawbuff1 = (uint16*)(workbuff + WB_OFFS_RH + disp_ptr);
-                    rawbuff2 = (uint16*)(workbuff + WB_OFFS_P + disp_ptr);
-                }
+                memcpy( stage, pfunc->stage, CORE_REC_STAGE );
+                recpack_decode( stage, pfunc->stg_shift, res, pfunc->stg_cnt * nch );
+                for ( i=0; i<pfunc->stg_cnt; i++ )
+                    local_recording_graph_extend( task_idx, 0, elem + i, res + i * nch );
+            }
 
-                for ( i=0; i<smp_proc; i++ )
-                {
-                    // get the 12bit value - no shift in this case
-                    val1 = ( ((uint32)(wbuff[0]) << 4) | (wbuff[1] >> 4) ) << 4;        // [tttt tttt][tttt hhhh][hhhh hhhh]
-                    val2 = ( ( ((uint32)(wbuff[1]) << 8) | wbuff[2] ) & 0x0fff) << 4;
-                    wbuff += 3;
-
-                    // check min/max and sum for average
-                    if ( core.readout.v1min > val1 )
-                        core.readout.v1min = val1;
-                    if ( core.readout.v1max < val1 )
-                        core.readout.v1max = val1;
-                    core.readout.v1ctr++;
-                    core.readout.v1sum += val1;
-
-                    if ( core.readout.v2min > val2 )
-                        core.readout.v2min = val2;
-                    if ( core.readout.v2max < val2 )
-                        core.readout.v2max = val2;
-                    core.readout.v2ctr++;
-                    core.readout.v2sum += val2;
-
-                    // see if should proceed with the next point
-                    dispctr += dispstep;
-                    if ( ((dispctr >> 16) != dispprev) ||
-                         (last && (i==smp_proc-1) && (core.readout.raw_ptr < WB_DISPPOINT)) )
-                    {
-                        dispprev = (dispctr >> 16);
-
-                        val1 = core.readout.v1sum / core.readout.v1ctr;
-                        val2 = core.readout.v2sum / core.readout.v2ctr;
-                        *rawbuff1        = core.readout.v1min;
-                        *(rawbuff1+WB_DISPPOINT)  = core.readout.v1max;
-                        *(rawbuff1+WB_DISPPOINT*2)  = val1;
-
-                        *rawbuff2        = core.readout.v2min;
-                        *(rawbuff2+WB_DISPPOINT)  = core.readout.v2max;
-                        *(rawbuff2+WB_DISPPOINT*2)  = val2;
-
-                        // save the global min/max values
-                        if ( core.readout.v1max_total < core.readout.v1max )
-                            core.readout.v1max_total = core.readout.v1max;
-                        if ( core.readout.v1min_total > core.readout.v1min )
-                            core.readout.v1min_total = core.readout.v1min;
-
-                        if ( core.readout.v2max_total < core.readout.v2max )
-                            core.readout.v2max_total = core.readout.v2max;
-                        if ( core.readout.v2min_total > core.readout.v2min )
-                            core.readout.v2min_total = core.readout.v2min;
-
-                        core.readout.v1min = 0xffff;
-                        core.readout.v1max = 0;
-                        core.readout.v1sum = 0;
-                        core.readout.v1ctr = 0;
-                        core.readout.v2min = 0xffff;
-                        core.readout.v2max = 0;
-                        core.readout.v2sum = 0;
-                        core.readout.v2ctr = 0;
-
-                        rawbuff1++;
-                        rawbuff2++;
-                        core.readout.raw_ptr++;
-                    }
-                }
+            // prepare the buffer for the next aquisition
+            if ( (nibbles & 0x01) && pfunc->w )         // If the last element ends on a half byte - keep it for the next write
+            {
+                pfunc->stage[0] = pfunc->stage[ee_len - 1];
+                pfunc->stg_shift = 1;
             }
-            break;
-        case rtt_thp:
+            else                                        // after wrap arround do not shift
             {
-                uint16 *rawbuff1;
-                uint16 *rawbuff2;
-                uint16 *rawbuff3;
-                register uint32 val1;
-                register uint32 val2;
-                register uint32 val3;
-
-                rawbuff1 = (uint16*)(workbuff + WB_OFFS_TEMP + disp_ptr);
-                rawbuff2 = (uint16*)(workbuff + WB_OFFS_RH + disp_ptr);
-                rawbuff3 = (uint16*)(workbuff + WB_OFFS_P + disp_ptr);
-
-                for ( i=0; i<smp_proc; i++ )
-                {
-                    // get the 12bit value - no shift in this case
-                    if ( shifted )
-                    {                                                               //      0          1          2          3          4
-                        val1 = (( ((uint32)(wbuff[0]) << 8) | wbuff[1] ) & 0x0fff) << 4;   // [xxxx tttt][tttt tttt][hhhh hhhh][hhhh pppp][pppp pppp]
-                        val2 = ( ((uint32)(wbuff[2]) << 4) | (wbuff[3] >> 4) ) << 4;
-                        val3 = (( ((uint32)(wbuff[3]) << 8) | wbuff[4] ) & 0x0fff) << 4;
-                        shifted = 0;
-                        wbuff += 5;
-                    }
-                    else
-                    {
-                        val1 = ( ((uint32)(wbuff[0]) << 4) | (wbuff[1] >> 4) ) << 4;       // [tttt tttt][tttt hhhh][hhhh hhhh][pppp pppp][pppp xxxx]
-                        val2 = (( ((uint32)(wbuff[1]) << 8) | wbuff[2] ) & 0x0fff) << 4;
-                        val3 = ( ((uint32)(wbuff[3]) << 4) | (wbuff[4] >> 4) ) << 4; 
-                        shifted = 1;
-                        wbuff += 4;
-                    }
+                pfunc->stage[0] = 0;
+                pfunc->stg_shift = 0;
+            }
+            memset( pfunc->stage + 1, 0, CORE_REC_STAGE - 1 );
+        }
 
-                    // check min/max and sum for average
-                    if ( core.readout.v1min > val1 )
-                        core.readout.v1min = val1;
-                    if ( core.readout.v1max < val1 )
-                        core.readout.v1max = val1;
-                    core.readout.v1ctr++;
-                    core.readout.v1sum += val1;
-
-                    if ( core.readout.v2min > val2 )
-                        core.readout.v2min = val2;
-                    if ( core.readout.v2max < val2 )
-                        core.readout.v2max = val2;
-                    core.readout.v2ctr++;
-                    core.readout.v2sum += val2;
-
-                    if ( core.readout.v3min > val3 )
-                        core.readout.v3min = val3;
-                    if ( core.readout.v3max < val3 )
-                        core.readout.v3max = val3;
-                    core.readout.v3ctr++;
-                    core.readout.v3sum += val3;
-
-                    // see if should proceed with the next point
-                    dispctr += dispstep;
-                    if ( ((dispctr >> 16) != dispprev) ||
-                         (last && (i==smp_proc-1) && (core.readout.raw_ptr < WB_DISPPOINT)) )
-                    {
-                        dispprev = (dispctr >> 16);
-
-                        val1 = core.readout.v1sum / core.readout.v1ctr;
-                        val2 = core.readout.v2sum / core.readout.v2ctr;
-                        val3 = core.readout.v3sum / core.readout.v3ctr;
-                        *rawbuff1        = core.readout.v1min;
-                        *(rawbuff1+WB_DISPPOINT)  = core.readout.v1max;
-                        *(rawbuff1+WB_DISPPOINT*2)  = val1;
-
-                        *rawbuff2        = core.readout.v2min;
-                        *(rawbuff2+WB_DISPPOINT)  = core.readout.v2max;
-                        *(rawbuff2+WB_DISPPOINT*2)  = val2;
-
-                        *rawbuff3        = core.readout.v3min;
-                        *(rawbuff3+WB_DISPPOINT)  = core.readout.v3max;
-                        *(rawbuff3+WB_DISPPOINT*2)  = val3;
-
-                        // save the global min/max values
-                        if ( core.readout.v1max_total < core.readout.v1max )
-                            core.readout.v1max_total = core.readout.v1max;
-                        if ( core.readout.v1min_total > core.readout.v1min )
-                            core.readout.v1min_total = core.readout.v1min;
-
-                        if ( core.readout.v2max_total < core.readout.v2max )
-                            core.readout.v2max_total = core.readout.v2max;
-                        if ( core.readout.v2min_total > core.readout.v2min )
-                            core.readout.v2min_total = core.readout.v2min;
-
-                        if ( core.readout.v3max_total < core.readout.v3max )
-                            core.readout.v3max_total = core.readout.v3max;
-                        if ( core.readout.v3min_total > core.readout.v3min )
-                            core.readout.v3min_total = core.readout.v3min;
-
-                        core.readout.v1min = 0xffff;
-                        core.readout.v1max = 0;
-                        core.readout.v1sum = 0;
-                        core.readout.v1ctr = 0;
-                        core.readout.v2min = 0xffff;
-                        core.readout.v2max = 0;
-                        core.readout.v2sum = 0;
-                        core.readout.v2ctr = 0;
-                        core.readout.v3min = 0xffff;
-                        core.readout.v3max = 0;
-                        core.readout.v3sum = 0;
-                        core.readout.v3ctr = 0;
-
-                        rawbuff1++;
-                        rawbuff2++;
-                        rawbuff3++;
-                        core.readout.raw_ptr++;
-                    }
-                }
+        // update the summary entries of the groups completed by the written elements
+        internal_recording_get_layout( task->size * CORE_RECMEM_PAGESIZE, task->task_elems, task->deadband, &levels, offs );
+        for ( i = elem + 1; levels && (i <= elem + pfunc->stg_cnt); i++ )
+        {
+            for ( lev = 1; lev <= levels; lev++ )
+            {
+                shift = internal_recording_group_shift( task->deadband, lev );
+                if ( i & ((1 << shift) - 1) )
+                    break;
+                internal_recording_summarize( task_addr, offs, task, lev, (i >> shift) - 1, res );
+                local_recording_graph_extend( task_idx, lev, (i >> shift) - 1, res );
             }
-            break;
+        }
+
+        pfunc->stg_cnt = 0;
+        core.nvrec.dirty = true;
+    }
+
+    if ( pfunc->elem_mask == CORE_ELEM_TO_RECORD )
+        pfunc->elem_mask = 0;                           // accept new elements
+}
+
+static void local_recording_savedata(void)
+{
+    int i;
+
+    // check if NVRAM is free
+    if ( eeprom_is_operation_finished() == false )
+        return;
+
+    // enable and 
+    eeprom_enable( true );
+    if ( eeprom_is_operation_finished() == false )
+        return;
+
+    for (i=0; i<STORAGE_RECTASK; i++)
+    {
+        if ( core.nvrec.func[i].elem_mask == CORE_ELEM_TO_RECORD )      // task has a full staging buffer
+            local_recording_flush( i );
     }
 
-    core.readout.dispctr  = dispctr;
-    core.readout.dispprev = dispprev;
-    core.readout.dispstep = dispstep;
+    core.vstatus.int_op.f.op_recsave = 0;      // everythign is saved
+}
+
+static void local_recording_all_pushdata( enum ESensorSelect sensor, uint32 value )
+{
+    int i;
+    for ( i=0; i<STORAGE_RECTASK; i++ )
+    {
+        if ( core.nvrec.running & (1<<i) )
+            local_recording_pushdata( i, sensor, value );
+    }
+}
+
+
+static void local_recording_task_reset( uint32 task_idx )
+{
+    uint32 wrap;
+    memset( &core.nvrec.func[task_idx], 0, sizeof(struct SRecTaskInternals) );
+
+    // wrap arround pointer is the max. elem. count of the current task
+    wrap = core_op_recording_get_total_samplenr( core.nvrec.task[task_idx].size * CORE_RECMEM_PAGESIZE, core.nvrec.task[task_idx].task_elems,
+                                                 core.nvrec.task[task_idx].deadband );
+
+    core.nvrec.func[task_idx].shedule = CORE_SCHED_NONE;
+    core.nvrec.func[task_idx].wrap = wrap;
+
+    local_recording_cache_drop( task_idx );
+}
+
+static void local_recording_task_stop( uint32 task_idx )
+{
+    // just disable the clock
+    core.nvrec.func[task_idx].shedule = CORE_SCHED_NONE;
+}
+
+static void local_recording_task_start( uint32 task_idx )
+{
+    core.nvrec.func[task_idx].shedule = RTCclock + 2 * core_utils_timeunit2seconds( core.nvrec.task[task_idx].sample_rate );
 }
 
 
@@ -1348,20 +1587,60 @@ uint32 internal_recording_read_calculate_next_step( uint32 length, uint32 *ee_si
 {
     uint32 ee_addr;
 
-    ee_addr = core.readout.task_elsizeX2 * core.readout.to_ptr;
-    if ( ee_addr & 0x01 )
-        core.readout.shifted = 1;
-    else
-        core.readout.shifted = 0;
-    ee_addr = ( ee_addr >> 1 ) + core.readout.task_offs;
-
     // calculate the length to be read - it should be the minimum bw. start_smpl -> wrap point  and  F1/F2 buffer size (256 bytes)
     if ( (core.readout.to_ptr + length) > core.readout.wrap )
         length = core.readout.wrap - core.readout.to_ptr;                   // limit the read length to the wrap point
-    if ( (length * core.readout.task_elsizeX2) > ((WB_FLIPB_SIZE - 1)*2) ) 
-        length = ((WB_FLIPB_SIZE - 1)*2) / core.readout.task_elsizeX2;      // limit the read length to the max flip buffer size with 1 byte reserve
 
-    *ee_size = ((length * core.readout.task_elsizeX2) >> 1) + 1;            // always compensate for the half byte
+    if ( core.readout.agg.dlt.band )
+    {
+        // deadband blocks from the block start ( see core_op_recording_read_request() ) while they follow each other in the
+        // data ring and the largest block after the last start fits in the flip buffer with the decoder reserve
+        uint16 dir[RECDELTA_BLOCK];
+        uint32 maxlen = RECDELTA_BLKMAX( core.readout.agg.dlt.nch );
+        uint32 ushift = core.readout.agg.dlt.ushift;
+        uint32 blocks;
+        uint32 start;
+        uint32 span;
+        uint32 i;
+
+        blocks = (length + RECDELTA_BLOCK - 1) >> RECDELTA_BLKSHIFT;
+        if ( blocks > RECDELTA_BLOCK )
+            blocks = RECDELTA_BLOCK;
+        while ( eeprom_is_operation_finished() == false );
+        eeprom_read( core.readout.task_offs + (core.readout.to_ptr >> RECDELTA_BLKSHIFT) * 2, blocks * 2, (uint8*)dir, false );
+        while ( eeprom_is_operation_finished() == false );
+
+        start = (uint32)dir[0] << ushift;
+        for ( i=1; i<blocks; i++ )
+        {
+            span = (uint32)dir[i] << ushift;
+            if ( (span <= start) || ((span - start + maxlen) > (WB_FLIPB_SIZE - 1)) )
+                break;
+        }
+        span = ((uint32)dir[i-1] << ushift) - start + maxlen;
+        if ( span > (core.readout.ring_size - start) )
+            span = core.readout.ring_size - start;
+        if ( length > (i << RECDELTA_BLKSHIFT) )
+            length = i << RECDELTA_BLKSHIFT;
+
+        core.readout.shifted = 0;
+        ee_addr = core.readout.task_offs + core.readout.ring_offs + start;
+        *ee_size = span + 1;
+    }
+    else
+    {
+        ee_addr = core.readout.task_elsizeX2 * core.readout.to_ptr;
+        if ( ee_addr & 0x01 )
+            core.readout.shifted = 1;
+        else
+            core.readout.shifted = 0;
+        ee_addr = ( ee_addr >> 1 ) + core.readout.task_offs;
+
+        if ( (length * core.readout.task_elsizeX2) > ((WB_FLIPB_SIZE - 1)*2) ) 
+            length = ((WB_FLIPB_SIZE - 1)*2) / core.readout.task_elsizeX2;      // limit the read length to the max flip buffer size with 1 byte reserve
+
+        *ee_size = ((length * core.readout.task_elsizeX2) >> 1) + 1;            // always compensate for the half byte
+    }
 
     // save the next read position and decrease the read length
     core.readout.to_process = length;
@@ -1422,11 +1701,17 @@ static inline void local_recording_readout( void )
         else
             finished = true;
 
-        // process the display points
-        if ( core.readout.total_read <= WB_DISPPOINT )
-            internal_recording_read_process_simple( wbuff, smp_proc, shifted );         // points fit to display - no min/max registering, just push them in the raw buffer
-        else
-            internal_recording_read_process_minmaxavg( wbuff, smp_proc, shifted, finished );      // points doesn't fit - min/max should be calculated, 
+        // deadband elements are read from the block start - decode the ones before the requested interval
+        if ( core.readout.skip )
+        {
+            shifted = recdelta_decode( &core.readout.agg.dlt, wbuff, shifted, NULL, core.readout.skip );
+            smp_proc -= core.readout.skip;
+            core.readout.skip = 0;
+        }
+
+        // process the display points - copied if they fit on the display, min/max/avg is calculated for each column otherwise
+        recagg_process( &core.readout.agg, (uint16*)(workbuff + WB_OFFS_RAWDISP), core.readout.taks_elem, core.readout.level,
+                        wbuff, shifted, smp_proc, finished );
 
         internal_DBG_simu_1_cycle();
 
@@ -1669,6 +1954,8 @@ static uint32 internal_sensor_shedule_increment( enum ESensorSelect sensor )
 
     if ( core.vstatus.int_op.f.sens_real_time == sensor )
         return CORE_SCHED_RT;
+    if ( core.vstatus.int_op.f.telemetry )
+        return CORE_SCHED_RT;                                   // telemetry streams every sensor at full rate
 
     // check for monitoring rates on the current sensor
     if ( core.nv.op.op_flags.b.op_monitoring )
@@ -1719,81 +2006,386 @@ static uint32 internal_sensor_shedule_increment( enum ESensorSelect sensor )
         return CORE_SCHED_2SEC;     // 2sec / read                - used for 5sec updates
 }
 
+// slot of a sensor read with the given increment after 'clock' - 'shed' is the current slot, kept for an unknown increment
+static uint32 internal_sensor_shedule_slot( uint32 incval, uint32 clock, uint32 shed )
+{
+    if ( incval == 0 )      // no increment should be done, disable sheduling
+        return CORE_SCHED_NONE;
+
+    clock += incval;
+    switch ( incval )
+    {
+        case CORE_SCHED_RT:     return (clock & CORE_SCHED_RT_MASK);
+        case CORE_SCHED_2SEC:   return (clock & CORE_SCHED_2SEC_MASK);
+        case CORE_SCHED_4SEC:   return (clock & CORE_SCHED_4SEC_MASK);
+        case CORE_SCHED_8SEC:   return (clock & CORE_SCHED_8SEC_MASK);
+        case CORE_SCHED_1MIN:   return (clock & CORE_SCHED_1MIN_MASK);
+    }
+    return shed;
+}
+
 static void internal_sensor_shedule_setval( uint32 incval, uint32 *pshed )
 {
-    uint32 shed = *pshed;
+    *pshed = internal_sensor_shedule_slot( incval, RTCclock, *pshed );
+}
 
-    if ( incval == 0 )      // no increment should be done, disable sheduling
+static uint32 *local_sensor_schedule_slot( enum ESensorSelect sensor )
+{
+    switch ( sensor )
+    {
+        case ss_thermo:     return &core.nv.op.sched.sch_thermo;
+        case ss_rh:         return &core.nv.op.sched.sch_hygro;
+        default:            return &core.nv.op.sched.sch_press;
+    }
+}
+
+// Telemetry - the core_bsy phases of a sensor read are timed and sent with the results in one frame ( see telemetry.h )
+// A read starts at the acquire and ends when its results are processed and saved in the recordings. A read acquired
+// while the previous one is still saved is merged in it.
+static struct
+{
+    struct STlmSensorRead rd;       // frame of the read in progress
+    uint32  t_acq;                  // timestamp of the acquire
+    uint32  t_last;                 // end of the last phase
+    bool    open;                   // a read is in progress
+} tlmrd;
+
+static void internal_telemetry_phase( uint16 *phase, uint32 from, uint32 to )
+{
+    uint32 val = *phase + (to - from);
+
+    *phase = ( val > 0xffff ) ? 0xffff : (uint16)val;
+}
+
+static void local_telemetry_acquire( uint32 mask )
+{
+    if ( core.vstatus.int_op.f.telemetry == 0 )
+        return;
+
+    telemetry_release();                                        // the sensor I2C needs the DMA channel back
+    if ( tlmrd.open == false )
+    {
+        memset( &tlmrd, 0, sizeof(tlmrd) );
+        tlmrd.open = true;
+        tlmrd.rd.clock = RTCclock;
+        tlmrd.t_acq = telemetry_timestamp();
+        tlmrd.t_last = tlmrd.t_acq;
+        internal_telemetry_phase( &tlmrd.rd.ph_wake, RTCclock << TLM_TICK_SHIFT, tlmrd.t_acq );
+    }
+    tlmrd.rd.sensors |= mask;
+}
+
+static void local_telemetry_ready( uint32 result )
+{
+    uint32 i;
+
+    if ( (core.vstatus.int_op.f.telemetry == 0) || (tlmrd.open == false) )
+        return;
+
+    tlmrd.t_last = telemetry_timestamp();
+    for ( i=0; i<3; i++ )
+    {
+        if ( result & (1 << i) )
+            internal_telemetry_phase( &tlmrd.rd.ph_conv[i], tlmrd.t_acq, tlmrd.t_last );
+    }
+}
+
+static void local_telemetry_mark( void )
+{
+    if ( core.vstatus.int_op.f.telemetry && tlmrd.open )
+        tlmrd.t_last = telemetry_timestamp();
+}
+
+// add the time from the last mark to a phase
+static void local_telemetry_phase( uint16 *phase )
+{
+    uint32 now;
+
+    if ( (core.vstatus.int_op.f.telemetry == 0) || (tlmrd.open == false) )
+        return;
+
+    now = telemetry_timestamp();
+    internal_telemetry_phase( phase, tlmrd.t_last, now );
+    tlmrd.t_last = now;
+}
+
+static void local_telemetry_poll( void )
+{
+    if ( core.vstatus.int_op.f.telemetry == 0 )
+        return;
+
+    if ( tlmrd.open && (core.vstatus.int_op.f.op_sread == 0) && (core.vstatus.int_op.f.op_recsave == 0) )
+    {
+        internal_telemetry_phase( &tlmrd.rd.ph_bsy, tlmrd.rd.clock << TLM_TICK_SHIFT, telemetry_timestamp() );
+        tlmrd.rd.temperature = core.measure.measured.temperature;
+        tlmrd.rd.dewpoint    = core.measure.measured.dewpoint;
+        tlmrd.rd.rh          = core.measure.measured.rh;
+        tlmrd.rd.absh        = core.measure.measured.absh;
+        tlmrd.rd.pressure    = core.measure.measured.pressure;
+        tlmrd.rd.battery     = core.measure.battery;
+        tlmrd.rd.ops         = (uint8)core.nv.op.op_flags.val;
+        if ( HW_Charge_Detect() )
+            tlmrd.rd.pwr |= TLM_PWR_CHARGE;
+        tlmrd.rd.ph_uart     = (uint16)( (telemetry_uart_time() > 0xffff) ? 0xffff : telemetry_uart_time() );
+
+        telemetry_push( TLM_TYPE_SREAD, &tlmrd.rd, sizeof(tlmrd.rd) );
+        tlmrd.open = false;
+    }
+
+    telemetry_poll( core.vstatus.int_op.f.op_sread == 0 );
+}
+
+static inline void local_check_sensor_read_schedules(void)
+{
+    // The sensor periods are powers of 2 in RTC ticks and every slot is aligned on its own period
+    // (see internal_sensor_shedule_setval()), so the slot of a slower consumer falls always on a slot
+    // of the faster ones - monitoring, recording tasks and the real-time view wake the device only
+    // on the grid of the fastest consumer. All the sensors due on the current slot are acquired
+    // together, so they share the same wake-up and the same I2C bus session.
+    uint32 mask = 0;
+    uint32 sensor;
+
+    for ( sensor = ss_thermo; sensor <= ss_pressure; sensor++ )
+    {
+        uint32 *pshed = local_sensor_schedule_slot( (enum ESensorSelect)sensor );
+
+        if ( *pshed <= RTCclock )
+        {
+            mask |= ( 1 << (sensor - 1) );                      // SENSOR_TEMP / SENSOR_RH / SENSOR_PRESS
+            internal_sensor_shedule_setval( internal_sensor_shedule_increment( (enum ESensorSelect)sensor ), pshed );
+        }
+    }
+
+    if ( mask )
+    {
+        local_telemetry_acquire( mask );
+        Sensor_Acquire( mask );
+        core.vstatus.int_op.f.op_sread |= mask;
+    }
+
+    local_check_first_scheduled_op();
+}
+
+
+static void local_sensor_reschedule_all(void)
+{
+    internal_sensor_shedule_setval( internal_sensor_shedule_increment( ss_thermo ), &core.nv.op.sched.sch_thermo );
+    internal_sensor_shedule_setval( internal_sensor_shedule_increment( ss_rh ), &core.nv.op.sched.sch_hygro );
+    internal_sensor_shedule_setval( internal_sensor_shedule_increment( ss_pressure ), &core.nv.op.sched.sch_press );
+
+    local_check_first_scheduled_op();
+}
+
+static void local_monitoring_reschedule(void)
+{
+    core.nv.op.sens_rd.moni.sch_moni_temp  = RTCclock + 2 * core_utils_timeunit2seconds( core.nv.setup.tim_tend_temp );
+    core.nv.op.sens_rd.moni.sch_moni_hygro = RTCclock + 2 * core_utils_timeunit2seconds( core.nv.setup.tim_tend_hygro );
+    core.nv.op.sens_rd.moni.sch_moni_press = RTCclock + 2 * core_utils_timeunit2seconds( core.nv.setup.tim_tend_press );
+    core.nv.op.sens_rd.moni.clk_last_day = RTCclock / DAY_TICKS;
+    core.nv.op.sens_rd.moni.clk_last_week = (RTCclock + DAY_TICKS) / WEEK_TICKS;
+}
+
+
+static void local_nvfast_load_struct(void)
+{
+    core.nf.status.val = BKP_ReadBackupRegister( BKP_DR2 );
+    core.nf.next_schedule = BKP_ReadBackupRegister( BKP_DR3 ) | ((uint32)(BKP_ReadBackupRegister( BKP_DR4 )) << 16);
+
+    core.measure.measured.temperature = BKP_ReadBackupRegister( BKP_DR5 );
+    core.measure.measured.rh = BKP_ReadBackupRegister( BKP_DR6 );
+
+}
+
+// Warm wake-up
+//
+// Only the backup domain survives the power down state ( 10 x 16bit registers ) - the operation structures can not be
+// kept there, and reloading them from FRAM costs more than the sensor read itself. So every second scheduled wake-up
+// reads only the sensors due and parks the raw results in the backup domain, the next full wake-up loads the
+// nonvolatile structures and processes the parked results first, in the order of their read and with the RTC clock
+// of their slot - the same as a full wake-up at that slot would have done it.
+//
+// The full wake-up arms the warm one at power down ( local_warm_arm() ) with the sensors due at the next slot and the
+// distance to the slot after it. The warm wake-up ( core_init() / local_warm_poll() ) reads the sensors, parks the
+// results and sleeps till the slot after. The slot of the parked results is the first schedule of the operation
+// structure saved in FRAM, they are kept till the full wake-up saves its state, so a reset before that replays them
+// again from the same FRAM content.
+#define WARM_BKP_STATE          BKP_DR7         // warm wake-up state - 0 if not armed
+#define WARM_BKP_TEMP           BKP_DR8         // parked temperature - WARM_TEMP_MAX for SENSOR_VAL_MAX
+#define WARM_BKP_RH             BKP_DR9         // parked humidity
+#define WARM_BKP_PRESS          BKP_DR10        // parked pressure bits 0-15
+
+#define WARM_PENDING            0x8000          // results are parked, else the wake-up at next_schedule is armed
+#define WARM_MASK_SHIFT         12              // sensors due - SENSOR_TEMP / SENSOR_RH / SENSOR_PRESS
+#define WARM_PRESS_SHIFT        8               // parked: pressure bits 16-19
+#define WARM_ORDER              0x3f            // parked: read order - 2 bit sensor codes ( enum ESensorSelect ) from bit 0
+#define WARM_DELTA              0xff            // armed: RTC ticks from the warm wake-up to the slot after it
+#define WARM_TEMP_MAX           0xffff
+
+static uint32 local_warm_first_slot( void )
+{
+    uint32 sensor;
+    uint32 first = CORE_SCHED_NONE;
+
+    for ( sensor = ss_thermo; sensor <= ss_pressure; sensor++ )
+    {
+        if ( *local_sensor_schedule_slot( (enum ESensorSelect)sensor ) < first )
+            first = *local_sensor_schedule_slot( (enum ESensorSelect)sensor );
+    }
+    return first;
+}
+
+static uint32 local_warm_arm( void )
+{
+    uint32 t1 = local_warm_first_slot();
+    uint32 t2 = CORE_SCHED_NONE;
+    uint32 mask = 0;
+    uint32 sensor;
+    uint32 next;
+
+    if ( (t1 == CORE_SCHED_NONE) || (t1 != core.nf.next_schedule) || core.vstatus.int_op.f.sens_real_time ||
+         core.vstatus.int_op.f.telemetry ||
+         (core.nv.op.op_flags.b.op_recording && (core.vstatus.int_op.f.nv_rec_initted == 0)) )
+        return 0;
+
+    // sensors due at the armed slot and the first slot after it
+    for ( sensor = ss_thermo; sensor <= ss_pressure; sensor++ )
+    {
+        next = *local_sensor_schedule_slot( (enum ESensorSelect)sensor );
+        if ( next == t1 )
+        {
+            mask |= ( 1 << (sensor - 1) );
+            next = internal_sensor_shedule_slot( internal_sensor_shedule_increment( (enum ESensorSelect)sensor ), t1, next );
+        }
+        if ( next < t2 )
+            t2 = next;
+    }
+
+    if ( (t2 <= t1) || ((t2 - t1) > WARM_DELTA) )
+        return 0;
+    return (mask << WARM_MASK_SHIFT) | (t2 - t1);
+}
+
+static bool local_warm_check( void )
+{
+    uint32 state = BKP_ReadBackupRegister( WARM_BKP_STATE );
+
+    return ( ((state & WARM_PENDING) == 0) && (state & WARM_DELTA) && (core.nf.next_schedule == RTCclock) );
+}
+
+static void local_warm_poll( void )
+{
+    uint32 state = BKP_ReadBackupRegister( WARM_BKP_STATE );
+    uint32 result;
+    uint32 sensor;
+    uint32 val;
+    uint32 pos;
+
+    if ( core.vstatus.int_op.f.op_sread == 0 )
+    {
+        // start the conversions of the sensors due, the results are parked from here
+        core.nf.next_schedule += (state & WARM_DELTA);
+        state &= ~WARM_DELTA;
+        BKP_WriteBackupRegister( WARM_BKP_STATE, state );
+
+        Sensor_Init();
+        core.vstatus.int_op.f.op_sread = state >> WARM_MASK_SHIFT;
+        Sensor_Acquire( core.vstatus.int_op.f.op_sread );
+        return;
+    }
+
+    result = Sensor_Is_Ready() & core.vstatus.int_op.f.op_sread;
+    if ( result == 0 )
+        return;
+
+    // results of a poll are appended in the processing order of core_poll()
+    for ( pos = 0; state & (0x03 << pos); pos += 2 )
+        ;
+    for ( sensor = ss_thermo; sensor <= ss_pressure; sensor++ )
     {
-        *pshed = CORE_SCHED_NONE;
-        return;
+        if ( (result & (1 << (sensor - 1))) == 0 )
+            continue;
+
+        val = Sensor_Get_Value( 1 << (sensor - 1) );
+        switch ( sensor )
+        {
+            case ss_thermo:     BKP_WriteBackupRegister( WARM_BKP_TEMP, (val > WARM_TEMP_MAX) ? WARM_TEMP_MAX : val ); break;
+            case ss_rh:         BKP_WriteBackupRegister( WARM_BKP_RH, val ); break;
+            default:
+                BKP_WriteBackupRegister( WARM_BKP_PRESS, val & 0xffff );
+                state |= ((val >> 16) & 0x0f) << WARM_PRESS_SHIFT;
+                break;
+        }
+        state |= sensor << pos;
+        pos += 2;
     }
+    core.vstatus.int_op.f.op_sread &= ~result;
 
-    shed = (RTCclock + incval);
-    switch ( incval )
+    if ( core.vstatus.int_op.f.op_sread == 0 )
     {
-        case CORE_SCHED_RT:     *pshed = (shed & CORE_SCHED_RT_MASK); return;
-        case CORE_SCHED_2SEC:   *pshed = (shed & CORE_SCHED_2SEC_MASK); return;
-        case CORE_SCHED_4SEC:   *pshed = (shed & CORE_SCHED_4SEC_MASK); return;
-        case CORE_SCHED_8SEC:   *pshed = (shed & CORE_SCHED_8SEC_MASK); return;
-        case CORE_SCHED_1MIN:   *pshed = (shed & CORE_SCHED_1MIN_MASK); return;
+        // all parked - sleep till the slot after
+        state |= WARM_PENDING;
+        core.vstatus.int_op.f.warm = 0;
+        core.vstatus.int_op.f.core_bsy = 0;
     }
+    BKP_WriteBackupRegister( WARM_BKP_STATE, state );
 }
 
-static inline void local_check_sensor_read_schedules(void)
+static void local_warm_replay( void )
 {
-    if ( core.nv.op.sched.sch_thermo <= RTCclock )
-    {
-        Sensor_Acquire( SENSOR_TEMP );
-        core.vstatus.int_op.f.op_sread |= SENSOR_TEMP; 
-        internal_sensor_shedule_setval( internal_sensor_shedule_increment( ss_thermo ), &core.nv.op.sched.sch_thermo );
-    }
-    if ( core.nv.op.sched.sch_hygro <= RTCclock )
+    uint32 state = BKP_ReadBackupRegister( WARM_BKP_STATE );
+    uint32 clock = RTCclock;
+    uint32 sensor;
+    uint32 val;
+    uint32 pos;
+
+    if ( (state & WARM_PENDING) == 0 )
+        return;
+
+    // run the scheduled operation of the warm wake-up at its slot
+    RTCclock = local_warm_first_slot();
+    if ( RTCclock > clock )
     {
-        Sensor_Acquire( SENSOR_RH );
-        core.vstatus.int_op.f.op_sread |= SENSOR_RH; 
-        internal_sensor_shedule_setval( internal_sensor_shedule_increment( ss_rh ), &core.nv.op.sched.sch_hygro );
+        RTCclock = clock;
+        return;
     }
-    if ( core.nv.op.sched.sch_press <= RTCclock )
+    for ( sensor = ss_thermo; sensor <= ss_pressure; sensor++ )
     {
-        Sensor_Acquire( SENSOR_PRESS );
-        core.vstatus.int_op.f.op_sread |= SENSOR_PRESS; 
-        internal_sensor_shedule_setval( internal_sensor_shedule_increment( ss_pressure ), &core.nv.op.sched.sch_press );
+        if ( state & (1 << (sensor - 1 + WARM_MASK_SHIFT)) )
+            internal_sensor_shedule_setval( internal_sensor_shedule_increment( (enum ESensorSelect)sensor ),
+                                            local_sensor_schedule_slot( (enum ESensorSelect)sensor ) );
     }
-
     local_check_first_scheduled_op();
-}
-
-
-static void local_sensor_reschedule_all(void)
-{
-    internal_sensor_shedule_setval( internal_sensor_shedule_increment( ss_thermo ), &core.nv.op.sched.sch_thermo );
-    internal_sensor_shedule_setval( internal_sensor_shedule_increment( ss_rh ), &core.nv.op.sched.sch_hygro );
-    internal_sensor_shedule_setval( internal_sensor_shedule_increment( ss_pressure ), &core.nv.op.sched.sch_press );
+    if ( core.nv.op.op_flags.b.op_monitoring )
+        local_push_minmax_set_if_needed();
 
-    local_check_first_scheduled_op();
-}
+    for ( pos = 0; pos < 6; pos += 2 )
+    {
+        switch ( (state >> pos) & 0x03 )
+        {
+            case ss_thermo:
+                val = BKP_ReadBackupRegister( WARM_BKP_TEMP );
+                local_process_temp_sensor_result( (val == WARM_TEMP_MAX) ? SENSOR_VAL_MAX : val );
+                break;
+            case ss_rh:
+                local_process_hygro_sensor_result( BKP_ReadBackupRegister( WARM_BKP_RH ) );
+                break;
+            case ss_pressure:
+                local_process_pressure_sensor_result( BKP_ReadBackupRegister( WARM_BKP_PRESS ) |
+                                                      (((state >> WARM_PRESS_SHIFT) & 0x0f) << 16) );
+                break;
+        }
+    }
+    RTCclock = clock;
 
-static void local_monitoring_reschedule(void)
-{
-    core.nv.op.sens_rd.moni.sch_moni_temp  = RTCclock + 2 * core_utils_timeunit2seconds( core.nv.setup.tim_tend_temp );
-    core.nv.op.sens_rd.moni.sch_moni_hygro = RTCclock + 2 * core_utils_timeunit2seconds( core.nv.setup.tim_tend_hygro );
-    core.nv.op.sens_rd.moni.sch_moni_press = RTCclock + 2 * core_utils_timeunit2seconds( core.nv.setup.tim_tend_press );
-    core.nv.op.sens_rd.moni.clk_last_day = RTCclock / DAY_TICKS;
-    core.nv.op.sens_rd.moni.clk_last_week = (RTCclock + DAY_TICKS) / WEEK_TICKS;
+    // staging buffers filled by the replay are written before the sensor reads of this wake-up
+    if ( core.vstatus.int_op.f.op_recsave )
+    {
+        local_recording_savedata();
+        DBG_recsave_close();
+    }
 }
 
 
-static void local_nvfast_load_struct(void)
-{
-    core.nf.status.val = BKP_ReadBackupRegister( BKP_DR2 );
-    core.nf.next_schedule = BKP_ReadBackupRegister( BKP_DR3 ) | ((uint32)(BKP_ReadBackupRegister( BKP_DR4 )) << 16);
-
-    core.measure.measured.temperature = BKP_ReadBackupRegister( BKP_DR5 );
-    core.measure.measured.rh = BKP_ReadBackupRegister( BKP_DR6 );
-
-}
-
 static void local_initialize_core_operation(void)
 {
     memset( &core.nv.op, 0, sizeof(core.nv.op) );
@@ -1810,6 +2402,7 @@ static void local_initialize_recording(void)
 {
     int i;
     memset( &core.nvrec, 0, sizeof(core.nvrec) );
+    memset( &core.grcache, 0, sizeof(core.grcache) );      // the views of the old tasks are not valid
 
     core.nvrec.dirty = true;
     core.nvrec.running = 0;                     // no task in run
@@ -1995,65 +2588,191 @@ void core_beep( enum EBeepSequence beep )
 //     Setup save / load
 //-------------------------------------------------
 
-int core_setup_save( void )
+static uint32 internal_nv_print( const uint8 *buff, uint32 len )
 {
-    uint32 i;
-    uint16  cksum_setup  = 0xABCD;
-    uint16  cksum_op     = 0xABCD;
-    uint8   *buffer;
+    // fingerprint of a block - the structures are 4 byte aligned, with size of 4 byte multiple
+    const uint32 *pw = (const uint32*)buff;
+    uint32 hash = 0x811c9dc5;
 
-    if ( eeprom_enable(true) )
-        return -1;
+    for ( len >>= 2; len; len-- )
+    {
+        hash = (hash ^ *pw++) * 0x01000193;                     // xor, multiply with odd and xorshift are all invertible
+        hash ^= hash >> 15;
+    }
+    return hash;
+}
+
+static uint32 internal_nv_blocks( const uint8 *buff, uint32 len, uint32 idx, uint32 blk, uint32 end, struct SNvCheck *chk )
+{
+    // takes the fingerprints of blocks 'blk' to 'end' of a structure from block index 'idx', updates the byte sum and CRC
+    // returns the mask of the changed blocks
+    uint32 print;
+    uint32 wmask = 0;
+    uint32 size;
 
-    // calculate checksums
-    buffer = (uint8*)&core.nv.setup;
-    for ( i=0; i<sizeof(core.nv.setup); i++ )
-        cksum_setup = cksum_setup + ( (uint16)(buffer[i] << 8) - (uint16)(~buffer[i]) ) + 1;
+    for ( ; blk < end; blk++ )
+    {
+        size = len - blk * EENV_BLOCK;
+        if ( size > EENV_BLOCK )
+            size = EENV_BLOCK;
+        print = internal_nv_print( buff + blk * EENV_BLOCK, size );
+        chk->crc = crc16_update( chk->crc, buff + blk * EENV_BLOCK, size );
+
+        if ( ((eenv.known & (1 << (idx + blk))) == 0) || (eenv.print[idx + blk] != print) )
+            wmask |= (1 << blk);
+        eenv.print[idx + blk] = print;
+    }
+    return wmask;
+}
 
-    buffer = (uint8*)&core.nv.op;
-    for ( i=0; i<sizeof(core.nv.op); i++ )
-        cksum_op = cksum_op + ( (uint16)(buffer[i] << 8) - (uint16)(~buffer[i]) ) + 1;
+static uint32 internal_nv_diff( const uint8 *buff, uint32 len, uint32 idx, struct SNvCheck *chk )
+{
+    // takes the fingerprints of a structure from block index 'idx' and returns the mask of the changed blocks
+    uint32 wmask;
 
-    // wait for enable to be finished
-    while ( eeprom_is_operation_finished() == false );
+    chk->crc = CRC16_INIT;
+    wmask = internal_nv_blocks( buff, len, idx, 0, EENV_BLOCKS( len ), chk );
+    eenv.known |= ( (1 << EENV_BLOCKS( len )) - 1 ) << idx;
+    return wmask;
+}
 
-    // write nonvolatile data
-    buffer = (uint8*)&core.nv.setup;
-    if ( eeprom_write( EEADDR_SETUP, buffer, sizeof(core.nv.setup), true ) != sizeof(core.nv.setup) )
-        return -1;
-    while ( eeprom_is_operation_finished() == false );
+static int internal_nv_load( uint32 ee_addr, uint8 *buff, uint32 len, uint32 idx, struct SNvCheck *chk )
+{
+    // reads a structure in chunks of EENV_RDCHUNK blocks - a chunk is checked while the next one is read
+    uint32 nblk = EENV_BLOCKS( len );
+    uint32 prev = 0;
+    uint32 blk = 0;
+    uint32 end;
+    uint32 size;
+
+    chk->crc = CRC16_INIT;
+    while ( blk < nblk )
+    {
+        end = blk + EENV_RDCHUNK;
+        if ( end > nblk )
+            end = nblk;
+        size = ( (end * EENV_BLOCK < len) ? (end * EENV_BLOCK) : len ) - blk * EENV_BLOCK;
+        if ( eeprom_read( ee_addr + blk * EENV_BLOCK, size, buff + blk * EENV_BLOCK, true ) != size )
+            return -1;
+
+        internal_nv_blocks( buff, len, idx, prev, blk, chk );
+        while ( eeprom_is_operation_finished() == false );
+        prev = blk;
+        blk = end;
+    }
+    internal_nv_blocks( buff, len, idx, prev, nblk, chk );
+    eenv.known |= ( (1 << nblk) - 1 ) << idx;
+    return 0;
+}
+
+static int internal_nv_write( uint32 ee_addr, const uint8 *buff, uint32 len, uint32 wmask )
+{
+    // writes the blocks selected by wmask in increasing order - consecutive blocks go in one write
+    uint32 blk = 0;
+    uint32 first;
+    uint32 end;
+
+    while ( wmask >> blk )
+    {
+        if ( (wmask & (1 << blk)) == 0 )
+        {
+            blk++;
+            continue;
+        }
+        first = blk;
+        while ( wmask & (1 << blk) )
+            blk++;
+
+        end = blk * EENV_BLOCK;
+        if ( end > len )
+            end = len;
+        if ( eeprom_write( ee_addr + first * EENV_BLOCK, buff + first * EENV_BLOCK, end - first * EENV_BLOCK, true ) != (end - first * EENV_BLOCK) )
+            return -1;
+        while ( eeprom_is_operation_finished() == false );
+    }
+    return 0;
+}
+
+int core_setup_save( void )
+{
+    struct SNvCheck chk;
+    uint32  i;
+    uint32  wmask;
+    uint16  cksum;
 
-    buffer = (uint8*)&core.nv.op;
-    if ( eeprom_write( EEADDR_OPS, buffer, sizeof(core.nv.op), true ) != sizeof(core.nv.op) )
+    if ( eeprom_enable(true) )
         return -1;
+
+    // wait for enable to be finished
     while ( eeprom_is_operation_finished() == false );
 
-    // write checksums
-    if ( eeprom_write( EEADDR_CK_SETUP, (uint8*)&cksum_setup, 2, false ) != 2 )
-        return -1;
-    if ( eeprom_write( EEADDR_CK_OPS, (uint8*)&cksum_op, 2, false ) != 2 )
-        return -1;
+    // write the changed blocks of setup and operation in place, the checksum only if the structure changed
+    wmask = internal_nv_diff( (uint8*)&core.nv.setup, sizeof(core.nv.setup), 0, &chk );
+    if ( wmask )
+    {
+        cksum = chk.crc;
+        if ( internal_nv_write( EEADDR_SETUP, (uint8*)&core.nv.setup, sizeof(core.nv.setup), wmask ) ||
+             (eeprom_write( EEADDR_CK_SETUP, (uint8*)&cksum, 2, false ) != 2) )
+            goto _error_exit;
+    }
+
+    wmask = internal_nv_diff( (uint8*)&core.nv.op, sizeof(core.nv.op), EENV_IDX_OPS, &chk );
+    if ( wmask )
+    {
+        cksum = chk.crc;
+        if ( internal_nv_write( EEADDR_OPS, (uint8*)&core.nv.op, sizeof(core.nv.op), wmask ) ||
+             (eeprom_write( EEADDR_CK_OPS, (uint8*)&cksum, 2, false ) != 2) )
+            goto _error_exit;
+    }
 
     if ( core.nvrec.dirty )
     {
+        uint32 slots = 1;
+        uint32 prev;
+
+        // Power loss safe commit: the record goes to the older slot, the last valid one is untouched till
+        // the new one and its checksum are not written. A freshly initted record is written in both slots.
+        // The older slot holds the commit before the newer one, so only the blocks changed by the last commit
+        // ( nvrec.wmask ) and the ones changed since are written. The first block with the commit counter is
+        // written first - an interrupted commit is always seen as the newer, corrupted one at load.
+        if ( core.nvrec.seq == 0 )
+            slots = 2;
+        prev = ( eenv.rec_history && (slots == 1) ) ? (core.nvrec.wmask & EENV_REC_ALL) : EENV_REC_ALL;
+        core.nvrec.seq++;
         core.nvrec.dirty = false;
 
-        cksum_setup = 0xABCD;
-        buffer = (uint8*)&core.nvrec;
-        for ( i=0; i<sizeof(core.nvrec); i++ )
-            cksum_setup = cksum_setup + ( (uint16)(buffer[i] << 8) - (uint16)(~buffer[i]) ) + 1;
+        wmask = internal_nv_diff( (uint8*)&core.nvrec, sizeof(core.nvrec), EENV_IDX_REC, &chk ) | 0x01;
+        core.nvrec.wmask = EENV_REC_VALID | ( (slots == 1) ? wmask : EENV_REC_ALL );
+        wmask |= prev;
 
-        if ( eeprom_write( EEADDR_RECORD, buffer, sizeof(core.nvrec), true ) != sizeof(core.nvrec) )
-            return -1;
-        while ( eeprom_is_operation_finished() == false );
+        // the first block changed with the mask - the CRC is taken again
+        eenv.print[EENV_IDX_REC] = internal_nv_print( (uint8*)&core.nvrec, EENV_BLOCK );
+        cksum = crc16_update( CRC16_INIT, (uint8*)&core.nvrec, sizeof(core.nvrec) );
 
-        if ( eeprom_write( EEADDR_CK_REC, (uint8*)&cksum_setup, 2, false ) != 2 )
-            return -1;
+        for ( i=0; i<slots; i++ )
+        {
+            uint32 slot = (core.nvrec.seq + i) & 0x01;
+            uint16 invalid = ~cksum;
+
+            // invalidate the slot first - a slot with mixed old and new blocks must not pass with its old
+            // checksum after an interrupted commit
+            if ( (eeprom_write( EEADDR_CK_REC + slot * 2, (uint8*)&invalid, 2, false ) != 2) ||
+                 internal_nv_write( EEADDR_RECORD + slot * sizeof(core.nvrec), (uint8*)&core.nvrec, sizeof(core.nvrec), wmask ) ||
+                 (eeprom_write( EEADDR_CK_REC + slot * 2, (uint8*)&cksum, 2, false ) != 2) )
+                goto _error_exit;
+        }
+        eenv.rec_history = true;
     }
 
     // disable eeprom
     eeprom_disable();
     return 0;
+
+_error_exit:
+    // FRAM content is not known - the next save writes everything
+    eenv.known = 0;
+    eenv.rec_history = false;
+    return -1;
 }
 
 
@@ -2101,82 +2820,78 @@ int core_setup_reset( bool save )
 
 int core_nvrecording_load( void )
 {
-    uint32  i;
-    uint16  cksum;
+    struct SNvCheck chk;
+    uint32  slot;
+    uint32  tries;
     uint16  cksum_op;
+    uint16  seq[2];
     uint8   *buffer;
 
     if ( eeprom_enable(false) )
         return -1;
     while ( eeprom_is_operation_finished() == false );
 
+    // get the commit counters from both slots - try the newer one first
+    for ( slot=0; slot<2; slot++ )
+    {
+        if ( eeprom_read( EEADDR_RECORD + slot * sizeof(core.nvrec) + offsetof(struct SCoreNonVolatileRec, seq), 2, (uint8*)&seq[slot], false ) != 2 )
+            return -1;
+        while ( eeprom_is_operation_finished() == false );
+    }
+    slot = ( (int16)(seq[1] - seq[0]) > 0 ) ? 1 : 0;
+
+    // if the newer one is corrupted (power loss at write) - the older one is used
     buffer = (uint8*)&core.nvrec;
-    if ( eeprom_read( EEADDR_RECORD, sizeof(core.nvrec), buffer, true ) != sizeof(core.nvrec) )
-        return -1;
-    while ( eeprom_is_operation_finished() == false );
-    if ( eeprom_read( EEADDR_CK_REC, 2, (uint8*)&cksum_op, false ) != 2 )
-        return -1;
-    while ( eeprom_is_operation_finished() == false );
+    for ( tries=0; tries<2; tries++, slot ^= 0x01 )
+    {
+        if ( internal_nv_load( EEADDR_RECORD + slot * sizeof(core.nvrec), buffer, sizeof(core.nvrec), EENV_IDX_REC, &chk ) )
+            return -1;
+        if ( eeprom_read( EEADDR_CK_REC + slot * 2, 2, (uint8*)&cksum_op, false ) != 2 )
+            return -1;
+        while ( eeprom_is_operation_finished() == false );
 
-    cksum = 0xABCD;
-    for ( i=0; i<sizeof(core.nvrec); i++ )
-        cksum = cksum + ( (uint16)(buffer[i] << 8) - (uint16)(~buffer[i]) ) + 1;
-    if ( cksum != cksum_op )
-        return -2;
+        if ( cksum_op == chk.crc )
+        {
+            // the other slot is the previous commit if the newer one is loaded and their counters follow
+            eenv.rec_history = (tries == 0) && (core.nvrec.wmask & EENV_REC_VALID) &&
+                               ( seq[slot ^ 0x01] == (uint16)(core.nvrec.seq - 1) );
+            core.vstatus.int_op.f.nv_rec_initted = 1;
+            return 0;
+        }
+    }
 
-    core.vstatus.int_op.f.nv_rec_initted = 1;
-    return 0;
+    eenv.known &= ~( EENV_REC_ALL << EENV_IDX_REC );
+    eenv.rec_history = false;
+    return -2;
 }
 
 int core_setup_load( bool no_op_load )
 {
-    uint32  i;
-    uint16  cksum;
+    struct SNvCheck chk;
     uint16  cksum_setup;
     uint16  cksum_op;
-    uint8   *buffer;
 
     if ( eeprom_enable(false) )
         return -1;
 
     // read the setup and checksum
-    buffer = (uint8*)&core.nv.setup;
-    if ( eeprom_read( EEADDR_SETUP, sizeof(core.nv.setup), buffer, true ) != sizeof(core.nv.setup) )
+    if ( internal_nv_load( EEADDR_SETUP, (uint8*)&core.nv.setup, sizeof(core.nv.setup), 0, &chk ) )
         return -1;
-    while ( eeprom_is_operation_finished() == false );
     if ( eeprom_read( EEADDR_CK_SETUP, 2, (uint8*)&cksum_setup, false ) != 2 )
         return -1;
     while ( eeprom_is_operation_finished() == false );
+    if ( cksum_setup != chk.crc )
+        goto _error_exit;
 
     // read the ops if needed
     if ( no_op_load == false )
     {
-        buffer = (uint8*)&core.nv.op;
-        if ( eeprom_read( EEADDR_OPS, sizeof(core.nv.op), buffer, true ) != sizeof(core.nv.op) )
+        if ( internal_nv_load( EEADDR_OPS, (uint8*)&core.nv.op, sizeof(core.nv.op), EENV_IDX_OPS, &chk ) )
             return -1;
-    }
-
-    // check the setup checksum till op is read
-    buffer = (uint8*)&core.nv.setup;
-    cksum = 0xABCD;
-    for ( i=0; i<sizeof(core.nv.setup); i++ )
-        cksum = cksum + ( (uint16)(buffer[i] << 8) - (uint16)(~buffer[i]) ) + 1;
-    if ( cksum != cksum_setup )
-        goto _error_exit;
-    while ( eeprom_is_operation_finished() == false );
-
-    // op read is finished - check the cksum for this also
-    if ( no_op_load == false )
-    {
         if ( eeprom_read( EEADDR_CK_OPS, 2, (uint8*)&cksum_op, false ) != 2 )
             return -1;
         while ( eeprom_is_operation_finished() == false );
-
-        buffer = (uint8*)&core.nv.op;
-        cksum = 0xABCD;
-        for ( i=0; i<sizeof(struct SCoreOperation); i++ )
-            cksum = cksum + ( (uint16)(buffer[i] << 8) - (uint16)(~buffer[i]) ) + 1;
-        if ( cksum != cksum_op )
+        if ( cksum_op != chk.crc )
             goto _error_exit;
     }
 
@@ -2195,6 +2910,8 @@ _error_exit:
     // eeprom data corrupted or not initialized
     while ( eeprom_is_operation_finished() == false );
 
+    eenv.known = 0;
+    eenv.rec_history = false;
     core_setup_reset( true );
     eeprom_disable();
     return -1;
@@ -2218,6 +2935,10 @@ void core_nvfast_save_struct(void)
         core.nv.dirty = false;
         core_setup_save();
     }
+
+    // the state is saved - the parked results are processed, arm the next slot for a warm wake-up
+    if ( core.vstatus.int_op.f.nv_initted )
+        BKP_WriteBackupRegister( WARM_BKP_STATE, local_warm_arm() );
 }
 
 
@@ -2233,6 +2954,28 @@ void core_op_realtime_sensor_select( enum ESensorSelect sensor )
 }
 
 
+void core_op_telemetry_switch( bool enable )
+{
+    if ( enable == (bool)core.vstatus.int_op.f.telemetry )
+        return;
+
+    if ( enable )
+    {
+        memset( &tlmrd, 0, sizeof(tlmrd) );
+        telemetry_start( RTCclock );
+        core.vstatus.int_op.f.telemetry = 1;
+    }
+    else
+    {
+        core.vstatus.int_op.f.telemetry = 0;
+        telemetry_stop();
+    }
+
+    // reshedule the sensor reads
+    local_sensor_reschedule_all();
+}
+
+
 void core_op_monitoring_switch( bool enable )
 {
     if ( enable == false )
@@ -2554,31 +3297,13 @@ void core_op_recording_task_run( uint32 task_idx, bool run )
     }
 }
 
-uint32 core_op_recording_get_total_samplenr( uint32 mem_len, enum ERecordingTaskType rectype )
+uint32 core_op_recording_get_total_samplenr( uint32 mem_len, enum ERecordingTaskType rectype, uint32 deadband )
 {
-    uint32 factor = 0;
-    switch ( rectype )
-    {
-        case rtt_t:
-        case rtt_h:
-        case rtt_p:
-            factor = 3;       // 1.5 byte  - 1x 12bit
-            break;
-        case rtt_th:
-        case rtt_hp:
-        case rtt_tp:
-            factor = 6;       // 3 bytes   - 2x 12bit
-            break;
-        case rtt_thp:
-            factor = 9;       // 4.5 bytes - 3x 12bit
-            break;
-    }
+    uint32 levels;
 
-    factor = (mem_len * 2) / factor;
-    if ( factor > 0xffff )
-        factor = 0xffff;        // do not exceed 16 bit spaces
-
-    return factor;
+    // 3 / 6 / 9 nibbles for 1.5 / 3 / 4.5 byte elements, the summary levels are reserved from the memory also
+    // deadband tasks: the elements of blocks without change - a changing signal gives less, see internal_recording_get_layout()
+    return internal_recording_get_layout( mem_len, rectype, deadband, &levels, NULL );
 }
 
 int core_op_recording_read_request( uint32 task_idx, uint32 smpl_depth, uint32 length )
@@ -2591,6 +3316,8 @@ int core_op_recording_read_request( uint32 task_idx, uint32 smpl_depth, uint32 l
         return -1;
     if ( core.vstatus.int_op.f.op_recread )                         // if read in progress - do not allow a new one
         return -2;
+    if ( local_recording_cache_request( task_idx, smpl_depth, length ) )   // view displayed lately - no need to read it
+        return 0;
 
     core.vstatus.int_op.f.graph_ok = 0;                             // data is being processed - clear the graph ok flag
 
@@ -2601,10 +3328,21 @@ int core_op_recording_read_request( uint32 task_idx, uint32 smpl_depth, uint32 l
         uint32 ee_size;
         uint32 start_smpl;
 
-        // enable eeprom
+        // write the staged elements first, then enable eeprom for read
+        if ( pfunc->stg_cnt )
+        {
+            eeprom_enable(true);
+            while ( eeprom_is_operation_finished() == false );
+            local_recording_flush( task_idx );
+        }
         eeprom_enable(false);
 
         memset( &core.readout, 0, sizeof(core.readout) );
+        core.readout.task_idx = task_idx;
+        core.readout.live = (smpl_depth == length);                 // the graph ends with the newest element
+        core.readout.req_depth = smpl_depth;
+        core.readout.req_length = length;
+        core.measure.dirty.b.upd_rec_graph = 0;
 
         // find out the start pointer
         if ( pfunc->w >= smpl_depth )
@@ -2616,37 +3354,64 @@ int core_op_recording_read_request( uint32 task_idx, uint32 smpl_depth, uint32 l
         core.readout.task_offs = EEADDR_STORAGE + (uint32)core.nvrec.task[task_idx].mempage * CORE_RECMEM_PAGESIZE; // save the Task memory offset
         core.readout.taks_elem = core.nvrec.task[task_idx].task_elems;                                              // save the task elem type
         core.readout.last_timestamp = pfunc->last_timestamp;                                                        // save the timestamp
-        core.readout.total_read = length;                                                                           // how many samples should be read in total
-        core.readout.to_read = length; 
         core.readout.wrap = pfunc->wrap;
         core.readout.to_ptr = start_smpl;
-        switch ( core.readout.taks_elem )
+        core.readout.task_elsizeX2 = RECPACK_ELSIZEX2( core.readout.taks_elem );
+
+        // use the coarsest summary level which still gives more entries than display points
+        // only the groups entirely in the requested interval are read - the dropped part is less than a display point
         {
-            case rtt_t:
-            case rtt_h:
-            case rtt_p: core.readout.task_elsizeX2 = 3; break;
-            case rtt_th:
-            case rtt_tp:
-            case rtt_hp: core.readout.task_elsizeX2 = 6; break;
-            default:     core.readout.task_elsizeX2 = 9; break;
+            uint32 offs[CORE_REC_SUMLEVELS + 1];
+            uint32 level;
+            uint32 shift = 0;
+            uint32 first = 0;
+            uint32 count = 0;
+
+            internal_recording_get_layout( core.nvrec.task[task_idx].size * CORE_RECMEM_PAGESIZE, core.readout.taks_elem, core.nvrec.task[task_idx].deadband, &level, offs );
+            while ( level )
+            {
+                shift = internal_recording_group_shift( core.nvrec.task[task_idx].deadband, level );
+                first = (start_smpl + (1 << shift) - 1) >> shift;           // first and last+1 entry of the interval
+                count = (start_smpl + length) >> shift;
+                if ( count > (first + WB_DISPPOINT) )
+                    break;
+                level--;
+            }
+
+            if ( level )
+            {
+                core.readout.level = level;
+                core.readout.task_offs += offs[level];
+                core.readout.task_elsizeX2 *= 3;
+                core.readout.wrap = pfunc->wrap >> shift;
+                if ( first >= core.readout.wrap )
+                    first -= core.readout.wrap;
+                core.readout.to_ptr = first;
+                length = count - first;
+            }
         }
 
-        core.readout.v1min = 0xffff;
-        core.readout.v2min = 0xffff;
-        core.readout.v3min = 0xffff;
+        core.readout.total_read = length;                                                                           // how many points should be read in total
+        core.readout.to_read = length; 
 
-        core.readout.v1min_total = 0xffff;
-        core.readout.v2min_total = 0xffff;
-        core.readout.v3min_total = 0xffff;
+        recagg_start( &core.readout.agg, WB_DISPPOINT, length );
 
-        if ( length > WB_DISPPOINT )
+        if ( (core.readout.level == 0) && core.nvrec.task[task_idx].deadband )
         {
-            // case when there are more elements than display points
-            core.readout.dispstep = (WB_DISPPOINT << 16) / length;
+            // deadband elements are decoded from the block start - the elements before the requested one are skipped
+            uint32 ring_offs;
+
+            core.readout.ring_size = internal_recording_get_ring( &core.nvrec.task[task_idx], &ring_offs );
+            core.readout.ring_offs = ring_offs;
+            core.readout.skip = core.readout.to_ptr & (RECDELTA_BLOCK - 1);
+            core.readout.to_ptr -= core.readout.skip;
+            core.readout.to_read += core.readout.skip;
+            recdelta_start( &core.readout.agg.dlt, RECPACK_CHANNELS( core.readout.taks_elem ), core.nvrec.task[task_idx].deadband,
+                            RECDELTA_USHIFT( core.nvrec.task[task_idx].size * CORE_RECMEM_PAGESIZE ), core.readout.to_ptr );
         }
 
         // calculate the memory address and size and advance the read pointers
-        ee_addr = internal_recording_read_calculate_next_step( length, &ee_size );
+        ee_addr = internal_recording_read_calculate_next_step( core.readout.to_read, &ee_size );
         DBG_recording_01_header( &core.readout, &core.nvrec.task[task_idx], &core.nvrec.func[task_idx], ee_addr, ee_size, (uint32)(workbuff + WB_OFFS_FLIP1) );
         dbg_readlenght = ee_size;
 
@@ -2665,6 +3430,8 @@ int core_op_recording_read_request( uint32 task_idx, uint32 smpl_depth, uint32 l
 
 void core_op_recording_read_cancel(void)
 {
+    core.readout.live = 0;                          // graph is not displayed anymore - stop extending it
+
     if ( core.vstatus.int_op.f.op_recread == 0 )
         return;
 
@@ -2902,7 +3669,7 @@ void core_op_recording_dbgfill( uint32 t )
     uint32 elems;
     int val;
     
-    smpl_total = 3 + core_op_recording_get_total_samplenr( core.nvrec.task[t].size * CORE_RECMEM_PAGESIZE, core.nvrec.task[t].task_elems );
+    smpl_total = 3 + core_op_recording_get_total_samplenr( core.nvrec.task[t].size * CORE_RECMEM_PAGESIZE, core.nvrec.task[t].task_elems, core.nvrec.task[t].deadband );
     smpl_day = (24 * 3600) / core_utils_timeunit2seconds( core.nvrec.task[t].sample_rate );
     elems = core.nvrec.task[t].task_elems;
 
@@ -2942,64 +3709,132 @@ void core_op_recording_dbgfill( uint32 t )
 }
 
 
-uint32 core_op_recording_dbgDumpNVRAM(void)
+static void internal_uart_send_pattern( uint8 pattern )
 {
-    temp = 0xAABBCCDD;
-#ifndef ON_QT_PLATFORM
-    int i;
+    HW_UART_SendSingle( pattern );
+    HW_UART_SendSingle( pattern );
+    HW_UART_SendSingle( pattern );
+    HW_UART_SendSingle( pattern );
+}
+
+static void internal_uart_send_nvram( uint32 ee_addr, uint32 ee_len )
+{
+    // Streams an NVRAM area on UART. While one flip buffer is sent by DMA the next block is read in the other one.
+    // NVRAM should be enabled
+    uint8 *buff;
+    uint32 flip = 0;
+    uint32 len;
+
+    while ( ee_len )
+    {
+        len  = ( ee_len > WB_FLIPB_SIZE ) ? WB_FLIPB_SIZE : ee_len;
+        buff = workbuff + ( flip ? WB_OFFS_FLIP2 : WB_OFFS_FLIP1 );
+
+        // this buffer was sent 2 blocks before - the previous send is the one in progress now
+        eeprom_read( ee_addr, len, buff, true );
+        while ( eeprom_is_operation_finished() == false );
+
+        while ( HW_UART_DMA_IsFinished() == false );
+        HW_UART_SendDMA( buff, len );
+
+        ee_addr += len;
+        ee_len  -= len;
+        flip ^= 0x01;
+    }
+
+    while ( HW_UART_DMA_IsFinished() == false );
+}
+
+static void internal_uart_send_closing( void )
+{
+    internal_uart_send_pattern( 0xBB );
+    temp = HW_UART_get_Checksum();
+    HW_UART_SendMulti( (uint8*)(&temp), sizeof(uint32) );
+    internal_uart_send_pattern( 0xFF );
+}
 
-    eeprom_enable( true );
+
+uint32 core_op_recording_dbgDumpNVRAM(void)
+{
+    // stream: { AA,AA,AA,AA } [ 256k NVRAM content ] { BB,BB,BB,BB } [ uint32 checksum ] { FF,FF,FF,FF }
+    // the checksum is the CRC16 of the stream before it ( see crc16.h )
+    telemetry_release();
+    eeprom_enable( false );
 
     HW_UART_Start();
     HW_UART_reset_Checksum();
-
-    HW_UART_SendSingle( 0xAA );
-    HW_UART_SendSingle( 0xAA );
-    HW_UART_SendSingle( 0xAA );
-    HW_UART_SendSingle( 0xAA );
+    internal_uart_send_pattern( 0xAA );
 
     while ( eeprom_is_operation_finished() == false );
+    internal_uart_send_nvram( 0, CORE_RECMEM_PAGESIZE * (CORE_RECMEM_MAXPAGE + 1) );
 
-    for ( i=0; i<256; i++ )
-    {
-        // Read Flip 1
-        eeprom_read( (i*2)*512, 512, (workbuff + WB_OFFS_FLIP1), true );
-
-        // Send Flip 2 (if not the first)
-        if ( i != 0 )
-            HW_UART_SendMulti( (workbuff + WB_OFFS_FLIP2), 512 );
+    internal_uart_send_closing();
+    HW_UART_Stop();
 
-        // Wait for flip1 to be read
-        while ( eeprom_is_operation_finished() == false );
+    eeprom_deepsleep();
+    return temp;
+}
 
-        // Read Flip 2
-        eeprom_read( (i*2+1)*512, 512, (workbuff + WB_OFFS_FLIP2), true );
 
-        // Send Flip 1
-        HW_UART_SendMulti( (workbuff + WB_OFFS_FLIP1), 512 );
+uint32 core_op_recording_export(void)
+{
+    // Stream for the host decoder ( Qsim/parse_recread_dump ):
+    //      { AA,AA,AA,AA } 'R' 'E' 'X' [ CORE_EXPORT_VERSION ] [ uint32 RTC counter ] [ uint16 record size ] [ struct SCoreNonVolatileRec ]
+    //      for every task with elements:
+    //          { 55,55,55 } [ task index ] [ uint32 NVRAM address ] [ uint32 length ] [ element memory of the task ]
+    //                                                                            - directory and data ring of a deadband task
+    //      { BB,BB,BB,BB } [ uint32 checksum ] { FF,FF,FF,FF }                   - CRC16 of the stream before it, see crc16.h
+    // Summary levels are not sent, the host can calculate them from the elements.
+    uint32 i;
+    uint32 ee_addr;
+    uint32 ee_len;
+    uint32 ring_offs;
+    uint16 rec_size = sizeof(core.nvrec);
 
-        // Wait for flip2 to be read
-        while ( eeprom_is_operation_finished() == false );
+    // write the staged elements first - all the elements are in storage after this
+    eeprom_enable( true );
+    while ( eeprom_is_operation_finished() == false );
+    for ( i=0; i<STORAGE_RECTASK; i++ )
+        local_recording_flush( i );
+    eeprom_enable( false );
 
-        // if last loop - send flip 2
-        if ( i == 255 )
-            HW_UART_SendMulti( (workbuff + WB_OFFS_FLIP2), 512 );
-    }
+    telemetry_release();
+    HW_UART_Start();
+    HW_UART_reset_Checksum();
+    internal_uart_send_pattern( 0xAA );
+    HW_UART_SendMulti( (uint8*)"REX", 3 );
+    HW_UART_SendSingle( CORE_EXPORT_VERSION );
+    HW_UART_SendMulti( (uint8*)(&RTCclock), sizeof(uint32) );
+    HW_UART_SendMulti( (uint8*)(&rec_size), sizeof(uint16) );
+    HW_UART_SendMulti( (uint8*)(&core.nvrec), sizeof(core.nvrec) );
 
-    HW_UART_SendSingle( 0xBB );
-    HW_UART_SendSingle( 0xBB );
-    HW_UART_SendSingle( 0xBB );
-    HW_UART_SendSingle( 0xBB );
+    for ( i=0; i<STORAGE_RECTASK; i++ )
+    {
+        if ( (core.nvrec.task[i].size == 0) || (core.nvrec.func[i].c == 0) )
+            continue;
 
-    temp = HW_UART_get_Checksum();
-    HW_UART_SendMulti( (uint8*)(&temp), sizeof(uint32) );
+        ee_addr = EEADDR_STORAGE + (uint32)core.nvrec.task[i].mempage * CORE_RECMEM_PAGESIZE;
+        if ( core.nvrec.task[i].deadband )
+        {
+            ee_len  = internal_recording_get_ring( &core.nvrec.task[i], &ring_offs );
+            ee_len += ring_offs;                                                    // directory and data ring
+        }
+        else
+            ee_len  = ( RECPACK_ELSIZEX2( core.nvrec.task[i].task_elems ) * core.nvrec.func[i].wrap + 1 ) >> 1;
+
+        HW_UART_SendSingle( 0x55 );
+        HW_UART_SendSingle( 0x55 );
+        HW_UART_SendSingle( 0x55 );
+        HW_UART_SendSingle( i );
+        HW_UART_SendMulti( (uint8*)(&ee_addr), sizeof(uint32) );
+        HW_UART_SendMulti( (uint8*)(&ee_len), sizeof(uint32) );
+        internal_uart_send_nvram( ee_addr, ee_len );
+    }
 
-    HW_UART_SendSingle(0xFF);
-    HW_UART_SendSingle(0xFF);
-    HW_UART_SendSingle(0xFF);
-    HW_UART_SendSingle(0xFF);
+    internal_uart_send_closing();
+    HW_UART_Stop();
 
-#endif
+    eeprom_deepsleep();
     return temp;
 }
 
@@ -3021,6 +3856,8 @@ int core_init( struct SCore **instance )
     // get the RTC clock counter in a local copy
     RTCclock = RTC_GetCounter();
     RTCctr = RTCclock;
+    counter = 0;                    // system tick counters start from the power-up (simulators keep them from the previous run)
+    sec_ctr = 0;
 
     // check the wake-up reason
     wur = HW_GetWakeUpReason();
@@ -3058,7 +3895,13 @@ int core_init( struct SCore **instance )
         core.vstatus.ui_cmd |= CORE_UISTATE_CHARGING;             // indicate charging
 
     // get the current RTC counter and check if operation is scheduled
-    if ( (core.nf.next_schedule <= RTCclock) || charge || (wur & (WUR_USR | WUR_FIRST)) )
+    if ( ((wur & (WUR_USR | WUR_FIRST)) == 0) && (charge == false) && local_warm_check() )
+    {
+        // warm wake-up - only the sensors due are read, see local_warm_poll()
+        core.vstatus.int_op.f.warm = 1;
+        core.vstatus.int_op.f.core_bsy = 1;
+    }
+    else if ( (core.nf.next_schedule <= RTCclock) || charge || (wur & (WUR_USR | WUR_FIRST)) )
     {
         // schedule was made on an operation - we need to check out the core.nv with setup and saved status
         // we will fetch nonvolatile data also when charger is connected because it will not go back in power save mode
@@ -3096,7 +3939,7 @@ void core_poll( struct SEventStruct *evmask )
     }
 
     // poll the sensor module
-    if ( core.vstatus.int_op.f.nv_initted )
+    if ( core.vstatus.int_op.f.nv_initted || core.vstatus.int_op.f.warm )
         Sensor_Poll( evmask->timer_tick_system );
  
     // if core module is busy - do the operations
@@ -3133,6 +3976,7 @@ void core_poll( struct SEventStruct *evmask )
                 result = Sensor_Is_Ready();
                 if ( result )
                 {
+                    local_telemetry_ready( result );
                     if ( result & SENSOR_TEMP )
                     {
                         local_process_temp_sensor_result( Sensor_Get_Value(SENSOR_TEMP) );
@@ -3148,6 +3992,7 @@ void core_poll( struct SEventStruct *evmask )
                         local_process_pressure_sensor_result( Sensor_Get_Value(SENSOR_PRESS) );
                         core.vstatus.int_op.f.op_sread &= ~SENSOR_PRESS;
                     }
+                    local_telemetry_phase( &tlmrd.rd.ph_proc );
 
                     if ( (core.vstatus.int_op.f.op_sread == 0) &&
                          (core.vstatus.int_op.f.op_recsave == 0 ) &&
@@ -3161,7 +4006,9 @@ void core_poll( struct SEventStruct *evmask )
 
             if ( core.vstatus.int_op.f.op_recsave )
             {
+                local_telemetry_mark();
                 local_recording_savedata();
+                local_telemetry_phase( &tlmrd.rd.ph_save );
 
                 if ( (core.vstatus.int_op.f.op_recsave == 0 ) &&
                      (core.vstatus.int_op.f.op_recread == 0 )   )
@@ -3189,6 +4036,11 @@ void core_poll( struct SEventStruct *evmask )
             }
 
         }
+        else if ( core.vstatus.int_op.f.warm )
+        {
+            local_warm_poll();
+            break;                                      // break the busy loop
+        }
         else
         {
             // if nonvolatile memory in not initted - do nothing else - must init it first
@@ -3196,6 +4048,8 @@ void core_poll( struct SEventStruct *evmask )
             {
                 if ( core_setup_load( core.vstatus.int_op.f.first_pwrup ) )
                     core.vstatus.ui_cmd |= CORE_UISTATE_EECORRUPTED;
+                else
+                    local_warm_replay();                    // results parked by the warm wake-up before
 
                 core.vstatus.int_op.f.first_pwrup = 0;
                 core.nv.dirty = true;
@@ -3207,7 +4061,7 @@ void core_poll( struct SEventStruct *evmask )
                 // init the sensor module
                 Sensor_Init();
 
-                if ( core.vstatus.int_op.f.sched == 0 )
+                if ( (core.vstatus.int_op.f.sched == 0) && (core.vstatus.int_op.f.op_recsave == 0) )
                     core.vstatus.int_op.f.core_bsy = 0;
 
                 // loop back to execute the first busy operation (if any)
@@ -3217,6 +4071,7 @@ void core_poll( struct SEventStruct *evmask )
         }
     }
 
+    local_telemetry_poll();
     internal_DBG_dump_values();
     
     return;
@@ -3233,11 +4088,11 @@ void core_pwr_setup_alarm( enum EPowerMode pwr_mode )
 
 
 
-uint32 core_pwr_getstate(void)
+static uint32 local_pwr_getstate(void)
 {
     uint32 pwr = SYSSTAT_CORE_STOPPED;
 
-    if ( core.vstatus.int_op.f.nv_initted )
+    if ( core.vstatus.int_op.f.nv_initted || core.vstatus.int_op.f.warm )
         pwr |= Sensor_GetPwrStatus();
 
     if ( core.vstatus.int_op.f.core_bsy )
@@ -3251,6 +4106,20 @@ uint32 core_pwr_getstate(void)
     return pwr;
 }
 
+uint32 core_pwr_getstate(void)
+{
+    uint32 pwr = local_pwr_getstate();
+
+    if ( core.vstatus.int_op.f.telemetry )
+    {
+        // no power down while streaming - the stream state is in RAM. The CPU runs while a frame is sent
+        pwr |= SYSYTAT_CORE_MONITOR | telemetry_pwr();
+        if ( tlmrd.open )
+            tlmrd.rd.pwr |= (uint8)( pwr & PM_MASK );
+    }
+    return pwr;
+}
+
 
 
 
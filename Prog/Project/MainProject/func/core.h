@@ -16,6 +16,7 @@
     #include "typedefs.h"
     #include "events_ui.h"
     #include "hw_stuff.h"
+    #include "recagg.h"
 
     /*
      *
@@ -249,9 +250,16 @@
         uint8   size;               // task size in pages. min 1024 bytes, maximum 252 pages = 258048 bytes - calculated in fn of task_elems
         uint8   task_elems;         // see enum ERecordingTaskType
         uint8   sample_rate;        // see enum EUpdateTimings
+        uint8   deadband;           // 0 - 12bit packed elements, 1..CORE_REC_MAXDEADBAND - deadband coded elements with this max. error in 12bit LSB ( see recdelta.h )
     };
 
     #define CORE_ELEM_TO_RECORD     0xff
+    #define CORE_REC_STAGE          16      // staging buffer of a recording task - 10 / 5 / 3 elements for 1.5 / 3 / 4.5 byte element size
+    #define CORE_REC_SUMLEVELS      2       // max. summary levels kept after the elements of a task - min/max/avg of 16 and 256 elements
+    #define CORE_REC_SUMSHIFT       4       // log2 of the entries summarized in one entry of the next level - deadband tasks start with the groups of 256
+    #define CORE_REC_MAXDEADBAND    15      // max. deadband of a task - 0.47*C / 0.94% / 240Pa
+    #define CORE_GRCACHE_VIEWS      2       // graph views kept for the recording viewer - 2 views of single parameter tasks fit in the workbuffer
+    #define CORE_EXPORT_VERSION     4       // format version of the recording export stream - see core_op_recording_export()
 
     struct SRecTaskInternals
     {   
@@ -268,11 +276,14 @@
         uint32  shedule;            // RTC schedule time for the next read
         uint32  last_timestamp;     // RTC timestamp of the last recorded value
 
-        uint8   elem_shift;         // if the element to be recorded needs to be shifted
-        uint8   element[5];         // temporary elem. buffer - collects data to generate a recording packet
+        uint8   stg_shift;          // staging buffer starts with the last half byte of the data allready in the storage
+        uint8   stg_cnt;            // nr. of complete elements in the staging buffer - counted in w/c, but not written to storage yet
         uint8   elem_mask;          // mask with the acquired data ( temp / rh / pressure ) - must be = with taks[i].task_elems to be able to write
-                                    // to storage
-
+                                    // to storage. CORE_ELEM_TO_RECORD - staging buffer is full, no new element till it is written
+        uint8   stage[CORE_REC_STAGE];  // staging buffer - collects the packed elements to write them to storage in a single operation
+                                        // it is part of the nonvolatile record, so it is saved with it at power down
+                                        // deadband tasks keep the byte offset of stage[0] in its block and the codec state of the
+                                        // first staged element in the last RECDELTA_STATE + 1 bytes
     };
 
     struct SCoreOperation           // core operations in nonvolatile space
@@ -299,6 +310,7 @@
             uint32 upd_pressure:1;         // barometric pressure updated
             uint32 upd_press_minmax:1;     // updated min/max values
             uint32 upd_press_tendency:1;   // updated tendency value set
+            uint32 upd_rec_graph:1;        // recording graph data extended with new elements
         } b;
     };
 
@@ -329,41 +341,34 @@
         uint8   flipbuff;                   // 0 - F1 is in read, F2 - not used yet
                                             // 1 - F2 is in read, F1 - in processing
                                             // 2 - F1 is in read, F2 - in processing
+        uint8   level;                      // 0 - reading elements, N - reading summary entries of level N ( min/max/avg sets )
+        uint8   task_idx;                   // task index of the readout
+        uint8   live;                       // 1 - the graph ends with the newest element, it is extended with the newly saved ones
         uint32  task_offs;                  // NVRAM offset for the task under processing
         uint16  wrap;                       // wrap point
-        uint16  total_read;                 // total points read from memory - it will tell the UI the max samples also (depth)
+        uint16  total_read;                 // total points ( elements or summary entries ) read from memory
         uint32  last_timestamp;             // saved last timestamp - used for UI
 
         uint16  to_read;                    // samples to read in total
-        uint16  to_ptr;                     // pointer from which to read (from start pointer and advancing)
+        uint16  to_ptr;                     // pointer from which to read (from start pointer and advancing) - after the readout
+                                            // it is the next element/entry expected for a live graph
         uint16  to_process;                 // samples to be processed when read is finished
+        uint16  req_depth;                  // the view requested - core_op_recording_read_request() parameters,
+        uint16  req_length;                 // req_length is 0 if the view changed since ( live graph extended )
+        uint8   skip;                       // elements decoded before the first requested one - deadband elements are read from the block start
+        uint16  ring_offs;                  // deadband elements: data ring offset after the block directory and its size in bytes
+        uint32  ring_size;
+
+        struct SRecAgg agg;                 // display column aggregation state - see recagg.h
+    };
 
-        uint16  v1ctr;                      // local min/max values and averaging counters
-        uint16  v2ctr;                      // do not use arrays because of performance issues
-        uint16  v3ctr;
-        uint16  v1max;
-        uint16  v2max;
-        uint16  v3max;
-        uint16  v1min;
-        uint16  v2min;
-        uint16  v3min;
-
-        uint16  v1max_total;                // used for global min/max value storage
-        uint16  v2max_total;
-        uint16  v3max_total;
-        uint16  v1min_total;
-        uint16  v2min_total;
-        uint16  v3min_total;
-
-        uint32  v1sum;
-        uint32  v2sum;
-        uint32  v3sum;
-
-        uint32  dispctr;                    // dipsplay position increment in fp16
-        uint16  dispstep;                   // fractional part of the display step increment
-        uint16  dispprev;                   // integer part of the prev. display counter
-
-        uint16  raw_ptr;                    // pointer in the raw data buffer, incremented after each push
+    struct SCoreGraphCache
+    {
+        uint8   taks_elem;                  // task layout of the cached views - the views with their readout state are kept in the
+                                            // workbuffer cache area ( if the flip buffers leave one ) and the graph memory blocks
+                                            // of the other parameters
+        uint8   stamp;                      // request counter for the LRU replacement
+        uint8   used[CORE_GRCACHE_VIEWS];   // 0 - free, N - request stamp when the view was displayed last
     };
     
 
@@ -395,8 +400,10 @@
     {
         uint16                      dirty;                      // if it is altered and it should be saved.
         uint16                      running;                    // bitfield of running tasks. 1-->4
-        struct SRecTaskInstance     task[STORAGE_RECTASK];      // 16 bytes
-        struct SRecTaskInternals    func[STORAGE_RECTASK];      // 112 bytes
+        struct SRecTaskInstance     task[STORAGE_RECTASK];      // 20 bytes
+        uint16                      seq;                        // commit counter - the structure is saved alternately in 2 slots, the newer valid one is loaded
+        uint16                      wmask;                      // blocks changed by the commit against the other slot - see core_setup_save()
+        struct SRecTaskInternals    func[STORAGE_RECTASK];      // 224 bytes
     };
 
 
@@ -429,10 +436,12 @@
             uint32  nv_initted:1;       // nonvolatile structure content initted
             uint32  nv_state:2;         // state of nonvolatile memory init
             uint32  nv_rec_initted:1;   // set when recording structure initted
+            uint32  warm:1;             // warm wake-up - the sensors due are read without the nonvolatile structures
 
             uint32  graph_ok:1;         // if the raw garph data is available
 
             uint32  sens_real_time:2;   // sensor in real time - see enum ESensorSelect
+            uint32  telemetry:1;        // telemetry stream on UART - see telemetry.h
 
         } f;
         uint32 val;
@@ -457,6 +466,7 @@
 
         struct SCoreMeasure     measure;
         struct SCoreNVreadout   readout;        // readout related parameters/status 
+        struct SCoreGraphCache  grcache;        // graph views displayed lately
     };
 
 
@@ -491,6 +501,8 @@
 
     // the selected sensor will update it's readings in real time
     void core_op_realtime_sensor_select( enum ESensorSelect sensor );
+    // start or stop the telemetry stream on UART - every sensor is read at full rate and sent with its phase timings ( see telemetry.h )
+    void core_op_telemetry_switch( bool enable );
     // enable or disable the monitoring feature. By disabling - all the tendency values will be cleared
     void core_op_monitoring_switch( bool enable );
     // sets the sample timing of the tendency monitoring. This will clear up the tendency graph of the affected sensor
@@ -509,11 +521,11 @@
     // stop and start individual tasks
     void core_op_recording_task_run( uint32 task_idx, bool run );
     // calculates the maximum sample nr which can be held in an amount of memory
-    uint32 core_op_recording_get_total_samplenr( uint32 mem_len, enum ERecordingTaskType rectype );
+    uint32 core_op_recording_get_total_samplenr( uint32 mem_len, enum ERecordingTaskType rectype, uint32 deadband );
     // do a readout and averaging in the temporary buffer. Operation is asynchronous
     // smpl_depth is from the last write, max value is count. lenght is the lenght in samples of the read operation
     int core_op_recording_read_request( uint32 task_idx, uint32 smpl_depth, uint32 lenght );
-    // cancel recording request and cleanup
+    // cancel recording request, stop the live graph updates and cleanup
     void core_op_recording_read_cancel(void);
     // check if read is finished and buffer is ready. Returns a value from 16->0 for progress bar displaying. 0 means finished
     int core_op_recording_read_busy(void);
@@ -526,6 +538,8 @@
     void core_op_recording_dbgfill( uint32 t );
     // debug dump entire NVRAM
     uint32 core_op_recording_dbgDumpNVRAM(void);
+    // export the recording tasks on UART ( task setup and element memory ) for the host decoder
+    uint32 core_op_recording_export(void);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,38 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#include "stm32f10x.h"
+#include "typedefs.h"
+
+
+// CRC16 of the nonvolatile structures and of the UART streams
+//
+// CRC-16/CCITT: polynomial 0x1021, MSB first, initial value CRC16_INIT, no final xor ( "123456789" gives 0x29B1 ).
+// Table driven, one lookup per byte. The CRC is a running value - a buffer can be processed in chunks, in order,
+// with the same result as in one call. So a chunk can be processed while the DMA transfer of the next one is in flight.
+//
+// The CRC unit of the STM32F10x works on 32bit words with a fixed initial value, it can not resume a running value
+// of an interleaved stream - the same code runs on the target and on the host tools.
+
+    #define CRC16_INIT      0xFFFF
+
+    extern const uint16 crc16_table[256];
+
+    // running CRC updated with one byte
+    #define CRC16_BYTE( crc, data )     ( (uint16)( ((crc) << 8) ^ crc16_table[ (((crc) >> 8) ^ (data)) & 0xff ] ) )
+
+    // running CRC updated with 'len' bytes from 'buff'
+    uint16 crc16_update( uint16 crc, const uint8 *buff, uint32 len );
+
+
+#ifdef __cplusplus
+    }
+#endif
+
+
+#endif // CRC16_H
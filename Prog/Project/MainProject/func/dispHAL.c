@@ -55,6 +55,9 @@
  *          starts them up. 
  *          There is no operation queue. DispHAL_Display_On(), DispHAL_SetContrast(), DispHAL_UpdateScreen() are marking flags, that they need to be executed
  *          DispHAL_Display_Off() will cancel any marked operation and powers off the display module.
+ *          The graphic library reports every modified area through DispHAL_NeedUpdate(), these are collected as a column range for each
+ *          display page. A screen update sends only the modified column range of the dirty pages, clean pages are skipped, and if nothing
+ *          was modified no transfer is done at all. Display startup, greyscale fields and greyscale exit still send the complete memory.
  *          As told abowe, SPI bus is acquired and configured at any display operation routine automatically, so any pending operation on it will be 
  *          interrupted. 
  */
@@ -78,6 +81,8 @@ uint8 gflip[660];               // special feature for Hygro project - greyscale
 #define CSPEC_DLY50     0x04
 #define CSPEC_UMEM      0x05                        // this should be the last command in a command sequence
 
+#define DISP_COL_OFFSET 2                           // controller has 132 columns, the 128 pixel panel starts at column 2
+
 // Predefined command list for startup
 #define CMDLIST_SIZE_STARTUP        30              // size of startup sequence command list (included the special commands)
 const uint8 cmdlist_startup[] = {   0xAE,               // Display off
@@ -111,6 +116,23 @@ const uint8 cmdlist_shutdown[] = {  0xAE,               // Display off
 uint8   cmdlist_custom[CMDLIST_SIZE_CUSTOM];
 
 
+// set the column range of all the pages: 0 - last_col, or clean the pages if last_col is negative
+// used also by ISR
+static void disp_internal_span_set( struct SDispSpan *span, int last_col )
+{
+    if ( last_col < 0 )
+    {
+        memset( span->start, 0xFF, sizeof(span->start) );
+        memset( span->end, 0x00, sizeof(span->end) );
+    }
+    else
+    {
+        memset( span->start, 0x00, sizeof(span->start) );
+        memset( span->end, last_col, sizeof(span->end) );
+    }
+}
+
+
 static void disp_spi_take_over( void )
 {
     if ( hal.status.spi_owner )
@@ -166,9 +188,25 @@ volatile uint32 isr_grey_ctr = 0;
 volatile uint32 isr_grey_toflip;
 volatile uint32 isr_grey_tomain;
 
+// !!!! NOTE !!!! this routine is used inside ISR, make sure to protect by interrupt disable if it is called from application !!!!
+// skips the clean pages from gmem_line_start, returns false if there is no page to be sent till gmem_line_end
+static bool disp_isr_internal_seek_page( void )
+{
+    while ( hal.send.gmem_line_start <= hal.send.gmem_line_end )
+    {
+        if ( hal.send.span.start[hal.send.gmem_line_start] <= hal.send.span.end[hal.send.gmem_line_start] )
+            return true;
+        hal.send.gmem_line_start++;
+    }
+    return false;
+}
+
+
 // !!!! NOTE !!!! this routine is used inside ISR, make sure to protect by interrupt disable if it is called from application !!!!
 static void disp_isr_internal_setup_display_page_command( void )
 {
+    uint32 col = hal.send.span.start[hal.send.gmem_line_start] + DISP_COL_OFFSET;
+
     hal.send.cmd_ptr = cmdlist_custom;
     hal.send.cmd_idx = 0;
     hal.send.cmd_len = 5;
@@ -178,8 +216,8 @@ static void disp_isr_internal_setup_display_page_command( void )
     else
         cmdlist_custom[0] = (uint8)(0xB0 + hal.send.gmem_line_start + 2);   // page address for the flip buffer (shifted down by 16 pixels)
     
-    cmdlist_custom[1] = 0x02;                                       // coloumn address low
-    cmdlist_custom[2] = 0x10;                                       // coloumn address hi
+    cmdlist_custom[1] = (uint8)(0x00 + (col & 0x0F));               // coloumn address low
+    cmdlist_custom[2] = (uint8)(0x10 + (col >> 4));                 // coloumn address hi
     cmdlist_custom[3] = 0xFF;                                       // display page line special command
     cmdlist_custom[4] = CSPEC_UMEM;
 }
@@ -188,20 +226,21 @@ static void disp_isr_internal_setup_display_page_command( void )
 // !!!! NOTE !!!! it is used by ISR only, never call it from application !!!!
 static inline void disp_isr_internal_run_update_gmem( void )
 {
+    int col = hal.send.span.start[hal.send.gmem_line_start];
+    int len = hal.send.span.end[hal.send.gmem_line_start] - col + 1;
+
     HW_Chip_Disp_Enable();           // chip select
     HW_Chip_Disp_BusData();          // assert the data signal
 
     if ( isr_grey_on != GREY_FIELD_SEC )
-        HW_DMA_Send( DMACH_DISP, gmem + hal.send.gmem_line_start * GDISP_MAX_MEM_W, GDISP_MAX_MEM_W );
+        HW_DMA_Send( DMACH_DISP, gmem + hal.send.gmem_line_start * GDISP_MAX_MEM_W + col, len );
     else
-        HW_DMA_Send( DMACH_DISP, gflip + hal.send.gmem_line_start * 110, 110 );     // special case for Hygro project
+        HW_DMA_Send( DMACH_DISP, gflip + hal.send.gmem_line_start * 110 + col, len );     // special case for Hygro project
 
-    // create the command list for the next group (if existent)
-    if ( hal.send.gmem_line_start < hal.send.gmem_line_end )
-    {
-        hal.send.gmem_line_start++;
+    // create the command list for the next modified page (if existent)
+    hal.send.gmem_line_start++;
+    if ( disp_isr_internal_seek_page() )
         disp_isr_internal_setup_display_page_command();
-    }
 }
 
 
@@ -322,9 +361,15 @@ void DispHAL_ISR_Poll(void)
             {
                 hal.send.gmem_line_start    = 0;
                 if ( isr_grey_on == GREY_FIELD_SEC )
+                {
                     hal.send.gmem_line_end      = 5;        // display the flip buffer - it has only 6 lines
+                    disp_internal_span_set( &hal.send.span, 109 );
+                }
                 else
+                {
                     hal.send.gmem_line_end      = 7;        // display all the graphic memory
+                    disp_internal_span_set( &hal.send.span, GDISP_MAX_MEM_W - 1 );
+                }
                 disp_isr_internal_setup_display_page_command();
                 disp_isr_internal_run_cmd_sequence( );  // run the command sequence
                 isr_busy = true;
@@ -377,6 +422,7 @@ static int disp_internal_launch_onoff_sequence( bool on )
         hal.send.cmd_len = CMDLIST_SIZE_STARTUP;
         hal.send.gmem_line_start    = 0;
         hal.send.gmem_line_end      = 7;        // display all the graphic memory
+        disp_internal_span_set( &hal.send.span, GDISP_MAX_MEM_W - 1 );
     }
     else
     {
@@ -404,8 +450,17 @@ static int disp_internal_update_gmem( void )
         __enable_interrupt();
         return 1;
     }
+    // take the modified areas
+    hal.send.span = hal.dirty;
+    disp_internal_span_set( &hal.dirty, -1 );
+
     hal.send.gmem_line_start    = 0;
-    hal.send.gmem_line_end      = 7;        // display all the graphic memory
+    hal.send.gmem_line_end      = 7;        // display all the modified pages
+    if ( disp_isr_internal_seek_page() == false )
+    {
+        __enable_interrupt();
+        return 0;                           // nothing was modified - no transfer needed
+    }
     disp_isr_internal_setup_display_page_command();
     disp_isr_internal_run_cmd_sequence( );  // run the command sequence
     isr_busy = true;
@@ -463,6 +518,7 @@ uint32 DispHAL_Init(uint8 *Gmem)
 
     gmem = Gmem;
     hal.contrast = 0x80;
+    disp_internal_span_set( &hal.dirty, -1 );
 
     return 0;
 }
@@ -477,7 +533,39 @@ uint32 DispHAL_UpdateLUT( LUTelem *LUT )
 
 void DispHAL_NeedUpdate(  uint32 X1, uint32 Y1, uint32 X2, uint32 Y2  )
 {
-
+    int x1 = (int)X1;               // coordinates may come negative from the clipped drawing routines
+    int y1 = (int)Y1;
+    int x2 = (int)X2;
+    int y2 = (int)Y2;
+    int tmp;
+    int page;
+
+    if ( x1 > x2 )
+    {
+        tmp = x1; x1 = x2; x2 = tmp;
+    }
+    if ( y1 > y2 )
+    {
+        tmp = y1; y1 = y2; y2 = tmp;
+    }
+    if ( (x2 < 0) || (y2 < 0) || (x1 >= GDISP_WIDTH) || (y1 >= GDISP_HEIGHT) )
+        return;                     // completely outside of the screen
+    if ( x1 < 0 )
+        x1 = 0;
+    if ( y1 < 0 )
+        y1 = 0;
+    if ( x2 >= GDISP_WIDTH )
+        x2 = GDISP_WIDTH - 1;
+    if ( y2 >= GDISP_HEIGHT )
+        y2 = GDISP_HEIGHT - 1;
+
+    for ( page = (y1 >> 3); page <= (y2 >> 3); page++ )
+    {
+        if ( hal.dirty.start[page] > x1 )
+            hal.dirty.start[page] = (uint8)x1;
+        if ( hal.dirty.end[page] < x2 )
+            hal.dirty.end[page] = (uint8)x2;
+    }
 }
 
 
@@ -518,6 +606,7 @@ void DispHal_ClearFlipBuffer( void )
         return;
 
     isr_grey_on = GREY_OFF;
+    disp_internal_span_set( &hal.dirty, GDISP_MAX_MEM_W - 1 );     // display has the greyscale content - redraw all
     hal.status.gmem_dirty = 1;
 }
 
@@ -538,6 +627,7 @@ int DispHAL_Display_On( void )
 
     isr_grey_on = GREY_OFF;
     hal.status.gmem_dirty = 0;
+    disp_internal_span_set( &hal.dirty, -1 );                   // startup sequence sends all the graphic memory
     hal.status.disp_iniprog = 1;                                // initialization in progress
     hal.status.disp_updating = 1;                               // mark this because display content will be updated also
 
@@ -16,7 +16,7 @@
     // update look up table (not used for 1 bit screens )   - not used for the current HAL implementation - but needed for compatibility with graphic library
     uint32 DispHAL_UpdateLUT( LUTelem *LUT );
 
-    // routine for graphic library to tell the HAL about the window it modified - not used for the current HAL implementation - but needed for compatibility with graphic library
+    // routine for graphic library to tell the HAL about the window it modified - only the modified column range of each page is sent at the next update
     void DispHAL_NeedUpdate(  uint32 X1, uint32 Y1, uint32 X2, uint32 Y2  ); 
 
 
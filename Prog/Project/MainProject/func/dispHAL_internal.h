@@ -26,6 +26,14 @@ struct SDispHALstate
 };
 
 
+// modified column range for each display page ( 8 pixel lines ), page is clean if start > end
+struct SDispSpan
+{
+    uint8   start[GDISP_MAX_MEM_H];     // first modified column
+    uint8   end[GDISP_MAX_MEM_H];       // last modified column
+};
+
+
 struct SDispSend
 {
     const uint8 *cmd_ptr;           // command pointer
@@ -33,6 +41,7 @@ struct SDispSend
     int cmd_len;                    // length of the command list
     int gmem_line_start;            // start page of the graphic memory (8 pixel packages vertically)
     int gmem_line_end;              // end page of the graphic memory
+    struct SDispSpan span;          // column range to be sent for each page
     int tmr;                        // if non-zero then timeout is counted before executing the next step
 };
 
@@ -42,6 +51,7 @@ struct SDispHALStruct
 {
     struct SDispHALstate status;
     struct SDispSend     send;
+    struct SDispSpan     dirty;     // column ranges modified by the graphic library since the last transfer
     int                  contrast;  // contrast value ( 0x00 - 0xFE )
 
 };
@@ -0,0 +1,96 @@
+#include "psychro.h"
+
+
+#define PSY_TEMP_FP         9                       // same as TEMP_FP
+#define PSY_TEMP_STEPS      128                     // table entries -1  ( 1*C steps from -40*C )
+#define PSY_RH_100          (100 << 8)              // 100% in 16fp8
+#define PSY_RH_FRAC16       10485                   // (rh16fp8 * PSY_RH_FRAC16) >> 12  -> rh fraction in 0.16 format
+#define PSY_TK_OFFS         119373                  // 233.15 * 512 - 16fp9+40*C to Kelvin
+#define PSY_ABSH_C          27735                   // 100 * 2.16679 * 128 - absolute humidity constant
+
+// saturation vapour pressure in Pa 24fp8 format for -40*C -> +88*C in 1*C steps
+static const uint32 psy_pws_table[ PSY_TEMP_STEPS + 1 ] =
+{
+         4808,      5334,      5913,      6547,      7242,      8002,      8835,      9744,   // -40*C
+        10737,     11821,     13001,     14287,     15687,     17208,     18860,     20653,   // -32*C
+        22598,     24706,     26989,     29458,     32128,     35013,     38127,     41486,   // -24*C
+        45108,     49009,     53209,     57727,     62584,     67802,     73404,     79414,   // -16*C
+        85859,     92764,    100159,    108073,    116538,    125585,    135251,    145570,   // -8*C
+       156581,    168323,    180838,    194169,    208362,    223464,    239524,    256595,   // +0*C
+       274731,    293987,    314423,    336100,    359083,    383436,    409231,    436539,   // +8*C
+       465434,    495995,    528304,    562443,    598501,    636568,    676739,    719111,   // +16*C
+       763785,    810867,    860465,    912692,    967665,   1025504,   1086334,   1150284,   // +24*C
+      1217488,   1288083,   1362214,   1440025,   1521671,   1607307,   1697095,   1791204,   // +32*C
+      1889804,   1993073,   2101194,   2214356,   2332753,   2456585,   2586057,   2721380,   // +40*C
+      2862774,   3010461,   3164671,   3325642,   3493616,   3668843,   3851580,   4042089,   // +48*C
+      4240641,   4447513,   4662990,   4887364,   5120933,   5364004,   5616892,   5879918,   // +56*C
+      6153413,   6437714,   6733167,   7040126,   7358954,   7690021,   8033706,   8390397,   // +64*C
+      8760490,   9144392,   9542516,   9955285,  10383132,  10826498,  11285835,  11761603,   // +72*C
+     12254271,  12764320,  13292239,  13838526,  14403692,  14988255,  15592744,  16217699,   // +80*C
+     16863670,   // +88*C
+};
+
+
+uint32 psychro_vapour_pressure( uint32 temp, uint32 rh )
+{
+    uint32 idx;
+    uint32 pws;
+
+    if ( temp > 0xffff )
+        temp = 0xffff;
+    if ( rh > PSY_RH_100 )
+        rh = PSY_RH_100;
+
+    // saturation vapour pressure - interpolate between the 1*C entries
+    idx = temp >> PSY_TEMP_FP;
+    pws = psy_pws_table[idx] + (( (psy_pws_table[idx+1] - psy_pws_table[idx]) * (temp & ((1<<PSY_TEMP_FP)-1)) ) >> PSY_TEMP_FP);
+
+    // Pw = Pws * rh
+    rh = (rh * PSY_RH_FRAC16) >> 12;
+    return (uint32)( ((uint64)pws * rh) >> 16 );
+}
+
+
+uint32 psychro_abs_humidity( uint32 temp, uint32 rh )
+{
+    //  A = C * Pw/T   - numerator and denominator are halved to fit in 32bit
+    uint32 pw;
+    uint32 num;
+    uint32 den;
+
+    pw  = psychro_vapour_pressure( temp, rh );
+    num = (uint32)( ((uint64)pw * PSY_ABSH_C) >> 7 );
+    den = (temp + PSY_TK_OFFS) >> 1;
+
+    return (num + den / 2) / den;
+}
+
+
+uint32 psychro_dewpoint( uint32 temp, uint32 rh )
+{
+    // the temperature where Pws = Pw - search in the table and interpolate
+    uint32 pw;
+    uint32 lo;
+    uint32 hi;
+    uint32 dew;
+
+    pw = psychro_vapour_pressure( temp, rh );
+    if ( pw <= psy_pws_table[0] )
+        return 0;
+
+    lo = 0;
+    hi = PSY_TEMP_STEPS;
+    while ( (hi - lo) > 1 )
+    {
+        uint32 mid = (lo + hi) >> 1;
+        if ( psy_pws_table[mid] > pw )
+            hi = mid;
+        else
+            lo = mid;
+    }
+
+    dew = (lo << PSY_TEMP_FP) + ( ((pw - psy_pws_table[lo]) << PSY_TEMP_FP) / (psy_pws_table[hi] - psy_pws_table[lo]) );
+    if ( dew > 0xffff )
+        dew = 0xffff;
+    return dew;
+}
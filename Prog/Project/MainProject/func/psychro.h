@@ -0,0 +1,34 @@
+#ifndef PSYCHRO_H
+#define PSYCHRO_H
+
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#include "stm32f10x.h"
+#include "typedefs.h"
+
+
+// Fixed point psychrometric calculations
+// Saturation vapour pressure is taken from a table with 1*C steps for the whole
+// 16fp9+40*C temperature range (-40*C -> +88*C) and linearly interpolated.
+// Table is generated with the Magnus formula - the same constants as used before:
+//      Pws = 6.116441 * 10^( 7.591386 * T / (T + 240.7263) )  [hPa]
+
+// partial water vapour pressure in Pa, 24fp8 format. temp: 16fp9+40*C, rh: 16fp8 %
+uint32 psychro_vapour_pressure( uint32 temp, uint32 rh );
+
+// absolute humidity in g/m3 x100. temp: 16fp9+40*C, rh: 16fp8 %
+uint32 psychro_abs_humidity( uint32 temp, uint32 rh );
+
+// dew point in 16fp9+40*C format, limited to -40*C. temp: 16fp9+40*C, rh: 16fp8 %
+uint32 psychro_dewpoint( uint32 temp, uint32 rh );
+
+
+#ifdef __cplusplus
+    }
+#endif
+
+
+#endif // PSYCHRO_H
@@ -0,0 +1,229 @@
+#include <string.h>
+
+#include "recagg.h"
+#include "recpack.h"
+
+
+// kernel signature - out[] points to the current position of the channel's arrays in packed order
+typedef uint32 (*recagg_kernel)( struct SRecAgg *agg, uint16 **out, const uint8 *buff, uint32 nibble, uint32 count, bool last );
+
+
+// Min / max / avg template: NCH channels / sample, K values / channel ( 1 - element, 3 - min/max/avg summary entry )
+// For elements the min, max and avg offsets ( 0, K>>1, K-1 ) point to the same value.
+// out[] points to the min arrays, the max and avg arrays follow with agg->cols
+#define RECAGG_MINMAXAVG( name, NCH, K )                                                                            \
+static uint32 name( struct SRecAgg *agg, uint16 **out, const uint8 *buff, uint32 nibble, uint32 count, bool last )  \
+{                                                                                                                   \
+    uint16 dec[RECPACK_CHUNK];                  /* decoded values of a chunk - channels are kept interleaved */     \
+    const uint16 *pdec;                                                                                             \
+    uint32 vmin[NCH];                                                                                               \
+    uint32 vmax[NCH];                                                                                               \
+    uint32 vsum[NCH];                                                                                               \
+    uint32 tmin[NCH];                                                                                               \
+    uint32 tmax[NCH];                                                                                               \
+    uint32 dispctr  = agg->dispctr;                                                                                 \
+    uint32 dispprev = agg->dispprev;                                                                                \
+    uint32 dispstep = agg->dispstep;                                                                                \
+    uint32 ctr      = agg->ctr;                                                                                     \
+    uint32 col      = agg->col;                                                                                     \
+    uint32 cols     = agg->cols;                                                                                    \
+    uint32 cnt;                                                                                                     \
+    uint32 ch;                                                                                                      \
+                                                                                                                    \
+    for ( ch=0; ch<NCH; ch++ )                                                                                      \
+    {                                                                                                               \
+        vmin[ch] = agg->vmin[ch];                                                                                   \
+        vmax[ch] = agg->vmax[ch];                                                                                   \
+        vsum[ch] = agg->vsum[ch];                                                                                   \
+        tmin[ch] = agg->tmin[ch];                                                                                   \
+        tmax[ch] = agg->tmax[ch];                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    while ( count )                                                                                                 \
+    {                                                                                                               \
+        cnt = (count > (RECPACK_CHUNK / (NCH * K))) ? (RECPACK_CHUNK / (NCH * K)) : count;                          \
+        if ( agg->dlt.band )                                                                                        \
+            nibble = recdelta_decode( &agg->dlt, buff, nibble, dec, cnt );                                          \
+        else                                                                                                        \
+            nibble = recpack_decode( buff, nibble, dec, cnt * NCH * K );                                            \
+        pdec = dec;                                                                                                 \
+                                                                                                                    \
+        while ( cnt-- )                                                                                             \
+        {                                                                                                           \
+            count--;                                                                                                \
+            for ( ch=0; ch<NCH; ch++ )                                                                              \
+            {                                                                                                       \
+                if ( vmin[ch] > pdec[0] )                                                                           \
+                    vmin[ch] = pdec[0];                                                                             \
+                if ( vmax[ch] < pdec[K >> 1] )                                                                      \
+                    vmax[ch] = pdec[K >> 1];                                                                        \
+                vsum[ch] += pdec[K - 1];                                                                            \
+                pdec += K;                                                                                          \
+            }                                                                                                       \
+            ctr++;                                                                                                  \
+                                                                                                                    \
+            /* close the column if the display position steps, or the readout ends with an open column */          \
+            dispctr += dispstep;                                                                                    \
+            if ( ((dispctr >> 16) != dispprev) || (last && (count == 0) && (col < cols)) )                          \
+            {                                                                                                       \
+                dispprev = (dispctr >> 16);                                                                         \
+                for ( ch=0; ch<NCH; ch++ )                                                                          \
+                {                                                                                                   \
+                    out[ch][0]        = (uint16)vmin[ch];                                                           \
+                    out[ch][cols]     = (uint16)vmax[ch];                                                           \
+                    out[ch][cols * 2] = (uint16)(vsum[ch] / ctr);                                                   \
+                    out[ch]++;                                                                                      \
+                                                                                                                    \
+                    if ( tmax[ch] < vmax[ch] )                                                                      \
+                        tmax[ch] = vmax[ch];                                                                        \
+                    if ( tmin[ch] > vmin[ch] )                                                                      \
+                        tmin[ch] = vmin[ch];                                                                        \
+                                                                                                                    \
+                    vmin[ch] = 0xffff;                                                                              \
+                    vmax[ch] = 0;                                                                                   \
+                    vsum[ch] = 0;                                                                                   \
+                }                                                                                                   \
+                ctr = 0;                                                                                            \
+                col++;                                                                                              \
+            }                                                                                                       \
+        }                                                                                                           \
+    }                                                                                                               \
+                                                                                                                    \
+    for ( ch=0; ch<NCH; ch++ )                                                                                      \
+    {                                                                                                               \
+        agg->vmin[ch] = (uint16)vmin[ch];                                                                           \
+        agg->vmax[ch] = (uint16)vmax[ch];                                                                           \
+        agg->vsum[ch] = vsum[ch];                                                                                   \
+        agg->tmin[ch] = (uint16)tmin[ch];                                                                           \
+        agg->tmax[ch] = (uint16)tmax[ch];                                                                           \
+    }                                                                                                               \
+    agg->dispctr  = dispctr;                                                                                        \
+    agg->dispprev = (uint16)dispprev;                                                                               \
+    agg->ctr      = (uint16)ctr;                                                                                    \
+    agg->col      = (uint16)col;                                                                                    \
+    return nibble;                                                                                                  \
+}
+
+
+// Copy template for the samples fitting on the display: NCH channels / element, one column / element
+// out[] points to the avg arrays, the global min / max is taken from the averages
+#define RECAGG_COPY( name, NCH )                                                                                    \
+static uint32 name( struct SRecAgg *agg, uint16 **out, const uint8 *buff, uint32 nibble, uint32 count, bool last )  \
+{                                                                                                                   \
+    uint16 dec[RECPACK_CHUNK];                                                                                      \
+    const uint16 *pdec;                                                                                             \
+    uint32 tmin[NCH];                                                                                               \
+    uint32 tmax[NCH];                                                                                               \
+    uint32 val;                                                                                                     \
+    uint32 cnt;                                                                                                     \
+    uint32 ch;                                                                                                      \
+                                                                                                                    \
+    (void)last;                                                                                                     \
+    for ( ch=0; ch<NCH; ch++ )                                                                                      \
+    {                                                                                                               \
+        tmin[ch] = agg->tmin[ch];                                                                                   \
+        tmax[ch] = agg->tmax[ch];                                                                                   \
+    }                                                                                                               \
+    agg->col += count;                                                                                              \
+                                                                                                                    \
+    while ( count )                                                                                                 \
+    {                                                                                                               \
+        cnt = (count > (RECPACK_CHUNK / NCH)) ? (RECPACK_CHUNK / NCH) : count;                                      \
+        if ( agg->dlt.band )                                                                                        \
+            nibble = recdelta_decode( &agg->dlt, buff, nibble, dec, cnt );                                          \
+        else                                                                                                        \
+            nibble = recpack_decode( buff, nibble, dec, cnt * NCH );                                                \
+        count -= cnt;                                                                                               \
+        pdec = dec;                                                                                                 \
+                                                                                                                    \
+        while ( cnt-- )                                                                                             \
+        {                                                                                                           \
+            for ( ch=0; ch<NCH; ch++ )                                                                              \
+            {                                                                                                       \
+                val = *pdec++;                                                                                      \
+                *out[ch]++ = (uint16)val;                                                                           \
+                if ( tmax[ch] < val )                                                                               \
+                    tmax[ch] = val;                                                                                 \
+                if ( tmin[ch] > val )                                                                               \
+                    tmin[ch] = val;                                                                                 \
+            }                                                                                                       \
+        }                                                                                                           \
+    }                                                                                                               \
+                                                                                                                    \
+    for ( ch=0; ch<NCH; ch++ )                                                                                      \
+    {                                                                                                               \
+        agg->tmin[ch] = (uint16)tmin[ch];                                                                           \
+        agg->tmax[ch] = (uint16)tmax[ch];                                                                           \
+    }                                                                                                               \
+    return nibble;                                                                                                  \
+}
+
+
+RECAGG_COPY( recagg_copy_1, 1 )
+RECAGG_COPY( recagg_copy_2, 2 )
+RECAGG_COPY( recagg_copy_3, 3 )
+
+RECAGG_MINMAXAVG( recagg_elem_1, 1, 1 )
+RECAGG_MINMAXAVG( recagg_elem_2, 2, 1 )
+RECAGG_MINMAXAVG( recagg_elem_3, 3, 1 )
+
+RECAGG_MINMAXAVG( recagg_summ_1, 1, 3 )
+RECAGG_MINMAXAVG( recagg_summ_2, 2, 3 )
+RECAGG_MINMAXAVG( recagg_summ_3, 3, 3 )
+
+
+// [channels - 1][ copy / elements / summary entries ]
+static const recagg_kernel recagg_kernels[RECAGG_MAXCH][3] =
+{
+    { recagg_copy_1, recagg_elem_1, recagg_summ_1 },
+    { recagg_copy_2, recagg_elem_2, recagg_summ_2 },
+    { recagg_copy_3, recagg_elem_3, recagg_summ_3 },
+};
+
+
+void recagg_start( struct SRecAgg *agg, uint32 cols, uint32 samples )
+{
+    uint32 ch;
+
+    memset( agg, 0, sizeof(struct SRecAgg) );
+    agg->cols = cols;
+    for ( ch=0; ch<RECAGG_MAXCH; ch++ )
+    {
+        agg->vmin[ch] = 0xffff;
+        agg->tmin[ch] = 0xffff;
+    }
+    if ( samples > cols )
+        agg->dispstep = (cols << 16) / samples;         // case when there are more samples than display columns
+}
+
+
+uint32 recagg_process( struct SRecAgg *agg, uint16 *graph, uint32 task_elems, uint32 level,
+                       const uint8 *buff, uint32 nibble, uint32 count, bool last )
+{
+    uint16 *out[RECAGG_MAXCH];
+    uint32 pos;
+    uint32 type;
+    uint32 nch = 0;
+    uint32 i;
+
+    if ( agg->dispstep == 0 )
+    {
+        type = 0;
+        pos  = agg->cols * 2 + agg->col;                // next average of the copied elements
+    }
+    else
+    {
+        type = level ? 2 : 1;
+        pos  = agg->dispctr >> 16;                      // the open column
+    }
+
+    for ( i=0; i<RECAGG_MAXCH; i++ )
+    {
+        if ( task_elems & (1 << i) )
+            out[nch++] = graph + i * agg->cols * 3 + pos;
+    }
+    if ( nch == 0 )
+        return nibble;
+
+    return recagg_kernels[nch - 1][type]( agg, out, buff, nibble, count, last );
+}
@@ -0,0 +1,64 @@
+#ifndef RECAGG_H
+#define RECAGG_H
+
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#include "stm32f10x.h"
+#include "typedefs.h"
+#include "recdelta.h"
+
+
+// Display column aggregation of the recording graph readout
+//
+// Samples are decoded from the packed stream ( see recpack.h ) flip buffer by flip buffer.
+// When the readout has more samples than display columns, the samples are grouped in columns
+// by a fp16 counter: each sample advances it with 'dispstep', the column is closed when the integer
+// part changes. A closed column gets the min / max / average of its samples - for summary entries
+// ( level > 0 ) a sample is a min/max/avg triplet and the min of mins, max of maxes, avg of averages is taken.
+// When the samples fit on the display they are copied to the average arrays one by one.
+// Elements of the deadband tasks are decoded with the 'dlt' codec ( see recdelta.h ) if it is set up after recagg_start().
+//
+// The graph memory holds the column arrays of the sensors in T -> RH -> P order, for each sensor:
+//      uint16 min[cols], max[cols], avg[cols]
+// only the arrays of the sensors present in the task are written.
+//
+// The kernels are generated from one template for every channel count and sample type ( see recagg.c ),
+// so the channel loops have constant bounds and the running column state stays in registers.
+
+    #define RECAGG_MAXCH        3
+
+    struct SRecAgg
+    {
+        uint32  dispctr;                    // display position in fp16
+        uint16  dispstep;                   // fractional display step / sample, 0 if the samples fit on the display
+        uint16  dispprev;                   // integer part of the display position at the last column close
+        uint16  cols;                       // display columns
+        uint16  col;                        // columns written, incremented after each push
+        uint16  ctr;                        // samples in the open column
+        uint16  vmin[RECAGG_MAXCH];         // open column min / max / sum of the channels in packed order
+        uint16  vmax[RECAGG_MAXCH];
+        uint32  vsum[RECAGG_MAXCH];
+        uint16  tmin[RECAGG_MAXCH];         // min / max of the written columns ( global min / max of the graph )
+        uint16  tmax[RECAGG_MAXCH];
+        struct SRecDelta dlt;               // element decoder of the deadband tasks - dlt.band is 0 for the packed samples
+    };
+
+    // set up the state for a readout of 'samples' elements or summary entries on 'cols' display columns
+    void recagg_start( struct SRecAgg *agg, uint32 cols, uint32 samples );
+
+    // process 'count' samples from the given nibble position of the packed stream. task_elems from enum ERecordingTaskType,
+    // level - 0 for elements, N for summary entries. 'last' - the readout ends with these samples, the open column is closed
+    // returns the nibble position after the last sample
+    uint32 recagg_process( struct SRecAgg *agg, uint16 *graph, uint32 task_elems, uint32 level,
+                           const uint8 *buff, uint32 nibble, uint32 count, bool last );
+
+
+#ifdef __cplusplus
+    }
+#endif
+
+
+#endif // RECAGG_H
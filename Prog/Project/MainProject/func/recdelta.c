@@ -0,0 +1,224 @@
+#include "recdelta.h"
+#include "recpack.h"
+
+
+#define RD_CODE_ESCAPE      0x08
+#define RD_CODE_RUN         0x07
+
+
+static inline uint32 internal_get_nibble( const uint8 *buff, uint32 nibble )
+{
+    // MSB first as the packed stream
+    return ( buff[nibble >> 1] >> ((~nibble & 0x01) << 2) ) & 0x0f;
+}
+
+static inline void internal_set_nibble( uint8 *buff, uint32 nibble, uint32 code )
+{
+    uint8 *p = buff + (nibble >> 1);
+
+    if ( nibble & 0x01 )
+        *p = (uint8)( (*p & 0xf0) | (code & 0x0f) );
+    else
+        *p = (uint8)( (*p & 0x0f) | ((code & 0x0f) << 4) );
+}
+
+static inline uint32 internal_align( const struct SRecDelta *dlt, uint32 nibble )
+{
+    // block start - next byte boundary aligned to the unit
+    uint32 mask = (2 << dlt->ushift) - 1;
+    return (nibble + mask) & ~mask;
+}
+
+static inline void internal_step( struct SRecDelta *dlt, uint32 ch, int32 steps )
+{
+    int32 val = (int32)dlt->val[ch] + steps * (int32)(2 * dlt->band + 1);
+
+    if ( val < 0 )
+        val = 0;
+    if ( val > 0xfff )
+        val = 0xfff;
+    dlt->val[ch] = (uint16)val;
+}
+
+
+void recdelta_start( struct SRecDelta *dlt, uint32 nch, uint32 band, uint32 ushift, uint32 elem )
+{
+    uint32 ch;
+
+    for ( ch=0; ch<RECDELTA_MAXCH; ch++ )
+        dlt->val[ch] = 0;
+    dlt->flat = 0;
+    dlt->nch = nch;
+    dlt->band = band;
+    dlt->ushift = ushift;
+    dlt->pos = elem & (RECDELTA_BLOCK - 1);
+    dlt->run = 0;
+}
+
+
+uint32 recdelta_decode( struct SRecDelta *dlt, const uint8 *buff, uint32 nibble, uint16 *val, uint32 count )
+{
+    uint16 key[RECDELTA_MAXCH];
+    uint32 nch = dlt->nch;
+    uint32 code;
+    uint32 ch;
+
+    while ( count-- )
+    {
+        if ( dlt->pos == 0 )
+        {
+            // block start - full values
+            nibble = recpack_decode( buff, internal_align( dlt, nibble ), key, nch );
+            for ( ch=0; ch<nch; ch++ )
+                dlt->val[ch] = key[ch] >> 4;
+            dlt->flat = 0;
+            dlt->run = 0;
+        }
+        else if ( dlt->run )
+            dlt->run--;
+        else if ( internal_get_nibble( buff, nibble ) == RD_CODE_RUN )
+        {
+            dlt->run = internal_get_nibble( buff, nibble + 1 );
+            dlt->flat = nibble + 1;
+            nibble += 2;
+        }
+        else
+        {
+            dlt->flat = 0;
+            for ( ch=0; ch<nch; ch++ )
+            {
+                code = internal_get_nibble( buff, nibble++ );
+                if ( code == RD_CODE_ESCAPE )
+                {
+                    dlt->val[ch] = (uint16)( (internal_get_nibble( buff, nibble ) << 8) |
+                                             (internal_get_nibble( buff, nibble + 1 ) << 4) |
+                                              internal_get_nibble( buff, nibble + 2 ) );
+                    nibble += 3;
+                }
+                else if ( code )
+                    internal_step( dlt, ch, (int32)(code ^ 0x08) - 0x08 );
+                else if ( nch == 1 )
+                    dlt->flat = nibble;                             // single unchanged element - a run can continue it
+            }
+        }
+
+        if ( val )
+        {
+            for ( ch=0; ch<nch; ch++ )
+                *val++ = (uint16)(dlt->val[ch] << 4);
+        }
+        dlt->pos = (dlt->pos + 1) & (RECDELTA_BLOCK - 1);
+    }
+    return nibble;
+}
+
+
+uint32 recdelta_put( struct SRecDelta *dlt, uint8 *buff, uint32 nibble, const uint16 *val )
+{
+    int32  band = dlt->band;
+    int32  diff;
+    int32  steps;
+    uint32 nch = dlt->nch;
+    uint32 ch;
+
+    if ( dlt->pos == 0 )
+    {
+        // block start - the values are written as they are
+        nibble = internal_align( dlt, nibble );
+        for ( ch=0; ch<nch; ch++ )
+        {
+            recpack_put( buff, nibble, val[ch] );
+            dlt->val[ch] = val[ch];
+            nibble += 3;
+        }
+        dlt->flat = 0;
+        dlt->pos = 1;
+        return nibble;
+    }
+
+    for ( ch=0; ch<nch; ch++ )
+    {
+        diff = (int32)val[ch] - (int32)dlt->val[ch];
+        if ( (diff > band) || (diff < -band) )
+            break;
+    }
+
+    if ( ch == nch )
+    {
+        // every channel in the band - continue the run of the element before or start one
+        if ( dlt->flat )
+        {
+            uint32 code = dlt->flat - 1;
+
+            if ( internal_get_nibble( buff, code ) == RD_CODE_RUN )
+                internal_set_nibble( buff, code + 1, internal_get_nibble( buff, code + 1 ) + 1 );
+            else
+            {
+                internal_set_nibble( buff, code, RD_CODE_RUN );
+                internal_set_nibble( buff, code + 1, 1 );
+                nibble = code + 2;
+            }
+        }
+        else
+        {
+            dlt->flat = nibble + 1;
+            if ( nch == 1 )
+                internal_set_nibble( buff, nibble++, 0 );
+            else
+            {
+                internal_set_nibble( buff, nibble, RD_CODE_RUN );
+                internal_set_nibble( buff, nibble + 1, 0 );
+                nibble += 2;
+            }
+        }
+    }
+    else
+    {
+        // nearest step count with the error in the band - the decoded value is clamped as in the decoder
+        dlt->flat = 0;
+        for ( ch=0; ch<nch; ch++ )
+        {
+            diff = (int32)val[ch] - (int32)dlt->val[ch];
+            if ( diff >= 0 )
+                steps = (diff + band) / (2 * band + 1);
+            else
+                steps = -((-diff + band) / (2 * band + 1));
+
+            if ( (steps > RECDELTA_MAXSTEP) || (steps < -(RECDELTA_MAXSTEP + 1)) )
+            {
+                internal_set_nibble( buff, nibble, RD_CODE_ESCAPE );
+                recpack_put( buff, nibble + 1, val[ch] );
+                dlt->val[ch] = val[ch];
+                nibble += 4;
+            }
+            else
+            {
+                internal_set_nibble( buff, nibble++, (uint32)steps );
+                internal_step( dlt, ch, steps );
+            }
+        }
+    }
+
+    dlt->pos = (dlt->pos + 1) & (RECDELTA_BLOCK - 1);
+    return nibble;
+}
+
+
+void recdelta_save( const struct SRecDelta *dlt, uint8 *state )
+{
+    state[0] = (uint8)(dlt->val[0] >> 4);
+    state[1] = (uint8)((dlt->val[0] << 4) | (dlt->val[1] >> 8));
+    state[2] = (uint8)dlt->val[1];
+    state[3] = (uint8)(dlt->val[2] >> 4);
+    state[4] = (uint8)(dlt->val[2] << 4);
+}
+
+
+void recdelta_load( struct SRecDelta *dlt, const uint8 *state )
+{
+    dlt->val[0] = (uint16)( ((uint32)state[0] << 4) | (state[1] >> 4) );
+    dlt->val[1] = (uint16)( (((uint32)state[1] & 0x0f) << 8) | state[2] );
+    dlt->val[2] = (uint16)( ((uint32)state[3] << 4) | (state[4] >> 4) );
+    dlt->flat = 0;
+    dlt->run = 0;
+}
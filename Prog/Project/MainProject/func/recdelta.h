@@ -0,0 +1,88 @@
+#ifndef RECDELTA_H
+#define RECDELTA_H
+
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#include "stm32f10x.h"
+#include "typedefs.h"
+
+
+// Deadband codec for the recording elements of the deadband tasks
+//
+// Every decoded value is within +/- band ( in 12bit LSB ) of the recorded one. Elements are grouped in blocks of
+// RECDELTA_BLOCK, a block starts at a byte boundary aligned to 1 << ushift bytes. The first element of a block is the
+// key: the 12bit values in the packed format ( see recpack.h ). The others are coded against the decoded values of
+// the element before, in 4bit codes ( MSB first ):
+//
+//      [0]                 the channel is within the band - not changed
+//      [1]..[6]            +1 .. +6 steps of 2 * band + 1
+//      [9]..[F]            -7 .. -1 steps
+//      [8][vvv]            escape - the exact 12bit value, for changes larger than the steps
+//      [7][n]              in place of the first code of an element: n + 1 elements with all the channels unchanged
+//
+// An element has one code per channel in the T -> RH -> P order, or a run. A single channel element without change
+// is coded with [0], the next unchanged element turns it into a run. The encoder quantizes against the decoded
+// values, so the errors do not add up:
+//
+//      1 channel, flat:    [vvv][7][E]                             -  3 bytes / block of 16 elements   ( packed: 24 )
+//      3 channels, flat:   [vvv vvv vvv][7][E]                     -  6 bytes / block                  ( packed: 72 )
+//      worst case:         every channel escaped                   -  RECDELTA_BLKMAX() bytes / block
+//
+// Blocks are variable length - the task memory has a directory with the start of each block ( see core.c ).
+// Decoding starts at a block start - an element inside a block needs the elements before it in the block.
+
+    #define RECDELTA_MAXCH          3
+    #define RECDELTA_BLKSHIFT       4                       // log2 of the elements in a block
+    #define RECDELTA_BLOCK          (1 << RECDELTA_BLKSHIFT)
+    #define RECDELTA_MAXSTEP        6                       // max. steps of a code - larger changes are escaped
+    #define RECDELTA_STATE          5                       // size of the saved codec state - see recdelta_save()
+
+    // max. element size in nibbles - every channel escaped
+    #define RECDELTA_ELMAXX2( nch )             ( 4 * (nch) )
+    // max. block size in bytes - key and the escaped elements
+    #define RECDELTA_BLKMAX( nch )              ( (3 * (nch) + (RECDELTA_BLOCK - 1) * RECDELTA_ELMAXX2( nch ) + 1) >> 1 )
+    // block size in bytes when no value leaves the band - key and one run
+    #define RECDELTA_BLKFLAT( nch )             ( (3 * (nch) + 2 + 1) >> 1 )
+    // block directory size in bytes for 'wrap' elements - 16 bit block starts in units of 1 << RECDELTA_USHIFT() bytes
+    #define RECDELTA_DIRSIZE( wrap )            ( ((wrap) >> RECDELTA_BLKSHIFT) * 2 )
+    #define RECDELTA_USHIFT( mem_len )          ( ((mem_len) > 0x20000) ? 2 : (((mem_len) > 0x10000) ? 1 : 0) )
+
+    struct SRecDelta
+    {
+        uint16  val[RECDELTA_MAXCH];        // last decoded values - 12 bit
+        uint16  flat;                       // nibble position of the code of the last unchanged element + 1, 0 if the last element changed
+        uint8   nch;                        // channels / element
+        uint8   band;                       // deadband in 12bit LSB - 0: codec not in use
+        uint8   ushift;                     // block start alignment: 1 << ushift bytes
+        uint8   pos;                        // index of the next element in its block - 0 is the block start
+        uint8   run;                        // elements left from the last run
+    };
+
+    // set up the codec for the element 'elem' - if it is inside a block the state is loaded or decoded after this
+    void recdelta_start( struct SRecDelta *dlt, uint32 nch, uint32 band, uint32 ushift, uint32 elem );
+
+    // decode 'count' elements from the given nibble position to 16bit values ( 4 LSB are 0 as for recpack_decode() ),
+    // val can be NULL to skip the elements. Returns the nibble position after the last element.
+    // A block start is aligned relative to the buffer start and read with recpack_decode() - the buffer needs 1 byte reserve
+    uint32 recdelta_decode( struct SRecDelta *dlt, const uint8 *buff, uint32 nibble, uint16 *val, uint32 count );
+
+    // encode the next element - val has the 12bit values of the channels, nibble is the position after the previous
+    // element. The code of the unchanged element before can be rewritten, so it must be in the same buffer.
+    // Returns the nibble position after the element
+    uint32 recdelta_put( struct SRecDelta *dlt, uint8 *buff, uint32 nibble, const uint16 *val );
+
+    // save / load the decoded values in RECDELTA_STATE bytes - the state of the codec at an element inside a block,
+    // the run and the flat position are not kept: the saved state is followed by a new code
+    void recdelta_save( const struct SRecDelta *dlt, uint8 *state );
+    void recdelta_load( struct SRecDelta *dlt, const uint8 *state );
+
+
+#ifdef __cplusplus
+    }
+#endif
+
+
+#endif // RECDELTA_H
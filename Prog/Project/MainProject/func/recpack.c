@@ -0,0 +1,97 @@
+#include "recpack.h"
+
+#ifdef __ICCARM__
+  // Cortex-M3 handles unaligned word access - load + byte reverse ( __REV from core_cm3.h )
+  #define LD32BE( p )           __REV( *(__packed uint32*)(p) )
+#else
+  #define LD32BE( p )           ( ((uint32)(p)[0] << 24) | ((uint32)(p)[1] << 16) | ((uint32)(p)[2] << 8) | (uint32)(p)[3] )
+#endif
+
+#define LD16BE( p )             ( ((uint32)(p)[0] << 8) | (uint32)(p)[1] )
+#define ST16BE( p, w )          do { (p)[0] = (uint8)((w) >> 8); (p)[1] = (uint8)(w); } while (0)
+
+
+// nr. of set bits for 3 bit values - channel count and channel index for the task element types
+const uint8 recpack_chcount[8] = { 0, 1, 1, 2, 1, 2, 2, 3 };
+
+
+uint32 recpack_encode( uint8 *buff, uint32 nibble, const uint16 *val, uint32 count )
+{
+    uint8  *p   = buff + (nibble >> 1);
+    uint32 sh   = (nibble & 0x01) << 2;                 // 0 or 4 bit shift - no branching on it
+    uint32 acc;
+    uint32 w;
+
+    nibble += 3 * count;
+
+    // bits belonging to the first byte from before - the leading nibble for shifted data
+    acc = ((uint32)p[0] << 24) & (0xff000000 << (8 - sh));
+
+    // value pairs - 24 bits written as 3 bytes, the trailing nibble of the shifted data is kept in acc
+    while ( count >= 2 )
+    {
+        w = acc | ( ( ((uint32)(val[0] & 0xfff0) << 16) | ((uint32)(val[1] & 0xfff0) << 4) ) >> sh );
+        p[0] = (uint8)(w >> 24);
+        p[1] = (uint8)(w >> 16);
+        p[2] = (uint8)(w >> 8);
+        acc = w << 24;
+        p += 3;
+        val += 2;
+        count -= 2;
+    }
+
+    if ( count )
+    {
+        // the last single value - 12 bits in a 16 bit window, keep the LSB nibble for non-shifted data
+        w = (acc >> 16) | ( (uint32)(val[0] & 0xfff0) >> sh ) | ( LD16BE(p) & (0x000f >> sh) );
+        ST16BE( p, w );
+    }
+    else
+    {
+        // flush the leading nibble for shifted data ( byte stays the same for non-shifted )
+        p[0] = (uint8)( (acc >> 24) | (p[0] & (0xff >> sh)) );
+    }
+
+    return nibble;
+}
+
+
+uint32 recpack_decode( const uint8 *buff, uint32 nibble, uint16 *val, uint32 count )
+{
+    const uint8 *p = buff + (nibble >> 1);
+    uint32 sh   = (nibble & 0x01) << 2;
+    uint32 w;
+
+    nibble += 3 * count;
+
+    while ( count >= 2 )
+    {
+        w = LD32BE(p) << sh;
+        val[0] = (uint16)( (w >> 16) & 0xfff0 );
+        val[1] = (uint16)( (w >> 4) & 0xfff0 );
+        p += 3;
+        val += 2;
+        count -= 2;
+    }
+
+    if ( count )
+    {
+        w = LD16BE(p) << sh;
+        val[0] = (uint16)( w & 0xfff0 );
+    }
+
+    return nibble;
+}
+
+
+void recpack_put( uint8 *buff, uint32 nibble, uint32 val )
+{
+    uint8  *p   = buff + (nibble >> 1);
+    uint32 sh   = (nibble & 0x01) << 2;
+    uint32 mask = 0xfff0 >> sh;
+    uint32 w;
+
+    // val is 12 bit here - as it is produced by the recording averager
+    w = ( LD16BE(p) & ~mask ) | ( ((val << 4) & 0xfff0) >> sh );
+    ST16BE( p, w );
+}
@@ -0,0 +1,57 @@
+#ifndef RECPACK_H
+#define RECPACK_H
+
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#include "stm32f10x.h"
+#include "typedefs.h"
+
+
+// Packed sample codec for the recording format
+//
+// A recording is a continuous stream of 12bit values, MSB first, without any padding.
+// One element holds 1, 2 or 3 values in T -> RH -> P order ( see enum ERecordingTaskType ),
+// so value 'v' of element 'e' is at nibble position:   3 * ( e * channels + v )
+//
+//      rtt_t/h/p:      [1111 1111][1111 2222][2222 2222]                   - 1.5 bytes / element
+//      rtt_th/tp/hp:   [tttt tttt][tttt hhhh][hhhh hhhh]                   - 3 bytes / element
+//      rtt_thp:        [tttt tttt][tttt hhhh][hhhh hhhh][pppp pppp][pppp   - 4.5 bytes / element
+//
+// Values are passed as 16bit ( the 4 LSB are dropped at encoding and are 0 at decoding ).
+// Nibble positions are counted from the buffer start, odd position means shifted data.
+// Values are processed in pairs ( 24 bits ): the decoder uses 32bit big endian loads so it can
+// read one byte after the last used one - the read buffer needs 1 byte reserve.
+
+    extern const uint8 recpack_chcount[8];
+
+    // nr. of values in one element, task_elems from enum ERecordingTaskType
+    #define RECPACK_CHANNELS( task_elems )              ( recpack_chcount[ (task_elems) & 0x07 ] )
+    // position of a sensor's value in the element, smask is the CORE_BM_xxx bitmask of the sensor
+    #define RECPACK_CHANNEL_IDX( task_elems, smask )    ( recpack_chcount[ (task_elems) & ((smask) - 1) & 0x07 ] )
+    // element size in nibbles ( = bytes X2 )
+    #define RECPACK_ELSIZEX2( task_elems )              ( 3 * RECPACK_CHANNELS( task_elems ) )
+
+    // maximum values decoded in one chunk by the readout - all the channel counts fit in it
+    #define RECPACK_CHUNK       24
+
+    // encode 'count' 16bit values to the packed stream from the given nibble position. Surrounding nibbles are left untouched.
+    // returns the nibble position after the last value
+    uint32 recpack_encode( uint8 *buff, uint32 nibble, const uint16 *val, uint32 count );
+
+    // decode 'count' values from the packed stream from the given nibble position to 16bit values
+    // returns the nibble position after the last value
+    uint32 recpack_decode( const uint8 *buff, uint32 nibble, uint16 *val, uint32 count );
+
+    // write a single value to the given nibble position
+    void recpack_put( uint8 *buff, uint32 nibble, uint32 val );
+
+
+#ifdef __cplusplus
+    }
+#endif
+
+
+#endif // RECPACK_H
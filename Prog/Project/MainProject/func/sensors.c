@@ -1,8 +1,14 @@
 /*
         Sensor interface routines
 
-        It works based on polling. Since I2C is slow, all the operations 
-        are done asynchronously so freqvent polling is needed
+        I2C transfers are done asynchronously - they are polled from the main
+        loop while the bus is busy ( PM_FULL, a few hundred us ). Between the
+        transfers nothing is polled:
+            - RH/Temp conversion and power-up delays are counted on the 1ms
+              system ticks ( PM_SLEEP )
+            - the pressure one-shot conversion ( ~512ms ) completes on the sensor
+              data ready line, which is armed as wake-up source, so the CPU can
+              stay stopped ( PM_HOLD ) till it is raised
 
         Estimated i2c speed: 400kHz -> 40kbps - 25us/byte = 400clocks
 
@@ -17,8 +23,6 @@
 #include "sensors_internals.h"
 #include "i2c.h"
 
-#define PSENS_READ_POLLING_TO  1000
-
 
 const uint8     psens_set_01_data_event[] = { REGPRESS_DATACFG, (PREG_DATACFG_TDEFE | PREG_DATACFG_PDEFE | PREG_DATACFG_DREM) };     // set up data event signalling for pressure update
 const uint8     psens_set_02_interrupt_src[]  = { REGPRESS_CTRL3, PREG_CTRL3_IPOL1 };       // pushpull active high on INT1
@@ -41,42 +45,31 @@ void local_i2c_reinit(void)
 
 }
 
-void local_setpower_free(void)
+void local_setpower_update(void)
 {
-    // called by state machines when a sensor finished operation, or cancelled 
-    // need to check if an other sensor needs SLEEP power management.
-    // FULL is held only for active bus operations, so if one finishes the no FULL is needed
+    // called by state machines when a sensor finished a bus operation, or cancelled it.
+    // FULL is held only for active bus operations, the waiting states decide bw. SLEEP and HOLD
+    if ( ss.hw.bus_busy )
+        return;
 
-    // cases when SLEEP is needed
     if ( (ss.hw.rhsens.sm == rhsm_init_01_wait_powerup) ||
-         (ss.hw.psens.sm == psm_read_oneshotcmd ) ||
          (ss.hw.rhsens.sm == rhsm_readrh_01_send_request ) ||
-         (ss.hw.rhsens.sm == rhsm_readt_01_send_request )     )
-        ss.flags.sens_pwr = PM_SLEEP;       // do not use PM_HOLD because at any point the Psensor IRQ can be set and event will be missed - locking the CPU in stopped state
+         (ss.hw.rhsens.sm == rhsm_readt_01_send_request ) ||
+         (ss.flags.sens_busy & (SENSOR_RH | SENSOR_TEMP)) )
+        ss.flags.sens_pwr = PM_SLEEP;       // RH sensor delays are counted on 1ms ticks
+    else if ( ss.hw.psens.sm == psm_read_oneshotcmd )
+        ss.flags.sens_pwr = PM_HOLD;        // pressure conversion - CPU stopped, data ready line wakes it up
     else
         ss.flags.sens_pwr = PM_DOWN;
 }
 
 
-void local_setpower_sleep(void)
-{
-    // do not set power management to sleep when an other sensor is operating at full
-    if ( ss.hw.bus_busy )
-        return;
-    ss.flags.sens_pwr = PM_SLEEP;
-
-    if ( (ss.hw.psens.sm == psm_read_oneshotcmd) &&                     // if pressure sensor on one-shot read and bus is free (waiting for IRQ)
-         (ss.hw.rhsens.sm == rhsm_none ) &&                             // and rh sensor has no ongoing operation ( i2c or wait )
-         ((ss.flags.sens_busy & (SENSOR_RH | SENSOR_TEMP)) == 0 ) )     // and RH / Temp is not requested
-        ss.flags.sens_pwr = PM_HOLD;                                    // --> can set CPU stop with event wake-up power management
-}
-
-
 void local_sensor_failure_press( void )
 {
     ss.hw.bus_busy = busst_none;            // mark bus free, routine will retry the command
     ss.hw.psens.sm = psm_none;
-    local_setpower_free();
+    HW_PSens_IRQ_Wait( false );
+    local_setpower_update();
     if ( ss.hw.psens.fail_ctr == 0 )        // first failure
         ss.hw.psens.fail_ctr = 5;
     else
@@ -95,7 +88,7 @@ void local_sensor_failure_rh( void )
 {
     ss.hw.bus_busy = busst_none;            // mark bus free, routine will retry the command
     ss.hw.rhsens.sm = rhsm_none;
-    local_setpower_free();
+    local_setpower_update();
     if ( ss.hw.rhsens.fail_ctr == 0 )       // first failure
         ss.hw.rhsens.fail_ctr = 5;
     else
@@ -150,12 +143,11 @@ void local_psensor_execute_ini( bool mstick )
             case psm_init_04:
                 ss.hw.bus_busy = busst_none;                // bus is free
                 ss.hw.psens.sm = psm_none;                  // no operation on sensor
-                ss.hw.psens.check_ctr = 0;
                 ss.hw.psens.fail_ctr = 0;
                 ss.status.sensp_ini_request = 0;            // ini request served
                 ss.status.initted_p = 1;                    // sensor initted
                 ss.flags.sens_fail &= ~SENSOR_PRESS;
-                local_setpower_free();
+                local_setpower_update();
                 break;
         }
     }
@@ -187,7 +179,7 @@ void local_rhsensor_execute_ini( bool mstick )
         // first entry in the ini procedure
         ss.hw.rhsens.sm = rhsm_init_01_wait_powerup;
         ss.hw.rhsens.to_ctr = 16;       // 15+1 ms countdown
-        local_setpower_sleep();
+        local_setpower_update();
         return;
     }
     else if ( ss.hw.rhsens.to_ctr )
@@ -234,7 +226,7 @@ void local_rhsensor_execute_ini( bool mstick )
                 ss.status.sensrh_ini_request = 0;           // ini request served
                 ss.status.initted_rh = 1;                   // sensor initted
                 ss.flags.sens_fail &= ~( SENSOR_RH | SENSOR_TEMP );
-                local_setpower_free();
+                local_setpower_update();
                 break;
         }
     } 
@@ -287,9 +279,10 @@ void local_psensor_execute_read( bool tick_ms )
         switch ( ss.hw.psens.sm )
         {
             case psm_read_oneshotcmd:
-                // free the bus, since we will poll on 5ms basis, and leave the bus free for other comm.
+                // free the bus for the other sensor and wait for the data ready line
                 ss.hw.bus_busy = busst_none;        
-                local_setpower_sleep();             // system can sleep with 1ms interrupt watch
+                HW_PSens_IRQ_Wait( true );
+                local_setpower_update();
                 break;
             case psm_read_waitresult:
                 // pressure data received
@@ -298,11 +291,10 @@ void local_psensor_execute_read( bool tick_ms )
                                           ((uint32)ss.hw.psens.hw_read_val[2] )        ) >> 4 );
                 ss.hw.bus_busy = busst_none;                // bus is free
                 ss.hw.psens.sm = psm_none;                  // no operation on sensor
-                ss.hw.psens.check_ctr = 0;
                 ss.hw.psens.fail_ctr = 0;
                 ss.flags.sens_busy &= ~SENSOR_PRESS;
                 ss.flags.sens_ready |= SENSOR_PRESS;
-                local_setpower_free();
+                local_setpower_update();
                 break;
         }
 
@@ -310,26 +302,20 @@ void local_psensor_execute_read( bool tick_ms )
     // if one-shot cmd is sent and bus is free
     else if ( ss.hw.psens.sm == psm_read_oneshotcmd )
     {
-        // if one-shot cmd is sent - check for data ready
+        // if one-shot cmd is sent - check for data ready ( the line wakes up the CPU, no need for tick based polling )
         if ( HW_PSens_IRQ() )
         {
             // IRQ received - request pressure data
+            HW_PSens_IRQ_Wait( false );
             if ( I2C_device_read( I2C_DEVICE_PRESSURE, REGPRESS_OUTP, 3, ss.hw.psens.hw_read_val ) == I2CSTATE_NONE )
             {
                 ss.hw.bus_busy = busst_pressure;        // mark bus busy
                 ss.hw.psens.sm = psm_read_waitresult;   // mark the current operation state
-                ss.hw.psens.check_ctr = 0;              // reset check counter
                 ss.flags.sens_pwr = PM_FULL;
             }
             else
                 goto _i2c_failure;
         }
-        else if ( tick_ms )
-        {
-            if ( ss.hw.psens.check_ctr < PSENS_READ_POLLING_TO )
-                ss.hw.psens.check_ctr++;
-            //TODO: time_out error handling
-        }
     }
     // if this is the first operation (no bus busy)
     else if ( ss.hw.psens.sm == psm_none )
@@ -339,7 +325,6 @@ void local_psensor_execute_read( bool tick_ms )
         {
             ss.hw.bus_busy = busst_pressure;        // mark bus busy
             ss.hw.psens.sm = psm_read_oneshotcmd;   // mark the current operation state
-            ss.hw.psens.check_ctr = 0;              // reset check counter
             ss.flags.sens_pwr = PM_FULL;
         }
         else
@@ -408,7 +393,7 @@ void local_rhsensor_execute_read( bool tick_ms )
                 else
                     ss.hw.rhsens.to_ctr = 80;
                 ss.hw.bus_busy = busst_none;        
-                local_setpower_sleep();             // system can sleep with 1ms interrupt watch
+                local_setpower_update();
                 break;
             case rhsm_readrh_02_wait4read:
             case rhsm_readt_02_wait4read:
@@ -417,7 +402,6 @@ void local_rhsensor_execute_read( bool tick_ms )
                 {
                     // result is ready
                     ss.hw.bus_busy = busst_none;                // bus is free
-                    local_setpower_free();                      // mark power management free
 
                     if ( ss.hw.rhsens.sm == rhsm_readrh_02_wait4read )
                     {
@@ -441,6 +425,7 @@ void local_rhsensor_execute_read( bool tick_ms )
                     }
                     ss.hw.rhsens.fail_ctr = 0;
                     ss.hw.rhsens.to_ctr = 0;
+                    local_setpower_update();
                 }
                 else
                 {
@@ -451,7 +436,7 @@ void local_rhsensor_execute_read( bool tick_ms )
                         ss.hw.rhsens.sm = rhsm_readt_01_send_request;
                     ss.hw.rhsens.to_ctr = 5;
                     ss.hw.bus_busy = busst_none;        
-                    local_setpower_sleep();             // system can sleep with 1ms interrupt watch
+                    local_setpower_update();
                 }
                 break;
         }
@@ -544,10 +529,10 @@ void Sensor_Shutdown( uint32 mask )
 
         // reset everything on the sensor
         ss.hw.psens.sm = psm_none;
-        ss.hw.psens.check_ctr = 0;
         ss.hw.psens.fail_ctr = 0;
+        HW_PSens_IRQ_Wait( false );
         if ( ss.hw.bus_busy == busst_none )         // set power management free only if the other sensor is not operated
-            local_setpower_free();
+            local_setpower_update();
 
         ss.flags.sens_ready &= ~SENSOR_PRESS;
         ss.flags.sens_busy &= ~SENSOR_PRESS;
@@ -566,7 +551,7 @@ void Sensor_Shutdown( uint32 mask )
         ss.hw.rhsens.to_ctr = 0;
         ss.hw.psens.fail_ctr = 0;
         if ( ss.hw.bus_busy == busst_none )         // set power management free only if the other sensor is not operated
-            local_setpower_free();
+            local_setpower_update();
 
         ss.flags.sens_ready &= ~( SENSOR_RH | SENSOR_TEMP );
         ss.flags.sens_busy &= ~( SENSOR_RH | SENSOR_TEMP );
@@ -580,14 +565,20 @@ void Sensor_Shutdown( uint32 mask )
 
 uint32 Sensor_Acquire( uint32 mask )
 {
+    uint32 result = 0;
+
+    // a failed sensor does not stop the acquisition of the other one - they are requested in the same bus session
     if ( (mask & SENSOR_PRESS) && ((ss.flags.sens_busy & SENSOR_PRESS) == 0) )
     {   
         if ( ss.flags.sens_fail & SENSOR_PRESS )
-            return 1;
-        if ( ss.status.initted_p == 0 )
-            local_init_pressure_sensor();       // mark for init if not done yet
-        ss.flags.sens_busy |= SENSOR_PRESS;     // mark sensor for read
-        ss.flags.sens_ready &= ~SENSOR_PRESS;   // clear the ready flag (if not cleared by a previous read)
+            result = 1;
+        else
+        {
+            if ( ss.status.initted_p == 0 )
+                local_init_pressure_sensor();       // mark for init if not done yet
+            ss.flags.sens_busy |= SENSOR_PRESS;     // mark sensor for read
+            ss.flags.sens_ready &= ~SENSOR_PRESS;   // clear the ready flag (if not cleared by a previous read)
+        }
     }
     if ( mask & (SENSOR_RH | SENSOR_TEMP) )
     {
@@ -607,7 +598,7 @@ uint32 Sensor_Acquire( uint32 mask )
             ss.flags.sens_ready &= ~SENSOR_TEMP;   // clear the ready flag (if not cleared by a previous read)
         }
     }
-    return 0;
+    return result;
 }
 
 uint32 Sensor_Is_Ready(void)
@@ -145,7 +145,6 @@
     struct SPressureSensorStatus
     {
         enum EPessureSensorStateMachine sm;
-        uint16                          check_ctr;      // time counter for polling period
         uint16                          fail_ctr;       // failure retrial counter
         uint8                           hw_read_val[4]; // read value from the sensor in i2c
     };
@@ -0,0 +1,177 @@
+#include <string.h>
+
+#include "telemetry.h"
+#include "hw_stuff.h"
+#include "crc16.h"
+
+
+// Frames wait in send order: 'head' is the oldest, it is in flight if 'busy' is set
+struct STelemetry
+{
+    uint8   buff[2][TLM_FRAMESIZE];
+    uint8   len[2];
+    uint8   head;                   // buffer of the oldest frame
+    uint8   count;                  // frames waiting or in flight
+    uint8   seq;                    // sequence nr. of the next frame
+    uint8   drops;                  // frames dropped since the last frame built
+    bool    on;
+    bool    busy;                   // head frame is in flight
+    bool    uart;                   // UART is started by the stream
+    bool    held;                   // frames wait for the end of a sensor read
+    uint32  t_start;                // timestamp of the transfer start
+    uint32  t_uart;                 // duration of the last transfer
+};
+
+static struct STelemetry tlm;
+
+
+uint32 telemetry_timestamp( void )
+{
+    uint32 ctr;
+    uint32 div;
+
+    // the divider counts down from the prescaler value, the counter is incremented when it reloads -
+    // read it again if the counter stepped meanwhile
+    do
+    {
+        ctr = RTC_GetCounter();
+        div = RTC_GetDivider();
+    } while ( ctr != RTC_GetCounter() );
+
+    return ( ctr << TLM_TICK_SHIFT ) + ( TIMER_RTC_PRESCALE - div );
+}
+
+
+void telemetry_start( uint32 clock )
+{
+    struct STlmStart start;
+
+    memset( &tlm, 0, sizeof(tlm) );
+    tlm.on = true;
+
+    start.clock = clock;
+    start.version = TLM_VERSION;
+    telemetry_push( TLM_TYPE_START, &start, sizeof(start) );
+}
+
+
+void telemetry_stop( void )
+{
+    // the frames waiting are dropped
+    telemetry_release();
+    tlm.count = 0;
+    tlm.on = false;
+}
+
+
+bool telemetry_push( uint32 type, const void *payload, uint32 len )
+{
+    uint8 *frame;
+    uint16 crc;
+    uint32 idx;
+
+    if ( (tlm.on == false) || (len > TLM_MAXPAYLOAD) || (tlm.count == 2) )
+    {
+        if ( tlm.drops < 0xff )
+            tlm.drops++;
+        return false;
+    }
+
+    idx = ( tlm.head + tlm.count ) & 0x01;
+    frame = tlm.buff[idx];
+
+    frame[0] = TLM_SYNC1;
+    frame[1] = TLM_SYNC2;
+    frame[2] = (uint8)type;
+    frame[3] = tlm.seq++;
+    frame[4] = (uint8)len;
+    frame[5] = tlm.drops;
+    memcpy( frame + TLM_HEADER, payload, len );
+
+    crc = crc16_update( CRC16_INIT, frame + 2, TLM_HEADER - 2 + len );
+    frame[TLM_HEADER + len]     = (uint8)crc;
+    frame[TLM_HEADER + len + 1] = (uint8)(crc >> 8);
+
+    tlm.len[idx] = (uint8)( TLM_HEADER + len + 2 );
+    tlm.drops = 0;
+    tlm.count++;
+    return true;
+}
+
+
+static void internal_check_finished( void )
+{
+    if ( tlm.busy && HW_UART_DMA_IsFinished() )
+    {
+        tlm.t_uart = telemetry_timestamp() - tlm.t_start;
+        tlm.busy = false;
+        tlm.head ^= 0x01;
+        tlm.count--;
+    }
+}
+
+
+void telemetry_poll( bool bus_free )
+{
+    if ( tlm.on == false )
+        return;
+
+    internal_check_finished();
+    if ( tlm.busy )
+        return;
+
+    tlm.held = !bus_free;
+
+    if ( bus_free && tlm.count )
+    {
+        HW_UART_Start();
+        tlm.uart = true;
+        tlm.t_start = telemetry_timestamp();
+        if ( HW_UART_SendDMA( tlm.buff[tlm.head], tlm.len[tlm.head] ) == 0 )
+        {
+            tlm.busy = true;
+            return;
+        }
+
+        // no transfer on this UART ( simulator ) - drop the frame
+        tlm.head ^= 0x01;
+        tlm.count--;
+        if ( tlm.drops < 0xff )
+            tlm.drops++;
+    }
+
+    // nothing in flight - give back the DMA channel and power down the UART
+    if ( tlm.uart )
+    {
+        HW_UART_Stop();
+        tlm.uart = false;
+    }
+}
+
+
+void telemetry_release( void )
+{
+    while ( tlm.busy )
+        internal_check_finished();
+
+    if ( tlm.uart )
+    {
+        HW_UART_Stop();
+        tlm.uart = false;
+    }
+}
+
+
+uint32 telemetry_pwr( void )
+{
+    // frames held by a sensor read do not keep the CPU running - the read itself sets the power state
+    if ( tlm.busy || (tlm.count && (tlm.held == false)) )
+        return PM_SLEEP;
+    return 0;
+}
+
+
+uint32 telemetry_uart_time( void )
+{
+    return tlm.t_uart;
+}
@@ -0,0 +1,99 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#include "stm32f10x.h"
+#include "typedefs.h"
+
+
+// Telemetry stream - framed binary packets on the UART for the host decoder ( see recread -l )
+//
+// Frame:   [ A5 ][ 5A ][ type ][ seq ][ len ][ drops ][ payload: len bytes ][ crc16 LSB ][ crc16 MSB ]
+//
+// seq is incremented by each frame sent, drops counts the frames dropped on the device since the previous frame - a seq
+// gap on the host side is a loss on the link. The CRC16 ( see crc16.h ) covers type .. payload. Payloads are the
+// structures below in the little endian memory format of the target.
+//
+// Frames are built in two buffers: one is sent by DMA while the next one is built in the other. A frame pushed while
+// both are in use is dropped. The UART TX DMA request shares the channel with the sensor I2C RX, so a transfer is
+// started only when no sensor read is in progress, and the channel is given back ( HW_UART_Stop() ) before an acquire.
+//
+// Timestamps are the RTC counter with the prescaler divider: TLM_TIME_UNIT / second, the counter is in the upper bits.
+// They wrap - only differences are used.
+
+    #define TLM_SYNC1           0xA5
+    #define TLM_SYNC2           0x5A
+    #define TLM_HEADER          6
+    #define TLM_MAXPAYLOAD      40
+    #define TLM_FRAMESIZE       ( TLM_HEADER + TLM_MAXPAYLOAD + 2 )
+
+    #define TLM_VERSION         1
+    #define TLM_TIME_UNIT       32768               // timestamp units / second - the RTC prescaler input clock
+    #define TLM_TICK_SHIFT      14                  // timestamp units / RTC tick ( 0.5sec ) in log2
+
+    #define TLM_TYPE_START      0x01                // stream started - struct STlmStart
+    #define TLM_TYPE_SREAD      0x02                // sensor read done - struct STlmSensorRead
+
+    #define TLM_PWR_CHARGE      0x80                // STlmSensorRead.pwr: charger connected
+
+    struct STlmStart
+    {
+        uint32  clock;              // RTC counter at the start
+        uint32  version;            // TLM_VERSION
+    };
+
+    struct STlmSensorRead
+    {
+        uint32  clock;              // RTC counter of the read slot
+        uint32  pressure;           // measured values after the read - see struct SMeasurements
+        uint16  temperature;
+        uint16  dewpoint;
+        uint16  rh;
+        uint16  absh;
+        uint8   sensors;            // sensors read in the slot - SENSOR_TEMP / SENSOR_RH / SENSOR_PRESS
+        uint8   pwr;                // PM_xxx power requirements of the core during the read, TLM_PWR_CHARGE
+        uint8   battery;            // battery in %
+        uint8   ops;                // operation flags - see union UCoreOperationFlags
+        // core_bsy phase timings in timestamp units, saturated at 0xffff
+        uint16  ph_wake;            // slot start -> Sensor_Acquire()
+        uint16  ph_conv[3];         // Sensor_Acquire() -> result ready for T / RH / P, 0 if not read
+        uint16  ph_proc;            // result processing
+        uint16  ph_save;            // recording save ( op_recsave )
+        uint16  ph_bsy;             // slot start -> read done with its recording save
+        uint16  ph_uart;            // DMA transfer of the previous frame - start -> finish seen by telemetry_poll()
+    };
+
+    // timestamp from the RTC counter and divider
+    uint32 telemetry_timestamp( void );
+
+    // start / stop the stream - stop waits for the frame in flight
+    void telemetry_start( uint32 clock );
+    void telemetry_stop( void );
+
+    // build a frame in the free buffer - returns false if it is dropped ( both buffers in use, payload too long )
+    bool telemetry_push( uint32 type, const void *payload, uint32 len );
+
+    // check the transfer in flight and start the next frame. 'bus_free' - no sensor read in progress, the DMA channel
+    // can be used, else the channel is given back when the transfer in flight is finished
+    void telemetry_poll( bool bus_free );
+
+    // wait for the transfer in flight and give back the DMA channel - call it before a sensor acquire or other UART use
+    void telemetry_release( void );
+
+    // power requirement - PM_SLEEP while a frame is waiting or in flight
+    uint32 telemetry_pwr( void );
+
+    // duration of the last transfer in timestamp units
+    uint32 telemetry_uart_time( void );
+
+
+#ifdef __cplusplus
+    }
+#endif
+
+
+#endif // TELEMETRY_H
@@ -17,6 +17,8 @@
 #include "graphic_lib.h"
 #include "ui_graphics.h"
 #include "utilities.h"
+#include "recpack.h"
+#include "recdelta.h"
 
 #ifndef ON_QT_PLATFORM
   #include "stdlib_extension.h"
@@ -90,6 +92,7 @@ void internal_get_regtask_set_from_ui(struct SRecTaskInstance *task)
     task->size = ui.p.swRegTaskSet.task.size;
     task->sample_rate = uiel_control_list_get_value( &ui.p.swRegTaskSet.m_rate );
     task->mempage = ui.p.swRegTaskSet.task.mempage;
+    task->deadband = uiel_control_numeric_get( &ui.p.swRegTaskSet.deadband );
 }
 
 bool internal_graph_is_zoomed(void)
@@ -435,8 +438,8 @@ void ui_call_setwindow_quickswitch_op_switch( int context, void *pval )
         {
             if ( core.nvrec.running == 0 )
             {
-                ui.popup.params.line1 = (uint32)popup_msg_op_register_nosel1;       // need to trick the compiler to not to complain about const type
-                ui.popup.params.line2 = (uint32)popup_msg_op_register_nosel2;
+                ui.popup.params.line1 = popup_msg_op_register_nosel1;
+                ui.popup.params.line2 = popup_msg_op_register_nosel2;
                 ui.popup.params.line3 = 0;
                 ui.popup.params.style1 = uitxt_micro;
                 ui.popup.params.x1 = 4;
@@ -456,12 +459,12 @@ void ui_call_setwindow_quickswitch_op_switch( int context, void *pval )
         // stop monitoring / registering
         // context 0 - monitoring,   context 1 - registering
         if ( context == 0 )
-            ui.popup.params.line1 = (uint32)popup_msg_op_monitoring;       // need to trick the compiler to not to complain about const type
+            ui.popup.params.line1 = popup_msg_op_monitoring;
         else
-            ui.popup.params.line1 = (uint32)popup_msg_op_registering;       // need to trick the compiler to not to complain about const type
+            ui.popup.params.line1 = popup_msg_op_registering;
 
-        ui.popup.params.line2 = (uint32)popup_msg_op_monitoring2;
-        ui.popup.params.line3 = (uint32)popup_msg_op_2;
+        ui.popup.params.line2 = popup_msg_op_monitoring2;
+        ui.popup.params.line3 = popup_msg_op_2;
         ui.popup.params.style1 = uitxt_micro;
         ui.popup.params.style3 = uitxt_small;
         ui.popup.params.x1 = 15;
@@ -526,9 +529,9 @@ const char popup_msg_reset_minmax_2[] = "min/max values ?";
 
 void ui_call_setwindow_quickswitch_reset_minmax( int context, void *pval )
 {
-    ui.popup.params.line1 = (uint32)popup_msg_reset_minmax_1;       // need to trick the compiler to not to complain about const type
+    ui.popup.params.line1 = popup_msg_reset_minmax_1;
     ui.popup.params.line2 = 0;
-    ui.popup.params.line3 = (uint32)popup_msg_reset_minmax_2;
+    ui.popup.params.line3 = popup_msg_reset_minmax_2;
     ui.popup.params.style1 = uitxt_small;
     ui.popup.params.style3 = uitxt_small;
     ui.popup.params.x1 = 10;
@@ -579,8 +582,8 @@ void ui_call_setwindow_regtaskset_next_action( int context, void *pval )
     if ( memcmp( &task_ui, &core.nvrec.task[ui.p.swRegTaskSet.task_index], sizeof(task_ui) ) )     // if setup is changed
     {   
         ui.p.swRegTaskSet.task = task_ui;
-        ui.popup.params.line1 = (uint32)popup_msg_regtaskset_setup1;
-        ui.popup.params.line2 = (uint32)popup_msg_regtaskset_setup2;
+        ui.popup.params.line1 = popup_msg_regtaskset_setup1;
+        ui.popup.params.line2 = popup_msg_regtaskset_setup2;
         change = true;
     }
     else 
@@ -588,15 +591,15 @@ void ui_call_setwindow_regtaskset_next_action( int context, void *pval )
         if ( (core.nvrec.running & (1<<ui.p.swRegTaskSet.task_index)) &&
              (uiel_control_checkbox_get( &ui.p.swRegTaskSet.run ) == false)  )      // stopping
         {
-            ui.popup.params.line1 = (uint32)popup_msg_regtaskset_stop1;
-            ui.popup.params.line2 = (uint32)popup_msg_regtaskset_stop2;
+            ui.popup.params.line1 = popup_msg_regtaskset_stop1;
+            ui.popup.params.line2 = popup_msg_regtaskset_stop2;
             change = true;
         }
         else if (  ((core.nvrec.running & (1<<ui.p.swRegTaskSet.task_index)) == 0) &&
                    uiel_control_checkbox_get( &ui.p.swRegTaskSet.run )  )           // starting
         {
-            ui.popup.params.line1 = (uint32)popup_msg_regtaskset_start1;
-            ui.popup.params.line2 = (uint32)popup_msg_regtaskset_start2;
+            ui.popup.params.line1 = popup_msg_regtaskset_start1;
+            ui.popup.params.line2 = popup_msg_regtaskset_start2;
             change = true;
         }
 
@@ -608,7 +611,7 @@ void ui_call_setwindow_regtaskset_next_action( int context, void *pval )
         // if changes in setup - go through popup
         ui.popup.params.style1 = uitxt_small;
         ui.popup.params.style3 = uitxt_small;
-        ui.popup.params.line3 = (uint32)popup_msg_op_2;
+        ui.popup.params.line3 = popup_msg_op_2;
         ui.popup.params.x1 = 5;
         ui.popup.params.y1 = 2;
         ui.popup.params.y2 = 10;
@@ -710,9 +713,9 @@ void ui_call_setwindow_regtaskmem_exit( int context, void *pval )
     // if change - put callback
     if ( change )
     {
-        ui.popup.params.line1 = (uint32)popup_msg_regtaskmem_change;
-        ui.popup.params.line2 = (uint32)popup_msg_regtaskmem_tasks;
-        ui.popup.params.line3 = (uint32)popup_msg_op_2;
+        ui.popup.params.line1 = popup_msg_regtaskmem_change;
+        ui.popup.params.line2 = popup_msg_regtaskmem_tasks;
+        ui.popup.params.line3 = popup_msg_op_2;
 
         ui.popup.params.style1 = uitxt_small;
         ui.popup.params.style3 = uitxt_small;
@@ -775,23 +778,28 @@ bool internal_regtaskmem_inside( uint32 mstart, uint32 size, struct SRecTaskInst
 uint32 internal_regtaskmem_maxlenght( struct SRecTaskInstance task )
 {
     // maximum memory length is limmited to 2^16 elements
+    // the memory of 2^16 deadband elements depends on the signal - up to the largest blocks with their directory entries
+    uint32 pages = 0;
+
     switch ( task.task_elems )
     {
         case rtt_t:
         case rtt_h:
         case rtt_p:
-            return 96;          // 1.5 byte  - 1x 12bit -> 98304 bytes -> 96 pages
+            pages = 96;         // 1.5 byte  - 1x 12bit -> 98304 bytes -> 96 pages
             break;
         case rtt_th:
         case rtt_hp:
         case rtt_tp:
-            return 192;       // 3 bytes   - 2x 12bit -> 196608 bytes -> 192 pages
+            pages = 192;      // 3 bytes   - 2x 12bit -> 196608 bytes -> 192 pages
             break;
         case rtt_thp:
-            return 288;       // 4.5 bytes - 3x 12bit -> 294912 bytes -> 288 pages
+            pages = 288;      // 4.5 bytes - 3x 12bit -> 294912 bytes -> 288 pages
             break;
     }
-    return 0;
+    if ( task.deadband )
+        pages = ( (0x10000 >> RECDELTA_BLKSHIFT) * (RECDELTA_BLKMAX( RECPACK_CHANNELS( task.task_elems ) ) + 2) + CORE_RECMEM_PAGESIZE - 1 ) / CORE_RECMEM_PAGESIZE;
+    return pages;
 }
 
 
@@ -1000,6 +1008,9 @@ _reset_display:
 // ---- Setup menu
 
 const char popup_msg_dbg_dump[] = {"Dump NVRAM content?"};
+const char popup_msg_export[] = {"Export recordings?"};
+const char popup_msg_telemetry_on[] = {"Start telemetry?"};
+const char popup_msg_telemetry_off[] = {"Stop telemetry?"};
 
 // ---- menu itself
 
@@ -1024,7 +1035,7 @@ void ui_call_setmenu_action( int context, void *pval )
             uist_change_state( UI_STATE_NONE, UI_SET_SetupTime, true );
             return;
         case 5:
-            ui.popup.params.line1 = (uint32)popup_msg_dbg_dump;       // need to trick the compiler to not to complain about const type
+            ui.popup.params.line1 = popup_msg_dbg_dump;
             ui.popup.params.line2 = 0;
             ui.popup.params.line3 = 0;
             ui.popup.params.style1 = uitxt_small;
@@ -1033,6 +1044,29 @@ void ui_call_setmenu_action( int context, void *pval )
             ui.popup.params.popup_action = uipa_ok_cancel;
             uist_enter_popup( 0, ui_call_dbgdump_NVram, 0, NULL );
             return;
+        case 6:
+            ui.popup.params.line1 = popup_msg_export;
+            ui.popup.params.line2 = 0;
+            ui.popup.params.line3 = 0;
+            ui.popup.params.style1 = uitxt_small;
+            ui.popup.params.x1 = 4;
+            ui.popup.params.y1 = 12;
+            ui.popup.params.popup_action = uipa_ok_cancel;
+            uist_enter_popup( 0, ui_call_export_recordings, 0, NULL );
+            return;
+        case 7:
+            if ( core.vstatus.int_op.f.telemetry )
+                ui.popup.params.line1 = popup_msg_telemetry_off;
+            else
+                ui.popup.params.line1 = popup_msg_telemetry_on;
+            ui.popup.params.line2 = 0;
+            ui.popup.params.line3 = 0;
+            ui.popup.params.style1 = uitxt_small;
+            ui.popup.params.x1 = 4;
+            ui.popup.params.y1 = 12;
+            ui.popup.params.popup_action = uipa_ok_cancel;
+            uist_enter_popup( 0, ui_call_telemetry_switch, 0, NULL );
+            return;
     }
 }
 
@@ -1202,6 +1236,24 @@ void ui_call_dbgdump_NVram( int context, void *pval )
 }
 
 
+void ui_call_export_recordings( int context, void *pval )
+{
+    // from export popup
+    core_op_recording_export();
+
+    uist_close_popup();
+}
+
+
+void ui_call_telemetry_switch( int context, void *pval )
+{
+    // from telemetry popup - the stream runs till it is stopped here
+    core_op_telemetry_switch( core.vstatus.int_op.f.telemetry == 0 );
+
+    uist_close_popup();
+}
+
+
 // Popup window default callback
 
 void ui_call_popup_default( int context, void *pval )
@@ -1247,6 +1299,13 @@ bool uist_apply_newstate(void)
     return true;
 }
 
+// send the drawn content to the display - redraw flags are kept for the simulator's UI profiler
+static void uist_display_refresh( uint32 redraw )
+{
+    ui.upd_last = redraw;
+    DispHAL_UpdateScreen();
+}
+
 static void uist_update_display( int disp_update )
 {
     if ( disp_update )
@@ -1263,7 +1322,7 @@ static void uist_update_display( int disp_update )
 
             }
         }
-        DispHAL_UpdateScreen();
+        uist_display_refresh( disp_update );
     }
 }
 
@@ -1551,7 +1610,7 @@ void uist_enter_popup( uint8 cont_ok, uiel_callback call_ok, uint8 cont_cancel,
     uiel_control_pushbutton_set_callback( &ui.popup.pb2, UICpb_Esc, cont_cancel, call_cancel ? call_cancel : ui_call_popup_default );
 
     uist_drawview_popup( RDRW_ALL );
-    DispHAL_UpdateScreen();
+    uist_display_refresh( RDRW_ALL );
     ui.upd_ui_disp = RDRW_ALL;
 }
 
@@ -1615,7 +1674,7 @@ void uist_debuginputs_entry( void )
 {
     uist_setupview_debuginputs();
     uist_drawview_debuginputs( RDRW_ALL, 0 );
-    DispHAL_UpdateScreen();
+    uist_display_refresh( RDRW_ALL );
     ui.m_substate ++;
     ui.upd_dynamics = 0;
     ui.upd_batt = 0;
@@ -1669,7 +1728,7 @@ void uist_debuginputs( struct SEventStruct *evmask )
         if (update)
         {
             uist_drawview_debuginputs( RDRW_UI_DYNAMIC, bits );
-            DispHAL_UpdateScreen();
+            uist_display_refresh( RDRW_UI_DYNAMIC );
         }
     }
 }
@@ -1681,7 +1740,7 @@ void uist_shutdown_entry( void )
     Graphics_ClearScreen(0);
     Graphic_SetColor(1);
     Graphic_FillRectangle( 0, 0, 127, 63, 1 );
-    DispHAL_UpdateScreen();
+    uist_display_refresh( RDRW_ALL );
     //core_beep( beep_pwroff );
     ui.m_substate = 100;    // 1sec. startup screen
 }
@@ -1733,7 +1792,7 @@ void uist_shutdown( struct SEventStruct *evmask )
         DispHAL_Display_Off();
     }
 
-    DispHAL_UpdateScreen();
+    uist_display_refresh( RDRW_UI_CONTENT );
 }
 
 /// OPMODE SELECTOR WINDOW
@@ -1742,7 +1801,7 @@ void uist_opmodeselect_entry( void )
 {
     uist_setupview_modeselect( true );
     uist_drawview_modeselect( RDRW_ALL );
-    DispHAL_UpdateScreen();
+    uist_display_refresh( RDRW_ALL );
     ui.m_substate ++;
 }
 
@@ -1801,7 +1860,7 @@ void uist_setwindow_entry( void )
 {
     uist_setupview_setwindow( true );
     uist_drawview_setwindow( RDRW_ALL );
-    DispHAL_UpdateScreen();
+    uist_display_refresh( RDRW_ALL );
     ui.m_substate ++;
     ui.upd_ui_disp = 0;
 }
@@ -1855,7 +1914,7 @@ void uist_mainwindowgauge_entry( void )
     core.measure.dirty.b.upd_th_tendency = 1;       // force an update on the tendency graph values
     uist_setupview_mainwindow( true );
     uist_drawview_mainwindow( RDRW_ALL );
-    DispHAL_UpdateScreen();
+    uist_display_refresh( RDRW_ALL );
     core_op_realtime_sensor_select( (enum ESensorSelect)(ui.main_mode + 1) );
     ui.m_substate ++;
     ui.upd_ui_disp = 0;
@@ -2003,7 +2062,7 @@ void uist_mainwindowgraph_entry( void )
 
     uist_setupview_mainwindow( true );
     uist_drawview_mainwindow( RDRW_ALL );
-    DispHAL_UpdateScreen();
+    uist_display_refresh( RDRW_ALL );
 
     ui.focus = 1;
     ui.m_substate ++;
@@ -2088,8 +2147,7 @@ void uist_mainwindowgraph( struct SEventStruct *evmask )
         // power button activated
         if ( evmask->key_longpressed & KEY_MODE )
         {
-            if (core_op_recording_read_busy())
-                core_op_recording_read_cancel();        
+            core_op_recording_read_cancel();                // stop the readout and the live graph
 
             DispHal_ClearFlipBuffer();
             uist_goto_shutdown();
@@ -2097,8 +2155,7 @@ void uist_mainwindowgraph( struct SEventStruct *evmask )
         }
         if ( evmask->key_released & KEY_MODE )
         {
-            if (core_op_recording_read_busy())
-                core_op_recording_read_cancel();        
+            core_op_recording_read_cancel();                // stop the readout and the live graph
 
             core_op_realtime_sensor_select( ss_none );
             ui.m_state = UI_STATE_MODE_SELECT;
@@ -2110,8 +2167,7 @@ void uist_mainwindowgraph( struct SEventStruct *evmask )
         {
             if ( ui.p.grDisp.d_state & GRSTATE_DISP )
             {
-                if (core_op_recording_read_busy())
-                    core_op_recording_read_cancel();        
+                core_op_recording_read_cancel();            // stop the readout and the live graph
                 DispHal_ClearFlipBuffer();
                 ui.m_state = UI_STATE_SETWINDOW;
                 ui.m_setstate = UI_SET_GraphSelect;
@@ -2146,6 +2202,16 @@ void uist_mainwindowgraph( struct SEventStruct *evmask )
                     ui.upd_ui_disp |= RDRW_UI_DYNAMIC;
             }
         }
+        else if ( core.measure.dirty.b.upd_rec_graph &&
+                  (ui.p.grDisp.d_state & (GRSTATE_DISP | GRSTATE_DETAIL)) )
+        {
+            // new elements were added to the graph while recording
+            core.measure.dirty.b.upd_rec_graph = 0;
+            if ( (ui.p.grDisp.view_elemend == 0) && (core.readout.total_read <= WB_DISPPOINT) )
+                ui.p.grDisp.view_elemstart = core.readout.total_read;      // short graph grows till the display is filled
+            ui.p.grDisp.graph_dirty = 1;
+            ui.upd_ui_disp |= RDRW_UI_CONTENT_ALL;
+        }
     }
 
     // update screen on timebase
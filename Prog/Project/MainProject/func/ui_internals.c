@@ -38,7 +38,7 @@ extern struct SCore core;
 
 const char c_menu_graph_main_nozoom[]            = { "info select zoom_to" };
 const char c_menu_graph_main_zoom[]              = { "info select pan zoom_out zoom_to" };
-const char c_menu_setup_menu[]                   = { "display sound alarms time power dbgDump" };
+const char c_menu_setup_menu[]                   = { "display sound alarms time power dbgDump export telemetry" };
 
 const char upd_rates[][6]               = { "5 sec",  "10sec",  "30sec",  "1 min",  "2 min",  "5 min",  "10min",  "30min",  "60min" };
 
@@ -137,18 +137,8 @@ static void internal_graphdisp_render( bool minmax )
     Graphic_SetColor(1);
     if ( minmax )
     {
-        uint8 *mins;
-        uint8 *maxs;
-
-        mins = grf_values;
-        maxs = grf_values + WB_DISPPOINT;
-
-        for (i=0; i<WB_DISPPOINT; i++)
-        {
-            Graphic_Line( i, *maxs, i, *mins );
-            maxs++;
-            mins++;
-        }
+        // min/max columns - mins are at the beginning, maxs are after them
+        Graphic_ColumnSpans( 0, WB_DISPPOINT, grf_values + WB_DISPPOINT, grf_values );
     }
     else
     {
@@ -165,36 +155,46 @@ static void internal_graphdisp_render( bool minmax )
 
 static uint32 internal_graphdisp_convert_cursor2time( uint32 sample_nr, timestruct *time, datestruct *date )
 {
+    uint32 step;
     uint32 rtime;
 
-    rtime = sample_nr * core_utils_timeunit2seconds( core.nvrec.task[ui.m_return].sample_rate ) * 2;
+    step = core_utils_timeunit2seconds( core.nvrec.task[ui.m_return].sample_rate ) * 2;
+    rtime = sample_nr * step;
     if ( rtime > core.readout.last_timestamp )
         rtime = 0;
     else
         rtime = core.readout.last_timestamp - rtime;
 
-    if ( time )
-        utils_convert_counter_2_hms( rtime, &time->hour, &time->minute, &time->second );
-    if ( date )
-        utils_convert_counter_2_ymd( rtime, &date->year, &date->mounth, &date->day );
+    if ( time || date )
+        utils_convert_samples_2_datetime( core.readout.last_timestamp, step, &sample_nr, 1, date, time );
 
     return rtime;
 }
 
-static void internal_graphdisp_putXtime( uint32 xpoz, uint32 sample_nr, bool inverted )
+static void internal_graphdisp_putXscale( uint32 smpl_left, uint32 smpl_right, bool inverted )
 {
-    timestruct tm;
-    datestruct dt;
-
-    internal_graphdisp_convert_cursor2time( sample_nr, &tm, &dt );
-    
-    uigrf_puttime( xpoz, 1, uitxt_micro, 1, tm, true, false );
-    uigrf_putdate( xpoz, 8, uitxt_micro, 1, dt, false, false );
+    // time of the left and right end of the X scale - converted together, they are mostly in the same month
+    static const uint8 xpoz[2] = { 1, 99 };
+    uint32 smpl[2];
+    timestruct tm[2];
+    datestruct dt[2];
+    uint32 i;
+
+    smpl[0] = smpl_left;
+    smpl[1] = smpl_right;
+    utils_convert_samples_2_datetime( core.readout.last_timestamp, core_utils_timeunit2seconds( core.nvrec.task[ui.m_return].sample_rate ) * 2,
+                                      smpl, 2, dt, tm );
 
-    if (inverted)
+    for ( i=0; i<2; i++ )
     {
-        Graphic_SetColor(-1);
-        Graphic_FillRectangle( xpoz-1, 0, xpoz+20, 13, -1 );
+        uigrf_puttime( xpoz[i], 1, uitxt_micro, 1, tm[i], true, false );
+        uigrf_putdate( xpoz[i], 8, uitxt_micro, 1, dt[i], false, false );
+
+        if (inverted)
+        {
+            Graphic_SetColor(-1);
+            Graphic_FillRectangle( xpoz[i]-1, 0, xpoz[i]+20, 13, -1 );
+        }
     }
 }
 
@@ -620,7 +620,7 @@ static void internal_task_allocation_bar( struct SRecTaskInstance *tasks, uint32
 
 static uint32 internal_mem_rate_2_time( struct SRecTaskInstance task )
 {
-    return core_op_recording_get_total_samplenr( task.size * CORE_RECMEM_PAGESIZE, (enum ERecordingTaskType)task.task_elems ) * core_utils_timeunit2seconds( task.sample_rate );
+    return core_op_recording_get_total_samplenr( task.size * CORE_RECMEM_PAGESIZE, (enum ERecordingTaskType)task.task_elems, task.deadband ) * core_utils_timeunit2seconds( task.sample_rate );
 }   
 
 
@@ -947,8 +947,7 @@ static inline void uist_draw_graph( int redraw_all )
         // static X scale
         if ( (ui.p.grDisp.d_state & GRSTATE_SELECT_ZOOM) == 0 )     // X scale for non-zoom select mode (it is static)
         {
-            internal_graphdisp_putXtime( 1, ui.p.grDisp.view_elemstart, false );
-            internal_graphdisp_putXtime( 99, ui.p.grDisp.view_elemend, false );
+            internal_graphdisp_putXscale( ui.p.grDisp.view_elemstart, ui.p.grDisp.view_elemend, false );
         }
 
         // zoom bar
@@ -1009,8 +1008,8 @@ static inline void uist_draw_graph( int redraw_all )
             Graphic_SetColor(0);
             Graphic_FillRectangle(0, 0, 21, 13, 0);
             Graphic_FillRectangle(98, 0, 119, 13, 0);
-            internal_graphdisp_putXtime( 1, internal_graphdisp_cursor2samplenr( ui.p.grDisp.view_cursor1 ), true );
-            internal_graphdisp_putXtime( 99, internal_graphdisp_cursor2samplenr( ui.p.grDisp.view_cursor2 ), true );
+            internal_graphdisp_putXscale( internal_graphdisp_cursor2samplenr( ui.p.grDisp.view_cursor1 ),
+                                          internal_graphdisp_cursor2samplenr( ui.p.grDisp.view_cursor2 ), true );
         }
 
         // cursor
@@ -1077,9 +1076,9 @@ static inline void uist_draw_setwindow_quickswitch( int redraw_type )
         for (i=0; i<3; i++)
         {
             int setval;
-            uint32 textaddr;
+            const char *textaddr;
             setval = uiel_control_list_get_value( &ui.p.swQuickSw.m_rates[i]);
-            textaddr = (uint32)tendency_total_lenght[setval];                   // trick the compiler
+            textaddr = tendency_total_lenght[setval];
             uigrf_text( 36, 20+11*i, uitxt_micro, (char*)textaddr );
         }
         
@@ -1114,9 +1113,10 @@ static inline void uist_draw_setwindow_regtask_set( int redraw_type )
         else
             uigrf_text( 106, 18, uitxt_micro,  "STOP" );
 
-        uigrf_text( 86, 26, uitxt_micro,  "TOTAL TIME:" );
+        uigrf_text( 86, 26, uitxt_micro,  "DBAND:" );
+        uigrf_text( 86, 34, uitxt_micro,  "TIME:" );
         time = internal_mem_rate_2_time( tasks[ui.p.swRegTaskSet.task_index] );
-        internal_puttime_info( 92, 34, uitxt_micro, time, true );
+        internal_puttime_info( 104, 34, uitxt_micro, time, false );
     }
 
     if ( redraw_type & RDRW_UI_CONTENT )
@@ -1144,7 +1144,8 @@ static inline void uist_draw_setwindow_regtask_mem( int redraw_type )
         uigrf_text( 72, 34, uitxt_micro,  "Smpl:" );
 
         smpl = core_op_recording_get_total_samplenr( ui.p.swRegTaskMem.task[ui.p.swRegTaskMem.task_index].size * CORE_RECMEM_PAGESIZE,
-                                                    (enum ERecordingTaskType)ui.p.swRegTaskMem.task[ui.p.swRegTaskMem.task_index].task_elems );
+                                                    (enum ERecordingTaskType)ui.p.swRegTaskMem.task[ui.p.swRegTaskMem.task_index].task_elems,
+                                                    ui.p.swRegTaskMem.task[ui.p.swRegTaskMem.task_index].deadband );
         uigrf_putnr( 92, 34, uitxt_micro, smpl, 5, 0, false );
         smpl = internal_mem_rate_2_time( ui.p.swRegTaskMem.task[ui.p.swRegTaskMem.task_index] );
         internal_puttime_info( 92, 26, uitxt_micro, smpl, true );
@@ -1166,11 +1167,11 @@ static inline void uist_draw_graphselect( int redraw_type )
 
         for (i=0; i<4; i++)
         {
-            uint32 txtaddr;
+            const char *txtaddr;
             time = core.nvrec.func[i].c * core_utils_timeunit2seconds( core.nvrec.task[i].sample_rate );
             internal_rectask_summary( 0, 17+i*12, i, time );
             internal_puttime_info( 72, 20+i*12, uitxt_micro, internal_mem_rate_2_time( core.nvrec.task[i] ), false );
-            txtaddr = (uint32)upd_rates[ core.nvrec.task[i].sample_rate ];
+            txtaddr = upd_rates[ core.nvrec.task[i].sample_rate ];
             uigrf_text( 107, 20+i*12, uitxt_micro, (char*)txtaddr );
         }
     }
@@ -1344,7 +1345,7 @@ static inline void uist_setview_mainwindow_graph( void )
 {
     int i;
     ui.ui_elem_nr = 0;
-    uint32 txtaddr;
+    const char *txtaddr = NULL;
 
     switch ( ui.p.grDisp.d_state & GRSTATE_MASK )
     {
@@ -1372,9 +1373,9 @@ static inline void uist_setview_mainwindow_graph( void )
             {
                 switch ( ui.p.grDisp.view_elem + 1 )
                 {
-                    case ss_thermo:     txtaddr=(uint32)grunit_txt_temp[i];  break;
-                    case ss_rh:         txtaddr=(uint32)grunit_txt_rh[i];    break;
-                    case ss_pressure:   txtaddr=(uint32)grunit_txt_press[i]; break;
+                    case ss_thermo:     txtaddr=grunit_txt_temp[i];  break;
+                    case ss_rh:         txtaddr=grunit_txt_rh[i];    break;
+                    case ss_pressure:   txtaddr=grunit_txt_press[i]; break;
                 }
                 uiel_control_list_add_item( &ui.p.grDisp.ctrl.unit, (char*)txtaddr, i );
             }
@@ -1489,13 +1490,20 @@ static inline void uist_setview_setwindow_regtask_set( void )
     uiel_control_list_set_callback( &ui.p.swRegTaskSet.m_rate, UIClist_EscLong, 0, ui_call_setwindow_dbg_gen_data );
     ui.ui_elems[4] = &ui.p.swRegTaskSet.m_rate;
 
+    // deadband in 12bit LSB - 0 for the 12bit packed elements
+    uiel_control_numeric_init( &ui.p.swRegTaskSet.deadband, 0, CORE_REC_MAXDEADBAND, 1, 108, 24, 2, ' ', uitxt_micro );
+    uiel_control_numeric_set( &ui.p.swRegTaskSet.deadband, core.nvrec.task[task_idx].deadband );
+    uiel_control_numeric_set_callback( &ui.p.swRegTaskSet.deadband, UICnum_Esc, UI_REG_TO_BEFORE, ui_call_setwindow_regtaskset_next_action );
+    uiel_control_numeric_set_callback( &ui.p.swRegTaskSet.deadband, UICnum_Vchange, 0, ui_call_setwindow_regtaskset_valch );
+    ui.ui_elems[5] = &ui.p.swRegTaskSet.deadband;
+
     uiel_control_pushbutton_init( &ui.p.swRegTaskSet.reallocate, 0, 40, 127, 23 );
     uiel_control_pushbutton_set_content( &ui.p.swRegTaskSet.reallocate, uicnt_hollow, 0, NULL, uitxt_micro );
     uiel_control_pushbutton_set_callback( &ui.p.swRegTaskSet.reallocate, UICpb_Esc, UI_REG_TO_BEFORE, ui_call_setwindow_regtaskset_next_action );
     uiel_control_pushbutton_set_callback( &ui.p.swRegTaskSet.reallocate, UICpb_OK, UI_REG_TO_REALLOC, ui_call_setwindow_regtaskset_next_action );
-    ui.ui_elems[5] = &ui.p.swRegTaskSet.reallocate;
+    ui.ui_elems[6] = &ui.p.swRegTaskSet.reallocate;
 
-    ui.ui_elem_nr = 6;
+    ui.ui_elem_nr = 7;
 }
 
 
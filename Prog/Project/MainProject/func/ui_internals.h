@@ -145,6 +145,7 @@
         struct Suiel_control_checkbox   run;
         struct Suiel_control_checkbox   THP[3];
         struct Suiel_control_list       m_rate;
+        struct Suiel_control_numeric    deadband;
         struct Suiel_control_pushbutton reallocate;
     };
 
@@ -200,9 +201,9 @@
 
     struct SPopupSetup
     {
-        uint32 line1;   // pointer to the text line1
-        uint32 line2;   // pointer to the text line2 
-        uint32 line3;   // pointer to the text line2 
+        const char *line1;  // text line1
+        const char *line2;  // text line2
+        const char *line3;  // text line3
         uint8 x1;       // coordinates of line 1
         uint8 y1;
         uint8 y2;
@@ -264,6 +265,7 @@
         uint32 upd_time;        // old saved clock- used to compare with current one and update display if needed
 
         uint32 upd_ui_disp;     // display update type to be used at polling. It will set in ui callbacks also
+        uint32 upd_last;        // redraw flags of the last display update ( RDRW_xxx ) - used by the simulator's UI profiler
     };
 
     #define UI_REG_TO_BEFORE    0x00
@@ -315,6 +317,8 @@
     void ui_call_settime_action( int context, void *pval );
 
     void ui_call_dbgdump_NVram( int context, void *pval );
+    void ui_call_export_recordings( int context, void *pval );
+    void ui_call_telemetry_switch( int context, void *pval );
 
     // routines
     void uist_drawview_modeselect( int redraw_type );
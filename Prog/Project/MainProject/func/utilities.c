@@ -5,6 +5,64 @@ const int mounthLUTly[] = { 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 33
 const int mounthDays[] =  { 31, 0, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };       // days in a mounth
 
 
+// Calendar cache - the day of the last conversion with the bounds of its month and year, all in days from YEAR_START
+// A day in the cached month is converted with a subtraction, the year and month search is done only when the month changes.
+// The cache follows the converted counters, a new RTC setting needs no invalidation.
+static struct
+{
+    uint16  days;                   // cached day
+    uint16  mon_first;              // first day of its month
+    uint16  mon_next;               // first day of the next month
+    uint16  year_first;             // first day of its year
+    uint16  year;                   // years from YEAR_START
+    uint8   mounth;                 // 0 based
+    uint8   day;                    // 0 based
+    uint8   dow;                    // day of week - 0 is monday
+    uint8   woy;                    // week of year - 0 based
+} cal = { 0, 0, 31, 0, 0, 0, 0, WEEK_START, 0 };      // start date
+
+
+static inline void internal_calendar_seek( uint32 days )
+{
+    const int *mounthLUT;
+    uint32 year;
+    int i;
+
+    if ( days == cal.days )
+        return;
+
+    if ( (days - cal.mon_first) >= (uint32)(cal.mon_next - cal.mon_first) )
+    {
+        // other month - year from the 365.25 day mean year ( the rounding adds the leap day ), month from the day table
+        year = (days * 100 + 99) / 36525;
+        cal.year = year;
+        cal.year_first = (year * 36525) / 100;
+
+        if ( (year+1) % 4 )
+            mounthLUT = mounthLUTny;
+        else
+            mounthLUT = mounthLUTly;
+
+        for (i=11; i>=0; i--)
+        {
+            if ( mounthLUT[i] <= (days - cal.year_first) )
+                break;
+        }
+        cal.mounth = i;
+        cal.mon_first = cal.year_first + mounthLUT[i];
+        if ( i < 11 )
+            cal.mon_next = cal.year_first + mounthLUT[i+1];
+        else
+            cal.mon_next = ((year + 1) * 36525) / 100;
+    }
+
+    cal.days = days;
+    cal.day  = days - cal.mon_first;
+    cal.dow  = (days + WEEK_START) % 7;
+    cal.woy  = (days + WEEK_START) / 7 - (cal.year_first + WEEK_START) / 7;
+}
+
+
 void utils_convert_counter_2_hms( uint32 counter, uint8 *phour, uint8 *pminute, uint8 *psecond)
 {
     counter = (counter>>1) % (3600*24);    // get the hour of day
@@ -20,38 +78,50 @@ void utils_convert_counter_2_hms( uint32 counter, uint8 *phour, uint8 *pminute,
 
 void utils_convert_counter_2_ymd( uint32 counter, uint16 *pyear, uint8 *pmounth, uint8 *pday )
 {
-    uint32 year;
-    uint32 mounth;
-    uint32 day;
-    const int *mounthLUT;
-    int i;
-    counter = (counter>>1) / (3600*24);     // get the day nr from YEAR_START
+    internal_calendar_seek( counter / DAY_TICKS );      // get the day nr from YEAR_START
+
+    if ( pday )
+        *pday = cal.day+1;
+    if ( pmounth )
+        *pmounth = cal.mounth+1;
+    if ( pyear )
+        *pyear = cal.year+YEAR_START;
+}
 
-    year = (counter * 100 + 99) / 36525;   // calculate the year
-    counter -= ((year * 36525) / 100);      // leave only the days from year
 
-    // find the mouth
-    if ( (year+1) % 4 )
-        mounthLUT = mounthLUTny;
-    else
-        mounthLUT = mounthLUTly;
+void utils_convert_samples_2_datetime( uint32 counter, uint32 step, const uint32 *samples, uint32 count, datestruct *pdate, timestruct *ptime )
+{
+    uint32 rtime;
+    uint32 days;
+    uint32 sec;
 
-    for (i=11; i>=0; i--)
+    while ( count-- )
     {
-        if ( mounthLUT[i] <= counter )
-            break;
+        rtime = *samples++ * step;
+        if ( rtime > counter )
+            rtime = 0;
+        else
+            rtime = counter - rtime;
+
+        days = rtime / DAY_TICKS;
+        internal_calendar_seek( days );
+        if ( pdate )
+        {
+            pdate->year   = cal.year+YEAR_START;
+            pdate->mounth = cal.mounth+1;
+            pdate->day    = cal.day+1;
+            pdate++;
+        }
+        if ( ptime )
+        {
+            sec = (rtime - days * DAY_TICKS) >> 1;          // second of the day
+            ptime->hour   = sec / 3600;
+            sec = sec % 3600;
+            ptime->minute = sec / 60;
+            ptime->second = sec % 60;
+            ptime++;
+        }
     }
-    mounth = i;
-
-    // find the day
-    day = counter - mounthLUT[i];
-
-    if ( pday )
-        *pday = day+1;
-    if ( pmounth )
-        *pmounth = mounth+1;
-    if ( pyear )
-        *pyear = year+YEAR_START;
 }
 
 uint32 utils_convert_date_2_counter( datestruct *pdate, timestruct *ptime )
@@ -109,36 +179,13 @@ uint32 utils_maximum_days_in_mounth( datestruct *pdate )
 
 uint32 utils_day_of_week( uint32 counter )
 {
-    uint32 dow;
-
-    dow = (counter >> 1) / (3600*24);       // gives back the days;
-    dow = (dow + WEEK_START) % 7;
-    return dow;                             // return 0 based value (0 means monday)
+    internal_calendar_seek( counter / DAY_TICKS );
+    return cal.dow;                         // return 0 based value (0 means monday)
 }
 
 uint32 utils_week_of_year( uint32 counter )
 {
-    uint32 woy;
-    uint32 days_yearstart;
-    uint32 days_thisday;
-
-    days_thisday = (counter >> 1) / (3600*24);          // total days till this day
-
-    // calculate the start day of this year ( yearX_Ian_01 )
-    woy = (days_thisday * 100 + 99) / 36525;            // calculate the year 
-    days_yearstart = ((woy * 36525) / 100);             // days till beginning of this year - the rounding takes care of leap year +1 day addition
-
-    days_thisday = (days_thisday + WEEK_START) / 7;         // this amount of weeks till the current day
-    days_yearstart = ( days_yearstart + WEEK_START ) / 7;   // this amount of weeks till the current year
-    woy = days_thisday - days_yearstart;
-    return woy;
+    // weeks till the current day minus the weeks till the start of this year
+    internal_calendar_seek( counter / DAY_TICKS );
+    return cal.woy;
 }
-
-
-
-
-
-
-
-
-
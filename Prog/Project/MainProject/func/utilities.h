@@ -23,8 +23,15 @@
 void utils_convert_counter_2_hms( uint32 counter, uint8 *phour, uint8 *pminute, uint8 *psecond);
 
 
+// convert RTC counter to year / mounth / day. Conversions of the same day and month are served from the calendar cache,
+// so counters near each other ( graph labels, clock display ) are converted without the year / mounth search
 void utils_convert_counter_2_ymd( uint32 counter, uint16 *pyear, uint8 *pmounth, uint8 *pday );
 
+// convert the sample indices back from the newest sample at 'counter' to date and time: counter - samples[i] * step,
+// limited to 0. pdate / ptime are arrays of 'count' entries, any of them can be NULL. Use it for close samples in order,
+// the calendar cache keeps the month between them
+void utils_convert_samples_2_datetime( uint32 counter, uint32 step, const uint32 *samples, uint32 count, datestruct *pdate, timestruct *ptime );
+
 // convert date and time to counter. Time can be ommited (NULL) - it puts 00:00:00 in that case
 uint32 utils_convert_date_2_counter( datestruct *date, timestruct *time );
 
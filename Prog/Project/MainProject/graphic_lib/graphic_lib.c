@@ -342,6 +342,93 @@ const uint8 SystemFontData[] = {0x25, 0x08, 0x05, 0x84, 0x10, 0x42, 0x00, 0x01,
     }//END: internal_rectangle_draw_1bp
 
 
+    // draws a vertical span y1 - y2 ( y1 <= y2, clipped ) on column x with byte masks
+    static inline void internal_vspan_draw_1bp( uint32 x, uint32 y1, uint32 y2, int32 color )
+    {
+        uint8 *mem  = g_mem + (y1 >> 3) * GDISP_MAX_MEM_W + x;
+        uint8 *last = g_mem + (y2 >> 3) * GDISP_MAX_MEM_W + x;
+        uint8 b     = (uint8)( 0xff << (y1 & 0x07) );           // first byte: bits from y1 downward
+        uint8 l     = (uint8)( 0xff >> (7 - (y2 & 0x07)) );     // last byte: bits till y2
+
+        while (1)
+        {
+            if ( mem == last )
+                b &= l;
+
+            if ( color == GRAPHIC_1BIT_BLACK )
+                *mem &= ~b;
+            else if ( color == GRAPHIC_1BIT_WHITE )
+                *mem |= b;
+            else
+                *mem ^= b;
+
+            if ( mem == last )
+                break;
+            mem += GDISP_MAX_MEM_W;
+            b    = 0xff;
+        }
+    }//END: internal_vspan_draw_1bp
+
+
+    // draws a horizontal span x1 - x2 ( x1 <= x2, clipped ) on line y
+    static inline void internal_hspan_draw_1bp( uint32 x1, uint32 x2, uint32 y, int32 color )
+    {
+        uint8 *mem  = g_mem + (y >> 3) * GDISP_MAX_MEM_W + x1;
+        uint8 b     = (uint8)( 1 << (y & 0x07) );
+        uint32 cnt  = x2 - x1 + 1;
+
+        if ( color == GRAPHIC_1BIT_BLACK )
+        {
+            b = ~b;
+            while ( cnt-- )
+                *mem++ &= b;
+        }
+        else if ( color == GRAPHIC_1BIT_WHITE )
+        {
+            while ( cnt-- )
+                *mem++ |= b;
+        }
+        else
+        {
+            while ( cnt-- )
+                *mem++ ^= b;
+        }
+    }//END: internal_hspan_draw_1bp
+
+
+    // draws a vertical or horizontal line clipped to the drawing window
+    static void internal_hvline_draw_1bp( int32 x1, int32 y1, int32 x2, int32 y2, int32 color )
+    {
+        int32 tmp;
+
+        if ( x1 > x2 )
+        {
+            tmp = x1; x1 = x2; x2 = tmp;
+        }
+        if ( y1 > y2 )
+        {
+            tmp = y1; y1 = y2; y2 = tmp;
+        }
+
+        if ( (x2 < (int32)G_var.draw_window.X1) || (x1 > (int32)G_var.draw_window.X2) ||
+             (y2 < (int32)G_var.draw_window.Y1) || (y1 > (int32)G_var.draw_window.Y2) )
+            return;
+        if ( x1 < (int32)G_var.draw_window.X1 )
+            x1 = G_var.draw_window.X1;
+        if ( x2 > (int32)G_var.draw_window.X2 )
+            x2 = G_var.draw_window.X2;
+        if ( y1 < (int32)G_var.draw_window.Y1 )
+            y1 = G_var.draw_window.Y1;
+        if ( y2 > (int32)G_var.draw_window.Y2 )
+            y2 = G_var.draw_window.Y2;
+
+        if ( x1 == x2 )
+            internal_vspan_draw_1bp( x1, y1, y2, color );
+        else
+            internal_hspan_draw_1bp( x1, x2, y1, color );
+    }//END: internal_hvline_draw_1bp
+
+
 
 
 
@@ -472,6 +559,7 @@ const uint8 SystemFontData[] = {0x25, 0x08, 0x05, 0x84, 0x10, 0x42, 0x00, 0x01,
                     g_mem[ y * GDISP_MAX_MEM_W + x ] = g_mem[ y * GDISP_MAX_MEM_W + x + amount ]; 
                 }
             }
+            DispHAL_NeedUpdate( X1, Y1, final, Y2 );
         }
     #else
         return GRESULT_NOT_IMPLEMENTED;
@@ -532,6 +620,16 @@ const uint8 SystemFontData[] = {0x25, 0x08, 0x05, 0x84, 0x10, 0x42, 0x00, 0x01,
             return GRESULT_PARAM_ERROR;
     #endif
 
+    #if (GDISP_PIXEL_FORMAT == gpixformat_1bit)
+        if ( ((X1 == X2) || (Y1 == Y2)) && (G_var.line_width == 1) )
+        {
+            // optimized routine for vertical / horizontal lines
+            internal_hvline_draw_1bp( X1, Y1, X2, Y2, G_var.color );
+            DispHAL_NeedUpdate( X1, Y1, X2, Y2 );
+            return GRESULT_OK;
+        }
+    #endif
+
         windowed = check_need_windowed( X1, Y1, X2, Y2 );
 
         MakeLine( X1, Y1, X2, Y2, windowed );
@@ -542,6 +640,51 @@ const uint8 SystemFontData[] = {0x25, 0x08, 0x05, 0x84, 0x10, 0x42, 0x00, 0x01,
     }//END: Graphic_Line
 
 
+    g_result Graphic_ColumnSpans( uint32 X, uint32 count, const uint8 *Y1, const uint8 *Y2 )
+    {
+        uint32 i;
+        uint32 ymin = GDISP_HEIGHT - 1;
+        uint32 ymax = 0;
+        uint32 ya;
+        uint32 yb;
+
+    #if ( GASSERTION_LEVEL & GASSERTION_CHECK_PARAMS )
+        if ( (G_var.line_width == 0) || (count == 0) )
+            return GRESULT_PARAM_ERROR;
+    #endif
+
+        for ( i=0; i<count; i++ )
+        {
+            if ( Y1[i] < Y2[i] )
+            {
+                ya = Y1[i];
+                yb = Y2[i];
+            }
+            else
+            {
+                ya = Y2[i];
+                yb = Y1[i];
+            }
+            if ( ymin > ya )
+                ymin = ya;
+            if ( ymax < yb )
+                ymax = yb;
+
+    #if (GDISP_PIXEL_FORMAT == gpixformat_1bit)
+            if ( G_var.line_width == 1 )
+            {
+                internal_hvline_draw_1bp( X + i, ya, X + i, yb, G_var.color );
+                continue;
+            }
+    #endif
+            MakeLine( X + i, ya, X + i, yb, check_need_windowed( X + i, ya, X + i, yb ) );
+        }
+
+        DispHAL_NeedUpdate( X, ymin, X + count - 1, ymax );
+        return GRESULT_OK;
+    }//END: Graphic_ColumnSpans
+
+
     g_result Graphic_AALine( uint32 X1, uint32 Y1, uint32 X2, uint32 Y2 )
     {
     #if ( GASSERTION_LEVEL & GASSERTION_CHECK_PARAMS )
@@ -808,6 +951,103 @@ const uint8 SystemFontData[] = {0x25, 0x08, 0x05, 0x84, 0x10, 0x42, 0x00, 0x01,
     //       !"#$%&'()*+,-./0123456789:
     
 
+#if (GDISP_PIXEL_FORMAT == gpixformat_1bit)
+
+    #define GLYPH_BLIT_MAX_W        24      // glyph rows are collected in a 32bit accumulator
+    #define GLYPH_BLIT_MAX_H        25      // glyph columns are shifted to the page position in 32bit
+
+    // bits of a nibble spread to the LSB of 4 bytes - 4 glyph pixels of a row to 4 column bytes
+    static const uint32 glyph_nibble_to_cols[16] = { 0x00000000, 0x00000001, 0x00000100, 0x00000101,
+                                                     0x00010000, 0x00010001, 0x00010100, 0x00010101,
+                                                     0x01000000, 0x01000001, 0x01000100, 0x01000101,
+                                                     0x01010000, 0x01010001, 0x01010100, 0x01010101 };
+
+    // draws a glyph from the font data with whole column bytes. Glyph is converted to columns
+    // of vertical bits, clipped once, then each column is or-ed / and-ed into the page bytes
+    static void internal_glyph_draw_1bp( const uint8 *fchar, uint32 width, uint32 height )
+    {
+        uint32 col[GLYPH_BLIT_MAX_W];                   // glyph columns, bit 0 is the top row
+        uint32 cols4[GLYPH_BLIT_MAX_W / 4];             // column bytes of an 8 row band - 4 columns in each
+        int32  x1    = G_var.text.Xpoz;
+        int32  x2    = G_var.text.Xpoz + width - 1;
+        int32  ylo   = (int32)G_var.draw_window.Y1 - (int32)G_var.text.Ypoz;    // first visible glyph row
+        int32  yhi   = (int32)G_var.draw_window.Y2 - (int32)G_var.text.Ypoz;    // last visible glyph row
+        uint32 ymask;
+        uint32 acc   = 0;
+        uint32 nbits = 0;
+        uint32 row;
+        uint32 band;
+        uint32 x, y;
+
+        // clipping for the whole glyph
+        if ( x1 < (int32)G_var.draw_window.X1 )
+            x1 = G_var.draw_window.X1;
+        if ( x2 > (int32)G_var.draw_window.X2 )
+            x2 = G_var.draw_window.X2;
+        if ( x2 > (GDISP_WIDTH - 1) )
+            x2 = GDISP_WIDTH - 1;
+        if ( ylo < 0 )
+            ylo = 0;
+        if ( yhi > (int32)height - 1 )
+            yhi = height - 1;
+        if ( (x1 > x2) || (ylo > yhi) || (width == 0) )
+            return;
+        ymask = ( (1 << (yhi + 1)) - 1 ) & ~( (1 << ylo) - 1 );
+
+        // rows to columns - glyph data is a bit stream of 'width' bit rows, LSB first.
+        // Each 8 row band is collected in column bytes, 4 columns at once with the nibble table
+        memset( col, 0, width * sizeof(uint32) );
+        for ( band=0; band<height; band+=8 )
+        {
+            memset( cols4, 0, sizeof(cols4) );
+            for ( y=band; (y < band + 8) && (y < height); y++ )
+            {
+                while ( nbits < width )
+                {
+                    acc |= (uint32)(*fchar++) << nbits;
+                    nbits += 8;
+                }
+                row    = acc & ( (1 << width) - 1 );
+                acc  >>= width;
+                nbits -= width;
+
+                if ( (ymask & (1 << y)) == 0 )
+                    continue;
+                for ( x=0; row; x++, row >>= 4 )
+                    cols4[x] |= glyph_nibble_to_cols[ row & 0x0f ] << (y - band);
+            }
+            for ( x=0; x<width; x++ )
+                col[x] |= ( (cols4[x >> 2] >> ((x & 0x03) * 8)) & 0xff ) << band;
+        }
+
+        // put the columns in the page bytes
+        {
+            uint8  *mem   = g_mem + (G_var.text.Ypoz >> 3) * GDISP_MAX_MEM_W + x1;
+            uint32 *pcol  = col + ( x1 - G_var.text.Xpoz );
+            uint32 shift  = G_var.text.Ypoz & 0x07;
+            int32  color  = G_var.text.color;
+            uint32 bits;
+            uint8  *pm;
+
+            for ( x = (uint32)x1; x <= (uint32)x2; x++, mem++ )
+            {
+                bits = *pcol++ << shift;
+                for ( pm = mem; bits; bits >>= 8, pm += GDISP_MAX_MEM_W )
+                {
+                    if ( color == GRAPHIC_1BIT_BLACK )
+                        *pm &= ~(uint8)bits;
+                    else if ( color == GRAPHIC_1BIT_WHITE )
+                        *pm |= (uint8)bits;
+                    else
+                        *pm ^= (uint8)bits;
+                }
+            }
+        }
+    }//END: internal_glyph_draw_1bp
+
+#endif
+
+
     static bool CheckCHRinFont( uint8 *pchr )
     {
         uint8 chr = *pchr;
@@ -973,6 +1213,13 @@ const uint8 SystemFontData[] = {0x25, 0x08, 0x05, 0x84, 0x10, 0x42, 0x00, 0x01,
             }
 
             // we have the data pointer for the current character, begin to draw it
+        #if (GDISP_PIXEL_FORMAT == gpixformat_1bit)
+            if ( (width <= GLYPH_BLIT_MAX_W) && (height <= GLYPH_BLIT_MAX_H) )
+            {
+                internal_glyph_draw_1bp( fchar, width, height );
+            }
+            else
+        #endif
             {
                 uint32 x;
                 uint32 y;
@@ -224,6 +224,10 @@
     // draws a simple line
     g_result Graphic_Line( uint32 X1, uint32 Y1, uint32 X2, uint32 Y2 );
 
+    // draws 'count' vertical lines on the adjacent columns from X, line i is drawn between Y1[i] and Y2[i]
+    // faster than separate Graphic_Line() calls for column graphs - display update is requested once for the whole area
+    g_result Graphic_ColumnSpans( uint32 X, uint32 count, const uint8 *Y1, const uint8 *Y2 );
+
     // draws an antialiassed line
     // works only in gpixformat_16bitARGB, and currently with line width 1 pixel
     g_result Graphic_AALine( uint32 X1, uint32 Y1, uint32 X2, uint32 Y2 );
@@ -1,4 +1,5 @@
 #include "hw_stuff.h"
+#include "crc16.h"
 
     
 extern void TimerRTCIntrHandler(void);
@@ -6,10 +7,11 @@ extern void SetSysClock(void);
 
     static volatile uint32 wakeup_reason = WUR_NONE;
     static volatile uint32 rtc_next_alarm = 0;
+    static bool psens_irq_wait = false;     // pressure conversion in progress - data ready line wakes up the CPU
     static volatile uint32 btn_press = 0;
     static volatile bool uart_set = false;
-    static volatile uint32 uart_cksum = 0;
-    #define UART_CKSUM_MAGICNR  0xAABBCCDD;
+    static volatile uint32 uart_cksum = 0;         // CRC16 of the bytes sent since HW_UART_reset_Checksum() - see crc16.h
+    static volatile bool uart_dma = false;
     
     static inline bool local_is_rtc_alarm( void )    
     {
@@ -418,11 +420,11 @@ extern void SetSysClock(void);
                 DMA_SENS_RX_Channel->CPAR     = (uint32_t)(&I2C_PORT_SENSOR->DR );              // base address for SPI data register
                 break;
             case DMACH_UART:
-                DMA_SENS_TX_Channel->CCR = ( DMA_SENS_TX_Channel->CCR & 0xFFFF800F ) |          // filter.value copied from stm32f10x_dma.c - not defined anywhere
+                DMA_COMM_TX_Channel->CCR = ( DMA_COMM_TX_Channel->CCR & 0xFFFF800F ) |          // filter.value copied from stm32f10x_dma.c - not defined anywhere
                                            ( DMA_DIR_PeripheralDST     | DMA_Mode_Normal               | DMA_PeripheralInc_Disable |
                                              DMA_MemoryInc_Enable      | DMA_PeripheralDataSize_Byte   | DMA_MemoryDataSize_Byte   |
-                                             DMA_Priority_Medium         | DMA_M2M_Disable );
-                DMA_SENS_TX_Channel->CPAR     = (uint32_t)(&UART_PORT_COMM->DR );              // base address for UART data register
+                                             DMA_Priority_Low          | DMA_M2M_Disable );
+                DMA_COMM_TX_Channel->CPAR     = (uint32_t)(&UART_PORT_COMM->DR );              // base address for UART data register
                 break;
         }
     }
@@ -605,7 +607,7 @@ extern void SetSysClock(void);
         // start the UART peripheral
         UART_PORT_COMM->CR1 |= UART_CR1_UE_Set;
         uart_set = true;
-        uart_cksum = UART_CKSUM_MAGICNR;
+        uart_cksum = CRC16_INIT;
     }
 
     void HW_UART_Stop()
@@ -614,6 +616,17 @@ extern void SetSysClock(void);
         if ( uart_set == false )
             return;
 
+        if ( uart_dma )
+        {
+            // wait for the last byte and give back the DMA channel to the sensor I2C
+            while ( HW_UART_DMA_IsFinished() == false );
+            while ( (UART_PORT_COMM->SR & USART_FLAG_TC) == 0 );
+            UART_PORT_COMM->CR3 &= (uint16_t)~USART_DMAReq_Tx;
+            HW_DMA_Uninit( DMACH_UART );
+            HW_DMA_Init( DMACH_SENS );
+            uart_dma = false;
+        }
+
         GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP;
         GPIO_InitStructure.GPIO_Speed = GPIO_Speed_10MHz;
         GPIO_InitStructure.GPIO_Pin = IO_OUT_COMM_TX;           // both on GPIOA port, set them together
@@ -630,7 +643,7 @@ extern void SetSysClock(void);
 
     static void internal_uart_sendsingle( uint8 data )
     {
-        uart_cksum = uart_cksum + data + ( ((1 - data)&0xff) << 16 );
+        uart_cksum = CRC16_BYTE( uart_cksum, data );
         while ( (UART_PORT_COMM->SR & USART_FLAG_TXE) == 0 );       // wait prew. transmit
         UART_PORT_COMM->DR = data;
     }
@@ -658,13 +671,35 @@ extern void SetSysClock(void);
     
     uint32 HW_UART_SendDMA(uint8 *data, uint32 size)
     {
+        if ( uart_set == false )
+            return 1;
+
+        if ( uart_dma == false )
+        {
+            // UART TX request shares the channel with the sensor I2C RX - it is given back at HW_UART_Stop()
+            HW_DMA_Uninit( DMACH_UART );
+            HW_DMA_Init( DMACH_UART );
+            UART_PORT_COMM->CR3 |= USART_DMAReq_Tx;
+            uart_dma = true;
+        }
+
+        DMA1->IFCR = DMA_COMM_TX_IRQ_FLAGS;
+        HW_DMA_Send( DMACH_UART, data, size );
 
+        // checksum is calculated while the buffer is sent - it should not be touched till the transfer is finished
+        uart_cksum = crc16_update( (uint16)uart_cksum, data, size );
         return 0;
     }
 
     bool HW_UART_DMA_IsFinished()
     {
-        return false;
+        if ( (uart_dma == false) || ((DMA_COMM_TX_Channel->CCR & DMA_CCR1_EN) == 0) )
+            return true;
+        if ( DMA_COMM_TX_Channel->CNDTR )
+            return false;
+
+        DMA_COMM_TX_Channel->CCR &= (uint16_t)(~DMA_CCR1_EN);      // last byte is in the UART, the buffer can be reused
+        return true;
     }
 
     uint32 HW_UART_get_Checksum()
@@ -674,7 +709,7 @@ extern void SetSysClock(void);
 
     void HW_UART_reset_Checksum()
     {
-        uart_cksum = UART_CKSUM_MAGICNR;
+        uart_cksum = CRC16_INIT;
     }
 
     static void internal_setup_stop_mode(bool stdby)
@@ -869,14 +904,18 @@ extern void SetSysClock(void);
             {
                 case pm_hold_btn:
                     // all keys to be active when waking up UI: rising or falling for all
-                    mask = IO_IN_BTN_ESC | IO_IN_BTN_OK | IO_IN_BTN_PP | IO_IN_BTN_1 | IO_IN_BTN_3 | IO_IN_BTN_4 | IO_IN_BTN_6 | IO_IN_SENS_IRQ |0x00020000;    // all the buttons + 
+                    mask = IO_IN_BTN_ESC | IO_IN_BTN_OK | IO_IN_BTN_PP | IO_IN_BTN_1 | IO_IN_BTN_3 | IO_IN_BTN_4 | IO_IN_BTN_6 | 0x00020000;    // all the buttons + RTC alarm
+                    if ( psens_irq_wait )
+                        mask |= IO_IN_SENS_IRQ;
                     rising = mask;
                     falling = IO_IN_BTN_ESC | IO_IN_BTN_OK | IO_IN_BTN_PP | IO_IN_BTN_1 | IO_IN_BTN_3 | IO_IN_BTN_4 | IO_IN_BTN_6; 
                     break;
                 case pm_hold:
                     // keys to be inactive when waking up UI: rising front for esc, start, menu, ok; falling for mode; any for p1 and p2
-                    mask = IO_IN_BTN_PP | IO_IN_SENS_IRQ | 0x00020000;           // just power button / RTC alarm
-                    rising = IO_IN_BTN_PP | IO_IN_SENS_IRQ | 0x00020000;
+                    mask = IO_IN_BTN_PP | 0x00020000;           // just power button / RTC alarm
+                    if ( psens_irq_wait )
+                        mask |= IO_IN_SENS_IRQ;
+                    rising = mask;
                     falling = 0x00;
                     break;
             }
@@ -965,7 +1004,10 @@ extern void SetSysClock(void);
                 HW_LED_Off();
                 HW_LED_On();
                 HW_LED_Off();
-                __asm("    wfi\n");       
+                if ( psens_irq_wait && HW_PSens_IRQ() )
+                    wakeup_reason |= WUR_SENS_IRQ;      // data ready was raised before the EXTI was armed - rising edge is lost, do not stop
+                else
+                    __asm("    wfi\n");       
                 // exit from low power mode
                 SetSysClock();
                 internal_HW_set_EXTI( pm_full );
@@ -993,6 +1035,12 @@ extern void SetSysClock(void);
     }
 
 
+    void HW_PSens_IRQ_Wait( bool wait )
+    {
+        psens_irq_wait = wait;
+    }
+
+
 /*
 
     Power check using the 2016-03-27 code:
@@ -293,6 +293,8 @@
     uint32 HW_Sleep( enum EPowerMode mode );
     // gets the wake-up reason in this loop (main loop or startup till HW_Sleep)
     uint32 HW_GetWakeUpReason(void);
+    // arm / disarm the pressure sensor data ready line as wake-up source for the stop modes
+    void HW_PSens_IRQ_Wait( bool wait );
 
 #endif
 
@@ -0,0 +1,41 @@
+// com_link built against the Qt shim and the pty serial port - the moc output is replaced by the code below
+
+#include "mserialport_pty.h"
+#include "../simu_hygro/simuhygro/serial_port/com_link.cpp"
+
+#include <string.h>
+
+
+const char *MSerialPort::device = NULL;
+
+
+void com_link::sig_connect()                { qt_shim_activate( this, "sig_connect()" ); }
+void com_link::sig_disconnect()             { qt_shim_activate( this, "sig_disconnect()" ); }
+void com_link::sig_datadump_start()         { qt_shim_activate( this, "sig_datadump_start()" ); }
+void com_link::sig_datadump_stop()          { qt_shim_activate( this, "sig_datadump_stop()" ); }
+
+bool com_link::qt_shim_invoke( const char *member )
+{
+    static const struct
+    {
+        const char *name;
+        void (com_link::*slot)();
+    } slots_list[] = { { "Serial_GetData()",           &com_link::Serial_GetData },
+                       { "Serial_Overflow()",          &com_link::Serial_Overflow },
+                       { "pslot_threadstartup()",      &com_link::pslot_threadstartup },
+                       { "pslot_connect()",            &com_link::pslot_connect },
+                       { "pslot_disconnect()",         &com_link::pslot_disconnect },
+                       { "pslot_datadump_start()",     &com_link::pslot_datadump_start },
+                       { "pslot_datadump_stop()",      &com_link::pslot_datadump_stop } };
+    size_t i;
+
+    for ( i=0; i<sizeof(slots_list)/sizeof(slots_list[0]); i++ )
+    {
+        if ( strcmp( member, slots_list[i].name ) == 0 )
+        {
+            (this->*slots_list[i].slot)();
+            return true;
+        }
+    }
+    return QObject::qt_shim_invoke( member );
+}
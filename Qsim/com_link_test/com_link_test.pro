@@ -0,0 +1,31 @@
+#-------------------------------------------------
+#
+# com_link test - the dump receiver of the Qt simulator
+# on a pseudo-terminal, built with a minimal Qt shim
+# ( POSIX hosts )
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = com_link_test
+CONFIG   += console
+CONFIG   -= app_bundle
+CONFIG   -= qt
+CONFIG   += c++11 thread
+
+TEMPLATE = app
+
+# the shim comes before the Qt headers
+INCLUDEPATH += qt_shim \
+               ../simu_hygro/simuhygro/serial_port
+
+
+# com_link.cpp is built by com_link_shim.cpp, with the pty serial port in place of MSerialPort
+SOURCES += main.cpp \
+    com_link_shim.cpp \
+    qt_shim/qt_shim.cpp
+
+HEADERS  += mserialport_pty.h \
+    qt_shim/qt_shim.h \
+    ../simu_hygro/simuhygro/serial_port/com_link.h
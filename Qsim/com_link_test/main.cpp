@@ -0,0 +1,300 @@
+/*
+ *  com_link test - the data dump receiver of the Qt simulator on a host, without Qt and a serial port
+ *
+ *  com_link.cpp is built against a minimal Qt shim ( qt_shim/ ) and a serial port stand-in on a pseudo-terminal
+ *  ( mserialport_pty.h ). Checks:
+ *      ring            com_ring with a small size - the spans at the wrap-around, fill level and data
+ *      ring threads    producer and consumer threads through a COM_RING_SIZE ring, more than 4 GB so the
+ *                      free running head / tail counters wrap as well, byte exact
+ *      capture         cmd_read_data_dump_start() - the port thread and the dump writer - with data written
+ *                      to the pty, more than the 10 MB the dump was limited to before, the file byte exact
+ *
+ *  usage: com_link_test [-s MB] [-g GB] [file.dmp]
+ *      -s MB           capture size, default: 24
+ *      -g GB           data through the ring in the threads test, default: 4.5
+ *      file.dmp        dump file of the capture test, default: com_link_test.dmp ( removed if the test passes )
+ *
+ *  exit code 0 - all passed, 1 - failed. POSIX hosts only.
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <thread>
+
+#include "mserialport_pty.h"
+#include "com_link.h"
+
+
+#define CLT_RING_SMALL      16                      // ring size of the wrap-around test
+#define CLT_RING_STEPS      200000
+#define CLT_CHUNK_MAX       ( 64 * 1024 )           // max. bytes moved in one step in the threads test
+#define CLT_WRITE_MAX       4096                    // max. bytes in one pty write
+#define CLT_TIMEOUT_MS      30000                   // max. wait for the capture to arrive
+#define CLT_PERIOD          1000003                 // period of the test data through the ring
+
+
+static uint32 rnd_state = 0x64892354;
+
+static uint32 internal_rand( void )
+{
+    rnd_state = rnd_state * 1103515245 + 12345;
+    return rnd_state >> 8;
+}
+
+// test data as a function of the stream position - the period is not a divisor of the ring sizes or of 2^32,
+// a stale or misplaced block after a wrap does not match
+static uint8 clt_table[ CLT_PERIOD + CLT_CHUNK_MAX ];
+
+static inline const uint8 *internal_pattern( uint64_t pos )
+{
+    return clt_table + pos % CLT_PERIOD;
+}
+
+
+//--- ring: spans and data at the wrap-around, single thread with a model of the ring
+
+static int test_ring_wrap( void )
+{
+    com_ring ring( CLT_RING_SMALL );
+    uint64_t head = 0;
+    uint64_t tail = 0;
+    uint32 errors = 0;
+    uint32 wraps = 0;
+    uint32 n;
+
+    for ( n=0; n<CLT_RING_STEPS; n++ )
+    {
+        uint8 *p;
+        uint32 span;
+        uint32 exp;
+        uint32 len;
+
+        // producer: the span is the free space up to the end of the buffer
+        span = ring.write_span( &p );
+        exp = CLT_RING_SMALL - (uint32)(head - tail);
+        if ( exp > CLT_RING_SMALL - (head % CLT_RING_SMALL) )
+            exp = CLT_RING_SMALL - (head % CLT_RING_SMALL);
+        if ( span != exp )
+            errors++;
+        len = internal_rand() % (span + 1);
+        memcpy( p, internal_pattern( head ), len );
+        if ( (head % CLT_RING_SMALL) + len == CLT_RING_SMALL )
+            wraps++;
+        ring.write_commit( len );
+        head += len;
+
+        if ( ring.used() != (uint32)(head - tail) )
+            errors++;
+
+        // consumer: the span is the filled part up to the end of the buffer
+        span = ring.read_span( &p );
+        exp = (uint32)(head - tail);
+        if ( exp > CLT_RING_SMALL - (tail % CLT_RING_SMALL) )
+            exp = CLT_RING_SMALL - (tail % CLT_RING_SMALL);
+        if ( span != exp )
+            errors++;
+        len = internal_rand() % (span + 1);
+        if ( memcmp( p, internal_pattern( tail ), len ) )
+            errors++;
+        ring.read_commit( len );
+        tail += len;
+    }
+
+    printf( "ring %u bytes:      %s ( %llu bytes, %u wraps, %u errors )\n", CLT_RING_SMALL, errors ? "FAILED" : "OK",
+            (unsigned long long)head, wraps, errors );
+    return errors ? 1 : 0;
+}
+
+
+//--- ring threads: the port thread / dump writer pair at full speed, past the 32 bit counter range
+
+static int test_ring_threads( uint64_t total )
+{
+    com_ring ring( COM_RING_SIZE );
+    QElapsedTimer timer;
+    uint64_t errors = 0;
+    uint64_t rx = 0;
+    qint64 ms;
+
+    timer.start();
+    std::thread producer( [&ring, total] {
+        uint32 rnd = 0x2545F491;
+        uint64_t tx = 0;
+
+        while ( tx < total )
+        {
+            uint8 *p;
+            uint32 span = ring.write_span( &p );
+            uint32 len;
+
+            rnd = rnd * 1103515245 + 12345;
+            len = 1 + (rnd >> 8) % CLT_CHUNK_MAX;
+            if ( len > span )
+                len = span;
+            if ( len > total - tx )
+                len = (uint32)(total - tx);
+            if ( len == 0 )
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            memcpy( p, internal_pattern( tx ), len );
+            ring.write_commit( len );
+            tx += len;
+        }
+    } );
+
+    while ( rx < total )
+    {
+        uint8 *p;
+        uint32 len = ring.read_span( &p );
+
+        if ( len == 0 )
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        if ( len > CLT_CHUNK_MAX )
+            len = CLT_CHUNK_MAX;
+        if ( memcmp( p, internal_pattern( rx ), len ) )
+            errors++;
+        ring.read_commit( len );
+        rx += len;
+    }
+    producer.join();
+    ms = timer.elapsed();
+
+    printf( "ring threads:       %s ( %.2f GB through %u kB, counters wrapped %u times, %llu blocks with errors, %.0f MB/s )\n",
+            errors ? "FAILED" : "OK", total / 1e9, COM_RING_SIZE / 1024, (uint32)(total >> 32), (unsigned long long)errors,
+            ms ? (total / 1e3 / ms) : 0.0 );
+    return errors ? 1 : 0;
+}
+
+
+//--- capture: pty -> port thread -> ring -> dump writer -> file
+
+static int test_capture( uint32 size, const char *filename )
+{
+    struct termios tio;
+    com_link *link;
+    uint8 *src;
+    uint8 *dst;
+    FILE *f;
+    uint32 sent = 0;
+    uint32 got = 0;
+    uint32 waited = 0;
+    uint32 i;
+    int master;
+    int slave;
+    int res = 0;
+
+    src = (uint8*)malloc( size );
+    dst = (uint8*)malloc( size + 1 );
+    if ( (src == NULL) || (dst == NULL) )
+        return 1;
+    for ( i=0; i<size; i++ )
+        src[i] = (uint8)internal_rand();
+
+    master = posix_openpt( O_RDWR | O_NOCTTY );
+    if ( (master < 0) || grantpt( master ) || unlockpt( master ) )
+    {
+        printf( "capture:            FAILED ( no pseudo-terminal )\n" );
+        return 1;
+    }
+    MSerialPort::device = ptsname( master );
+    slave = open( MSerialPort::device, O_RDWR | O_NOCTTY );     // kept open - the pty is not hung up between the steps
+    if ( (slave < 0) || tcgetattr( slave, &tio ) )
+        return 1;
+    cfmakeraw( &tio );
+    tcsetattr( slave, TCSANOW, &tio );
+
+    link = new com_link();
+    if ( link->cmd_connect() || link->cmd_read_data_dump_start( filename ) )
+    {
+        printf( "capture:            FAILED ( can not start the dump in %s )\n", filename );
+        return 1;
+    }
+
+    // the device side - blocks while the pty is full, as the UART would be paced
+    while ( sent < size )
+    {
+        uint32 len = 1 + internal_rand() % CLT_WRITE_MAX;
+        int wr;
+
+        if ( len > size - sent )
+            len = size - sent;
+        wr = write( master, src + sent, len );
+        if ( wr > 0 )
+            sent += wr;
+    }
+    while ( ((uint32)link->cmd_read_data_check_inbuffer() < size) && (waited < CLT_TIMEOUT_MS) )
+    {
+        QThread::msleep( 1 );
+        waited++;
+    }
+    if ( link->cmd_read_data_stop() )
+        res = 1;
+    link->cmd_disconnect();
+    delete link;
+    close( slave );
+    close( master );
+
+    f = fopen( filename, "rb" );
+    if ( f )
+    {
+        got = (uint32)fread( dst, 1, size + 1, f );
+        fclose( f );
+    }
+    if ( (got != size) || memcmp( src, dst, size ) )
+        res = 1;
+    for ( i=0; (i<got) && (i<size) && (src[i] == dst[i]); i++ );
+
+    printf( "capture:            %s ( %u bytes sent, %u in the file, first difference at %u )\n", res ? "FAILED" : "OK",
+            size, got, (i < size) ? i : size );
+    free( src );
+    free( dst );
+    return res;
+}
+
+
+int main( int argc, char *argv[] )
+{
+    const char *filename = "com_link_test.dmp";
+    uint32 size = 24 * 1024 * 1024;
+    uint64_t ring_total = 4500000000ULL;
+    int res = 0;
+    int i;
+
+    for ( i=1; i<argc; i++ )
+    {
+        if ( (strcmp( argv[i], "-s" ) == 0) && (i + 1 < argc) )
+            size = (uint32)( atof( argv[++i] ) * 1024 * 1024 );
+        else if ( (strcmp( argv[i], "-g" ) == 0) && (i + 1 < argc) )
+            ring_total = (uint64_t)( atof( argv[++i] ) * 1e9 );
+        else if ( argv[i][0] != '-' )
+            filename = argv[i];
+        else
+        {
+            printf( "usage: com_link_test [-s MB] [-g GB] [file.dmp]\n" );
+            return 1;
+        }
+    }
+
+    for ( i=0; i<CLT_PERIOD; i++ )
+        clt_table[i] = (uint8)internal_rand();
+    memcpy( clt_table + CLT_PERIOD, clt_table, CLT_CHUNK_MAX );     // a block from the end of the period continues at its start
+
+    res |= test_ring_wrap();
+    res |= test_ring_threads( ring_total );
+    res |= test_capture( size, filename );
+    if ( res == 0 )
+        remove( filename );
+
+    printf( "com_link test: %s\n", res ? "FAILED" : "OK" );
+    return res;
+}
@@ -0,0 +1,71 @@
+#ifndef MSERIALPORT_PTY_H
+#define MSERIALPORT_PTY_H
+
+// Serial port driver stand-in: the Windows API of MSerialPort used by com_link, on the slave side of a pseudo-terminal.
+// It takes the place of MSerialPort.hpp ( same include guard ), every COMn port opens the same pty.
+
+#define MSERIALPORT_HPP
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include "qt_shim.h"
+
+#define SB1             0
+#define ParityNone      0
+
+
+class MSerialPort : public QObject
+{
+public:
+    static const char *device;              // pty slave standing in for the COM ports
+
+    MSerialPort() : fd(-1) {}
+    ~MSerialPort()                          { closePort(); }
+
+    int openPort( QString *device_Name, int _buad, int _byteSize, int _stopBits, int _parity, uint8_t ev_char )
+    {
+        struct termios tio;
+
+        fd = open( device, O_RDWR | O_NOCTTY | O_NONBLOCK );
+        if ( fd < 0 )
+            return -1;
+        if ( tcgetattr( fd, &tio ) == 0 )
+        {
+            cfmakeraw( &tio );
+            tcsetattr( fd, TCSANOW, &tio );
+        }
+        return 0;
+    }
+
+    void closePort()
+    {
+        if ( fd >= 0 )
+            close( fd );
+        fd = -1;
+    }
+
+    uint32_t bytesAvailable()
+    {
+        int n = 0;
+
+        if ( ioctl( fd, FIONREAD, &n ) )
+            return 0;
+        return (uint32_t)n;
+    }
+
+    int getBytes( uint8_t *buffer, int size )
+    {
+        int rd = read( fd, buffer, size );
+        return ( rd < 0 ) ? 0 : rd;
+    }
+
+    void flushInQ()                         { tcflush( fd, TCIFLUSH ); }
+    void flushOutQ()                        { tcflush( fd, TCOFLUSH ); }
+
+private:
+    int fd;
+};
+
+#endif // MSERIALPORT_PTY_H
@@ -0,0 +1,164 @@
+#include "qt_shim.h"
+
+#include <functional>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+
+
+struct SShimConnection
+{
+    const QObject *sender;
+    std::string    signal;
+    QObject       *receiver;
+    std::string    member;
+};
+
+static std::mutex                       conn_mtx;
+static std::vector<SShimConnection>     conns;
+static thread_local QThread            *current_thread = NULL;
+
+
+QObject::QObject()
+{
+    affinity = QThread::currentThread();
+}
+
+bool QObject::connect( const QObject *sender, const char *signal, const QObject *receiver, const char *member )
+{
+    std::lock_guard<std::mutex> lock( conn_mtx );
+    SShimConnection conn = { sender, signal, const_cast<QObject*>(receiver), member };
+
+    conns.push_back( conn );
+    return true;
+}
+
+bool QObject::qt_shim_invoke( const char *member )
+{
+    return ( strcmp( member, "deleteLater()" ) == 0 );
+}
+
+void QObject::qt_shim_activate( QObject *sender, const char *signal )
+{
+    std::vector<SShimConnection> hit;
+
+    {
+        std::lock_guard<std::mutex> lock( conn_mtx );
+        for ( size_t i=0; i<conns.size(); i++ )
+        {
+            if ( (conns[i].sender == sender) && (conns[i].signal == signal) )
+                hit.push_back( conns[i] );
+        }
+    }
+
+    for ( size_t i=0; i<hit.size(); i++ )
+    {
+        QThread *target = hit[i].receiver->thread();
+
+        if ( target == QThread::currentThread() )
+            hit[i].receiver->qt_shim_invoke( hit[i].member.c_str() );
+        else if ( target )
+            target->post( hit[i].receiver, strdup( hit[i].member.c_str() ) );
+    }
+}
+
+
+QThread::QThread() : quit_req(false), running(false)
+{
+}
+
+QThread::~QThread()
+{
+    if ( th.joinable() )
+        th.detach();
+}
+
+QThread *QThread::currentThread()
+{
+    return current_thread;
+}
+
+quintptr QThread::currentThreadId()
+{
+    return (quintptr)std::hash<std::thread::id>()( std::this_thread::get_id() );
+}
+
+void QThread::entry( QThread *self )
+{
+    current_thread = self;
+    qt_shim_activate( self, "started()" );
+    self->run();
+    qt_shim_activate( self, "finished()" );
+
+    std::lock_guard<std::mutex> lock( self->mtx );
+    self->running.store( false );
+    self->cv.notify_all();
+}
+
+void QThread::start()
+{
+    if ( th.joinable() )
+        th.join();
+    quit_req = false;
+    running.store( true );
+    th = std::thread( entry, this );
+}
+
+void QThread::quit()
+{
+    std::lock_guard<std::mutex> lock( mtx );
+    quit_req = true;
+    cv.notify_all();
+}
+
+bool QThread::wait( unsigned long ms )
+{
+    std::unique_lock<std::mutex> lock( mtx );
+
+    if ( ms == ULONG_MAX )
+        cv.wait( lock, [this] { return running.load() == false; } );
+    else if ( cv.wait_for( lock, std::chrono::milliseconds(ms), [this] { return running.load() == false; } ) == false )
+        return false;
+    lock.unlock();
+
+    if ( th.joinable() )
+        th.join();
+    return true;
+}
+
+void QThread::post( QObject *receiver, const char *member )
+{
+    std::lock_guard<std::mutex> lock( mtx );
+    queue.push_back( std::make_pair( receiver, member ) );
+    cv.notify_all();
+}
+
+bool QThread::qt_shim_invoke( const char *member )
+{
+    if ( strcmp( member, "quit()" ) == 0 )
+    {
+        quit();
+        return true;
+    }
+    return QObject::qt_shim_invoke( member );
+}
+
+int QThread::exec()
+{
+    while (1)
+    {
+        std::pair<QObject*, const char*> call;
+
+        {
+            std::unique_lock<std::mutex> lock( mtx );
+            cv.wait( lock, [this] { return quit_req || (queue.empty() == false); } );
+            if ( quit_req )
+                break;
+            call = queue.front();
+            queue.pop_front();
+        }
+        call.first->qt_shim_invoke( call.second );
+        free( (void*)call.second );
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+#ifndef QT_SHIM_H
+#define QT_SHIM_H
+
+// Minimal stand-in of the Qt classes used by com_link - the serial link is built and tested on a host without Qt.
+//
+// Only what com_link.h / com_link.cpp need is provided, with the same semantics:
+// - QObject::connect() with SIGNAL() / SLOT() strings. A signal is delivered directly when the receiver lives in the
+//   emitting thread, otherwise it is queued to the event loop of the receiver's thread ( auto connection ). The
+//   main thread has no event loop here - calls queued to it are dropped.
+// - moc is replaced by hand: Q_OBJECT declares qt_shim_invoke(), which calls a slot by its signature, the signal
+//   bodies call qt_shim_activate() ( see com_link_shim.cpp ).
+// - QThread runs run() on a std::thread, the default run() is the event loop.
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <limits.h>
+#include <stdint.h>
+
+typedef int64_t     qint64;
+typedef uintptr_t   quintptr;
+
+#define Q_OBJECT        public: bool qt_shim_invoke( const char *member ); private:
+#define signals         public
+#define slots
+#define emit
+#define SIGNAL(a)       #a
+#define SLOT(a)         #a
+
+
+class QThread;
+
+class QObject
+{
+public:
+    QObject();
+    virtual ~QObject() {}
+
+    static bool connect( const QObject *sender, const char *signal, const QObject *receiver, const char *member );
+    void moveToThread( QThread *thread )    { affinity = thread; }
+    QThread *thread() const                 { return affinity; }
+
+    // moc replacement - calls the slot by its signature, false if the object has no such slot
+    virtual bool qt_shim_invoke( const char *member );
+
+protected:
+    void deleteLater()                      {}          // the objects are released by the test
+    static void qt_shim_activate( QObject *sender, const char *signal );
+
+private:
+    QThread *affinity;                      // thread of the event loop the queued slots run on - NULL: main thread
+};
+
+
+class QThread : public QObject
+{
+public:
+    QThread();
+    virtual ~QThread();
+
+    void start();
+    void quit();
+    bool wait( unsigned long ms = ULONG_MAX );
+    bool isRunning() const                  { return running.load(); }
+
+    static QThread *currentThread();
+    static quintptr currentThreadId();
+    static void yieldCurrentThread()        { std::this_thread::yield(); }
+    static void usleep( unsigned long us )  { std::this_thread::sleep_for( std::chrono::microseconds(us) ); }
+    static void msleep( unsigned long ms )  { std::this_thread::sleep_for( std::chrono::milliseconds(ms) ); }
+
+    void post( QObject *receiver, const char *member );     // queued slot call - runs in the event loop
+    bool qt_shim_invoke( const char *member );
+
+protected:
+    virtual void run()                      { exec(); }
+    int exec();
+
+private:
+    static void entry( QThread *self );
+
+    std::thread             th;
+    std::mutex              mtx;
+    std::condition_variable cv;
+    std::deque< std::pair<QObject*, const char*> > queue;
+    bool                    quit_req;
+    std::atomic<bool>       running;
+};
+
+
+class QMutex
+{
+public:
+    void lock()                             { mtx.lock(); }
+    void unlock()                           { mtx.unlock(); }
+
+private:
+    std::mutex mtx;
+};
+
+
+class QAtomicInt
+{
+public:
+    QAtomicInt( int value = 0 ) : val(value) {}
+
+    int load() const                        { return val.load( std::memory_order_relaxed ); }
+    int loadAcquire() const                 { return val.load( std::memory_order_acquire ); }
+    void store( int value )                 { val.store( value, std::memory_order_relaxed ); }
+    void storeRelease( int value )          { val.store( value, std::memory_order_release ); }
+    int fetchAndAddRelease( int value )     { return val.fetch_add( value, std::memory_order_release ); }
+
+private:
+    std::atomic<int> val;
+};
+
+
+class QElapsedTimer
+{
+public:
+    void start()                            { t0 = std::chrono::steady_clock::now(); }
+    qint64 elapsed() const                  { return std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now() - t0 ).count(); }
+
+private:
+    std::chrono::steady_clock::time_point t0;
+};
+
+
+typedef std::string QByteArray;
+
+class QString
+{
+public:
+    QString( const char *str = "" ) : s(str) {}
+
+    static QString number( int n )          { return QString( std::to_string(n).c_str() ); }
+    QByteArray toLatin1() const             { return s; }
+    friend QString operator+( const char *a, const QString &b )    { return QString( (std::string(a) + b.s).c_str() ); }
+
+private:
+    std::string s;
+};
+
+
+// qDebug() << a << b - one line on stderr, the items separated with a space
+class QDebug
+{
+public:
+    QDebug() {}
+    QDebug( const QDebug & ) {}
+    ~QDebug()                               { std::cerr << os.str() << std::endl; }
+
+    template <class T> QDebug &operator<<( const T &v )    { os << v << ' '; return *this; }
+
+private:
+    std::ostringstream os;
+};
+
+inline QDebug qDebug()                      { return QDebug(); }
+
+#endif // QT_SHIM_H
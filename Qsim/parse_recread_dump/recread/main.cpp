@@ -1,6 +1,12 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifndef _WIN32
+#include <termios.h>
+#endif
 
 #include "hw_stuff.h"
 #include "typedefs.h"
@@ -9,8 +15,24 @@
 #include "hw_stuff.h"
 #include "utilities.h"
 #include "events_ui.h"
+#include "recpack.h"
+#include "recdelta.h"
+#include "crc16.h"
+#include "telemetry.h"
 
-#define UART_CKSUM_MAGICNR  0xAABBCCDD;
+
+// FRAM layout - keep it in sync with the EEADDR_xxx defines from core.c
+#define EXP_FRAM_SIZE       ( 256 * 1024 )
+#define EXP_ADDR_RECORD     ( sizeof(struct SCoreSetup) + sizeof(struct SCoreOperation) )
+#define EXP_ADDR_CK_REC     ( EXP_ADDR_RECORD + 2 * sizeof(struct SCoreNonVolatileRec) + 4 )
+#define EXP_ADDR_STORAGE    CORE_RECMEM_PAGESIZE
+#define EXP_DB_STATE        ( CORE_REC_STAGE - RECDELTA_STATE )     // codec state in the stage of deadband tasks - REC_DB_STATE in core.c
+
+#define EXP_UNIX_START      1356998400          // 2013-01-01 00:00:00 - RTC counter 0, see utilities.h
+
+#ifndef O_BINARY
+#define O_BINARY            0
+#endif
 
 uint8 in_buffer[ 1024*1024 ];
 int   in_size;
@@ -28,22 +50,22 @@ int internal_print_readout( struct SCoreNVreadout *readout )
     fprintf( file, "\t\tto_read[%d]  to_ptr[%d]  to_process[%d]\n\n",
              readout->to_read, readout->to_ptr, readout->to_process );
 
-    fprintf( file, "\t\tv1ctr[0x%08lX]  v2ctr[0x%08lX]  v3ctr[0x%08lX]\n", readout->v1ctr, readout->v2ctr, readout->v3ctr );
-    fprintf( file, "\t\tv1max[0x%08lX]  v2max[0x%08lX]  v3max[0x%08lX]\n", readout->v1max, readout->v2max, readout->v3max );
-    fprintf( file, "\t\tv1min[0x%08lX]  v2min[0x%08lX]  v3min[0x%08lX]\n", readout->v1min, readout->v2min, readout->v3min );
-    fprintf( file, "\t\tv1max_total[0x%08lX]  v2max_total[0x%08lX]  v3max_total[0x%08lX]\n", readout->v1max_total, readout->v2max_total, readout->v3max_total );
-    fprintf( file, "\t\tv1min_total[0x%08lX]  v2min_total[0x%08lX]  v3min_total[0x%08lX]\n", readout->v1min_total, readout->v2min_total, readout->v3min_total );
-    fprintf( file, "\t\tv1sum[0x%08lX]  v2sum[0x%08lX]  v3sum[0x%08lX]\n\n", readout->v1sum, readout->v2sum, readout->v3sum );
+    fprintf( file, "\t\tctr[0x%08lX]\n", (unsigned long)readout->agg.ctr );
+    fprintf( file, "\t\tvmax[0x%08lX]  [0x%08lX]  [0x%08lX]\n", (unsigned long)readout->agg.vmax[0], (unsigned long)readout->agg.vmax[1], (unsigned long)readout->agg.vmax[2] );
+    fprintf( file, "\t\tvmin[0x%08lX]  [0x%08lX]  [0x%08lX]\n", (unsigned long)readout->agg.vmin[0], (unsigned long)readout->agg.vmin[1], (unsigned long)readout->agg.vmin[2] );
+    fprintf( file, "\t\ttmax[0x%08lX]  [0x%08lX]  [0x%08lX]\n", (unsigned long)readout->agg.tmax[0], (unsigned long)readout->agg.tmax[1], (unsigned long)readout->agg.tmax[2] );
+    fprintf( file, "\t\ttmin[0x%08lX]  [0x%08lX]  [0x%08lX]\n", (unsigned long)readout->agg.tmin[0], (unsigned long)readout->agg.tmin[1], (unsigned long)readout->agg.tmin[2] );
+    fprintf( file, "\t\tvsum[0x%08lX]  [0x%08lX]  [0x%08lX]\n\n", (unsigned long)readout->agg.vsum[0], (unsigned long)readout->agg.vsum[1], (unsigned long)readout->agg.vsum[2] );
              
-    fprintf( file, "\t\tdispctr[0x%08lX]  dispstep[0x%08lX]  dispprev[0x%08lX] raw_ptr[0x%08lX]\n\n", readout->dispctr, readout->dispstep, readout->dispprev, readout->raw_ptr );
+    fprintf( file, "\t\tdispctr[0x%08lX]  dispstep[0x%08lX]  dispprev[0x%08lX] col[0x%08lX]\n\n", (unsigned long)readout->agg.dispctr, (unsigned long)readout->agg.dispstep, (unsigned long)readout->agg.dispprev, (unsigned long)readout->agg.col );
 
     return 0;
 }
 
 int internal_print_taskInstance( struct SRecTaskInstance *taskInst )
 {
-    fprintf( file, "\t\tmempage[%d]  size[%d]  task_elems[0x%X]  sample_rate[%d]\n\n",
-             taskInst->mempage, taskInst->size, taskInst->task_elems, taskInst->sample_rate );
+    fprintf( file, "\t\tmempage[%d]  size[%d]  task_elems[0x%X]  sample_rate[%d]  deadband[%d]\n\n",
+             taskInst->mempage, taskInst->size, taskInst->task_elems, taskInst->sample_rate, taskInst->deadband );
     return 0;
 }
 
@@ -51,7 +73,7 @@ int internal_print_taskFunc( struct SRecTaskInternals *taskFunc )
 {
     // print just a subset
     int i;
-    fprintf( file, "\t\tr[%d]  w[%d]  c[%d]  wrap[%d]\n", taskFunc->r, taskFunc->w, taskFunc->c, taskFunc->wrap );
+    fprintf( file, "\t\tr[%d]  w[%d]  c[%d]  wrap[%d]  staged[%d]\n", taskFunc->r, taskFunc->w, taskFunc->c, taskFunc->wrap, taskFunc->stg_cnt );
 
     fprintf( file, "\t\tavg_cnt[ " );
     for (i=0; i<3; i++)
@@ -86,9 +108,562 @@ int internal_print_NVRAM_readinfo( uint8 *inbuff )
 }
 
 
-int main(int argc, char *argv[])
+//--- recording export: stream from core_op_recording_export() or FRAM image from the simulators
+
+uint8 ee_image[ EXP_FRAM_SIZE + 4 ];            // +4: the recpack decoder reads after the last used byte
+struct SCoreNonVolatileRec nvrec;
+
+static const uint32 c_timeunit_sec[] = { 5, 10, 30, 60, 120, 300, 600, 1800, 3600 };     // enum EUpdateTimings
+
+
+static int internal_load_input( const char *filename )
+{
+    file = fopen( filename, "rb" );
+    if ( file == NULL )
+    {
+        printf( "Failed to open file %s\n", filename );
+        return 1;
+    }
+    in_size = fread( in_buffer, 1, sizeof(in_buffer), file );
+    fclose( file );
+    return 0;
+}
+
+static int internal_parse_export_stream( void )
+{
+    uint8 hdr_start[] = { 0xaa, 0xaa, 0xaa, 0xaa, 'R', 'E', 'X', CORE_EXPORT_VERSION };
+    uint8 hdr_task[] = { 0x55, 0x55, 0x55 };
+    uint8 hdr_end[] = { 0xbb, 0xbb, 0xbb, 0xbb };
+    uint32 clock;
+    uint16 rec_size;
+
+    if ( (in_size < 14) || memcmp( in_buffer, hdr_start, sizeof(hdr_start) ) )
+    {
+        printf( "Invalid export header or version\n" );
+        return 1;
+    }
+    ptr = sizeof(hdr_start);
+    memcpy( &clock, in_buffer + ptr, sizeof(uint32) );
+    memcpy( &rec_size, in_buffer + ptr + 4, sizeof(uint16) );
+    ptr += 6;
+    if ( (rec_size != sizeof(nvrec)) || (ptr + rec_size > in_size) )
+    {
+        printf( "Recording structure size mismatch: %d, expected %d\n", rec_size, (int)sizeof(nvrec) );
+        return 1;
+    }
+    memcpy( &nvrec, in_buffer + ptr, sizeof(nvrec) );
+    ptr += sizeof(nvrec);
+    printf( "export taken at RTC counter 0x%08X\n", clock );
+
+    while ( (ptr + 12) <= in_size )
+    {
+        uint32 eeaddr;
+        uint32 eesize;
+
+        if ( memcmp( in_buffer + ptr, hdr_end, sizeof(hdr_end) ) == 0 )
+        {
+            uint32 cksum;
+            uint32 in_cksum;
+
+            ptr += 4;
+            cksum = crc16_update( CRC16_INIT, in_buffer, ptr );
+            memcpy( &in_cksum, in_buffer + ptr, sizeof(uint32) );
+            if ( cksum != in_cksum )
+            {
+                printf( "Checksum ERROR: InCksum[0x%08X]  CalcCksum[0x%08X]\n", in_cksum, cksum );
+                return 1;
+            }
+            return 0;
+        }
+
+        if ( memcmp( in_buffer + ptr, hdr_task, sizeof(hdr_task) ) )
+            break;
+
+        memcpy( &eeaddr, in_buffer + ptr + 4, sizeof(uint32) );
+        memcpy( &eesize, in_buffer + ptr + 8, sizeof(uint32) );
+        ptr += 12;
+        if ( (eeaddr + eesize > EXP_FRAM_SIZE) || (ptr + eesize > (uint32)in_size) )
+            break;
+        memcpy( ee_image + eeaddr, in_buffer + ptr, eesize );
+        ptr += eesize;
+    }
+
+    printf( "Inconsistency detected at offset %d\n", ptr );
+    return 1;
+}
+
+static int internal_parse_fram_image( void )
+{
+    // the recording structure is selected the same way as core_nvrecording_load() does
+    uint16 seq[2];
+    uint16 cksum;
+    uint16 cksum_rec;
+    uint32 slot;
+    uint32 tries;
+
+    if ( in_size != EXP_FRAM_SIZE )
+    {
+        printf( "Invalid FRAM image size: %d\n", in_size );
+        return 1;
+    }
+    memcpy( ee_image, in_buffer, EXP_FRAM_SIZE );
+
+    for ( slot=0; slot<2; slot++ )
+        memcpy( &seq[slot], ee_image + EXP_ADDR_RECORD + slot * sizeof(nvrec) + offsetof(struct SCoreNonVolatileRec, seq), 2 );
+    slot = ( (int16)(seq[1] - seq[0]) > 0 ) ? 1 : 0;
+
+    for ( tries=0; tries<2; tries++, slot ^= 0x01 )
+    {
+        uint8 *buffer = ee_image + EXP_ADDR_RECORD + slot * sizeof(nvrec);
+
+        memcpy( &cksum_rec, ee_image + EXP_ADDR_CK_REC + slot * 2, 2 );
+        cksum = crc16_update( CRC16_INIT, buffer, sizeof(nvrec) );
+        if ( cksum == cksum_rec )
+        {
+            memcpy( &nvrec, buffer, sizeof(nvrec) );
+            return 0;
+        }
+    }
+
+    printf( "No valid recording structure in the FRAM image\n" );
+    return 1;
+}
+
+static int internal_write_task( const char *outbase, uint32 idx, bool binary )
+{
+    // Elements are written from the oldest to the newest. The newest one has the last_timestamp, the elements
+    // before it are at sample rate distance. Binary output has columns: [ uint32 count ][ uint32 channels ]
+    // [ count x uint32 unix time ] [ count x float for each channel in T -> RH -> P order ]
+    // Deadband tasks: the blocks are found in the directory at the task start, the data ring follows it ( see core.c )
+    struct SRecTaskInstance *task = &nvrec.task[idx];
+    struct SRecTaskInternals *func = &nvrec.func[idx];
+    char outfname[256];
+    uint8 *mem;
+    uint32 elsizeX2;
+    uint32 nch;
+    uint32 step;
+    uint32 k;
+    uint32 ch;
+    uint32 el[3];
+    uint32 *times;
+    float *cols;
+    struct SRecDelta dlt;
+    const uint8 *blk = NULL;
+    uint32 nibble = 0;
+    uint32 ushift;
+    uint32 ring_offs;
+    int len;
+
+    if ( (task->size == 0) || (func->c == 0) || (func->wrap == 0) || (task->sample_rate > ut_60min) )
+        return 0;
+
+    mem      = ee_image + EXP_ADDR_STORAGE + (uint32)task->mempage * CORE_RECMEM_PAGESIZE;
+    elsizeX2 = RECPACK_ELSIZEX2( task->task_elems );
+    nch      = RECPACK_CHANNELS( task->task_elems );
+    step     = 2 * c_timeunit_sec[ task->sample_rate ];
+    ushift   = RECDELTA_USHIFT( task->size * CORE_RECMEM_PAGESIZE );
+    ring_offs = RECDELTA_DIRSIZE( func->wrap );
+
+    if ( (mem + ( task->deadband ? (uint32)task->size * CORE_RECMEM_PAGESIZE : ((elsizeX2 * func->wrap + 1) >> 1) )) > (ee_image + EXP_FRAM_SIZE) )
+    {
+        printf( "task %d: memory is out of the FRAM\n", idx );
+        return 1;
+    }
+
+    // staged elements are not in the storage yet - place them as local_recording_flush() does, the deadband
+    // elements are decoded from the stage
+    if ( func->stg_cnt && (task->deadband == 0) )
+    {
+        uint32 elem = ( func->w ? func->w : func->wrap ) - func->stg_cnt;
+        memcpy( mem + ((elsizeX2 * elem) >> 1), func->stage, (func->stg_shift + elsizeX2 * func->stg_cnt + 1) >> 1 );
+    }
+
+    // channel list of the element
+    for ( k=0, ch=0; k<3; k++ )
+    {
+        if ( task->task_elems & (1 << k) )
+            el[ch++] = k;
+    }
+
+    times = (uint32*)malloc( func->c * sizeof(uint32) );
+    cols  = (float*)malloc( func->c * nch * sizeof(float) );
+    if ( (times == NULL) || (cols == NULL) )
+        return 1;
+
+    for ( k=0; k<func->c; k++ )
+    {
+        uint16 val[3];
+        uint32 e = (func->r + k) % func->wrap;
+
+        if ( task->deadband && (k + func->stg_cnt >= func->c) )
+        {
+            // staged elements - from the codec state saved at the first one
+            if ( (k == 0) || (k + func->stg_cnt == func->c) )
+            {
+                recdelta_start( &dlt, nch, task->deadband, 0, e );
+                recdelta_load( &dlt, func->stage + EXP_DB_STATE );
+                blk = func->stage;
+                nibble = func->stg_shift;
+            }
+            nibble = recdelta_decode( &dlt, blk, nibble, val, 1 );
+        }
+        else if ( task->deadband )
+        {
+            // deadband elements are decoded in sequence from the block start
+            if ( (k == 0) || ((e & (RECDELTA_BLOCK - 1)) == 0) )
+            {
+                uint16 entry;
+
+                memcpy( &entry, mem + (e >> RECDELTA_BLKSHIFT) * 2, 2 );
+                recdelta_start( &dlt, nch, task->deadband, ushift, e & ~(RECDELTA_BLOCK - 1) );
+                blk = mem + ring_offs + ((uint32)entry << ushift);
+                nibble = recdelta_decode( &dlt, blk, 0, NULL, e & (RECDELTA_BLOCK - 1) );
+            }
+            nibble = recdelta_decode( &dlt, blk, nibble, val, 1 );
+        }
+        else
+            recpack_decode( mem, e * elsizeX2, val, nch );
+        times[k] = func->last_timestamp - (func->c - 1 - k) * step;
+        for ( ch=0; ch<nch; ch++ )
+        {
+            switch ( el[ch] )
+            {
+                case 0:  cols[ch * func->c + k] = (float)val[ch] / 512.0f - 40.0f; break;      // 16fp9 + 40*C
+                case 1:  cols[ch * func->c + k] = (float)val[ch] / 256.0f; break;              // 16fp8 %
+                default: cols[ch * func->c + k] = ((float)val[ch] + 50000.0f) / 100.0f; break; // Pa - 50kPa -> hPa
+            }
+        }
+    }
+
+    len = snprintf( outfname, sizeof(outfname), "%s_task%d.%s", outbase, idx, binary ? "bin" : "csv" );
+    if ( (len < 0) || (len >= (int)sizeof(outfname)) )
+    {
+        printf( "Output file name too long: %s\n", outbase );
+        free( times );
+        free( cols );
+        return 1;
+    }
+    file = fopen( outfname, binary ? "wb" : "w" );
+    if ( file == NULL )
+    {
+        printf( "Failed to open output file %s\n", outfname );
+        free( times );
+        free( cols );
+        return 1;
+    }
+
+    if ( binary )
+    {
+        uint32 hdr[2] = { func->c, nch };
+        fwrite( hdr, sizeof(uint32), 2, file );
+        for ( k=0; k<func->c; k++ )
+        {
+            uint32 ut = EXP_UNIX_START + times[k] / 2;
+            fwrite( &ut, sizeof(uint32), 1, file );
+        }
+        fwrite( cols, sizeof(float), func->c * nch, file );
+    }
+    else
+    {
+        static const char *c_names[] = { "temperature[C]", "rh[%]", "pressure[hPa]" };
+
+        fprintf( file, "time" );
+        for ( ch=0; ch<nch; ch++ )
+            fprintf( file, ",%s", c_names[ el[ch] ] );
+        fprintf( file, "\n" );
+
+        for ( k=0; k<func->c; k++ )
+        {
+            uint16 year;
+            uint8 mounth, day, hour, minute, second;
+
+            utils_convert_counter_2_ymd( times[k], &year, &mounth, &day );
+            utils_convert_counter_2_hms( times[k], &hour, &minute, &second );
+            fprintf( file, "%04d-%02d-%02d %02d:%02d:%02d", year, mounth, day, hour, minute, second );
+            for ( ch=0; ch<nch; ch++ )
+                fprintf( file, ",%.2f", cols[ch * func->c + k] );
+            fprintf( file, "\n" );
+        }
+    }
+    fclose( file );
+
+    printf( "task %d: %d elements -> %s\n", idx, func->c, outfname );
+    free( times );
+    free( cols );
+    return 0;
+}
+
+static int internal_decode_recordings( const char *filename, bool image, bool binary )
+{
+    char outbase[256];
+    char *ext;
+    uint32 i;
+    int res = 0;
+
+    if ( strlen( filename ) >= sizeof(outbase) )
+    {
+        printf( "Input file name too long: %s\n", filename );
+        return 1;
+    }
+    if ( internal_load_input( filename ) )
+        return 1;
+
+    if ( image )
+        res = internal_parse_fram_image();
+    else
+        res = internal_parse_export_stream();
+    if ( res )
+        return res;
+
+    strcpy( outbase, filename );
+    ext = strrchr( outbase, '.' );
+    if ( ext && (strchr( ext, '/' ) == NULL) )
+        *ext = 0;
+
+    for ( i=0; i<STORAGE_RECTASK; i++ )
+        res |= internal_write_task( outbase, i, binary );
+    return res;
+}
+
+
+//--- telemetry stream: frames from the device or the simulators UART ( see telemetry.h )
+
+#define TLM_PHASES          8                   // ph_wake, ph_conv[3], ph_proc, ph_save, ph_bsy, ph_uart
+
+struct STlmStats
+{
+    uint64  bytes;
+    uint32  frames;
+    uint32  reads;
+    uint32  crc_err;                            // frames with a CRC error
+    uint64  skipped;                            // bytes skipped while searching the frame start
+    uint32  lost;                               // seq gaps - frames lost on the link
+    uint32  drops;                              // frames dropped on the device
+    uint32  ph_cnt[TLM_PHASES];
+    uint64  ph_sum[TLM_PHASES];
+    uint32  ph_max[TLM_PHASES];
+    bool    seq_ok;                             // seq of the next frame is known
+    uint8   seq;
+};
+
+static struct STlmStats tst;
+
+static double internal_tlm_ms( uint32 val )
+{
+    return val * 1000.0 / TLM_TIME_UNIT;
+}
+
+static void internal_tlm_sread( FILE *out, const uint8 *payload, bool live )
+{
+    struct STlmSensorRead rd;
+    uint16 ph[TLM_PHASES];
+    uint16 year;
+    uint8 mounth, day, hour, minute, second;
+    uint32 i;
+
+    memcpy( &rd, payload, sizeof(rd) );
+    ph[0] = rd.ph_wake;
+    ph[1] = rd.ph_conv[0];
+    ph[2] = rd.ph_conv[1];
+    ph[3] = rd.ph_conv[2];
+    ph[4] = rd.ph_proc;
+    ph[5] = rd.ph_save;
+    ph[6] = rd.ph_bsy;
+    ph[7] = rd.ph_uart;
+    for ( i=0; i<TLM_PHASES; i++ )
+    {
+        // conversions are counted only for the sensors read
+        if ( (i >= 1) && (i <= 3) && ((rd.sensors & (1 << (i - 1))) == 0) )
+            continue;
+        tst.ph_cnt[i]++;
+        tst.ph_sum[i] += ph[i];
+        if ( tst.ph_max[i] < ph[i] )
+            tst.ph_max[i] = ph[i];
+    }
+    tst.reads++;
+
+    utils_convert_counter_2_ymd( rd.clock, &year, &mounth, &day );
+    utils_convert_counter_2_hms( rd.clock, &hour, &minute, &second );
+    fprintf( out, "%04d-%02d-%02d %02d:%02d:%02d.%d,%u,%u,", year, mounth, day, hour, minute, second, (rd.clock & 1) * 5,
+                  rd.clock, rd.sensors );
+    fprintf( out, "%.2f,%.2f,%.2f,%.2f,%.2f,", rd.temperature / 512.0 - 40.0,      // 16fp9 + 40*C
+                  rd.dewpoint / 512.0 - 40.0, rd.rh / 100.0, rd.absh / 100.0,      // x100 % and g/m3
+                  rd.pressure / 400.0 );                                            // 20fp2 Pa -> hPa
+    fprintf( out, "%s,%u,%u", (rd.pwr & PM_FULL) ? "full" : (rd.pwr & PM_SLEEP) ? "sleep" : (rd.pwr & PM_HOLD_BTN) ? "hold_btn" :
+                              (rd.pwr & PM_HOLD) ? "hold" : "down", (rd.pwr & TLM_PWR_CHARGE) ? 1 : 0, rd.battery );
+    for ( i=0; i<TLM_PHASES; i++ )
+        fprintf( out, ",%.3f", internal_tlm_ms( ph[i] ) );
+    fprintf( out, "\n" );
+    fflush( out );                              // the log can be followed / plotted while the stream runs
+
+    if ( live )
+    {
+        printf( "\r%02d:%02d:%02d  T %6.2f  RH %6.2f  P %7.2f  bsy %7.3f ms  frames %u  crc err %u  lost %u  drops %u ",
+                hour, minute, second, rd.temperature / 512.0 - 40.0, rd.rh / 100.0, rd.pressure / 400.0,
+                internal_tlm_ms( rd.ph_bsy ), tst.frames, tst.crc_err, tst.lost, tst.drops );
+        fflush( stdout );
+    }
+}
+
+// decode the frames from the buffer - returns the bytes used, the rest is an incomplete frame
+static uint32 internal_tlm_parse( FILE *out, const uint8 *buff, uint32 len, bool live )
+{
+    uint32 pos = 0;
+
+    while ( pos + TLM_HEADER <= len )
+    {
+        const uint8 *frame = buff + pos;
+        uint32 plen;
+        uint16 crc;
+
+        if ( (frame[0] != TLM_SYNC1) || (frame[1] != TLM_SYNC2) || (frame[4] > TLM_MAXPAYLOAD) )
+        {
+            pos++;
+            tst.skipped++;
+            continue;
+        }
+
+        plen = frame[4];
+        if ( pos + TLM_HEADER + plen + 2 > len )
+            break;
+
+        crc = crc16_update( CRC16_INIT, frame + 2, TLM_HEADER - 2 + plen );
+        if ( (frame[TLM_HEADER + plen] != (uint8)crc) || (frame[TLM_HEADER + plen + 1] != (uint8)(crc >> 8)) )
+        {
+            // a sync pattern in the data or a corrupted frame - search the next start from the following byte
+            tst.crc_err++;
+            pos++;
+            tst.skipped++;
+            continue;
+        }
+
+        if ( tst.seq_ok && (frame[3] != tst.seq) && (frame[2] != TLM_TYPE_START) )       // seq restarts with the stream
+            tst.lost += (uint8)( frame[3] - tst.seq );
+        tst.drops += frame[5];
+        tst.frames++;
+
+        switch ( frame[2] )
+        {
+            case TLM_TYPE_START:
+                if ( plen >= sizeof(struct STlmStart) )
+                {
+                    struct STlmStart start;
+
+                    memcpy( &start, frame + TLM_HEADER, sizeof(start) );
+                    if ( live )
+                        printf( "\n" );
+                    printf( "stream start at RTC counter 0x%08X, version %u\n", start.clock, start.version );
+                }
+                break;
+            case TLM_TYPE_SREAD:
+                if ( plen == sizeof(struct STlmSensorRead) )
+                    internal_tlm_sread( out, frame + TLM_HEADER, live );
+                break;
+        }
+
+        tst.seq = frame[3] + 1;
+        tst.seq_ok = true;
+        pos += TLM_HEADER + plen + 2;
+    }
+    return pos;
+}
+
+static int internal_decode_telemetry( const char *filename, const char *outfname )
+{
+    // The stream is read as it arrives - a serial port or pseudo-terminal can be given for live decoding,
+    // it ends when the sender closes it. The CSV log is flushed with every read, plot it with e.g. gnuplot:
+    //      set datafile separator ","; plot "telemetry.csv" using 2:4 with lines
+    static const char *c_phases[TLM_PHASES] = { "wake", "conv_t", "conv_rh", "conv_p", "proc", "save", "bsy", "uart" };
+    char outbase[256];
+    FILE *out;
+    uint32 fill = 0;
+    uint32 used;
+    bool live;
+    int fd;
+    int rd;
+    int i;
+
+    fd = open( filename, O_RDONLY | O_BINARY );
+    if ( fd < 0 )
+    {
+        printf( "Failed to open file %s\n", filename );
+        return 1;
+    }
+    live = isatty( fd );
+
+#ifndef _WIN32
+    if ( live )
+    {
+        // binary stream - no line editing and character translations
+        struct termios tio;
+
+        if ( tcgetattr( fd, &tio ) == 0 )
+        {
+            cfmakeraw( &tio );
+            tcsetattr( fd, TCSANOW, &tio );
+        }
+    }
+#endif
+
+    if ( outfname == NULL )
+    {
+        char *ext;
+
+        if ( (live == false) && (strlen( filename ) + 5 > sizeof(outbase)) )
+        {
+            printf( "Output file name too long: %s\n", filename );
+            close( fd );
+            return 1;
+        }
+        strcpy( outbase, live ? "telemetry" : filename );
+        ext = strrchr( outbase, '.' );
+        if ( ext && (strchr( ext, '/' ) == NULL) )
+            *ext = 0;
+        strcat( outbase, ".csv" );
+        outfname = outbase;
+    }
+    out = fopen( outfname, "w" );
+    if ( out == NULL )
+    {
+        printf( "Failed to open output file %s\n", outfname );
+        close( fd );
+        return 1;
+    }
+
+    fprintf( out, "time,clock,sensors,temperature[C],dewpoint[C],rh[%%],absh[g/m3],pressure[hPa],pwr,charge,battery[%%]" );
+    for ( i=0; i<TLM_PHASES; i++ )
+        fprintf( out, ",%s[ms]", c_phases[i] );
+    fprintf( out, "\n" );
+
+    memset( &tst, 0, sizeof(tst) );
+    while ( (rd = read( fd, in_buffer + fill, sizeof(in_buffer) - fill )) > 0 )
+    {
+        tst.bytes += rd;
+        fill += rd;
+        used = internal_tlm_parse( out, in_buffer, fill, live );
+        memmove( in_buffer, in_buffer + used, fill - used );
+        fill -= used;
+    }
+    close( fd );
+    fclose( out );
+
+    if ( live )
+        printf( "\n" );
+    printf( "%llu bytes, %u frames, %u sensor reads -> %s\n", (unsigned long long)tst.bytes, tst.frames, tst.reads, outfname );
+    printf( "crc errors %u, skipped bytes %llu, lost frames %u, dropped on the device %u, incomplete at the end %u bytes\n",
+            tst.crc_err, (unsigned long long)tst.skipped, tst.lost, tst.drops, fill );
+    for ( i=0; i<TLM_PHASES; i++ )
+    {
+        if ( tst.ph_cnt[i] )
+            printf( "  %-8s avg %8.3f ms  max %8.3f ms\n", c_phases[i], internal_tlm_ms( (uint32)(tst.ph_sum[i] / tst.ph_cnt[i]) ),
+                                                          internal_tlm_ms( tst.ph_max[i] ) );
+    }
+    return ( tst.crc_err || tst.lost ) ? 1 : 0;
+}
+
+
+static int internal_parse_readout_trace( char *filename )
 {
-    char *filename = argv[1];
     char outfname[64];
 
     struct SCoreNVreadout readout;
@@ -111,7 +686,7 @@ int main(int argc, char *argv[])
     fclose(file);
 
     // open the output file
-    strcpy( outfname, argv[1] );
+    strcpy( outfname, filename );
     outfname[ strlen(outfname) - 4 ] = 0;
     strcat( outfname, ".txt");
 
@@ -243,17 +818,9 @@ int main(int argc, char *argv[])
 
             // checksum processing
             {
-                int i;
-                uint32 cksum = UART_CKSUM_MAGICNR;
+                uint32 cksum = crc16_update( CRC16_INIT, in_buffer, ptr );
                 uint32 in_cksum = *(uint32*)(in_buffer + ptr);
 
-                for (i=0; i<ptr; i++)
-                {
-                    uint8 data;
-                    data = *(in_buffer+i);
-                    cksum = cksum + data + ( ((1 - data)&0xff) << 16 );
-                }
-
                 fprintf( file, "\nCKSUM:  InCksum[0x%08lX]  CalcCksum[0x%08lX]\n", in_cksum, cksum );
                 if ( cksum == in_cksum )
                     fprintf( file, "\t checksum OK\n");
@@ -278,4 +845,30 @@ int main(int argc, char *argv[])
 
 _error_exit:
     fclose(file);
+    return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+    // recread dump.bin                     - readout debug trace ( DBG_READOUT ) to dump.txt
+    // recread -x export.bin [-b]           - recording export stream to export_taskN.csv ( -b: binary columns in .bin )
+    // recread -e eeprom.dat [-b]           - the same from an FRAM image ( simulator eeprom.dat or core_op_recording_dbgDumpNVRAM() content )
+    // recread -l stream [out.csv]          - telemetry stream ( core_op_telemetry_switch() ) from a file or a serial port / pty, live
+    bool binary = ( (argc > 3) && (strcmp( argv[3], "-b" ) == 0) );
+
+    if ( argc < 2 )
+    {
+        printf( "usage: recread dump.bin | recread -x export.bin [-b] | recread -e eeprom.dat [-b] | recread -l stream [out.csv]\n" );
+        return 1;
+    }
+
+    if ( (strcmp( argv[1], "-x" ) == 0) && (argc > 2) )
+        return internal_decode_recordings( argv[2], false, binary );
+    if ( (strcmp( argv[1], "-e" ) == 0) && (argc > 2) )
+        return internal_decode_recordings( argv[2], true, binary );
+    if ( (strcmp( argv[1], "-l" ) == 0) && (argc > 2) )
+        return internal_decode_telemetry( argv[2], (argc > 3) ? argv[3] : NULL );
+
+    return internal_parse_readout_trace( argv[1] );
 }
@@ -38,8 +38,17 @@ HEADERS  += mainw.h \
     ../../../Prog/Project/MainProject/func/ui_graphics.h \
     ../../../Prog/Project/MainProject/func/dispHAL.h \
     ../../../Prog/Project/MainProject/func/utilities.h \
+    ../../../Prog/Project/MainProject/func/recagg.h \
+    ../../../Prog/Project/MainProject/func/recpack.h \
+    ../../../Prog/Project/MainProject/func/crc16.h \
+    ../../../Prog/Project/MainProject/func/telemetry.h \
+    ../../../Prog/Project/MainProject/func/recdelta.h \
     serial_port/MSerialPort_Global.hpp \
     serial_port/MSerialPort.hpp \
     serial_port/com_link.h
 
-SOURCES += main.cpp
+SOURCES += main.cpp \
+    ../../../Prog/Project/MainProject/func/recpack.c \
+    ../../../Prog/Project/MainProject/func/crc16.c \
+    ../../../Prog/Project/MainProject/func/recdelta.c \
+    ../../../Prog/Project/MainProject/func/utilities.c
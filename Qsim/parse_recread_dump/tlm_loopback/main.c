@@ -0,0 +1,273 @@
+/*
+ *  Telemetry pty loopback - replays a captured telemetry stream through a pseudo-terminal to recread -l
+ *
+ *  The capture of the headless simulator ( simu_headless -l stream.bin ) is written to the master side of a pty
+ *  in chunks of random size, recread decodes it live from the slave side as it would from the device UART.
+ *  The frames of the capture are counted here, the summary of recread must show the same frame count and byte
+ *  count with no CRC errors, lost frames, skipped or incomplete bytes.
+ *
+ *  usage: tlm_loopback recread stream.bin [out.csv]
+ *      recread         path of the recread binary
+ *      stream.bin      telemetry stream captured by simu_headless -l
+ *      out.csv         CSV log of recread, default: tlm_loopback.csv
+ *
+ *  exit code 0 - decoded without errors, 1 - failed. POSIX hosts only ( the pty and the tty path of recread ).
+ *
+ **/
+
+#define _GNU_SOURCE                             // posix_openpt(), cfmakeraw()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+
+#include "typedefs.h"
+#include "crc16.h"
+#include "telemetry.h"
+
+
+#define TLB_CHUNK_MAX       ( 2 * TLM_FRAMESIZE )   // frames are split between the writes
+#define TLB_DRAIN_MS        5000                    // max. wait for recread to read the rest of the stream
+#define TLB_QUIET_MS        200                     // time with empty pty input queue before the hangup
+#define TLB_LOG_MAX         ( 64 * 1024 )           // tail of the recread output kept for the summary
+
+
+static uint8 *stream;
+static uint32 stream_len;
+static char   rr_log[ TLB_LOG_MAX + 1 ];
+
+
+// frames of the capture - a clean capture has nothing between them
+static int internal_count_frames( uint32 *frames )
+{
+    uint32 pos = 0;
+
+    *frames = 0;
+    while ( pos + TLM_HEADER <= stream_len )
+    {
+        const uint8 *frame = stream + pos;
+        uint32 plen = frame[4];
+        uint16 crc;
+
+        if ( (frame[0] != TLM_SYNC1) || (frame[1] != TLM_SYNC2) || (plen > TLM_MAXPAYLOAD) ||
+             (pos + TLM_HEADER + plen + 2 > stream_len) )
+            break;
+
+        crc = crc16_update( CRC16_INIT, frame + 2, TLM_HEADER - 2 + plen );
+        if ( (frame[TLM_HEADER + plen] != (uint8)crc) || (frame[TLM_HEADER + plen + 1] != (uint8)(crc >> 8)) )
+            break;
+
+        (*frames)++;
+        pos += TLM_HEADER + plen + 2;
+    }
+
+    if ( pos != stream_len )
+    {
+        printf( "capture is not a clean telemetry stream at offset %u\n", pos );
+        return 1;
+    }
+    return 0;
+}
+
+static int internal_load( const char *filename )
+{
+    FILE *f;
+    long size;
+
+    f = fopen( filename, "rb" );
+    if ( f == NULL )
+    {
+        printf( "Failed to open file %s\n", filename );
+        return 1;
+    }
+    fseek( f, 0L, SEEK_END );
+    size = ftell( f );
+    fseek( f, 0L, SEEK_SET );
+
+    stream = (uint8*)malloc( size ? size : 1 );
+    if ( (stream == NULL) || (fread( stream, 1, size, f ) != (size_t)size) )
+    {
+        printf( "Failed to read file %s\n", filename );
+        fclose( f );
+        return 1;
+    }
+    stream_len = (uint32)size;
+    fclose( f );
+    return 0;
+}
+
+// recread prints its live status while the stream runs - the output is collected, the summary is at the end
+static void internal_collect( int fd, uint32 *fill )
+{
+    int rd;
+
+    while ( (rd = read( fd, rr_log + *fill, TLB_LOG_MAX - *fill )) > 0 )
+    {
+        *fill += rd;
+        if ( *fill == TLB_LOG_MAX )
+        {
+            memmove( rr_log, rr_log + TLB_LOG_MAX / 2, TLB_LOG_MAX / 2 );
+            *fill = TLB_LOG_MAX / 2;
+        }
+    }
+}
+
+static int internal_loopback( const char *recread, const char *outfname, int *status )
+{
+    struct termios tio;
+    struct pollfd pfd[2];
+    uint32 sent = 0;
+    uint32 fill = 0;
+    uint32 waited = 0;
+    uint32 quiet = 0;
+    int master;
+    int slave;
+    int out[2];
+    int inq;
+    char *name;
+    pid_t pid;
+
+    // pty in raw mode - the stream is written before recread sets it up itself
+    master = posix_openpt( O_RDWR | O_NOCTTY );
+    if ( (master < 0) || grantpt( master ) || unlockpt( master ) )
+    {
+        printf( "Failed to open a pseudo-terminal\n" );
+        return 1;
+    }
+    name = ptsname( master );
+    slave = open( name, O_RDWR | O_NOCTTY );
+    if ( (slave < 0) || tcgetattr( slave, &tio ) )
+    {
+        printf( "Failed to open %s\n", name );
+        return 1;
+    }
+    cfmakeraw( &tio );
+    tcsetattr( slave, TCSANOW, &tio );
+
+    if ( pipe( out ) )
+        return 1;
+
+    pid = fork();
+    if ( pid < 0 )
+        return 1;
+    if ( pid == 0 )
+    {
+        dup2( out[1], STDOUT_FILENO );
+        close( out[0] );
+        close( out[1] );
+        close( master );
+        close( slave );
+        execl( recread, recread, "-l", name, outfname, (char*)NULL );
+        printf( "Failed to start %s\n", recread );
+        _exit( 127 );
+    }
+    close( out[1] );
+    fcntl( out[0], F_SETFL, O_NONBLOCK );
+    fcntl( master, F_SETFL, O_NONBLOCK );
+
+    // send the stream - the pty takes it as fast as recread reads
+    pfd[0].fd = master;
+    pfd[1].fd = out[0];
+    pfd[1].events = POLLIN;
+    while ( sent < stream_len )
+    {
+        int wr;
+        uint32 len = 1 + rand() % TLB_CHUNK_MAX;
+
+        pfd[0].events = POLLOUT;
+        if ( poll( pfd, 2, 1000 ) < 0 )
+            break;
+        if ( pfd[1].revents )
+            internal_collect( out[0], &fill );
+        if ( (pfd[0].revents & POLLOUT) == 0 )
+            continue;
+
+        if ( len > stream_len - sent )
+            len = stream_len - sent;
+        wr = write( master, stream + sent, len );
+        if ( wr > 0 )
+            sent += wr;
+    }
+
+    // the hangup at close drops the unread input - wait till recread has it all. The written data reaches the
+    // input queue of the slave with a delay, so the queue has to stay empty for a while
+    while ( (quiet < TLB_QUIET_MS) && (waited < TLB_DRAIN_MS) )
+    {
+        if ( (ioctl( slave, FIONREAD, &inq ) == 0) && (inq == 0) )
+            quiet++;
+        else
+            quiet = 0;
+        internal_collect( out[0], &fill );
+        usleep( 1000 );
+        waited++;
+    }
+    close( slave );
+    close( master );
+
+    fcntl( out[0], F_SETFL, 0 );
+    internal_collect( out[0], &fill );
+    close( out[0] );
+    rr_log[fill] = 0;
+
+    waitpid( pid, status, 0 );
+    return ( sent == stream_len ) ? 0 : 1;
+}
+
+
+int main( int argc, char *argv[] )
+{
+    const char *outfname = ( argc > 3 ) ? argv[3] : "tlm_loopback.csv";
+    unsigned long long bytes = 0;
+    unsigned long long skipped = 0;
+    uint32 frames_exp;
+    uint32 frames = 0;
+    uint32 reads, crc_err, lost, drops, incomplete;
+    bool summary = false;
+    bool counters = false;
+    char *line;
+    int status = -1;
+    int res;
+
+    if ( argc < 3 )
+    {
+        printf( "usage: tlm_loopback recread stream.bin [out.csv]\n" );
+        return 1;
+    }
+    if ( internal_load( argv[2] ) || internal_count_frames( &frames_exp ) )
+        return 1;
+
+    srand( 0x64892354 );
+    res = internal_loopback( argv[1], outfname, &status );
+
+    for ( line = strtok( rr_log, "\r\n" ); line; line = strtok( NULL, "\r\n" ) )
+    {
+        if ( sscanf( line, "%llu bytes, %u frames, %u sensor reads", &bytes, &frames, &reads ) == 3 )
+            summary = true;
+        if ( sscanf( line, "crc errors %u, skipped bytes %llu, lost frames %u, dropped on the device %u, incomplete at the end %u bytes",
+                     &crc_err, &skipped, &lost, &drops, &incomplete ) == 5 )
+            counters = true;
+    }
+
+    if ( res || (summary == false) || (counters == false) )
+    {
+        printf( "%s", rr_log );
+        printf( "telemetry loopback: FAILED ( no summary from recread )\n" );
+        return 1;
+    }
+
+    res = ( (WIFEXITED(status) == 0) || WEXITSTATUS(status) || (bytes != stream_len) || (frames != frames_exp) ||
+            crc_err || skipped || lost || incomplete );
+    printf( "telemetry loopback through a pseudo-terminal:\n" );
+    printf( "  bytes          %llu / %u sent\n", bytes, stream_len );
+    printf( "  frames         %u / %u in the capture\n", frames, frames_exp );
+    printf( "  crc errors     %u, lost frames %u, skipped bytes %llu, incomplete %u bytes, dropped on the device %u\n",
+            crc_err, lost, skipped, incomplete, drops );
+    printf( "  result         %s\n", res ? "FAILED" : "OK" );
+    return res;
+}
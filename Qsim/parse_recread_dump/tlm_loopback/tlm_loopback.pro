@@ -0,0 +1,30 @@
+#-------------------------------------------------
+#
+# Telemetry pty loopback - a captured stream is replayed
+# through a pseudo-terminal to recread -l ( POSIX hosts )
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = tlm_loopback
+CONFIG   += console
+CONFIG   -= app_bundle
+CONFIG   -= qt
+
+TEMPLATE = app
+
+DEFINES += ON_QT_PLATFORM
+
+INCLUDEPATH += ../../../Prog/Project/MainProject/ \
+               ../../../Prog/Project/MainProject/func/  \
+               ../../../Qsim/simu_hygro/simuhygro
+
+
+SOURCES += main.c \
+    ../../../Prog/Project/MainProject/func/crc16.c
+
+HEADERS  += ../../../Qsim/simu_hygro/simuhygro/stm32f10x.h \
+    ../../../Prog/Project/MainProject/typedefs.h \
+    ../../../Prog/Project/MainProject/func/crc16.h \
+    ../../../Prog/Project/MainProject/func/telemetry.h
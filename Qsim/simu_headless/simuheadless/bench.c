@@ -0,0 +1,2436 @@
+/*
+ *  Host benchmarks for firmware routines
+ *
+ *  Each benchmark compares a firmware routine against its reference
+ *  implementation (usually the one it replaced) for accuracy and speed,
+ *  or times a firmware pipeline on the emulated hardware.
+ *  Run with: simu_headless -b <name>
+ *
+ **/
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include <time.h>
+
+#include "hw_headless.h"
+#include "bench.h"
+#include "core.h"
+#include "crc16.h"
+#include "events_ui.h"
+#include "psychro.h"
+#include "recagg.h"
+#include "recdelta.h"
+#include "recpack.h"
+#include "utilities.h"
+#include "graphic_lib.h"
+
+
+static double internal_elapsed_ns( clock_t start, uint32 calls )
+{
+    return ( (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC ) / calls;
+}
+
+// results of the timed loops are stored here - the compiler can not drop a loop whose result is written in a volatile
+static volatile uint32 bench_sink;
+
+
+/////////////////////////////////////////////////////
+// psychro - dew point / absolute humidity
+/////////////////////////////////////////////////////
+
+// the double implementation replaced by psychro.c - dew point limit fixed to -40*C
+static void ref_calculate_dewpoint_abshum( uint32 temp, uint32 rh, uint32 *p_abs_hum, uint32 *p_dew )
+{
+    #define CT_A    6.116441        // constant set for -20*C <--> + 50*C with max error 0.08%
+    #define CT_m    7.591386        //
+    #define CT_Tn   240.7263        //
+    #define CT_C    2.16679         //
+
+    double Pw;
+    double T;
+
+    T =  ( ( ((int)temp * 100) >> TEMP_FP ) - 4000 ) / 100.0;
+    rh = ((rh * 100) >> RH_FP);
+    Pw = ( CT_A * (rh / 100.0) * pow( 10, ((CT_m * T) / (T + CT_Tn)) ) ) / 100.0;
+
+    if ( p_abs_hum )
+    {
+        double Abs;
+
+        Abs = (CT_C * Pw * 100) / (T + 273.15);
+        *p_abs_hum = (uint32)(Abs * 100);
+    }
+
+    if ( p_dew )
+    {
+        double Td;
+
+        Td = CT_Tn / (  (CT_m / log10(Pw/CT_A)) - 1 );
+        if ( Td < -39.99 )
+            Td = -40.0;
+        *p_dew = (uint16)((Td + 40.0) * (1<< TEMP_FP));
+    }
+}
+
+#define BPSY_TEMP_STEP      37          // 0.07*C
+#define BPSY_RH_STEP        53          // 0.2%
+#define BPSY_RH_MIN         (1 << RH_FP)
+
+static void bench_psychro( void )
+{
+    uint32  temp;
+    uint32  rh;
+    uint32  ref_abs, ref_dew;
+    uint32  abs, dew;
+    uint32  calls;
+    uint32  dummy = 0;
+    double  err;
+    double  max_abs = 0, max_dew = 0;
+    double  sum_abs = 0, sum_dew = 0;
+    uint32  max_abs_t = 0, max_abs_rh = 0;
+    uint32  max_dew_t = 0, max_dew_rh = 0;
+    double  t_ref, t_fix;
+    clock_t start;
+
+    // accuracy over the whole temperature range and 1% -> 100% RH
+    calls = 0;
+    for ( temp = 0; temp <= 0xffff; temp += BPSY_TEMP_STEP )
+    {
+        for ( rh = BPSY_RH_MIN; rh <= (100 << RH_FP); rh += BPSY_RH_STEP )
+        {
+            ref_calculate_dewpoint_abshum( temp, rh, &ref_abs, &ref_dew );
+            abs = psychro_abs_humidity( temp, rh );
+            dew = psychro_dewpoint( temp, rh );
+
+            err = fabs( (double)abs - (double)ref_abs ) / 100.0;                // g/m3
+            sum_abs += err;
+            if ( err > max_abs )
+            {
+                max_abs = err;  max_abs_t = temp;  max_abs_rh = rh;
+            }
+            err = fabs( (double)dew - (double)ref_dew ) / (1 << TEMP_FP);       // *C
+            sum_dew += err;
+            if ( err > max_dew )
+            {
+                max_dew = err;  max_dew_t = temp;  max_dew_rh = rh;
+            }
+            calls++;
+        }
+    }
+
+    // speed - both values are calculated in one call as in core.c
+    start = clock();
+    for ( temp = 0; temp <= 0xffff; temp += BPSY_TEMP_STEP )
+        for ( rh = BPSY_RH_MIN; rh <= (100 << RH_FP); rh += BPSY_RH_STEP )
+        {
+            ref_calculate_dewpoint_abshum( temp, rh, &abs, &dew );
+            dummy += abs + dew;
+        }
+    t_ref = internal_elapsed_ns( start, calls );
+
+    start = clock();
+    for ( temp = 0; temp <= 0xffff; temp += BPSY_TEMP_STEP )
+        for ( rh = BPSY_RH_MIN; rh <= (100 << RH_FP); rh += BPSY_RH_STEP )
+            dummy += psychro_abs_humidity( temp, rh ) + psychro_dewpoint( temp, rh );
+    t_fix = internal_elapsed_ns( start, calls );
+
+    printf( "psychro: %u points, -40*C -> +88*C, 1%% -> 100%% RH\n", calls );
+    printf( "  abs. humidity: max error %.3f g/m3 ( at %.2f*C %.1f%% ), avg %.4f g/m3\n", max_abs,
+                            max_abs_t / 512.0 - 40, max_abs_rh / 256.0, sum_abs / calls );
+    printf( "  dew point:     max error %.3f *C ( at %.2f*C %.1f%% ), avg %.4f *C\n", max_dew,
+                            max_dew_t / 512.0 - 40, max_dew_rh / 256.0, sum_dew / calls );
+    printf( "  double:        %8.1f ns / sample\n", t_ref );
+    printf( "  fixed point:   %8.1f ns / sample  ( x%.1f )\n", t_fix, t_fix > 0 ? t_ref / t_fix : 0.0 );
+    bench_sink = dummy;
+}
+
+
+/////////////////////////////////////////////////////
+// recpack - packed recording sample codec
+/////////////////////////////////////////////////////
+
+#define BRP_ELEMS           4000                        // elements per layout
+#define BRP_VALUES          (BRP_ELEMS * 3)
+#define BRP_BUFF            ((BRP_VALUES * 3) / 2 + 8)
+#define BRP_LOOPS           200
+
+static uint16 brp_val[BRP_VALUES];
+static uint16 brp_dec[BRP_VALUES];
+static uint8  brp_ref[BRP_BUFF];
+static uint8  brp_buf[BRP_BUFF];
+
+// nibble by nibble reference of the recording format
+static void ref_recpack_put_nibble( uint8 *buff, uint32 nibble, uint32 val )
+{
+    if ( nibble & 0x01 )
+        buff[nibble >> 1] = (buff[nibble >> 1] & 0xf0) | (val & 0x0f);
+    else
+        buff[nibble >> 1] = (buff[nibble >> 1] & 0x0f) | ((val & 0x0f) << 4);
+}
+
+static void ref_recpack_encode( uint8 *buff, uint32 nibble, const uint16 *val, uint32 count )
+{
+    while ( count-- )
+    {
+        ref_recpack_put_nibble( buff, nibble++, *val >> 12 );
+        ref_recpack_put_nibble( buff, nibble++, *val >> 8 );
+        ref_recpack_put_nibble( buff, nibble++, *val >> 4 );
+        val++;
+    }
+}
+
+static void ref_recpack_decode( const uint8 *buff, uint32 nibble, uint16 *val, uint32 count )
+{
+    uint32 i;
+    uint32 v;
+
+    while ( count-- )
+    {
+        v = 0;
+        for ( i=0; i<3; i++, nibble++ )
+            v = (v << 4) | ( (nibble & 0x01) ? (buff[nibble >> 1] & 0x0f) : (buff[nibble >> 1] >> 4) );
+        *val++ = (uint16)(v << 4);
+    }
+}
+
+static uint32 internal_rand( void )
+{
+    static uint32 seed = 0x12345678;
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+// the recording writer as done by core.c: values pushed in sensor order into the staging
+// buffer, the buffer written when the next element doesn't fit, the half byte carried over
+static void internal_recpack_writer( uint8 *stream, uint32 task_elems, uint32 shift, const uint16 *val, uint32 elems )
+{
+    uint8  stage[CORE_REC_STAGE];
+    uint32 stg_shift = shift;
+    uint32 stg_cnt = 0;
+    uint32 elsizeX2 = RECPACK_ELSIZEX2( task_elems );
+    uint32 nibbles;
+    uint32 ee_len;
+    uint32 order[3];
+    uint32 nch = 0;
+    uint32 e, i, j, t;
+
+    memset( stage, 0, sizeof(stage) );
+    if ( shift )
+        stage[0] = stream[0];
+
+    for ( e=0; e<elems; e++ )
+    {
+        // push the sensor values in random order
+        nch = 0;
+        for ( i=0; i<3; i++ )
+            if ( task_elems & (1 << i) )
+                order[nch++] = i;
+        for ( i=nch; i>1; i-- )
+        {
+            j = internal_rand() % i;
+            t = order[j];  order[j] = order[i-1];  order[i-1] = t;
+        }
+        for ( i=0; i<nch; i++ )
+        {
+            uint32 smask = 1 << order[i];
+            recpack_put( stage, stg_shift + elsizeX2 * stg_cnt + 3 * RECPACK_CHANNEL_IDX( task_elems, smask ),
+                         val[ e * nch + RECPACK_CHANNEL_IDX( task_elems, smask ) ] >> 4 );
+        }
+        stg_cnt++;
+
+        // save if the next element doesn't fit or at the end
+        if ( ((stg_shift + elsizeX2 * (stg_cnt + 1)) > (CORE_REC_STAGE * 2)) || (e == elems - 1) )
+        {
+            nibbles = stg_shift + elsizeX2 * stg_cnt;
+            ee_len  = (nibbles + 1) >> 1;
+            memcpy( stream + ((shift + (e + 1 - stg_cnt) * elsizeX2) >> 1), stage, ee_len );
+
+            stage[0] = (nibbles & 0x01) ? stage[ee_len - 1] : 0;
+            stg_shift = nibbles & 0x01;
+            memset( stage + 1, 0, CORE_REC_STAGE - 1 );
+            stg_cnt = 0;
+        }
+    }
+}
+
+static void bench_recpack( void )
+{
+    static const char *names[8] = { "", "T", "H", "TH", "P", "TP", "HP", "THP" };
+    uint32  task_elems;
+    uint32  shift;
+    uint32  nval;
+    uint32  i, pos, cnt;
+    uint32  errors = 0;
+    uint32  dummy = 0;
+    double  t_ref_enc, t_enc, t_ref_dec, t_dec;
+    clock_t start;
+
+    printf( "recpack: %u elements per layout, both nibble alignments\n", BRP_ELEMS );
+    printf( "  layout  elsize   encode ref / word   [ns/value]   decode ref / word   [ns/value]   errors\n" );
+
+    for ( task_elems = rtt_t; task_elems <= rtt_thp; task_elems++ )
+    {
+        uint32 lerr = 0;
+        nval = BRP_ELEMS * RECPACK_CHANNELS( task_elems );
+
+        for ( i=0; i<nval; i++ )
+            brp_val[i] = (uint16)internal_rand();
+
+        for ( shift = 0; shift < 2; shift++ )
+        {
+            // reference stream with guard bytes
+            memset( brp_ref, 0xa5, BRP_BUFF );
+            ref_recpack_encode( brp_ref, shift, brp_val, nval );
+
+            // block encoder - must leave the surrounding nibbles untouched
+            memset( brp_buf, 0xa5, BRP_BUFF );
+            if ( recpack_encode( brp_buf, shift, brp_val, nval ) != shift + 3 * nval )
+                lerr++;
+            if ( memcmp( brp_buf, brp_ref, BRP_BUFF ) )
+                lerr++;
+
+            // staged writer as in core.c - byte complete elements are never shifted
+            if ( (shift == 0) || (RECPACK_ELSIZEX2( task_elems ) & 0x01) )
+            {
+                memset( brp_buf, 0xa5, BRP_BUFF );
+                internal_recpack_writer( brp_buf, task_elems, shift, brp_val, BRP_ELEMS );
+                if ( memcmp( brp_buf, brp_ref, (shift + 3 * nval) >> 1 ) )
+                    lerr++;
+            }
+
+            // decoder - whole stream and random chunks from random positions
+            memset( brp_dec, 0, sizeof(brp_dec) );
+            recpack_decode( brp_ref, shift, brp_dec, nval );
+            for ( i=0; i<nval; i++ )
+                if ( brp_dec[i] != (brp_val[i] & 0xfff0) )
+                    lerr++;
+            for ( i=0; i<1000; i++ )
+            {
+                pos = internal_rand() % nval;
+                cnt = 1 + internal_rand() % RECPACK_CHUNK;
+                if ( pos + cnt > nval )
+                    cnt = nval - pos;
+                recpack_decode( brp_ref, shift + 3 * pos, brp_dec, cnt );
+                while ( cnt-- )
+                    if ( brp_dec[cnt] != (brp_val[pos + cnt] & 0xfff0) )
+                        lerr++;
+            }
+        }
+
+        // throughput - readout decodes by chunks of RECPACK_CHUNK values
+        start = clock();
+        for ( i=0; i<BRP_LOOPS; i++ )
+            ref_recpack_encode( brp_buf, i & 1, brp_val, nval );
+        t_ref_enc = internal_elapsed_ns( start, BRP_LOOPS * nval );
+
+        start = clock();
+        for ( i=0; i<BRP_LOOPS; i++ )
+            recpack_encode( brp_buf, i & 1, brp_val, nval );
+        t_enc = internal_elapsed_ns( start, BRP_LOOPS * nval );
+
+        start = clock();
+        for ( i=0; i<BRP_LOOPS; i++ )
+        {
+            for ( pos = 0; pos < nval; pos += RECPACK_CHUNK )
+            {
+                cnt = (nval - pos > RECPACK_CHUNK) ? RECPACK_CHUNK : nval - pos;
+                ref_recpack_decode( brp_buf, (i & 1) + 3 * pos, brp_dec, cnt );
+                dummy += brp_dec[0];
+            }
+        }
+        t_ref_dec = internal_elapsed_ns( start, BRP_LOOPS * nval );
+
+        start = clock();
+        for ( i=0; i<BRP_LOOPS; i++ )
+        {
+            for ( pos = 0; pos < nval; pos += RECPACK_CHUNK )
+            {
+                cnt = (nval - pos > RECPACK_CHUNK) ? RECPACK_CHUNK : nval - pos;
+                recpack_decode( brp_buf, (i & 1) + 3 * pos, brp_dec, cnt );
+                dummy += brp_dec[0];
+            }
+        }
+        t_dec = internal_elapsed_ns( start, BRP_LOOPS * nval );
+
+        printf( "  %-6s  %3.1f B    %8.2f / %-8.2f              %8.2f / %-8.2f              %u\n",
+                names[task_elems], RECPACK_ELSIZEX2( task_elems ) / 2.0,
+                t_ref_enc, t_enc, t_ref_dec, t_dec, lerr );
+        errors += lerr;
+    }
+
+    printf( "  round trip: %s\n", errors ? "FAILED" : "OK" );
+    bench_sink = dummy;
+}
+
+
+/////////////////////////////////////////////////////
+// readout - recording graph read path
+/////////////////////////////////////////////////////
+
+extern struct SCore core;
+
+#define BRO_TASK_PAGES      252         // largest task - 64K elements except for rtt_thp
+#define BRO_SPI_HZ          2000000     // FRAM SPI clock on the board: 8MHz HSI / 4
+#define BRO_CMD_BYTES       4           // read command + 24bit address for each FRAM read
+#define BRO_MIN_TIME        (CLOCKS_PER_SEC / 20)   // repeat a readout for at least 50ms
+
+static const uint32 bro_depths[] = { 110, 1000, 4000, 16000, 65535 };
+
+static void internal_readout_core_start( void )
+{
+    struct SCore *pcore;
+    struct SEventStruct ev;
+
+    // first power-up with erased FRAM, wait for the setup load
+    HL_Init( NULL );
+    hl.PwrMode = pm_full;
+    core_init( &pcore );
+
+    memset( &ev, 0, sizeof(ev) );
+    ev.timer_tick_system = 1;
+    while ( core.vstatus.int_op.f.nv_initted == 0 )
+        core_poll( &ev );
+    core_op_recording_init();
+
+    // let the start-up sensor reads finish - a pending read keeps the core from serving the readout
+    while ( core.vstatus.int_op.f.core_bsy )
+    {
+        Sensor_simu_poll();
+        core_poll( &ev );
+    }
+}
+
+static uint32 internal_readout_run( uint32 depth )
+{
+    // full graph pipeline as the UI does it: request, poll till ready, pixels for every parameter of the task
+    struct SEventStruct ev;
+    uint32 param;
+    uint32 dummy = 0;
+    int high, low;
+    bool has_minmax;
+
+    memset( &ev, 0, sizeof(ev) );
+    core_op_recording_read_request( 0, depth, depth );
+    while ( core_op_recording_read_busy() )
+        core_poll( &ev );
+
+    for ( param = ss_thermo; param <= ss_pressure; param++ )
+    {
+        if ( core.readout.taks_elem & (1 << (param - 1)) )
+            dummy += core_op_recording_calculate_pixels( (enum ESensorSelect)param, &high, &low, &has_minmax )[0];
+    }
+    core_op_recording_read_cancel();
+    return dummy;
+}
+
+static void bench_readout( void )
+{
+    static const char *names[8] = { "", "T", "H", "TH", "P", "TP", "HP", "THP" };
+    struct SRecTaskInstance task;
+    uint32  task_elems;
+    uint32  depth;
+    uint32  reps;
+    uint32  dummy = 0;
+    uint32  i;
+    uint32  reads;
+    uint64  bytes;
+    double  t_us;
+    clock_t start;
+
+    internal_readout_core_start();
+
+    printf( "readout: %u page task filled with dbgfill data, read_request -> readout -> calculate_pixels\n", BRO_TASK_PAGES );
+    printf( "  layout  depth   level  points    FRAM reads   bytes     host [us]   [Msample/s]   SPI @%uMHz [ms]\n", BRO_SPI_HZ / 1000000 );
+
+    for ( task_elems = rtt_t; task_elems <= rtt_thp; task_elems++ )
+    {
+        task.mempage = 0;
+        task.size = BRO_TASK_PAGES;
+        task.task_elems = task_elems;
+        task.sample_rate = ut_5sec;
+        task.deadband = 0;
+        core_op_recording_setup_task( 0, &task );
+        core_op_recording_dbgfill( 0 );
+        internal_readout_run( core.nvrec.func[0].c );               // flush the staged elements
+
+        for ( i=0; i<sizeof(bro_depths)/sizeof(bro_depths[0]); i++ )
+        {
+            depth = bro_depths[i];
+            if ( depth > core.nvrec.func[0].c )
+                depth = core.nvrec.func[0].c;                       // the task can not hold more
+
+            reads = hl.st_ee_reads;
+            bytes = hl.st_ee_bytes_rd;
+            dummy += internal_readout_run( depth );
+            reads = hl.st_ee_reads - reads;
+            bytes = hl.st_ee_bytes_rd - bytes;
+
+            reps = 0;
+            start = clock();
+            do
+            {
+                dummy += internal_readout_run( depth );
+                reps++;
+            } while ( (clock() - start) < BRO_MIN_TIME );
+            t_us = internal_elapsed_ns( start, reps ) / 1000.0;
+
+            printf( "  %-6s  %5u   %u      %5u     %5u        %-8llu  %8.1f     %8.2f      %8.2f\n",
+                    names[task_elems], depth, core.readout.level, core.readout.total_read, reads, (unsigned long long)bytes,
+                    t_us, depth / t_us, ((bytes + BRO_CMD_BYTES * reads) * 8 * 1000.0) / BRO_SPI_HZ );
+
+            if ( depth != bro_depths[i] )
+                break;
+        }
+    }
+    bench_sink = dummy;
+}
+
+
+/////////////////////////////////////////////////////
+// grcache - zoom in / out on the recording viewer
+/////////////////////////////////////////////////////
+
+#define BGC_STEPS           5
+#define BGC_ZOOM            2000        // elements shown zoomed in at the end of the recording
+
+static uint32 internal_grcache_step( uint32 depth, uint32 length )
+{
+    // one view change of the viewer: request, poll till ready, hash of the pixels of every parameter of the task
+    struct SEventStruct ev;
+    const uint8 *pix;
+    uint32 param;
+    uint32 hash = 2166136261u;
+    uint32 i;
+    int high, low;
+    bool has_minmax;
+
+    memset( &ev, 0, sizeof(ev) );
+    core_op_recording_read_request( 0, depth, length );
+    while ( core_op_recording_read_busy() )
+        core_poll( &ev );
+
+    for ( param = ss_thermo; param <= ss_pressure; param++ )
+    {
+        if ( core.readout.taks_elem & (1 << (param - 1)) )
+        {
+            pix = core_op_recording_calculate_pixels( (enum ESensorSelect)param, &high, &low, &has_minmax );
+            for ( i=0; i<3*WB_DISPPOINT; i++ )
+                hash = (hash ^ pix[i]) * 16777619u;
+            hash = (hash ^ (uint32)high) * 16777619u;
+            hash = (hash ^ (uint32)low) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+static void bench_grcache( void )
+{
+    static const char *names[8] = { "", "T", "H", "TH", "P", "TP", "HP", "THP" };
+    static const char *steps[BGC_STEPS] = { "full", "zoom", "full", "zoom", "full" };
+    struct SRecTaskInstance task;
+    uint32  task_elems;
+    uint32  total;
+    uint32  depth;
+    uint32  length;
+    uint32  hash[2];
+    uint32  h;
+    uint32  reads;
+    uint64  bytes;
+    uint32  errors = 0;
+    uint32  again[2] = { 0, 0 };                                    // views shown again / served from the cache for single
+    uint32  hits[2] = { 0, 0 };                                     // and multi parameter tasks
+    uint32  multi;
+    uint32  i;
+
+    internal_readout_core_start();
+
+    printf( "grcache: %u page task filled with dbgfill data, viewer steps full -> zoom (%u) -> full -> zoom -> full\n", BRO_TASK_PAGES, BGC_ZOOM );
+    printf( "  layout  step   level  points    FRAM reads   bytes     SPI @%uMHz [ms]   pixels\n", BRO_SPI_HZ / 1000000 );
+
+    for ( task_elems = rtt_t; task_elems <= rtt_thp; task_elems++ )
+    {
+        task.mempage = 0;
+        task.size = BRO_TASK_PAGES;
+        task.task_elems = task_elems;
+        task.sample_rate = ut_5sec;
+        task.deadband = 0;
+        core_op_recording_setup_task( 0, &task );
+        core_op_recording_dbgfill( 0 );
+        internal_readout_run( core.nvrec.func[0].c );               // flush the staged elements
+        total = core.nvrec.func[0].c;
+        multi = (RECPACK_CHANNELS( task_elems ) > 1);
+
+        for ( i=0; i<BGC_STEPS; i++ )
+        {
+            depth = total;
+            length = (i & 1) ? BGC_ZOOM : total;
+
+            reads = hl.st_ee_reads;
+            bytes = hl.st_ee_bytes_rd;
+            h = internal_grcache_step( depth, length );
+            reads = hl.st_ee_reads - reads;
+            bytes = hl.st_ee_bytes_rd - bytes;
+
+            if ( i < 2 )
+                hash[i] = h;                                        // first readouts of the views
+            else
+            {
+                again[multi]++;
+                if ( reads == 0 )
+                    hits[multi]++;
+                if ( hash[i & 1] != h )
+                    errors++;
+            }
+
+            printf( "  %-6s  %-4s   %u      %5u     %5u        %-8llu  %8.2f           %08x %s\n",
+                    names[task_elems], steps[i], core.readout.level, core.readout.total_read, reads, (unsigned long long)bytes,
+                    ((bytes + BRO_CMD_BYTES * reads) * 8 * 1000.0) / BRO_SPI_HZ, h,
+                    ((i < 2) || (hash[i & 1] == h)) ? "" : "MISMATCH" );
+        }
+        core_op_recording_read_cancel();
+    }
+    printf( "  views served from the cache: single parameter %u / %u, multi parameter %u / %u\n", hits[0], again[0], hits[1], again[1] );
+    printf( "  views served again: %s\n", (errors || (hits[0] == 0)) ? "FAILED" : "OK" );
+}
+
+
+/////////////////////////////////////////////////////
+// deadband - deadband coded recording elements
+/////////////////////////////////////////////////////
+
+#define BDB_ELEMS           4096                        // elements of the codec tests - whole blocks
+#define BDB_VALUES          (BDB_ELEMS * 3)
+#define BDB_BUFF            ((BDB_VALUES * 3) / 2 + 8)                  // packed elements - the largest coded ones fit also
+#define BDB_LOOPS           200
+#define BDB_FILL            (65536 + 3)                 // dbgfill elements of a task of 64K elements
+#define BDB_PAGES           32                          // task size of the storage and capacity tables
+#define BDB_RATE            ut_5min                     // sample rate for the capacity in days
+#define BDB_OLDEST          100                         // elements of the view at the oldest element
+
+struct SBdbSignal
+{
+    const char  *name;
+    uint32      slope;                                  // max. change / sample of the random walk
+    uint32      noise;                                  // max. noise added to the walk
+    uint32      fronts;                                 // 1 - occasional fast changes
+};
+
+static const uint32 bdb_bands[] = { 1, 2, 4, 8, CORE_REC_MAXDEADBAND };
+static const struct SBdbSignal bdb_signals[] = { { "flat",   0, 1,  0 },
+                                                 { "drift",  1, 1,  0 },
+                                                 { "noisy",  4, 8,  1 } };
+// readout views of the correctness check: depth, length - copy views with block start and mid-block first elements,
+// a view at the oldest element is added after the fill
+static const uint32 bdb_views[][2] = { { 110, 110 }, { 96, 96 }, { 105, 60 }, { 37, 37 }, { 110, 1 } };
+
+static uint16 bdb_val[BDB_VALUES];
+static uint16 bdb_dec[BDB_VALUES];
+static uint8  bdb_buf[BDB_BUFF];
+static uint16 bdb_ref[BDB_FILL * 3];                    // dbgfill values as the decoder gives them back
+static uint32 bdb_ring[8];                              // data ring size of the storage table tasks
+
+// random walk in 12bit with noise - a sensor signal
+static void internal_deadband_signal( uint16 *val, uint32 nch, uint32 elems, const struct SBdbSignal *sig )
+{
+    int32 v[3] = { 0x600, 0x300, 0x900 };
+    int32 out;
+    uint32 i, ch;
+
+    for ( i=0; i<elems; i++ )
+    {
+        for ( ch=0; ch<nch; ch++ )
+        {
+            if ( sig->fronts && ((internal_rand() & 0xff) == 0) )
+                v[ch] += (int32)(internal_rand() % 257) - 128;
+            else
+                v[ch] += (int32)(internal_rand() % (2 * sig->slope + 1)) - (int32)sig->slope;
+            if ( v[ch] < 0x100 )
+                v[ch] = 0x100;
+            if ( v[ch] > 0xeff )
+                v[ch] = 0xeff;
+            out = v[ch] + (int32)(internal_rand() % (2 * sig->noise + 1)) - (int32)sig->noise;
+            *val++ = (uint16)out;
+        }
+    }
+}
+
+// element writer as core.c does it, in one linear stream - returns the size in nibbles
+static uint32 internal_deadband_encode( uint8 *buff, uint32 nch, uint32 band, const uint16 *val, uint32 elems )
+{
+    struct SRecDelta dlt;
+    uint32 nibble = 0;
+    uint32 i;
+
+    recdelta_start( &dlt, nch, band, 0, 0 );
+    for ( i=0; i<elems; i++ )
+        nibble = recdelta_put( &dlt, buff, nibble, val + i * nch );
+    return nibble;
+}
+
+// 12bit value pushed by core_op_recording_dbgfill() for element i, channel in T -> RH -> P order
+static uint32 internal_deadband_dbgfill_value( uint32 i, uint32 param )
+{
+    switch ( param )
+    {
+        case 0:  return i & 0xff;
+        case 1:  return 0x0c00 | (0xff - (i & 0xff));
+        default: return 0x0f | ((i << 1) & 0xff);
+    }
+}
+
+static void internal_deadband_codec( void )
+{
+    uint32  nch;
+    uint32  i, k;
+    uint32  nval;
+    uint32  nibbles = 0;
+    uint32  dummy = 0;
+    double  t_penc, t_enc, t_pdec, t_dec;
+    clock_t start;
+
+    printf( "  codec: %u elements of the drift signal, deadband 2, encode = recdelta_put / recpack_put, decode = recdelta_decode / recpack_decode\n", BDB_ELEMS );
+    printf( "  ch   bytes/block deadband / packed   encode deadband / packed [ns/value]   decode deadband / packed [ns/value]\n" );
+    for ( nch = 1; nch <= 3; nch++ )
+    {
+        nval = BDB_ELEMS * nch;
+        internal_deadband_signal( bdb_val, nch, BDB_ELEMS, &bdb_signals[1] );
+
+        start = clock();
+        for ( k=0; k<BDB_LOOPS; k++ )
+            for ( i=0; i<nval; i++ )
+                recpack_put( bdb_buf, 3 * i, bdb_val[i] );
+        t_penc = internal_elapsed_ns( start, BDB_LOOPS * nval );
+
+        start = clock();
+        for ( k=0; k<BDB_LOOPS; k++ )
+            nibbles = internal_deadband_encode( bdb_buf, nch, 2, bdb_val, BDB_ELEMS );
+        t_enc = internal_elapsed_ns( start, BDB_LOOPS * nval );
+
+        start = clock();
+        for ( k=0; k<BDB_LOOPS; k++ )
+        {
+            recpack_decode( bdb_buf, k & 1, bdb_dec, nval );
+            dummy += bdb_dec[k];
+        }
+        t_pdec = internal_elapsed_ns( start, BDB_LOOPS * nval );
+
+        // the buffer holds the packed elements now
+        internal_deadband_encode( bdb_buf, nch, 2, bdb_val, BDB_ELEMS );
+        start = clock();
+        for ( k=0; k<BDB_LOOPS; k++ )
+        {
+            struct SRecDelta dlt;
+            recdelta_start( &dlt, nch, 2, 0, 0 );
+            recdelta_decode( &dlt, bdb_buf, 0, bdb_dec, BDB_ELEMS );
+            dummy += bdb_dec[k];
+        }
+        t_dec = internal_elapsed_ns( start, BDB_LOOPS * nval );
+
+        printf( "  %u    %6.2f / %2u                     %6.2f / %6.2f                         %6.2f / %6.2f\n",
+                nch, (double)nibbles / 2 / (BDB_ELEMS / RECDELTA_BLOCK), 3 * RECDELTA_BLOCK * nch / 2, t_enc, t_penc, t_dec, t_pdec );
+    }
+    bench_sink = dummy;
+}
+
+static void internal_deadband_error( void )
+{
+    static const char *names[8] = { "", "T", "H", "TH", "P", "TP", "HP", "THP" };
+    static const uint32 layouts[] = { rtt_t, rtt_thp };
+    uint32 l, b, s;
+
+    printf( "  error and capacity: random walk signals, %u page task, days at %u min sample rate\n",
+            BDB_PAGES, core_utils_timeunit2seconds( BDB_RATE ) / 60 );
+    printf( "  layout  band  signal   bytes/block   max err   rms err   elements   days    packed   max err <= band\n" );
+    for ( l=0; l<sizeof(layouts)/sizeof(layouts[0]); l++ )
+    {
+        uint32 task_elems = layouts[l];
+        uint32 nch = RECPACK_CHANNELS( task_elems );
+        uint32 packed = core_op_recording_get_total_samplenr( BDB_PAGES * CORE_RECMEM_PAGESIZE, task_elems, 0 );
+
+        for ( b=0; b<sizeof(bdb_bands)/sizeof(bdb_bands[0]); b++ )
+        {
+            uint32 band = bdb_bands[b];
+            uint32 flat = core_op_recording_get_total_samplenr( BDB_PAGES * CORE_RECMEM_PAGESIZE, task_elems, band );
+
+            for ( s=0; s<sizeof(bdb_signals)/sizeof(bdb_signals[0]); s++ )
+            {
+                struct SRecDelta dlt;
+                uint32 nval = BDB_ELEMS * nch;
+                uint32 maxerr = 0;
+                uint32 elems;
+                uint32 i;
+                int32  err;
+                double sqsum = 0;
+                double blk;
+
+                internal_deadband_signal( bdb_val, nch, BDB_ELEMS, &bdb_signals[s] );
+                blk = (double)internal_deadband_encode( bdb_buf, nch, band, bdb_val, BDB_ELEMS ) / 2 / (BDB_ELEMS / RECDELTA_BLOCK);
+                recdelta_start( &dlt, nch, band, 0, 0 );
+                recdelta_decode( &dlt, bdb_buf, 0, bdb_dec, BDB_ELEMS );
+                for ( i=0; i<nval; i++ )
+                {
+                    err = (int32)(bdb_dec[i] >> 4) - (int32)bdb_val[i];
+                    if ( err < 0 )
+                        err = -err;
+                    if ( (uint32)err > maxerr )
+                        maxerr = err;
+                    sqsum += (double)err * err;
+                }
+
+                // the data ring holds this many blocks of the signal, the directory and the counters limit it to the flat case
+                elems = (uint32)( bdb_ring[task_elems] / (blk + 2) ) * RECDELTA_BLOCK;
+                if ( elems > flat )
+                    elems = flat;
+                printf( "  %-6s  %2u    %-6s   %6.2f        %4u      %6.2f    %5u    %6.1f  %5u    %s\n",
+                        names[task_elems], band, bdb_signals[s].name, blk, maxerr, sqrt( sqsum / nval ), elems,
+                        (double)elems * core_utils_timeunit2seconds( BDB_RATE ) / (24 * 3600), packed,
+                        (maxerr <= band) ? "OK" : "FAILED" );
+            }
+        }
+    }
+}
+
+static uint32 internal_deadband_check( uint32 task_elems, uint32 band )
+{
+    // readout copy views against the dbgfill values coded as core.c does it - the blocks start at the same
+    // elements in the task, the decoded values do not depend on where the blocks are in the memory
+    struct SRecDelta dlt;
+    struct SEventStruct ev;
+    uint32 nch = RECPACK_CHANNELS( task_elems );
+    uint32 smpl_total;
+    uint32 errors = 0;
+    uint32 nibble = 0;
+    uint32 v, i, k, ch;
+    uint32 depth, length, first;
+    uint16 val[3];
+
+    smpl_total = 3 + core_op_recording_get_total_samplenr( BDB_PAGES * CORE_RECMEM_PAGESIZE, task_elems, band );
+    if ( smpl_total > BDB_FILL )
+        return 1;
+
+    recdelta_start( &dlt, nch, band, 0, 0 );
+    for ( i=0; i<smpl_total; i++ )
+    {
+        for ( k=0, ch=0; k<3; k++ )
+        {
+            if ( task_elems & (1 << k) )
+                val[ch++] = (uint16)internal_deadband_dbgfill_value( i, k );
+        }
+        if ( band )
+        {
+            if ( (i & (RECDELTA_BLOCK - 1)) == 0 )
+                nibble = 0;
+            nibble = recdelta_put( &dlt, bdb_buf, nibble, val );    // a block at a time in the buffer
+            for ( ch=0; ch<nch; ch++ )
+                bdb_ref[i * nch + ch] = (uint16)(dlt.val[ch] << 4);
+        }
+        else
+        {
+            for ( ch=0; ch<nch; ch++ )
+                bdb_ref[i * nch + ch] = (uint16)(val[ch] << 4);
+        }
+    }
+
+    memset( &ev, 0, sizeof(ev) );
+    for ( v=0; v<=sizeof(bdb_views)/sizeof(bdb_views[0]); v++ )
+    {
+        if ( v < sizeof(bdb_views)/sizeof(bdb_views[0]) )
+        {
+            depth  = bdb_views[v][0];
+            length = bdb_views[v][1];
+        }
+        else
+        {
+            depth  = core.nvrec.func[0].c;                          // the oldest elements kept
+            length = BDB_OLDEST;
+        }
+        first = smpl_total - depth;
+
+        if ( core_op_recording_read_request( 0, depth, length ) )
+            return 1;
+        while ( core_op_recording_read_busy() )
+            core_poll( &ev );
+        bdb_ring[task_elems] = band ? core.readout.ring_size : 0;
+
+        for ( i=0; i<length; i++ )
+        {
+            for ( k=0, ch=0; k<3; k++ )
+            {
+                if ( (task_elems & (1 << k)) == 0 )
+                    continue;
+                if ( core_op_recording_get_buf_value( i, (enum ESensorSelect)(ss_thermo + k), 0 ) != bdb_ref[(first + i) * nch + ch] )
+                    errors++;
+                ch++;
+            }
+        }
+        core_op_recording_read_cancel();
+    }
+    return errors;
+}
+
+static void bench_deadband( void )
+{
+    static const char *names[8] = { "", "T", "H", "TH", "P", "TP", "HP", "THP" };
+    struct SRecTaskInstance task;
+    uint32  task_elems;
+    uint32  total;
+    uint32  b;
+    uint32  writes;
+    uint64  bytes;
+    uint32  errors = 0;
+    uint32  band;
+
+    printf( "deadband: deadband coded elements, max. error of the band, blocks of %u elements\n", RECDELTA_BLOCK );
+    internal_deadband_codec();
+
+    internal_readout_core_start();
+
+    printf( "  storage: %u page task, dbgfill data, elements pushed / kept, FRAM writes of the dbgfill per 1000 elements\n", BDB_PAGES );
+    printf( "  layout  band   pushed   kept     writes   bytes     copy views\n" );
+    for ( task_elems = rtt_t; task_elems <= rtt_thp; task_elems++ )
+    {
+        for ( b=0; b<=sizeof(bdb_bands)/sizeof(bdb_bands[0]); b++ )
+        {
+            uint32 err;
+
+            band = b ? bdb_bands[b - 1] : 0;
+            task.mempage = 0;
+            task.size = BDB_PAGES;
+            task.task_elems = task_elems;
+            task.sample_rate = ut_5sec;
+            task.deadband = band;
+            core_op_recording_setup_task( 0, &task );
+            total = 3 + core_op_recording_get_total_samplenr( BDB_PAGES * CORE_RECMEM_PAGESIZE, task_elems, band );
+
+            writes = hl.st_ee_writes;
+            bytes = hl.st_ee_bytes_wr;
+            core_op_recording_dbgfill( 0 );
+            writes = hl.st_ee_writes - writes;
+            bytes = hl.st_ee_bytes_wr - bytes;
+
+            err = internal_deadband_check( task_elems, band );
+            errors += err;
+            printf( "  %-6s  %2u     %5u    %5u    %6.1f   %8.1f  %s\n", names[task_elems], band, total, core.nvrec.func[0].c,
+                    writes * 1000.0 / total, bytes * 1000.0 / total, err ? "FAILED" : "OK" );
+        }
+    }
+    printf( "  readout of the deadband coded elements: %s\n", errors ? "FAILED" : "OK" );
+
+    internal_deadband_error();
+}
+
+
+/////////////////////////////////////////////////////
+// graph - min/max column rendering of the graph view
+/////////////////////////////////////////////////////
+
+// graphic_lib.c internals - the pixel by pixel line drawing used for every line before the span routines
+void MakeLine( int32 X1, int32 Y1, int32 X2, int32 Y2, bool window );
+
+#define BGR_SETS            16          // random graphs
+#define BGR_MIN_TIME        (CLOCKS_PER_SEC / 20)
+
+static uint8 bgr_values[BGR_SETS][2*WB_DISPPOINT];     // mins then maxs - as grf_values holds them
+static uint8 bgr_screen[GDISP_WIDTH * GDISP_HEIGHT];
+
+// the former internal_graphdisp_render( true ): every column through the generic Graphic_Line()
+static void ref_graph_columns( const uint8 *values )
+{
+    int i;
+    for ( i=0; i<WB_DISPPOINT; i++ )
+    {
+        MakeLine( i, values[WB_DISPPOINT + i], i, values[i], false );      // graph is always inside the window
+        DispHAL_NeedUpdate( i, values[WB_DISPPOINT + i], i, values[i] );
+    }
+}
+
+static void internal_graph_lines( const uint8 *values )
+{
+    int i;
+    for ( i=0; i<WB_DISPPOINT; i++ )
+        Graphic_Line( i, values[WB_DISPPOINT + i], i, values[i] );
+}
+
+static void internal_graph_spans( const uint8 *values )
+{
+    Graphic_ColumnSpans( 0, WB_DISPPOINT, values + WB_DISPPOINT, values );
+}
+
+static void ref_graph_hlines( const uint8 *values )
+{
+    int i;
+    for ( i=0; i<WB_DISPPOINT; i+=8 )
+    {
+        MakeLine( 0, values[i], GDISP_WIDTH-1, values[i], false );
+        DispHAL_NeedUpdate( 0, values[i], GDISP_WIDTH-1, values[i] );
+    }
+}
+
+static void internal_graph_hlines( const uint8 *values )
+{
+    int i;
+    for ( i=0; i<WB_DISPPOINT; i+=8 )
+        Graphic_Line( 0, values[i], GDISP_WIDTH-1, values[i] );
+}
+
+// renders every graph set on clean screen, returns the number of pixels differing from the reference
+static uint32 internal_graph_check( void (*ref)(const uint8*), void (*func)(const uint8*) )
+{
+    uint32 set, x, y;
+    uint32 err = 0;
+
+    for ( set=0; set<BGR_SETS; set++ )
+    {
+        Graphics_ClearScreen( 0 );
+        ref( bgr_values[set] );
+        for ( y=0; y<GDISP_HEIGHT; y++ )
+            for ( x=0; x<GDISP_WIDTH; x++ )
+                bgr_screen[ y * GDISP_WIDTH + x ] = (uint8)Graphic_GetPixel( x, y );
+
+        Graphics_ClearScreen( 0 );
+        func( bgr_values[set] );
+        for ( y=0; y<GDISP_HEIGHT; y++ )
+            for ( x=0; x<GDISP_WIDTH; x++ )
+                if ( bgr_screen[ y * GDISP_WIDTH + x ] != (uint8)Graphic_GetPixel( x, y ) )
+                    err++;
+    }
+    return err;
+}
+
+static double internal_graph_time( void (*func)(const uint8*) )
+{
+    uint32  reps = 0;
+    clock_t start = clock();
+
+    do
+    {
+        func( bgr_values[reps % BGR_SETS] );
+        reps++;
+    } while ( (clock() - start) < BGR_MIN_TIME );
+    return internal_elapsed_ns( start, reps ) / 1000.0;
+}
+
+static void bench_graph( void )
+{
+    static const int colors[] = { 1, -1 };
+    uint32 set, i, c;
+    int avg, lo, hi;
+    uint32 errors = 0;
+    uint32 err;
+    double t_ref, t;
+
+    // graph area of the view: 110 columns, 48 pixels high from line 16, min/max around a random walk
+    for ( set=0; set<BGR_SETS; set++ )
+    {
+        avg = 40;
+        for ( i=0; i<WB_DISPPOINT; i++ )
+        {
+            avg += (int)(internal_rand() % 9) - 4;
+            if ( avg < 16 )
+                avg = 16;
+            if ( avg > 63 )
+                avg = 63;
+            lo = avg + (int)(internal_rand() % (2 + set));
+            hi = avg - (int)(internal_rand() % (2 + set));
+            bgr_values[set][i]                  = (uint8)( lo > 63 ? 63 : lo );
+            bgr_values[set][WB_DISPPOINT + i]   = (uint8)( hi < 16 ? 16 : hi );
+        }
+    }
+
+    Graphics_Init( NULL, NULL );
+
+    printf( "graph: %u columns min/max graph, %u random sets\n", WB_DISPPOINT, BGR_SETS );
+    printf( "  color  drawing               reference [us]   new [us]   speedup   pixel errors\n" );
+    for ( c=0; c<sizeof(colors)/sizeof(colors[0]); c++ )
+    {
+        Graphic_SetColor( colors[c] );
+
+        t_ref = internal_graph_time( ref_graph_columns );
+
+        err = internal_graph_check( ref_graph_columns, internal_graph_lines );
+        t = internal_graph_time( internal_graph_lines );
+        printf( "  %2d     columns Graphic_Line  %8.2f        %8.2f   %6.1fx    %u\n", colors[c], t_ref, t, t_ref / t, err );
+        errors += err;
+
+        err = internal_graph_check( ref_graph_columns, internal_graph_spans );
+        t = internal_graph_time( internal_graph_spans );
+        printf( "  %2d     columns spans         %8.2f        %8.2f   %6.1fx    %u\n", colors[c], t_ref, t, t_ref / t, err );
+        errors += err;
+
+        t_ref = internal_graph_time( ref_graph_hlines );
+        err = internal_graph_check( ref_graph_hlines, internal_graph_hlines );
+        t = internal_graph_time( internal_graph_hlines );
+        printf( "  %2d     14 horizontal lines   %8.2f        %8.2f   %6.1fx    %u\n", colors[c], t_ref, t, t_ref / t, err );
+        errors += err;
+    }
+    printf( "  rendering: %s\n", errors ? "FAILED" : "OK" );
+}
+
+
+/////////////////////////////////////////////////////
+// text - glyph rendering
+/////////////////////////////////////////////////////
+
+// graphic_lib.c internals
+void SetSinglePixelInMemory( uint32 X_poz, uint32 Y_poz, int32 color );
+
+// fonts from ui_graphics.c
+extern const uint8 font_large_num[];
+extern const uint8 font_small[];
+extern const uint8 font_small_bold[];
+extern const uint8 font_micro[];
+
+#define BTX_LINES           9           // text positions on screen - last ones are clipped at the bottom
+
+// the former glyph drawing of Gtext_PutChar(): every set bit of the font data with SetSinglePixelInMemory(),
+// window is the full screen. Returns the next character position
+static uint32 ref_glyph_draw( const uint8 *font, uint32 xpoz, uint32 ypoz, uint8 chr )
+{
+    const uint8 *fchar;
+    uint32 c_size = font[0] & 0x1f;
+    uint32 offs = 3;
+    uint32 width;
+    uint32 height = font[1];
+    uint32 x, y;
+    uint32 datacnt = 0;
+    uint8  data;
+
+    if ( c_size == 0 )
+    {
+        c_size = font[3];
+        offs = 4;
+    }
+    if ( font[0] & 0x20 )
+        width = font[2];
+    else
+        width = font[offs];                 // space has the width of the first character
+    if ( chr == ' ' )
+        return xpoz + width + 1;
+
+    fchar = font + ( chr - '!' ) * c_size + offs;
+    if ( (font[0] & 0x20) == 0 )
+        width = *fchar++;
+
+    data = *fchar++;
+    for ( y = 0; y<height; y++, ypoz++ )
+    {
+        for ( x = 0; x<width; x++ )
+        {
+            if ( (data & 0x01) && ((xpoz + x) < GDISP_WIDTH) && (ypoz < GDISP_HEIGHT) )
+                SetSinglePixelInMemory( xpoz + x, ypoz, 1 );
+            data = data >> 1;
+            if ( ++datacnt == 8 )
+            {
+                data    = *fchar++;
+                datacnt = 0;
+            }
+        }
+    }
+    return xpoz + width + 1;
+}
+
+static void ref_text_draw( const uint8 *font, const char *text, uint32 ypoz )
+{
+    uint32 xpoz = 0;
+    while ( *text && (xpoz < GDISP_WIDTH) )
+        xpoz = ref_glyph_draw( font, xpoz, ypoz, (uint8)*text++ );
+}
+
+static void internal_text_draw( const uint8 *font, const char *text, uint32 ypoz )
+{
+    Gtext_SetFontAndColors( font, false, 1, -1 );
+    Gtext_SetCoordinates( 0, ypoz );
+    Gtext_PutText( text );
+}
+
+static uint32 internal_text_ypoz( uint32 line )
+{
+    // odd line steps - glyphs are placed on different bit positions of the pages, the last lines are clipped
+    return ( line * (GDISP_HEIGHT - 2) ) / (BTX_LINES - 1);
+}
+
+static void bench_text( void )
+{
+    static const struct
+    {
+        const char  *name;
+        const uint8 *font;
+        const char  *text;
+    } fonts[] =
+    {
+        { "large_num",  font_large_num,     "-12.5:0/3" },
+        { "small",      font_small,         "Temp 23.5*C RH:45%" },
+        { "small_bold", font_small_bold,    "SETUP 2013-12-31" },
+        { "micro",      font_micro,         "MIN MAX 12:30 AVG" },
+    };
+    uint32 f, line, x, y;
+    uint32 reps;
+    uint32 chars;
+    uint32 err;
+    uint32 errors = 0;
+    double t_ref, t;
+    clock_t start;
+
+    Graphics_Init( NULL, NULL );
+
+    printf( "text: font rendering, %u text lines on screen\n", BTX_LINES );
+    printf( "  font        height  chars   reference [ns/char]   new [ns/char]   speedup   pixel errors\n" );
+    for ( f=0; f<sizeof(fonts)/sizeof(fonts[0]); f++ )
+    {
+        // accuracy - full screen window
+        err = 0;
+        for ( line=0; line<BTX_LINES; line++ )
+        {
+            Graphics_ClearScreen( 0 );
+            ref_text_draw( fonts[f].font, fonts[f].text, internal_text_ypoz( line ) );
+            for ( y=0; y<GDISP_HEIGHT; y++ )
+                for ( x=0; x<GDISP_WIDTH; x++ )
+                    bgr_screen[ y * GDISP_WIDTH + x ] = (uint8)Graphic_GetPixel( x, y );
+
+            Graphics_ClearScreen( 0 );
+            internal_text_draw( fonts[f].font, fonts[f].text, internal_text_ypoz( line ) );
+            for ( y=0; y<GDISP_HEIGHT; y++ )
+                for ( x=0; x<GDISP_WIDTH; x++ )
+                    if ( bgr_screen[ y * GDISP_WIDTH + x ] != (uint8)Graphic_GetPixel( x, y ) )
+                        err++;
+        }
+
+        chars = strlen( fonts[f].text ) * BTX_LINES;
+
+        reps = 0;
+        start = clock();
+        do
+        {
+            for ( line=0; line<BTX_LINES; line++ )
+                ref_text_draw( fonts[f].font, fonts[f].text, internal_text_ypoz( line ) );
+            reps++;
+        } while ( (clock() - start) < BGR_MIN_TIME );
+        t_ref = internal_elapsed_ns( start, reps * chars );
+
+        reps = 0;
+        start = clock();
+        do
+        {
+            for ( line=0; line<BTX_LINES; line++ )
+                internal_text_draw( fonts[f].font, fonts[f].text, internal_text_ypoz( line ) );
+            reps++;
+        } while ( (clock() - start) < BGR_MIN_TIME );
+        t = internal_elapsed_ns( start, reps * chars );
+
+        printf( "  %-10s  %3u     %3u     %8.1f              %8.1f        %5.1fx    %u\n",
+                fonts[f].name, fonts[f].font[1], chars, t_ref, t, t_ref / t, err );
+        errors += err;
+    }
+    printf( "  rendering: %s\n", errors ? "FAILED" : "OK" );
+}
+
+
+/////////////////////////////////////////////////////
+// aggregate - display column aggregation of the graph readout
+/////////////////////////////////////////////////////
+
+// graph memory layout of core.c ( WB_OFFS_xxx relative to WB_OFFS_RAWDISP )
+#define BAG_OFFS_TEMP       0
+#define BAG_OFFS_TEMP_AVG   (BAG_OFFS_TEMP + WB_DISPPOINT*4)
+#define BAG_OFFS_RH         (BAG_OFFS_TEMP + WB_DISPPOINT*6)
+#define BAG_OFFS_RH_AVG     (BAG_OFFS_RH + WB_DISPPOINT*4)
+#define BAG_OFFS_P          (BAG_OFFS_RH + WB_DISPPOINT*6)
+#define BAG_OFFS_P_AVG      (BAG_OFFS_P + WB_DISPPOINT*4)
+#define BAG_GRAPH           (WB_DISPPOINT*9)                    // uint16 values
+#define BAG_FLIPB           0x200                               // WB_FLIPB_SIZE of core.c
+#define BAG_SAMPLES         65535                               // elements of the largest task
+#define BAG_STREAM          ((BAG_SAMPLES * 9 * 3) / 2 + 8)     // for the summary entries of rtt_thp
+#define BAG_FILL            0x5a5a
+
+// readout state as the scalar kernels used it
+static struct
+{
+    uint8   taks_elem;
+    uint8   level;
+    uint16  total_read;
+    uint16  v1ctr;
+    uint16  v2ctr;
+    uint16  v3ctr;
+    uint16  v1max;
+    uint16  v2max;
+    uint16  v3max;
+    uint16  v1min;
+    uint16  v2min;
+    uint16  v3min;
+    uint16  v1max_total;
+    uint16  v2max_total;
+    uint16  v3max_total;
+    uint16  v1min_total;
+    uint16  v2min_total;
+    uint16  v3min_total;
+    uint32  v1sum;
+    uint32  v2sum;
+    uint32  v3sum;
+    uint32  dispctr;
+    uint16  dispstep;
+    uint16  dispprev;
+    uint16  raw_ptr;
+} bag_ref;
+
+static struct SRecAgg bag_agg;
+static uint16 bag_refgraph[BAG_GRAPH];
+static uint8 * const bag_refwb = (uint8*)bag_refgraph;
+static uint16 bag_graph[BAG_GRAPH];
+static uint8  bag_stream[BAG_STREAM];
+
+// the per element type scalar kernels of core.c before recagg.c
+static void ref_recagg_simple( uint8 *wbuff, uint32 smp_proc, uint32 shifted )
+{
+    // Do not try to optimize this - it should work as quick as possible
+    uint16 dec[RECPACK_CHUNK];                  // decoded values of a chunk - elements are kept interleaved
+    uint16 *pdec;
+    uint32 nibble = shifted;                    // position in wbuff - the packed stream is decoded by chunks
+    uint32 smp_left = smp_proc;
+    uint32 cnt;
+    uint32 disp_ptr;
+
+    disp_ptr = bag_ref.raw_ptr << 1;
+
+    switch ( bag_ref.taks_elem )
+    {
+        case rtt_t:
+        case rtt_p:
+        case rtt_h:
+            {
+                uint16 *rawbuff;
+                uint32 val;
+
+                if ( bag_ref.taks_elem == rtt_t )
+                    rawbuff = (uint16*)(bag_refwb + BAG_OFFS_TEMP_AVG + disp_ptr);
+                else if ( bag_ref.taks_elem == rtt_h )
+                    rawbuff = (uint16*)(bag_refwb + BAG_OFFS_RH_AVG + disp_ptr);
+                else
+                    rawbuff = (uint16*)(bag_refwb + BAG_OFFS_P_AVG + disp_ptr);
+
+                while ( smp_left )
+                {
+                    // get the 16bit values
+                    cnt = (smp_left > RECPACK_CHUNK) ? RECPACK_CHUNK : smp_left;
+                    nibble = recpack_decode( wbuff, nibble, dec, cnt );
+                    smp_left -= cnt;
+                    pdec = dec;
+
+                    while ( cnt-- )
+                    {
+                        val = *pdec++;
+                        // save
+                        *rawbuff = val;
+
+                        // save the global min/max values
+                        if ( bag_ref.v1max_total < val )
+                            bag_ref.v1max_total = val;
+                        if ( bag_ref.v1min_total > val )
+                            bag_ref.v1min_total = val;
+
+                        rawbuff++;
+                    }
+                }
+            }
+            break;
+        case rtt_th:
+        case rtt_tp:
+        case rtt_hp:
+            {
+                uint16 *rawbuff1;
+                uint16 *rawbuff2;
+                uint32 val1;
+                uint32 val2;
+
+                if ( bag_ref.taks_elem == rtt_th )
+                {
+                    rawbuff1 = (uint16*)(bag_refwb + BAG_OFFS_TEMP_AVG + disp_ptr);
+                    rawbuff2 = (uint16*)(bag_refwb + BAG_OFFS_RH_AVG + disp_ptr);
+                }
+                else if ( bag_ref.taks_elem == rtt_tp )
+                {
+                    rawbuff1 = (uint16*)(bag_refwb + BAG_OFFS_TEMP_AVG + disp_ptr);
+                    rawbuff2 = (uint16*)(bag_refwb + BAG_OFFS_P_AVG + disp_ptr);
+                }
+                else
+                {
+                    rawbuff1 = (uint16*)(bag_refwb + BAG_OFFS_RH_AVG + disp_ptr);
+                    rawbuff2 = (uint16*)(bag_refwb + BAG_OFFS_P_AVG + disp_ptr);
+                }
+
+                while ( smp_left )
+                {
+                    // get the 16bit values - no shift in this case
+                    cnt = (smp_left > (RECPACK_CHUNK / 2)) ? (RECPACK_CHUNK / 2) : smp_left;
+                    nibble = recpack_decode( wbuff, nibble, dec, cnt * 2 );
+                    smp_left -= cnt;
+                    pdec = dec;
+
+                    while ( cnt-- )
+                    {
+                        val1 = *pdec++;
+                        val2 = *pdec++;
+
+                        // save
+                        *rawbuff1 = val1;
+                        *rawbuff2 = val2;
+                        rawbuff1++;
+                        rawbuff2++;
+
+                        // save the global min/max values
+                        if ( bag_ref.v1max_total < val1 )
+                            bag_ref.v1max_total = val1;
+                        if ( bag_ref.v1min_total > val1 )
+                            bag_ref.v1min_total = val1;
+
+                        if ( bag_ref.v2max_total < val2 )
+                            bag_ref.v2max_total = val2;
+                        if ( bag_ref.v2min_total > val2 )
+                            bag_ref.v2min_total = val2;
+                    }
+                }
+            }
+            break;
+        default:
+            {
+                uint16 *rawbuff1 = (uint16*)(bag_refwb + BAG_OFFS_TEMP_AVG + disp_ptr);
+                uint16 *rawbuff2 = (uint16*)(bag_refwb + BAG_OFFS_RH_AVG + disp_ptr);
+                uint16 *rawbuff3 = (uint16*)(bag_refwb + BAG_OFFS_P_AVG + disp_ptr);
+                uint32 val1;
+                uint32 val2;
+                uint32 val3;
+                while ( smp_left )
+                {
+                    // get the 16bit values
+                    cnt = (smp_left > (RECPACK_CHUNK / 3)) ? (RECPACK_CHUNK / 3) : smp_left;
+                    nibble = recpack_decode( wbuff, nibble, dec, cnt * 3 );
+                    smp_left -= cnt;
+                    pdec = dec;
+
+                    while ( cnt-- )
+                    {
+                        val1 = *pdec++;
+                        val2 = *pdec++;
+                        val3 = *pdec++;
+
+                        // save
+                        *rawbuff1 = val1;
+                        *rawbuff2 = val2;
+                        *rawbuff3 = val3;
+                        rawbuff1++;
+                        rawbuff2++;
+                        rawbuff3++;
+
+                        // save the global min/max values
+                        if ( bag_ref.v1max_total < val1 )
+                            bag_ref.v1max_total = val1;
+                        if ( bag_ref.v1min_total > val1 )
+                            bag_ref.v1min_total = val1;
+
+                        if ( bag_ref.v2max_total < val2 )
+                            bag_ref.v2max_total = val2;
+                        if ( bag_ref.v2min_total > val2 )
+                            bag_ref.v2min_total = val2;
+
+                        if ( bag_ref.v3max_total < val3 )
+                            bag_ref.v3max_total = val3;
+                        if ( bag_ref.v3min_total > val3 )
+                            bag_ref.v3min_total = val3;
+                    }
+                }
+            }
+            break;
+    }
+    bag_ref.raw_ptr += smp_proc;
+}
+
+static void ref_recagg_minmaxavg( uint8 *wbuff, uint32 smp_proc, uint32 shifted, bool last )
+{
+    uint16 dec[RECPACK_CHUNK];                  // decoded values of a chunk - elements are kept interleaved
+    uint16 *pdec;
+    uint32 nibble = shifted;                    // position in wbuff - the packed stream is decoded by chunks
+    uint32 cnt;
+    uint32 disp_ptr;
+    uint32 k;                                   // values / channel: 1 - elements, 3 - summary entries ( min / max / avg )
+    uint32 oh;                                  // offset of the max. value in a channel
+    uint32 oa;                                  // offset of the average value in a channel
+
+    register uint32 dispctr  = bag_ref.dispctr;
+    register uint32 dispprev = bag_ref.dispprev;
+    register uint32 dispstep = bag_ref.dispstep;
+
+    disp_ptr = (dispctr >> 15) & (~0x01);       // use the disp counter's integer part, but x2
+
+    k  = bag_ref.level ? 3 : 1;            // for elements all the three point to the same value
+    oh = k >> 1;
+    oa = k - 1;
+
+    switch ( bag_ref.taks_elem )
+    {
+        case rtt_t:
+        case rtt_p:
+        case rtt_h:
+            {
+                uint16 *rawbuff;
+                register uint32 val;
+
+                if ( bag_ref.taks_elem == rtt_t )
+                    rawbuff = (uint16*)(bag_refwb + BAG_OFFS_TEMP + disp_ptr);
+                else if ( bag_ref.taks_elem == rtt_h )
+                    rawbuff = (uint16*)(bag_refwb + BAG_OFFS_RH + disp_ptr);
+                else
+                    rawbuff = (uint16*)(bag_refwb + BAG_OFFS_P + disp_ptr);
+
+                while ( smp_proc )
+                {
+                    // get the 16bit values
+                    cnt = (smp_proc > (RECPACK_CHUNK / k)) ? (RECPACK_CHUNK / k) : smp_proc;
+                    nibble = recpack_decode( wbuff, nibble, dec, cnt * k );
+                    pdec = dec;
+
+                    while ( cnt-- )
+                    {
+                        smp_proc--;
+
+                        // check min/max and sum for average
+                        if ( bag_ref.v1min > pdec[0] )
+                            bag_ref.v1min = pdec[0];
+                        if ( bag_ref.v1max < pdec[oh] )
+                            bag_ref.v1max = pdec[oh];
+                        bag_ref.v1ctr++;
+                        bag_ref.v1sum += pdec[oa];
+                        pdec += k;
+
+                        // see if should proceed with the next point
+                        dispctr += dispstep;
+                        if ( ((dispctr >> 16) != dispprev) ||
+                             (last && (smp_proc == 0) && (bag_ref.raw_ptr < WB_DISPPOINT)) )
+                        {
+                            dispprev = (dispctr >> 16);
+
+                            val = bag_ref.v1sum / bag_ref.v1ctr;
+                            *rawbuff        = bag_ref.v1min;
+                            *(rawbuff+WB_DISPPOINT)  = bag_ref.v1max;
+                            *(rawbuff+WB_DISPPOINT*2)  = val;
+
+                            // save the global min/max values
+                            if ( bag_ref.v1max_total < bag_ref.v1max )
+                                bag_ref.v1max_total = bag_ref.v1max;
+                            if ( bag_ref.v1min_total > bag_ref.v1min )
+                                bag_ref.v1min_total = bag_ref.v1min;
+
+                            bag_ref.v1min = 0xffff;
+                            bag_ref.v1max = 0;
+                            bag_ref.v1sum = 0;
+                            bag_ref.v1ctr = 0;
+
+                            rawbuff++;
+                            bag_ref.raw_ptr++;
+                        }
+                    }
+                }
+            }
+            break;
+        case rtt_th:
+        case rtt_tp:
+        case rtt_hp:
+            {
+                uint16 *rawbuff1;
+                uint16 *rawbuff2;
+                register uint32 val1;
+                register uint32 val2;
+
+                if ( bag_ref.taks_elem == rtt_th )
+                {
+                    rawbuff1 = (uint16*)(bag_refwb + BAG_OFFS_TEMP + disp_ptr);
+                    rawbuff2 = (uint16*)(bag_refwb + BAG_OFFS_RH + disp_ptr);
+                }
+                else if ( bag_ref.taks_elem == rtt_tp )
+                {
+                    rawbuff1 = (uint16*)(bag_refwb + BAG_OFFS_TEMP + disp_ptr);
+                    rawbuff2 = (uint16*)(bag_refwb + BAG_OFFS_P + disp_ptr);
+                }
+                else
+                {
+                    rawbuff1 = (uint16*)(bag_refwb + BAG_OFFS_RH + disp_ptr);
+                    rawbuff2 = (uint16*)(bag_refwb + BAG_OFFS_P + disp_ptr);
+                }
+
+                while ( smp_proc )
+                {
+                    // get the 16bit values - no shift in this case
+                    cnt = (smp_proc > (RECPACK_CHUNK / (2 * k))) ? (RECPACK_CHUNK / (2 * k)) : smp_proc;
+                    nibble = recpack_decode( wbuff, nibble, dec, cnt * 2 * k );
+                    pdec = dec;
+
+                    while ( cnt-- )
+                    {
+                        smp_proc--;
+
+                        // check min/max and sum for average
+                        if ( bag_ref.v1min > pdec[0] )
+                            bag_ref.v1min = pdec[0];
+                        if ( bag_ref.v1max < pdec[oh] )
+                            bag_ref.v1max = pdec[oh];
+                        bag_ref.v1ctr++;
+                        bag_ref.v1sum += pdec[oa];
+                        pdec += k;
+
+                        if ( bag_ref.v2min > pdec[0] )
+                            bag_ref.v2min = pdec[0];
+                        if ( bag_ref.v2max < pdec[oh] )
+                            bag_ref.v2max = pdec[oh];
+                        bag_ref.v2ctr++;
+                        bag_ref.v2sum += pdec[oa];
+                        pdec += k;
+
+                        // see if should proceed with the next point
+                        dispctr += dispstep;
+                        if ( ((dispctr >> 16) != dispprev) ||
+                             (last && (smp_proc == 0) && (bag_ref.raw_ptr < WB_DISPPOINT)) )
+                        {
+                            dispprev = (dispctr >> 16);
+
+                            val1 = bag_ref.v1sum / bag_ref.v1ctr;
+                            val2 = bag_ref.v2sum / bag_ref.v2ctr;
+                            *rawbuff1        = bag_ref.v1min;
+                            *(rawbuff1+WB_DISPPOINT)  = bag_ref.v1max;
+                            *(rawbuff1+WB_DISPPOINT*2)  = val1;
+
+                            *rawbuff2        = bag_ref.v2min;
+                            *(rawbuff2+WB_DISPPOINT)  = bag_ref.v2max;
+                            *(rawbuff2+WB_DISPPOINT*2)  = val2;
+
+                            // save the global min/max values
+                            if ( bag_ref.v1max_total < bag_ref.v1max )
+                                bag_ref.v1max_total = bag_ref.v1max;
+                            if ( bag_ref.v1min_total > bag_ref.v1min )
+                                bag_ref.v1min_total = bag_ref.v1min;
+
+                            if ( bag_ref.v2max_total < bag_ref.v2max )
+                                bag_ref.v2max_total = bag_ref.v2max;
+                            if ( bag_ref.v2min_total > bag_ref.v2min )
+                                bag_ref.v2min_total = bag_ref.v2min;
+
+                            bag_ref.v1min = 0xffff;
+                            bag_ref.v1max = 0;
+                            bag_ref.v1sum = 0;
+                            bag_ref.v1ctr = 0;
+                            bag_ref.v2min = 0xffff;
+                            bag_ref.v2max = 0;
+                            bag_ref.v2sum = 0;
+                            bag_ref.v2ctr = 0;
+
+                            rawbuff1++;
+                            rawbuff2++;
+                            bag_ref.raw_ptr++;
+                        }
+                    }
+                }
+            }
+            break;
+        case rtt_thp:
+            {
+                uint16 *rawbuff1;
+                uint16 *rawbuff2;
+                uint16 *rawbuff3;
+                register uint32 val1;
+                register uint32 val2;
+                register uint32 val3;
+
+                rawbuff1 = (uint16*)(bag_refwb + BAG_OFFS_TEMP + disp_ptr);
+                rawbuff2 = (uint16*)(bag_refwb + BAG_OFFS_RH + disp_ptr);
+                rawbuff3 = (uint16*)(bag_refwb + BAG_OFFS_P + disp_ptr);
+
+                while ( smp_proc )
+                {
+                    // get the 16bit values
+                    cnt = (smp_proc > (RECPACK_CHUNK / (3 * k))) ? (RECPACK_CHUNK / (3 * k)) : smp_proc;
+                    nibble = recpack_decode( wbuff, nibble, dec, cnt * 3 * k );
+                    pdec = dec;
+
+                    while ( cnt-- )
+                    {
+                        smp_proc--;
+
+                        // check min/max and sum for average
+                        if ( bag_ref.v1min > pdec[0] )
+                            bag_ref.v1min = pdec[0];
+                        if ( bag_ref.v1max < pdec[oh] )
+                            bag_ref.v1max = pdec[oh];
+                        bag_ref.v1ctr++;
+                        bag_ref.v1sum += pdec[oa];
+                        pdec += k;
+
+                        if ( bag_ref.v2min > pdec[0] )
+                            bag_ref.v2min = pdec[0];
+                        if ( bag_ref.v2max < pdec[oh] )
+                            bag_ref.v2max = pdec[oh];
+                        bag_ref.v2ctr++;
+                        bag_ref.v2sum += pdec[oa];
+                        pdec += k;
+
+                        if ( bag_ref.v3min > pdec[0] )
+                            bag_ref.v3min = pdec[0];
+                        if ( bag_ref.v3max < pdec[oh] )
+                            bag_ref.v3max = pdec[oh];
+                        bag_ref.v3ctr++;
+                        bag_ref.v3sum += pdec[oa];
+                        pdec += k;
+
+                        // see if should proceed with the next point
+                        dispctr += dispstep;
+                        if ( ((dispctr >> 16) != dispprev) ||
+                             (last && (smp_proc == 0) && (bag_ref.raw_ptr < WB_DISPPOINT)) )
+                        {
+                            dispprev = (dispctr >> 16);
+
+                            val1 = bag_ref.v1sum / bag_ref.v1ctr;
+                            val2 = bag_ref.v2sum / bag_ref.v2ctr;
+                            val3 = bag_ref.v3sum / bag_ref.v3ctr;
+                            *rawbuff1        = bag_ref.v1min;
+                            *(rawbuff1+WB_DISPPOINT)  = bag_ref.v1max;
+                            *(rawbuff1+WB_DISPPOINT*2)  = val1;
+
+                            *rawbuff2        = bag_ref.v2min;
+                            *(rawbuff2+WB_DISPPOINT)  = bag_ref.v2max;
+                            *(rawbuff2+WB_DISPPOINT*2)  = val2;
+
+                            *rawbuff3        = bag_ref.v3min;
+                            *(rawbuff3+WB_DISPPOINT)  = bag_ref.v3max;
+                            *(rawbuff3+WB_DISPPOINT*2)  = val3;
+
+                            // save the global min/max values
+                            if ( bag_ref.v1max_total < bag_ref.v1max )
+                                bag_ref.v1max_total = bag_ref.v1max;
+                            if ( bag_ref.v1min_total > bag_ref.v1min )
+                                bag_ref.v1min_total = bag_ref.v1min;
+
+                            if ( bag_ref.v2max_total < bag_ref.v2max )
+                                bag_ref.v2max_total = bag_ref.v2max;
+                            if ( bag_ref.v2min_total > bag_ref.v2min )
+                                bag_ref.v2min_total = bag_ref.v2min;
+
+                            if ( bag_ref.v3max_total < bag_ref.v3max )
+                                bag_ref.v3max_total = bag_ref.v3max;
+                            if ( bag_ref.v3min_total > bag_ref.v3min )
+                                bag_ref.v3min_total = bag_ref.v3min;
+
+                            bag_ref.v1min = 0xffff;
+                            bag_ref.v1max = 0;
+                            bag_ref.v1sum = 0;
+                            bag_ref.v1ctr = 0;
+                            bag_ref.v2min = 0xffff;
+                            bag_ref.v2max = 0;
+                            bag_ref.v2sum = 0;
+                            bag_ref.v2ctr = 0;
+                            bag_ref.v3min = 0xffff;
+                            bag_ref.v3max = 0;
+                            bag_ref.v3sum = 0;
+                            bag_ref.v3ctr = 0;
+
+                            rawbuff1++;
+                            rawbuff2++;
+                            rawbuff3++;
+                            bag_ref.raw_ptr++;
+                        }
+                    }
+                }
+            }
+            break;
+    }
+
+    bag_ref.dispctr  = dispctr;
+    bag_ref.dispprev = dispprev;
+    bag_ref.dispstep = dispstep;
+}
+
+
+static void internal_aggregate_start( uint32 task_elems, uint32 level, uint32 samples, bool ref )
+{
+    if ( ref == false )
+    {
+        recagg_start( &bag_agg, WB_DISPPOINT, samples );
+        return;
+    }
+
+    memset( &bag_ref, 0, sizeof(bag_ref) );
+    bag_ref.taks_elem = task_elems;
+    bag_ref.level = level;
+    bag_ref.total_read = samples;
+    bag_ref.v1min = 0xffff;
+    bag_ref.v2min = 0xffff;
+    bag_ref.v3min = 0xffff;
+    bag_ref.v1min_total = 0xffff;
+    bag_ref.v2min_total = 0xffff;
+    bag_ref.v3min_total = 0xffff;
+    if ( samples > WB_DISPPOINT )
+        bag_ref.dispstep = (WB_DISPPOINT << 16) / samples;
+}
+
+// feed the stream flip buffer by flip buffer as local_recording_readout() does
+static void internal_aggregate_run( uint32 task_elems, uint32 level, uint32 shift, uint32 samples, bool ref )
+{
+    uint32 elsizeX2 = RECPACK_ELSIZEX2( task_elems ) * (level ? 3 : 1);
+    uint32 chunk = ((BAG_FLIPB - 1) * 2) / elsizeX2;
+    uint32 nibble = shift;
+    uint32 cnt;
+    bool last;
+
+    internal_aggregate_start( task_elems, level, samples, ref );
+    while ( samples )
+    {
+        cnt = (samples > chunk) ? chunk : samples;
+        samples -= cnt;
+        last = (samples == 0);
+
+        if ( ref == false )
+            recagg_process( &bag_agg, bag_graph, task_elems, level, bag_stream + (nibble >> 1), nibble & 0x01, cnt, last );
+        else if ( bag_ref.total_read <= WB_DISPPOINT )
+            ref_recagg_simple( bag_stream + (nibble >> 1), cnt, nibble & 0x01 );
+        else
+            ref_recagg_minmaxavg( bag_stream + (nibble >> 1), cnt, nibble & 0x01, last );
+        nibble += cnt * elsizeX2;
+    }
+}
+
+static uint32 internal_aggregate_check( uint32 task_elems, uint32 level, uint32 shift, uint32 samples )
+{
+    const uint16 *rmin[3]  = { &bag_ref.v1min, &bag_ref.v2min, &bag_ref.v3min };
+    const uint16 *rmax[3]  = { &bag_ref.v1max, &bag_ref.v2max, &bag_ref.v3max };
+    const uint32 *rsum[3]  = { &bag_ref.v1sum, &bag_ref.v2sum, &bag_ref.v3sum };
+    const uint16 *rtmin[3] = { &bag_ref.v1min_total, &bag_ref.v2min_total, &bag_ref.v3min_total };
+    const uint16 *rtmax[3] = { &bag_ref.v1max_total, &bag_ref.v2max_total, &bag_ref.v3max_total };
+    uint32 errors = 0;
+    uint32 ch;
+    uint32 i;
+
+    for ( i=0; i<BAG_GRAPH; i++ )
+    {
+        bag_refgraph[i] = BAG_FILL;
+        bag_graph[i] = BAG_FILL;
+    }
+
+    internal_aggregate_run( task_elems, level, shift, samples, true );
+    internal_aggregate_run( task_elems, level, shift, samples, false );
+
+    if ( memcmp( bag_refgraph, bag_graph, sizeof(bag_graph) ) )
+        errors++;
+    for ( ch=0; ch<RECPACK_CHANNELS( task_elems ); ch++ )
+    {
+        if ( (*rmin[ch] != bag_agg.vmin[ch]) || (*rmax[ch] != bag_agg.vmax[ch]) || (*rsum[ch] != bag_agg.vsum[ch]) ||
+             (*rtmin[ch] != bag_agg.tmin[ch]) || (*rtmax[ch] != bag_agg.tmax[ch]) )
+            errors++;
+    }
+    if ( (bag_ref.dispctr != bag_agg.dispctr) || (bag_ref.dispprev != bag_agg.dispprev) ||
+         (bag_ref.raw_ptr != bag_agg.col) || (bag_ref.v1ctr != bag_agg.ctr) )
+        errors++;
+
+    if ( errors )
+        printf( "  MISMATCH: layout %u  level %u  shift %u  samples %u\n", task_elems, level, shift, samples );
+    return errors;
+}
+
+static double internal_aggregate_time( uint32 task_elems, uint32 level, uint32 samples, bool ref )
+{
+    uint32 reps = 0;
+    clock_t start;
+
+    start = clock();
+    do
+    {
+        internal_aggregate_run( task_elems, level, 0, samples, ref );
+        reps++;
+    } while ( (clock() - start) < BRO_MIN_TIME );
+    return internal_elapsed_ns( start, reps ) / 1000.0;
+}
+
+static void bench_aggregate( void )
+{
+    static const char *names[8] = { "", "T", "H", "TH", "P", "TP", "HP", "THP" };
+    static const uint32 counts[] = { 1, 37, 109, 110, 111, 257, 1000, 4000, 16000, BAG_SAMPLES };
+    uint16 val[RECPACK_CHUNK];
+    uint32 task_elems;
+    uint32 level;
+    uint32 shift;
+    uint32 samples;
+    uint32 errors = 0;
+    uint32 checks = 0;
+    uint32 i, j;
+    double t_ref;
+    double t_new;
+
+    // random 12bit stream - summary entries are not ordered, the kernels do not rely on min <= avg <= max
+    for ( i=0; i<(BAG_STREAM * 2 - 16) / 3; i += RECPACK_CHUNK )
+    {
+        for ( j=0; j<RECPACK_CHUNK; j++ )
+            val[j] = (uint16)internal_rand();
+        recpack_encode( bag_stream, i * 3, val, ((i + RECPACK_CHUNK) * 3 < BAG_STREAM * 2 - 16) ? RECPACK_CHUNK : 1 );
+    }
+
+    printf( "aggregate: display column aggregation, scalar per layout kernels vs. recagg templates, %u columns\n", WB_DISPPOINT );
+
+    for ( task_elems = rtt_t; task_elems <= rtt_thp; task_elems++ )
+    {
+        for ( level=0; level<2; level++ )
+        {
+            for ( i=0; i<sizeof(counts)/sizeof(counts[0]); i++ )
+            {
+                samples = counts[i];
+                if ( level && (samples <= WB_DISPPOINT) )
+                    continue;                                   // summary entries are read only if they exceed the display
+                for ( shift=0; shift<2; shift++ )
+                {
+                    errors += internal_aggregate_check( task_elems, level, shift, samples );
+                    checks++;
+                }
+            }
+        }
+    }
+    printf( "  bit exact: %u readouts, %s\n", checks, errors ? "FAILED" : "OK" );
+
+    printf( "  layout  level  samples    scalar [us]   recagg [us]   [Msample/s]   speedup\n" );
+    for ( task_elems = rtt_t; task_elems <= rtt_thp; task_elems++ )
+    {
+        for ( level=0; level<2; level++ )
+        {
+            samples = level ? 16000 : BAG_SAMPLES;
+            t_ref = internal_aggregate_time( task_elems, level, samples, true );
+            t_new = internal_aggregate_time( task_elems, level, samples, false );
+            printf( "  %-6s  %u      %5u      %9.1f     %9.1f      %8.2f     %5.2fx\n",
+                    names[task_elems], level, samples, t_ref, t_new, samples / t_new, t_ref / t_new );
+        }
+    }
+}
+
+
+/////////////////////////////////////////////////////
+// calendar - RTC counter to date conversions
+/////////////////////////////////////////////////////
+
+#define BCAL_RANDOM         2000000     // random counters over the whole range
+#define BCAL_SERIES         20000       // sample series of the batch conversion
+#define BCAL_LOOPS          20
+
+static const uint32 bcal_lutny[] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+static const uint32 bcal_lutly[] = { 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335 };
+
+// the conversions replaced by the calendar cache of utilities.c
+static void ref_convert_counter_2_ymd( uint32 counter, uint16 *pyear, uint8 *pmounth, uint8 *pday )
+{
+    uint32 year;
+    const uint32 *mounthLUT;
+    int i;
+    counter = (counter>>1) / (3600*24);
+
+    year = (counter * 100 + 99) / 36525;
+    counter -= ((year * 36525) / 100);
+
+    if ( (year+1) % 4 )
+        mounthLUT = bcal_lutny;
+    else
+        mounthLUT = bcal_lutly;
+
+    for (i=11; i>=0; i--)
+    {
+        if ( mounthLUT[i] <= counter )
+            break;
+    }
+
+    *pday = counter - mounthLUT[i] + 1;
+    *pmounth = i + 1;
+    *pyear = year + YEAR_START;
+}
+
+static uint32 ref_day_of_week( uint32 counter )
+{
+    return ( (counter >> 1) / (3600*24) + WEEK_START ) % 7;
+}
+
+static uint32 ref_week_of_year( uint32 counter )
+{
+    uint32 days_thisday = (counter >> 1) / (3600*24);
+    uint32 days_yearstart = ( ((days_thisday * 100 + 99) / 36525) * 36525 ) / 100;
+
+    return (days_thisday + WEEK_START) / 7 - (days_yearstart + WEEK_START) / 7;
+}
+
+static uint32 internal_calendar_check( uint32 counter )
+{
+    uint16 year, ryear;
+    uint8  mounth, rmounth;
+    uint8  day, rday;
+    uint32 errors = 0;
+
+    utils_convert_counter_2_ymd( counter, &year, &mounth, &day );
+    ref_convert_counter_2_ymd( counter, &ryear, &rmounth, &rday );
+    if ( (year != ryear) || (mounth != rmounth) || (day != rday) )
+        errors++;
+    if ( utils_day_of_week( counter ) != ref_day_of_week( counter ) )
+        errors++;
+    if ( utils_week_of_year( counter ) != ref_week_of_year( counter ) )
+        errors++;
+    return errors;
+}
+
+static void bench_calendar( void )
+{
+    static uint32 smpl[WB_DISPPOINT];
+    static datestruct dt[WB_DISPPOINT];
+    static timestruct tm[WB_DISPPOINT];
+    uint32  counter;
+    uint32  days;
+    uint32  calls;
+    uint32  i, k;
+    uint32  errors = 0;
+    uint32  berrors = 0;
+    uint32  dummy = 0;
+    uint16  year;
+    uint8   mounth, day;
+    double  t_ref_seq, t_seq, t_ref_rnd, t_rnd, t_ref_batch, t_batch;
+    clock_t start;
+
+    // every day of the counter range forward and backward, a random time of the day, then random counters
+    days = 0xffffffffu / DAY_TICKS + 1;
+    for ( i=0; i<days; i++ )
+    {
+        counter = i * DAY_TICKS + internal_rand() % DAY_TICKS;
+        if ( counter < i * DAY_TICKS )
+            counter = 0xffffffffu;                                  // last day of the range
+        errors += internal_calendar_check( counter );
+        errors += internal_calendar_check( counter - (counter % DAY_TICKS) );        // midnight
+    }
+    for ( i=days; i>0; i-- )
+    {
+        counter = (i - 1) * DAY_TICKS;
+        if ( counter <= 0xffffffffu - (DAY_TICKS - 1) )
+            counter += DAY_TICKS - 1;                               // last half second of the day
+        else
+            counter = 0xffffffffu;
+        errors += internal_calendar_check( counter );
+    }
+    for ( i=0; i<BCAL_RANDOM; i++ )
+        errors += internal_calendar_check( (internal_rand() << 8) ^ internal_rand() );
+
+    // batch conversion of graph sample series against the single conversions
+    for ( k=0; k<BCAL_SERIES; k++ )
+    {
+        uint32 last = (internal_rand() << 8) ^ internal_rand();
+        uint32 step = 2 * core_utils_timeunit2seconds( internal_rand() % (ut_60min + 1) ) << (internal_rand() % 8);
+
+        for ( i=0; i<WB_DISPPOINT; i++ )
+            smpl[i] = (k & 1) ? (WB_DISPPOINT - 1 - i) * (k % 97 + 1) : i * (k % 97 + 1);
+        utils_convert_samples_2_datetime( last, step, smpl, WB_DISPPOINT, dt, tm );
+        for ( i=0; i<WB_DISPPOINT; i++ )
+        {
+            uint8 hour, minute, second;
+            counter = ( smpl[i] * step > last ) ? 0 : last - smpl[i] * step;
+            ref_convert_counter_2_ymd( counter, &year, &mounth, &day );
+            utils_convert_counter_2_hms( counter, &hour, &minute, &second );
+            if ( (dt[i].year != year) || (dt[i].mounth != mounth) || (dt[i].day != day) ||
+                 (tm[i].hour != hour) || (tm[i].minute != minute) || (tm[i].second != second) )
+                berrors++;
+        }
+    }
+
+    // speed - clock display updated every minute, random counters, a graph series of 5 min samples
+    calls = BCAL_LOOPS * days;
+    start = clock();
+    for ( i=0; i<calls; i++ )
+    {
+        counter = i * 120;
+        ref_convert_counter_2_ymd( counter, &year, &mounth, &day );
+        dummy += day + ref_day_of_week( counter ) + ref_week_of_year( counter );
+    }
+    t_ref_seq = internal_elapsed_ns( start, calls );
+    start = clock();
+    for ( i=0; i<calls; i++ )
+    {
+        counter = i * 120;
+        utils_convert_counter_2_ymd( counter, &year, &mounth, &day );
+        dummy += day + utils_day_of_week( counter ) + utils_week_of_year( counter );
+    }
+    t_seq = internal_elapsed_ns( start, calls );
+
+    start = clock();
+    for ( i=0; i<calls; i++ )
+    {
+        counter = (internal_rand() << 8) ^ internal_rand();
+        ref_convert_counter_2_ymd( counter, &year, &mounth, &day );
+        dummy += day + ref_day_of_week( counter ) + ref_week_of_year( counter );
+    }
+    t_ref_rnd = internal_elapsed_ns( start, calls );
+    start = clock();
+    for ( i=0; i<calls; i++ )
+    {
+        counter = (internal_rand() << 8) ^ internal_rand();
+        utils_convert_counter_2_ymd( counter, &year, &mounth, &day );
+        dummy += day + utils_day_of_week( counter ) + utils_week_of_year( counter );
+    }
+    t_rnd = internal_elapsed_ns( start, calls );
+
+    for ( i=0; i<WB_DISPPOINT; i++ )
+        smpl[i] = i;
+    calls = BCAL_LOOPS * days / WB_DISPPOINT;
+    start = clock();
+    for ( k=0; k<calls; k++ )
+        for ( i=0; i<WB_DISPPOINT; i++ )
+        {
+            counter = 0x40000000 + k * 0x1000 - smpl[i] * 600;     // 5 min samples
+            ref_convert_counter_2_ymd( counter, &dt[i].year, &dt[i].mounth, &dt[i].day );
+            utils_convert_counter_2_hms( counter, &tm[i].hour, &tm[i].minute, &tm[i].second );
+        }
+    t_ref_batch = internal_elapsed_ns( start, calls * WB_DISPPOINT );
+    dummy += dt[k & 0x3f].day;
+    start = clock();
+    for ( k=0; k<calls; k++ )
+        utils_convert_samples_2_datetime( 0x40000000 + k * 0x1000, 600, smpl, WB_DISPPOINT, dt, tm );
+    t_batch = internal_elapsed_ns( start, calls * WB_DISPPOINT );
+    dummy += dt[k & 0x3f].day;
+
+    printf( "calendar: %u days of the RTC counter range ( %u -> %u ) forward and backward, %u random counters\n",
+            days, YEAR_START, YEAR_END, BCAL_RANDOM );
+    printf( "  ymd / day of week / week of year:  %s ( %u errors )\n", errors ? "FAILED" : "OK", errors );
+    printf( "  batch sample series:               %s ( %u errors in %u series )\n", berrors ? "FAILED" : "OK", berrors, BCAL_SERIES );
+    printf( "                       ref [ns]   cached [ns]\n" );
+    printf( "  clock every minute   %6.1f     %6.1f\n", t_ref_seq, t_seq );
+    printf( "  random               %6.1f     %6.1f\n", t_ref_rnd, t_rnd );
+    printf( "  graph series / smpl  %6.1f     %6.1f\n", t_ref_batch, t_batch );
+    bench_sink = dummy;
+}
+
+
+/////////////////////////////////////////////////////
+// nvsave - differential save of the nonvolatile structures at power down
+/////////////////////////////////////////////////////
+
+#define BNV_COMMITS         20000       // power downs with a few changed fields
+#define BNV_CUT_EVERY       5           // every Nth power down loses the supply in the middle of the save
+#define BNV_FULL_BYTES      ( sizeof(struct SCoreSetup) + sizeof(struct SCoreOperation) + sizeof(struct SCoreNonVolatileRec) + 3 * 2 )
+
+static struct SCoreSetup            bnv_setup;
+static struct SCoreOperation        bnv_op;
+static struct SCoreNonVolatileRec   bnv_rec[2];     // committed / the one before
+
+static void internal_nvsave_change( bool op )
+{
+    // a power down changes a few fields: the task counters and the staging buffer, some operation parameters
+    // setup and operation are written in place - only the record commit is power loss safe ( op = false )
+    uint32 i;
+    uint32 n = 1 + internal_rand() % 4;
+
+    for ( i=0; i<n; i++ )
+    {
+        uint32 pos = offsetof( struct SCoreNonVolatileRec, func ) + internal_rand() % sizeof(core.nvrec.func);
+        ((uint8*)&core.nvrec)[pos] = (uint8)internal_rand();
+    }
+    if ( op && ((internal_rand() & 0x07) == 0) )
+    {
+        uint32 pos = offsetof( struct SCoreOperation, sens_rd ) + internal_rand() % (sizeof(core.nv.op) - offsetof( struct SCoreOperation, sens_rd ));
+        ((uint8*)&core.nv.op)[pos] = (uint8)internal_rand();
+    }
+    core.nvrec.dirty = true;
+}
+
+static uint32 internal_nvsave_wake( uint32 *pfallback )
+{
+    // RAM content is lost at power down - load back and compare with the last or the previous commit
+    memset( &core.nv.setup, 0x5a, sizeof(core.nv.setup) );
+    memset( &core.nv.op, 0x5a, sizeof(core.nv.op) );
+    memset( &core.nvrec, 0x5a, sizeof(core.nvrec) );
+    core.nv.op.op_flags.b.op_recording = 0;
+
+    if ( core_setup_load( false ) )
+        return 1;
+    if ( memcmp( &core.nv.setup, &bnv_setup, sizeof(bnv_setup) ) || memcmp( &core.nv.op, &bnv_op, sizeof(bnv_op) ) )
+        return 1;
+    if ( memcmp( &core.nvrec, &bnv_rec[0], sizeof(bnv_rec[0]) ) == 0 )
+        return 0;
+    if ( pfallback && (memcmp( &core.nvrec, &bnv_rec[1], sizeof(bnv_rec[1]) ) == 0) )
+    {
+        (*pfallback)++;             // the interrupted commit is dropped
+        return 0;
+    }
+    return 1;
+}
+
+static void bench_nvsave( void )
+{
+    struct SRecTaskInstance task;
+    uint32  n;
+    uint32  errors = 0;
+    uint32  cuts = 0;
+    uint32  fallbacks = 0;
+    uint32  saves = 0;
+    uint32  writes;
+    uint64  bytes;
+
+    internal_readout_core_start();
+
+    task.mempage = 0;
+    task.size = 8;
+    task.task_elems = rtt_thp;
+    task.sample_rate = ut_5sec;
+    task.deadband = 0;
+    core_op_recording_setup_task( 0, &task );
+    core_op_recording_task_run( 0, true );
+    core_op_recording_switch( true );
+    core_setup_save();
+
+    memcpy( &bnv_setup, &core.nv.setup, sizeof(bnv_setup) );
+    memcpy( &bnv_op, &core.nv.op, sizeof(bnv_op) );
+    memcpy( &bnv_rec[0], &core.nvrec, sizeof(bnv_rec[0]) );
+    errors += internal_nvsave_wake( NULL );
+
+    writes = hl.st_ee_writes;
+    bytes = hl.st_ee_bytes_wr;
+    for ( n=1; n<=BNV_COMMITS; n++ )
+    {
+        internal_nvsave_change( (n % BNV_CUT_EVERY) != 0 );
+        memcpy( &bnv_rec[1], &bnv_rec[0], sizeof(bnv_rec[0]) );
+
+        if ( (n % BNV_CUT_EVERY) == 0 )
+        {
+            // the supply is lost somewhere in the save - the one before or this commit is loaded at the next power up
+            struct SCoreNonVolatileRec rec;
+
+            memcpy( &rec, &core.nvrec, sizeof(rec) );
+            rec.dirty = false;
+            hl.ee_cut = true;
+            hl.ee_cut_bytes = internal_rand() % (sizeof(struct SCoreNonVolatileRec) + 16);
+            core_setup_save();
+            hl.ee_cut = false;
+
+            // the commit counter and mask are set by the save
+            rec.seq = core.nvrec.seq;
+            rec.wmask = core.nvrec.wmask;
+            memcpy( &bnv_rec[0], &rec, sizeof(rec) );
+            errors += internal_nvsave_wake( &fallbacks );
+            memcpy( &bnv_rec[0], &core.nvrec, sizeof(rec) );
+            cuts++;
+            continue;
+        }
+
+        core_setup_save();
+        saves++;
+        memcpy( &bnv_op, &core.nv.op, sizeof(bnv_op) );
+        memcpy( &bnv_rec[0], &core.nvrec, sizeof(bnv_rec[0]) );
+        errors += internal_nvsave_wake( NULL );
+    }
+    writes = hl.st_ee_writes - writes;
+    bytes = hl.st_ee_bytes_wr - bytes;
+
+    printf( "nvsave: %u power downs with 1-4 changed record bytes ( operation bytes at every 8th ), %u with power loss in the save\n",
+            BNV_COMMITS, cuts );
+    printf( "  load after each power down:   %s ( %u errors, %u interrupted commits dropped )\n", errors ? "FAILED" : "OK", errors, fallbacks );
+    printf( "  FRAM writes / power down:     %.2f ( %.1f bytes, full save: %u bytes )\n",
+            (double)writes / BNV_COMMITS, (double)bytes / BNV_COMMITS, (uint32)BNV_FULL_BYTES );
+}
+
+
+/////////////////////////////////////////////////////
+// crc - CRC16 of the nonvolatile structures and the UART streams
+/////////////////////////////////////////////////////
+
+#define BCRC_LOOPS          20000
+#define BCRC_CHECKS         2000        // random buffers for the bit exact / chunked check
+#define BCRC_FLIPS          20000       // corrupted copies for the detection check
+#define BCRC_BUFF           1024
+
+static uint8 bcrc_buf[BCRC_BUFF];
+static uint8 bcrc_cpy[BCRC_BUFF];
+
+// the per byte additive checksum of the nonvolatile structures replaced by crc16_update()
+static uint16 ref_nv_cksum( const uint8 *buff, uint32 len )
+{
+    uint16 cksum = 0xABCD;
+    uint32 i;
+
+    for ( i=0; i<len; i++ )
+        cksum = cksum + ( (uint16)(buff[i] << 8) - (uint16)(~buff[i]) ) + 1;
+    return cksum;
+}
+
+// the bitwise CRC16/CCITT the table is generated from
+static uint16 ref_crc16( uint16 crc, const uint8 *buff, uint32 len )
+{
+    uint32 i;
+
+    while ( len-- )
+    {
+        crc ^= (uint16)( *buff++ << 8 );
+        for ( i=0; i<8; i++ )
+            crc = (crc & 0x8000) ? (uint16)( (crc << 1) ^ 0x1021 ) : (uint16)( crc << 1 );
+    }
+    return crc;
+}
+
+static void bench_crc( void )
+{
+    static const uint32 sizes[] = { sizeof(struct SCoreSetup), sizeof(struct SCoreOperation), sizeof(struct SCoreNonVolatileRec), BCRC_BUFF };
+    uint32 errors = 0;
+    uint32 missed_crc = 0;
+    uint32 missed_sum = 0;
+    uint32 corrupted = 0;
+    uint32 dummy = 0;
+    uint32 i, k;
+    uint16 crc;
+    clock_t start;
+
+    // check value of the CRC16/CCITT-FALSE parameters
+    if ( crc16_update( CRC16_INIT, (const uint8*)"123456789", 9 ) != 0x29B1 )
+        errors++;
+
+    // bit exact with the bitwise one, in one call, byte by byte and in random chunks
+    for ( k=0; k<BCRC_CHECKS; k++ )
+    {
+        uint32 len = 1 + internal_rand() % BCRC_BUFF;
+        uint32 pos;
+        uint16 ref;
+
+        for ( i=0; i<len; i++ )
+            bcrc_buf[i] = (uint8)internal_rand();
+        ref = ref_crc16( CRC16_INIT, bcrc_buf, len );
+        if ( crc16_update( CRC16_INIT, bcrc_buf, len ) != ref )
+            errors++;
+
+        crc = CRC16_INIT;
+        for ( i=0; i<len; i++ )
+            crc = CRC16_BYTE( crc, bcrc_buf[i] );
+        if ( crc != ref )
+            errors++;
+
+        crc = CRC16_INIT;
+        for ( pos=0; pos<len; )
+        {
+            uint32 chunk = 1 + internal_rand() % 64;
+            if ( chunk > len - pos )
+                chunk = len - pos;
+            crc = crc16_update( crc, bcrc_buf + pos, chunk );
+            pos += chunk;
+        }
+        if ( crc != ref )
+            errors++;
+    }
+
+    // detection: a random bit flip pair or two swapped bytes in the recording structure
+    for ( k=0; k<BCRC_FLIPS; k++ )
+    {
+        uint32 len = sizeof(struct SCoreNonVolatileRec);
+        uint32 p1 = internal_rand() % len;
+        uint32 p2 = internal_rand() % len;
+
+        for ( i=0; i<len; i++ )
+            bcrc_buf[i] = (uint8)internal_rand();
+        memcpy( bcrc_cpy, bcrc_buf, len );
+        if ( k & 1 )
+        {
+            bcrc_cpy[p1] = bcrc_buf[p2];
+            bcrc_cpy[p2] = bcrc_buf[p1];
+        }
+        else
+        {
+            bcrc_cpy[p1] ^= (uint8)( 1 << (internal_rand() & 7) );
+            bcrc_cpy[p2] ^= (uint8)( 1 << (internal_rand() & 7) );
+        }
+        if ( memcmp( bcrc_cpy, bcrc_buf, len ) == 0 )
+            continue;           // the same bytes swapped, the same bit flipped twice
+        corrupted++;
+        if ( crc16_update( CRC16_INIT, bcrc_cpy, len ) == crc16_update( CRC16_INIT, bcrc_buf, len ) )
+            missed_crc++;
+        if ( ref_nv_cksum( bcrc_cpy, len ) == ref_nv_cksum( bcrc_buf, len ) )
+            missed_sum++;
+    }
+
+    printf( "crc: CRC16/CCITT ( 0x1021, init 0xFFFF ) against the bitwise calculation, %u random buffers\n", BCRC_CHECKS );
+    printf( "  check value / one call / byte / chunks:  %s ( %u errors )\n", errors ? "FAILED" : "OK", errors );
+    printf( "  undetected corruptions of the recording structure ( %u copies, 2 bit flips or a byte swap ):\n", corrupted );
+    printf( "      additive: %u   crc16: %u\n", missed_sum, missed_crc );
+    printf( "  size [bytes]   additive [ns/B]   bitwise [ns/B]   crc16 [ns/B]\n" );
+
+    for ( i=0; i<BCRC_BUFF; i++ )
+        bcrc_buf[i] = (uint8)internal_rand();
+    for ( k=0; k<sizeof(sizes)/sizeof(sizes[0]); k++ )
+    {
+        uint32 loops = BCRC_LOOPS * BCRC_BUFF / sizes[k];
+        double t_sum, t_bit, t_crc;
+        uint32 n;
+
+        start = clock();
+        for ( n=0; n<loops; n++ )
+        {
+            bcrc_buf[0] = (uint8)n;
+            dummy += ref_nv_cksum( bcrc_buf, sizes[k] );
+        }
+        t_sum = internal_elapsed_ns( start, loops * sizes[k] );
+        start = clock();
+        for ( n=0; n<loops / 8; n++ )
+        {
+            bcrc_buf[0] = (uint8)n;
+            dummy += ref_crc16( CRC16_INIT, bcrc_buf, sizes[k] );
+        }
+        t_bit = internal_elapsed_ns( start, (loops / 8) * sizes[k] );
+        start = clock();
+        for ( n=0; n<loops; n++ )
+        {
+            bcrc_buf[0] = (uint8)n;
+            dummy += crc16_update( CRC16_INIT, bcrc_buf, sizes[k] );
+        }
+        t_crc = internal_elapsed_ns( start, loops * sizes[k] );
+        printf( "  %6u         %6.2f            %6.2f           %6.2f\n", sizes[k], t_sum, t_bit, t_crc );
+    }
+    bench_sink = dummy;
+}
+
+
+/////////////////////////////////////////////////////
+
+struct SBenchEntry
+{
+    const char  *name;
+    void        (*run)(void);
+};
+
+static const struct SBenchEntry benches[] =
+{
+    { "psychro",    bench_psychro },
+    { "recpack",    bench_recpack },
+    { "readout",    bench_readout },
+    { "aggregate",  bench_aggregate },
+    { "grcache",    bench_grcache },
+    { "deadband",   bench_deadband },
+    { "graph",      bench_graph },
+    { "text",       bench_text },
+    { "calendar",   bench_calendar },
+    { "nvsave",     bench_nvsave },
+    { "crc",        bench_crc },
+    { NULL,         NULL }
+};
+
+
+int bench_run( const char *name )
+{
+    int i;
+
+    for ( i=0; benches[i].name; i++ )
+    {
+        if ( (strcmp( name, benches[i].name ) == 0) || (strcmp( name, "all" ) == 0) )
+        {
+            benches[i].run();
+            if ( strcmp( name, "all" ) )
+                return 0;
+        }
+    }
+    return strcmp( name, "all" ) ? -1 : 0;
+}
+
+void bench_list( void )
+{
+    int i;
+
+    printf( "benchmarks: all" );
+    for ( i=0; benches[i].name; i++ )
+        printf( ", %s", benches[i].name );
+    printf( "\n" );
+}
@@ -0,0 +1,18 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+    // run a host benchmark by name. Returns 0 on success, -1 if the name is unknown
+    int bench_run( const char *name );
+
+    // print the benchmark names
+    void bench_list( void );
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif // BENCH_H
@@ -0,0 +1,113 @@
+/*
+ *  Energy model for the headless simulator
+ *
+ *  Integrates the simulated time spent in each power mode and the active time of
+ *  the display, FRAM and sensors into charge drawn from the battery. The mode
+ *  currents are from the PWR_01 measurements ( see the end of hw/hw_stuff.h ),
+ *  measured at 3.65V with every circuit powered - the display module included.
+ *  The display-off hold current from the 2016-03-27 measurement in hw/hw_stuff.c
+ *  gives the display share, so it is accounted separately for the time the
+ *  display is really on. FRAM and sensor currents are not measured on the board -
+ *  they are estimates of the parts' active current from datasheets ( worst case for
+ *  the pressure conversion ), their standby currents are inside the mode currents.
+ *
+ *  The battery life is projected by repeating the simulated scenario till the
+ *  given capacity is used up, so the scenario should cover a full period of the
+ *  configuration ( one day of monitoring / recording is usually enough ).
+ *
+ **/
+
+#include <stdio.h>
+
+#include "hw_headless.h"
+#include "energy.h"
+
+
+#define EN_DISP_MA          ( 1.7 - 0.219 )     // stop mode with everything powered - stop mode with display off
+#define EN_EE_MA            3.0                 // SPI FRAM read / write at full clock
+#define EN_SENS_RH_MA       0.45                // RH/Temp sensor during power-up and conversion
+#define EN_SENS_P_MA        2.0                 // pressure sensor during the one-shot conversion
+
+static const double en_mode_ma[pm_down+1] =
+{
+    9.96 - EN_DISP_MA,                          // pm_full
+    4.65 - EN_DISP_MA,                          // pm_sleep
+    1.7  - EN_DISP_MA,                          // pm_hold_btn
+    1.7  - EN_DISP_MA,                          // pm_hold
+    0.013                                       // pm_down - RTC alarm only
+};
+
+enum EEnergyItem
+{
+    en_disp = pm_down + 1,
+    en_ee,
+    en_sens_rh,
+    en_sens_p,
+    en_count
+};
+
+
+// mA*ms -> mAh
+static double local_mah( double ma, double ms )
+{
+    return ma * ms / 3600000.0;
+}
+
+static void local_collect( double *mah )
+{
+    int i;
+
+    for ( i=0; i<=pm_down; i++ )
+        mah[i] = local_mah( en_mode_ma[i], (double)hl.st_mode_ms[i] );
+
+    mah[en_disp]    = local_mah( EN_DISP_MA, (double)hl.st_disp_on_ms );
+    mah[en_ee]      = local_mah( EN_EE_MA, hl.st_ee_busy_us / 1000.0 );
+    mah[en_sens_rh] = local_mah( EN_SENS_RH_MA, (double)hl.st_sens_rh_ms );
+    mah[en_sens_p]  = local_mah( EN_SENS_P_MA, (double)hl.st_sens_p_ms );
+}
+
+double energy_total_mah( void )
+{
+    double mah[en_count];
+    double total = 0;
+    int i;
+
+    local_collect( mah );
+    for ( i=0; i<en_count; i++ )
+        total += mah[i];
+    return total;
+}
+
+void energy_report( double battery_mah )
+{
+    static const char *name[en_count] = { "full", "sleep", "hold_btn", "hold", "down", "display on", "FRAM", "sensor rh", "sensor p" };
+    double mah[en_count];
+    double ms[en_count];
+    double total = 0;
+    double days = (double)hl.sim_ms / ( 24.0 * 3600000.0 );
+    int i;
+
+    local_collect( mah );
+    for ( i=0; i<=pm_down; i++ )
+        ms[i] = (double)hl.st_mode_ms[i];
+    ms[en_disp]     = (double)hl.st_disp_on_ms;
+    ms[en_ee]       = hl.st_ee_busy_us / 1000.0;
+    ms[en_sens_rh]  = (double)hl.st_sens_rh_ms;
+    ms[en_sens_p]   = (double)hl.st_sens_p_ms;
+
+    for ( i=0; i<en_count; i++ )
+        total += mah[i];
+
+    printf( "energy:          %.3f mAh", total );
+    if ( hl.sim_ms )
+        printf( " ( %.3f mAh / day, avg. %.1f uA )", total / days, total * 1000.0 * 3600000.0 / hl.sim_ms );
+    printf( "\n" );
+    for ( i=0; i<en_count; i++ )
+    {
+        printf( "  %-10s %14.1f ms  %8.3f mAh  %6.2f%%\n", name[i], ms[i], mah[i],
+                                                          (total > 0) ? (100.0 * mah[i]) / total : 0.0 );
+    }
+
+    if ( total > 0 )
+        printf( "battery life:    %.1f days with %.0f mAh\n", battery_mah / ( total / days ), battery_mah );
+}
@@ -0,0 +1,23 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "typedefs.h"
+
+    #define ENERGY_DEFAULT_BATTERY  600.0       // mAh - battery capacity used when not given in command line
+
+    // charge consumed in the simulated time in mAh ( see the current table in energy.c )
+    double energy_total_mah( void );
+
+    // print the consumption per power mode and peripheral, and the battery life projected
+    // with the given capacity for the simulated scenario
+    void energy_report( double battery_mah );
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif // ENERGY_H
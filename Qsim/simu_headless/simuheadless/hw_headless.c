@@ -0,0 +1,992 @@
+/*
+ *  Hardware wrapper for the headless simulator
+ *
+ *  Same functionality as hw_wrapper.cpp from the Qt simulator, without any
+ *  GUI dependency. The state of the simulated hardware is held in 'hl',
+ *  the simulation loop ( see main.c ) drives the clocks.
+ *
+ *  FRAM content is a shared memory mapping of the image file: eeprom_write()
+ *  goes through to the file without copying the whole image, so an interrupted
+ *  simulation keeps its recordings and the image can be inspected while the
+ *  simulation runs. Without image file the content is held in memory only.
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+#include "hw_headless.h"
+#include "core.h"
+#include "eeprom_spi.h"
+#include "graphic_lib.h"
+#include "dispHAL.h"
+#include "crc16.h"
+
+
+struct SHeadlessHW hl;
+
+static uint8  eeprom_mem[ EEPROM_SIZE ];       // FRAM content when no image file is used
+static uint8 *eeprom_cont = eeprom_mem;
+static bool   ee_mapped = false;
+#ifdef _WIN32
+static HANDLE ee_hmap = NULL;
+#endif
+static uint8 *dispmem = NULL;
+
+
+static void internal_unmap_image( void )
+{
+    if ( ee_mapped == false )
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile( eeprom_cont );
+    CloseHandle( ee_hmap );
+    ee_hmap = NULL;
+#else
+    munmap( eeprom_cont, EEPROM_SIZE );
+#endif
+    eeprom_cont = eeprom_mem;
+    ee_mapped = false;
+}
+
+static int internal_map_image( const char *eefile )
+{
+    // a new image file is created erased, an existing one should have the FRAM size
+    memset( eeprom_mem, 0xff, EEPROM_SIZE );
+#ifdef _WIN32
+    HANDLE hfile;
+    DWORD  size;
+    void   *map = NULL;
+
+    hfile = CreateFileA( eefile, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                         OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+    if ( hfile == INVALID_HANDLE_VALUE )
+        return -1;
+    size = GetFileSize( hfile, NULL );
+    if ( size == 0 )
+        WriteFile( hfile, eeprom_mem, EEPROM_SIZE, &size, NULL );
+    if ( size == EEPROM_SIZE )
+    {
+        ee_hmap = CreateFileMappingA( hfile, NULL, PAGE_READWRITE, 0, EEPROM_SIZE, NULL );
+        if ( ee_hmap )
+            map = MapViewOfFile( ee_hmap, FILE_MAP_ALL_ACCESS, 0, 0, EEPROM_SIZE );
+        if ( (map == NULL) && ee_hmap )
+        {
+            CloseHandle( ee_hmap );
+            ee_hmap = NULL;
+        }
+    }
+    CloseHandle( hfile );
+    if ( map == NULL )
+        return -1;
+#else
+    int    fd;
+    struct stat st;
+    void   *map = MAP_FAILED;
+
+    fd = open( eefile, O_RDWR | O_CREAT, 0644 );
+    if ( fd < 0 )
+        return -1;
+    if ( (fstat( fd, &st ) == 0) && (st.st_size == 0) )
+    {
+        if ( write( fd, eeprom_mem, EEPROM_SIZE ) == EEPROM_SIZE )
+            st.st_size = EEPROM_SIZE;
+    }
+    if ( st.st_size == EEPROM_SIZE )
+        map = mmap( NULL, EEPROM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    close( fd );
+    if ( map == MAP_FAILED )
+        return -1;
+#endif
+    eeprom_cont = (uint8*)map;
+    ee_mapped = true;
+    return 0;
+}
+
+
+int HL_Init( const char *eefile )
+{
+    memset( &hl, 0, sizeof(hl) );
+    internal_unmap_image();
+    memset( eeprom_mem, 0xff, EEPROM_SIZE );
+
+    hl.RTCcounter   = 0x00;
+    hl.RTCalarm     = 0xffffffff;
+    hl.PwrMode      = pm_down;
+    hl.PwrWUR       = WUR_FIRST;
+    hl.battery      = VBAT_MAX;
+    hl.sens[0]      = 23.54;
+    hl.sens[1]      = 56.7;
+    hl.sens[2]      = 1013.25;
+
+    if ( eefile == NULL )
+        return 0;
+    return internal_map_image( eefile );
+}
+
+int HL_Flush( const char *eefile )
+{
+    FILE *file;
+
+    if ( ee_mapped )
+    {
+        // content is in the file already - wait for it to be written on disk
+#ifdef _WIN32
+        return FlushViewOfFile( eeprom_cont, EEPROM_SIZE ) ? 0 : -1;
+#else
+        return msync( eeprom_cont, EEPROM_SIZE, MS_SYNC );
+#endif
+    }
+    if ( eefile == NULL )
+        return 0;
+
+    file = fopen( eefile, "wb" );
+    if ( file == NULL )
+        return -1;
+    fwrite( eeprom_cont, 1, EEPROM_SIZE, file );
+    fclose( file );
+    return 0;
+}
+
+
+/////////////////////////////////////////////////////
+// Environment simulation
+/////////////////////////////////////////////////////
+
+// the same random walk as in mainw::InputValSimulation(), but advanced in bulk
+// instead of 1ms steps, so it doesn't slow down the time skips
+
+static const double SIMUVAL_DIFF[]  = { 20.0, 60.0, 90.0  };     // differences over the floor values
+static const double SIMUVAL_FLOOR[] = { 12.0, 30.0, 950.0 };     // floor values
+
+static const int    SIMUIV_MIN[]     = { 1000, 1000, 5000 };         // minimum intervals for value change
+static const int    SIMUIV_STRETCH[] = { 600000, 600000, 600000, };  // maximum strech bw. value changes
+
+static struct
+{
+    uint32  steps_todo[HL_SENSORS];
+    double  sdiff[HL_SENSORS];
+} inval;
+
+void HL_InputAdvance( uint32 ms )
+{
+    int i;
+
+    if ( hl.sens_vary == false )
+        return;
+
+    for ( i=0; i<HL_SENSORS; i++ )
+    {
+        uint32 todo = ms;
+        while ( todo )
+        {
+            uint32 steps;
+
+            if ( inval.steps_todo[i] == 0 )
+            {
+                double diff;
+                diff  = ( rand() * SIMUVAL_DIFF[i] ) / RAND_MAX + SIMUVAL_FLOOR[i];
+                steps = (uint32)( ( (uint64)rand() * SIMUIV_STRETCH[i] ) / RAND_MAX + SIMUIV_MIN[i] );
+
+                inval.steps_todo[i] = steps;
+                inval.sdiff[i] = (diff - hl.sens[i]) / steps;
+            }
+
+            steps = ( todo < inval.steps_todo[i] ) ? todo : inval.steps_todo[i];
+            hl.sens[i] += inval.sdiff[i] * steps;
+            inval.steps_todo[i] -= steps;
+            todo -= steps;
+        }
+    }
+}
+
+static int internal_get_temperature( void )
+{
+    if ( hl.sens[0] > 87.99 )
+        return 0xffff;
+    if ( hl.sens[0] < -39.99 )
+        return 0;
+
+    return (int)( (hl.sens[0] + 40) * (1 << TEMP_FP) );
+}
+
+static int internal_get_humidity( void )
+{
+    return (int)( hl.sens[1] * (1<<RH_FP) );
+}
+
+static int internal_get_pressure( void )
+{
+    return (int)( hl.sens[2] * 400 );
+}
+
+
+/////////////////////////////////////////////////////
+// System / RTC / buttons
+/////////////////////////////////////////////////////
+
+void InitHW(void)
+{
+    hl.RTCalarm = hl.RTCcounter+1;
+}
+
+void HW_ASSERT()
+{
+}
+
+void HW_DBG_DUMP(struct SCore *core)
+{
+    (void)core;
+}
+
+void HW_DBG_SIMUSKIP(void)
+{
+}
+
+void HL_ButtonSet( int btn, bool pressed )
+{
+    bool pwrbtn = (btn == BTN_MODE);
+
+    hl.buttons[btn] = pressed;
+    if ( pressed == false )
+        return;
+
+    if ( hl.PwrMode == pm_down )
+    {
+        if ( pwrbtn )                       // power button wakes it up and starts from reset
+        {
+            hl.PwrMode = pm_full;
+            if ( hl.PwrWUR != WUR_FIRST )
+                hl.PwrWUR = WUR_USR;
+            hl.st_resets++;
+            hl.st_wakeups++;
+            main_entry( NULL );
+        }
+    }
+    else if ( ((hl.PwrMode == pm_hold) && pwrbtn) || (hl.PwrMode == pm_hold_btn) )
+    {
+        hl.PwrMode = pm_full;
+        hl.PwrWUR = WUR_USR;
+        hl.st_wakeups++;
+    }
+}
+
+bool BtnGet_OK()        { return hl.buttons[BTN_OK];    }
+bool BtnGet_Esc()       { return hl.buttons[BTN_ESC];   }
+bool BtnGet_Mode()      { return hl.buttons[BTN_MODE];  }
+bool BtnGet_Up()        { return hl.buttons[BTN_UP];    }
+bool BtnGet_Down()      { return hl.buttons[BTN_DOWN];  }
+bool BtnGet_Left()      { return hl.buttons[BTN_LEFT];  }
+bool BtnGet_Right()     { return hl.buttons[BTN_RIGHT]; }
+
+bool HW_Charge_Detect()
+{
+    return hl.charge;
+}
+
+void HW_LED_On()
+{
+}
+
+
+static int saved_secCtr;
+
+void HW_Seconds_Start(void)
+{
+    saved_secCtr = hl.sec_ctr;
+    hl.sec_ctr = 0;
+}
+
+void HW_Seconds_Restore(void)
+{
+    hl.sec_ctr = saved_secCtr;
+}
+
+void HW_Buzzer_On(int pulse)
+{
+    (void)pulse;
+}
+
+void HW_Buzzer_Off(void)
+{
+}
+
+uint32 HW_Sleep( enum EPowerMode mode)
+{
+    hl.PwrWUR = WUR_NONE;
+
+    if ( mode >= pm_hold_btn )
+        hl.RTCalarm = hl.RTCNextAlarm;
+
+    hl.PwrMode = mode;
+    return 0;
+}
+
+uint32 HW_GetWakeUpReason(void)
+{
+    return hl.PwrWUR;
+}
+
+uint32 RTC_GetCounter(void)
+{
+    return hl.RTCcounter;
+}
+
+uint32 RTC_GetDivider(void)
+{
+    return TIMER_RTC_PRESCALE - ( (uint32)hl.sec_ctr * (TIMER_RTC_PRESCALE + 1) ) / HL_MS_PER_RTC;
+}
+
+void RTC_SetAlarm(uint32 value)
+{
+    hl.RTCalarm = value;
+}
+
+void RTC_WaitForSynchro(void)
+{
+}
+
+void RTC_SetCounter(uint32 RTCctr)
+{
+    hl.RTCcounter = RTCctr;
+}
+
+void HW_SetRTC_NextAlarm( uint32 alarm )
+{
+    hl.RTCNextAlarm = alarm + 1;        // simulate the shift in clock ticks produced by late trigger in STM32F RTC alarm
+}
+
+uint32 HW_ADC_GetBattery(void)
+{
+    return hl.battery;
+}
+
+void HW_PWR_An_On( void )
+{
+}
+
+void HW_PWR_An_Off( void )
+{
+}
+
+void HWDBG( int val )
+{
+    (void)val;
+}
+
+int HWDBG_Get_Temp()
+{
+    return internal_get_temperature();
+}
+
+int HWDBG_Get_Humidity()
+{
+    return internal_get_humidity();
+}
+
+int HWDBG_Get_Pressure()
+{
+    return internal_get_pressure();
+}
+
+void BKP_WriteBackupRegister( int reg, uint16 data )
+{
+    if (reg < 10)
+        hl.BKPregs[reg] = data;
+}
+
+uint16 BKP_ReadBackupRegister( int reg )
+{
+    if (reg < 10)
+        return hl.BKPregs[reg];
+    return 0xffff;
+}
+
+
+/////////////////////////////////////////////////////
+// Sensor emulation - device model of func/sensors.c, the same as in hw_wrapper.cpp
+//
+//  Every I2C transfer is polled in PM_FULL ( it takes less than 1ms, accounted as one tick ),
+//  the RH/Temp power-up and conversion delays are counted on 1ms ticks in PM_SLEEP, the pressure
+//  one-shot conversion ends with the data ready line which wakes up the CPU from PM_HOLD.
+//  With hl.sens_polled the pressure conversion is waited in PM_SLEEP, as the sensor module did
+//  before the data ready line was armed as wake-up source.
+/////////////////////////////////////////////////////
+
+#define SENS_I2C_MS         1           // one I2C transfer
+#define SENS_P_CONV_MS      512         // pressure one-shot with 128x oversampling
+#define SENS_RH_POWERUP_MS  15
+#define SENS_RH_CONV_MS     29
+#define SENS_T_CONV_MS      85
+#define SENS_RH_POLL_MS     24          // first read-out attempt after the request ( see local_rhsensor_execute_read() )
+#define SENS_T_POLL_MS      80
+#define SENS_RETRY_MS       5           // read-out retry after NAK
+
+enum ESimuPSensor
+{
+    sp_off = 0,
+    sp_init,                            // set-up transfers
+    sp_idle,
+    sp_cmd,                             // one-shot command transfer
+    sp_conv,                            // conversion in progress, bus is free
+    sp_read                             // data ready line raised - result read-out transfer
+};
+
+enum ESimuRHSensor
+{
+    sr_off = 0,
+    sr_powerup,                         // power-up delay
+    sr_init,                            // user register read / write transfers
+    sr_idle,
+    sr_cmd,                             // measurement request transfer
+    sr_wait,                            // waiting for the read-out attempt, bus is free
+    sr_read                             // read-out transfer - NAK if the conversion is not finished
+};
+
+static struct
+{
+    enum ESimuPSensor   p;
+    enum ESimuRHSensor  r;
+    int     p_ctr;                      // ms left from the current pressure sensor phase
+    int     r_ctr;                      // ms left from the current RH sensor phase
+    int     r_conv;                     // ms left from the RH/Temp conversion inside the sensor
+    uint32  r_cur;                      // SENSOR_RH or SENSOR_TEMP in conversion
+
+    uint32  requested;                  // acquire requests not served yet
+    uint32  ready;                      // measurement is ready
+} sens;
+
+
+static bool internal_sens_bus_busy( void )
+{
+    return ( (sens.p == sp_init) || (sens.p == sp_cmd) || (sens.p == sp_read) ||
+             (sens.r == sr_init) || (sens.r == sr_cmd) || (sens.r == sr_read) );
+}
+
+bool HL_SensorBusy( void )
+{
+    return ( sens.requested ||
+             ((sens.p != sp_off) && (sens.p != sp_idle)) ||
+             ((sens.r != sr_off) && (sens.r != sr_idle)) );
+}
+
+void Sensor_Init()
+{
+    memset( &sens, 0, sizeof(sens));
+
+    sens.p = sp_init;
+    sens.p_ctr = SENS_I2C_MS;
+    sens.r = sr_powerup;
+    sens.r_ctr = SENS_RH_POWERUP_MS;
+}
+
+void Sensor_Shutdown( uint32 mask )
+{
+    if ( mask & (SENSOR_TEMP | SENSOR_RH) )
+    {
+        sens.ready &= ~(SENSOR_TEMP | SENSOR_RH);
+        sens.requested &= ~(SENSOR_TEMP | SENSOR_RH);
+        sens.r = sr_off;
+    }
+    if ( mask & SENSOR_PRESS )
+    {
+        sens.ready &= ~SENSOR_PRESS;
+        sens.requested &= ~SENSOR_PRESS;
+        sens.p = sp_off;
+    }
+}
+
+uint32 Sensor_Acquire( uint32 mask )
+{
+    mask &= (SENSOR_TEMP | SENSOR_RH | SENSOR_PRESS);
+
+    // sensors shut down are initialized again
+    if ( (mask & SENSOR_PRESS) && (sens.p == sp_off) )
+    {
+        sens.p = sp_init;
+        sens.p_ctr = SENS_I2C_MS;
+    }
+    if ( (mask & (SENSOR_TEMP | SENSOR_RH)) && (sens.r == sr_off) )
+    {
+        sens.r = sr_powerup;
+        sens.r_ctr = SENS_RH_POWERUP_MS;
+    }
+
+    sens.ready &= ~mask;
+    sens.requested |= mask;
+    return 0;
+}
+
+uint32 Sensor_Is_Ready(void)
+{
+    return sens.ready;
+}
+
+uint32 Sensor_Is_Busy(void)
+{
+    return sens.requested;
+}
+
+uint32 Sensor_Is_Failed(void)
+{
+    return 0;
+}
+
+uint32 Sensor_Get_Value( uint32 sensor )
+{
+    switch ( sensor )
+    {
+        case SENSOR_TEMP:
+            if ( (sens.ready & SENSOR_TEMP) == 0 )
+                return SENSOR_VALUE_FAIL;
+            sens.ready &= ~SENSOR_TEMP;
+            return internal_get_temperature();
+        case SENSOR_PRESS:
+            if ( (sens.ready & SENSOR_PRESS) == 0 )
+                return SENSOR_VALUE_FAIL;
+            sens.ready &= ~SENSOR_PRESS;
+            return internal_get_pressure();
+        case SENSOR_RH:
+            if ( (sens.ready & SENSOR_RH) == 0 )
+                return SENSOR_VALUE_FAIL;
+            sens.ready &= ~SENSOR_RH;
+            return internal_get_humidity();
+        default:
+            return SENSOR_VALUE_FAIL;
+    }
+}
+
+static bool internal_sens_pressure_step( void )
+{
+    if ( sens.p_ctr )
+        sens.p_ctr--;
+
+    switch ( sens.p )
+    {
+        case sp_init:
+            if ( sens.p_ctr == 0 )
+                sens.p = sp_idle;
+            break;
+        case sp_cmd:
+            if ( sens.p_ctr == 0 )
+            {
+                sens.p = sp_conv;
+                sens.p_ctr = SENS_P_CONV_MS;
+            }
+            break;
+        case sp_conv:
+            if ( (sens.p_ctr == 0) && (internal_sens_bus_busy() == false) )
+            {
+                sens.p = sp_read;               // data ready line raised - CPU wakes up and reads the result
+                sens.p_ctr = SENS_I2C_MS;
+                return true;
+            }
+            break;
+        case sp_read:
+            if ( sens.p_ctr == 0 )
+            {
+                sens.p = sp_idle;
+                sens.requested &= ~SENSOR_PRESS;
+                sens.ready |= SENSOR_PRESS;
+            }
+            break;
+        default:
+            break;
+    }
+
+    if ( (sens.p == sp_idle) && (sens.requested & SENSOR_PRESS) && (internal_sens_bus_busy() == false) )
+    {
+        sens.p = sp_cmd;
+        sens.p_ctr = SENS_I2C_MS;
+    }
+    return false;
+}
+
+static void internal_sens_rh_step( void )
+{
+    if ( sens.r_ctr )
+        sens.r_ctr--;
+    if ( sens.r_conv )
+        sens.r_conv--;
+
+    switch ( sens.r )
+    {
+        case sr_powerup:
+            if ( (sens.r_ctr == 0) && (internal_sens_bus_busy() == false) )
+            {
+                sens.r = sr_init;
+                sens.r_ctr = SENS_I2C_MS;
+            }
+            break;
+        case sr_init:
+            if ( sens.r_ctr == 0 )
+                sens.r = sr_idle;
+            break;
+        case sr_cmd:
+            if ( sens.r_ctr == 0 )
+            {
+                sens.r = sr_wait;
+                sens.r_ctr = (sens.r_cur == SENSOR_RH) ? SENS_RH_POLL_MS : SENS_T_POLL_MS;
+            }
+            break;
+        case sr_wait:
+            if ( (sens.r_ctr == 0) && (internal_sens_bus_busy() == false) )
+            {
+                sens.r = sr_read;
+                sens.r_ctr = SENS_I2C_MS;
+            }
+            break;
+        case sr_read:
+            if ( sens.r_ctr == 0 )
+            {
+                if ( sens.r_conv == 0 )
+                {
+                    sens.r = sr_idle;
+                    sens.requested &= ~sens.r_cur;
+                    sens.ready |= sens.r_cur;
+                }
+                else
+                {
+                    sens.r = sr_wait;           // NAK - conversion is not finished
+                    sens.r_ctr = SENS_RETRY_MS;
+                }
+            }
+            break;
+        default:
+            break;
+    }
+
+    // RH first, temperature after ( see _reload_operation in local_rhsensor_execute_read() )
+    if ( (sens.r == sr_idle) && (sens.requested & (SENSOR_RH | SENSOR_TEMP)) && (internal_sens_bus_busy() == false) )
+    {
+        sens.r_cur = (sens.requested & SENSOR_RH) ? SENSOR_RH : SENSOR_TEMP;
+        sens.r_conv = (sens.r_cur == SENSOR_RH) ? SENS_RH_CONV_MS : SENS_T_CONV_MS;
+        sens.r = sr_cmd;
+        sens.r_ctr = SENS_I2C_MS;
+    }
+}
+
+// advance the sensor model with 1ms - returns true when the pressure data ready line wakes up the CPU
+bool Sensor_simu_poll()
+{
+    bool irq;
+
+    if ( (sens.p == sp_cmd) || (sens.p == sp_conv) || (sens.p == sp_read) )
+        hl.st_sens_p_ms++;
+    if ( (sens.r != sr_off) && (sens.r != sr_idle) )
+        hl.st_sens_rh_ms++;
+
+    irq = internal_sens_pressure_step();
+    internal_sens_rh_step();
+    return irq;
+}
+
+void Sensor_Poll(bool tick_ms)
+{
+    (void)tick_ms;
+}
+
+uint32 Sensor_GetPwrStatus(void)
+{
+    uint32 pwr = PM_DOWN;
+
+    // bus transfers are polled
+    if ( internal_sens_bus_busy() )
+        return PM_FULL;
+    // requested operation waits to be started - sensor poll should be called as soon as possible
+    if ( ((sens.requested & SENSOR_PRESS) && (sens.p == sp_idle)) ||
+         ((sens.requested & (SENSOR_RH | SENSOR_TEMP)) && (sens.r == sr_idle)) )
+        return PM_FULL;
+
+    // delays counted on the 1ms ticks
+    if ( (sens.r == sr_powerup) || (sens.r == sr_wait) )
+        pwr |= PM_SLEEP;
+
+    // pressure conversion - the data ready line wakes up the CPU
+    if ( sens.p == sp_conv )
+        pwr |= hl.sens_polled ? PM_SLEEP : PM_HOLD;
+
+    return pwr;
+}
+
+
+/////////////////////////////////////////////////////
+// EEPROM emulation
+/////////////////////////////////////////////////////
+
+// FM25V20A on SPI1: 8MHz HSI with prescaler 4 ( see eeprom_spi.c ). The transfer time is given in polls
+// of eeprom_is_operation_finished() - asynchronous operations are polled once in a main loop
+#define EE_SPI_HZ           2000000
+#define EE_CMD_BYTES        4                       // opcode + 3 address bytes
+#define EE_WREN_BYTES       1                       // write enable opcode, separate chip select
+#define EE_WAKEUP_US        450                     // tREC - recovery from the sleep mode
+#define EE_POLL_US          ( 1000 / HL_FULL_LOOPS )
+
+static bool   ee_enabled = false;
+static bool   ee_deepsleep = true;
+static bool   ee_wren = false;
+static uint32 ee_count = 0;
+
+static uint32 internal_ee_polls( uint32 us )
+{
+    hl.st_ee_busy_us += us;
+    return ( us + EE_POLL_US - 1 ) / EE_POLL_US;
+}
+
+static uint32 internal_ee_transfer_us( uint32 bytes )
+{
+    return (uint32)( ((uint64)bytes * 8 * 1000000 + EE_SPI_HZ - 1) / EE_SPI_HZ );
+}
+
+uint32 eeprom_init()
+{
+    return 0;                           // content is loaded by HL_Init()
+}
+
+uint32 eeprom_get_size()
+{
+    return EEPROM_SIZE;
+}
+
+uint32 eeprom_enable( bool write )
+{
+    ee_enabled = true;
+    ee_wren = write;
+    if ( ee_deepsleep )
+    {
+        ee_deepsleep = false;
+        ee_count = internal_ee_polls( EE_WAKEUP_US );
+    }
+    return 0;
+}
+
+uint32 eeprom_disable()
+{
+    ee_enabled = false;
+    ee_wren = false;
+    return 0;
+}
+
+uint32 eeprom_deepsleep()
+{
+    ee_deepsleep = true;
+    ee_enabled = false;
+    ee_wren = false;
+    return 0;
+}
+
+uint32 eeprom_read( uint32 address, uint32 count, uint8 *buff, bool async )
+{
+    (void)async;
+    if (ee_enabled == false)
+        return (uint32)-1;
+    if ( count > (EEPROM_SIZE - address) )
+        count = (EEPROM_SIZE - address);
+
+    memcpy( buff, eeprom_cont + address, count );
+
+    ee_count = internal_ee_polls( internal_ee_transfer_us( EE_CMD_BYTES + count ) );
+    hl.st_ee_reads++;
+    hl.st_ee_bytes_rd += count;
+    return count;
+}
+
+uint32 eeprom_write( uint32 address, const uint8 *buff, uint32 count, bool async )
+{
+    (void)async;
+    if ( (ee_enabled == false) || (ee_wren == false) )
+        return (uint32)-1;
+
+    if ( count > (EEPROM_SIZE - address) )
+        count = (EEPROM_SIZE - address);
+
+    if ( hl.ee_cut == false )
+        memcpy( eeprom_cont + address, buff, count );
+    else
+    {
+        // supply lost in the middle - the chip takes only the bytes clocked in before
+        uint32 len = ( count < hl.ee_cut_bytes ) ? count : hl.ee_cut_bytes;
+
+        memcpy( eeprom_cont + address, buff, len );
+        hl.ee_cut_bytes -= len;
+    }
+
+    ee_count = internal_ee_polls( internal_ee_transfer_us( EE_WREN_BYTES + EE_CMD_BYTES + count ) );
+    hl.st_ee_writes++;
+    hl.st_ee_bytes_wr += count;
+    return count;
+}
+
+bool eeprom_is_operation_finished( void )
+{
+    if ( ee_count )
+    {
+        ee_count--;
+        return false;
+    }
+    return true;
+}
+
+
+/////////////////////////////////////////////////////
+// UART - the transmitted stream is captured in a file
+/////////////////////////////////////////////////////
+
+static FILE   *uart_file = NULL;
+static bool   uart_set = false;
+static uint32 uart_cksum = 0;           // CRC16 of the stream - see crc16.h
+
+int HL_UartCapture( const char *file )
+{
+    if ( uart_file )
+        fclose( uart_file );
+    uart_file = NULL;
+
+    if ( file == NULL )
+        return 0;
+
+    uart_file = fopen( file, "wb" );
+    if ( uart_file == NULL )
+        return -1;
+    return 0;
+}
+
+void HW_UART_Start()
+{
+    if ( uart_set )
+        return;
+    uart_set = true;
+    uart_cksum = CRC16_INIT;
+}
+
+void HW_UART_Stop()
+{
+    uart_set = false;
+}
+
+uint32 HW_UART_SendMulti( uint8 *data, uint32 size )
+{
+    if ( uart_set == false )
+        return 1;
+
+    uart_cksum = crc16_update( (uint16)uart_cksum, data, size );
+    if ( uart_file )
+        fwrite( data, 1, size, uart_file );
+    hl.st_uart_bytes += size;
+    return 0;
+}
+
+uint32 HW_UART_SendSingle( uint8 data )
+{
+    return HW_UART_SendMulti( &data, 1 );
+}
+
+uint32 HW_UART_SendDMA( uint8 *data, uint32 size )
+{
+    return HW_UART_SendMulti( data, size );       // transfer is finished immediately
+}
+
+bool HW_UART_DMA_IsFinished()
+{
+    return true;
+}
+
+uint32 HW_UART_get_Checksum()
+{
+    return uart_cksum;
+}
+
+void HW_UART_reset_Checksum()
+{
+    uart_cksum = CRC16_INIT;
+}
+
+
+/////////////////////////////////////////////////////
+// Display - content is kept only in the graphic memory
+/////////////////////////////////////////////////////
+
+uint32 DispHAL_Init(uint8 *Gmem)
+{
+    dispmem = Gmem;
+    return 0;
+}
+
+uint32 DispHAL_UpdateLUT( LUTelem *LUT )
+{
+    (void)LUT;
+    return 0;
+}
+
+void DispHAL_NeedUpdate(  uint32 X1, uint32 Y1, uint32 X2, uint32 Y2  )
+{
+    if ( hl.on_need_update )
+        hl.on_need_update( X1, Y1, X2, Y2 );
+}
+
+uint32 DispHAL_App_Poll(void)
+{
+    return 0;
+}
+
+void DispHAL_ISR_Poll()
+{
+}
+
+void DispHal_ToFlipBuffer()
+{
+}
+
+void DispHal_ClearFlipBuffer()
+{
+}
+
+void DispHal_GreySetup( uint32 rate, uint32 all, uint32 grey )
+{
+    (void)rate;
+    (void)all;
+    (void)grey;
+}
+
+int  DispHAL_Display_On( void )
+{
+    hl.disp_on = true;
+    return 0;
+}
+
+int  DispHAL_Display_Off( void )
+{
+    hl.disp_on = false;
+    return 0;
+}
+
+void DispHAL_SetContrast( int cval )
+{
+    (void)cval;
+}
+
+bool DispHAL_DisplayBusy( void )
+{
+    return false;
+}
+
+bool DispHAL_ReleaseSPI( void )
+{
+    return true;
+}
+
+void DispHAL_UpdateScreen()
+{
+    hl.st_disp_updates++;
+    if ( hl.on_disp_update )
+        hl.on_disp_update( dispmem );
+}
@@ -0,0 +1,92 @@
+#ifndef HW_HEADLESS_H
+#define HW_HEADLESS_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "stm32f10x.h"
+#include "typedefs.h"
+
+struct SCore;                               // hw_stuff.h uses it in a prototype - declare it in file scope for C
+
+#include "hw_stuff.h"
+
+#define EEPROM_SIZE         256*1024        // 256k FRAM
+
+#define HL_BUTTONS          7               // see BTN_xxx in hw_stuff.h
+#define HL_SENSORS          3               // temperature / humidity / pressure
+#define HL_FULL_LOOPS       8               // main loops executed in one ms in pm_full mode
+#define HL_MS_PER_RTC       500             // RTC tick is 0.5 second
+
+    // state of the simulated hardware - the same fields as mainw holds for the Qt simulator
+    struct SHeadlessHW
+    {
+        // clocks and power
+        uint64  sim_ms;                     // simulated time in ms since the simulation start
+        int     sec_ctr;                    // ms counter inside the 0.5sec RTC interval
+        uint32  RTCcounter;
+        uint32  RTCalarm;
+        uint32  RTCNextAlarm;
+        enum EPowerMode PwrMode;
+        uint32  PwrWUR;
+        uint16  BKPregs[10];
+
+        // inputs
+        bool    buttons[HL_BUTTONS];
+        bool    charge;
+        int     battery;                    // raw ADC value
+        double  sens[HL_SENSORS];           // current environment values - temp [*C], rh [%], pressure [hPa]
+        bool    sens_vary;                  // if true - environment values are changed in a random walk
+        bool    sens_polled;                // if true - pressure conversion keeps the CPU in sleep mode ( legacy timing )
+
+        bool    disp_on;                    // display module is powered
+
+        bool    ee_cut;                     // power loss test: FRAM writes are dropped after ee_cut_bytes bytes
+        uint32  ee_cut_bytes;
+
+        // statistics
+        uint64  st_mode_ms[pm_down+1];      // time spent in each power mode
+        uint32  st_wakeups;                 // wake-ups from stopped or power down state
+        uint32  st_wake_rtc;                // wake-ups by the RTC alarm ( core_pwr_setup_alarm() )
+        uint32  st_wake_sched;              // RTC alarm wake-ups with a sensor read slot due
+        uint32  st_wake_sens;               // wake-ups by the pressure sensor data ready line
+        uint32  st_resets;                  // starts from power down state ( main_entry calls )
+        uint32  st_mainloops;               // main loop executions
+        uint32  st_ee_reads;                // FRAM read operations
+        uint32  st_ee_writes;               // FRAM write operations
+        uint64  st_ee_bytes_rd;             // FRAM bytes read
+        uint64  st_ee_bytes_wr;             // FRAM bytes written
+        uint64  st_ee_busy_us;              // FRAM SPI transfer and wake-up time in us
+        uint64  st_disp_on_ms;              // display powered while the electronics is on
+        uint64  st_sens_rh_ms;              // RH/Temp sensor power-up and conversion time
+        uint64  st_sens_p_ms;               // pressure sensor conversion time
+        uint32  st_disp_updates;            // display updates requested by application
+        uint64  st_uart_bytes;              // bytes transmitted on UART
+
+        // display hooks - called by the DispHAL stubs if set ( see uiprof.c )
+        void    (*on_need_update)( uint32 X1, uint32 Y1, uint32 X2, uint32 Y2 );
+        void    (*on_disp_update)( const uint8 *gmem );
+    };
+
+    extern struct SHeadlessHW hl;
+
+    // set up the simulated hardware and map the FRAM content from file ( created erased if missing, NULL - erased FRAM in memory )
+    int  HL_Init( const char *eefile );
+    // make sure the FRAM content is written in file
+    int  HL_Flush( const char *eefile );
+    // advance the environment simulation with the given ms
+    void HL_InputAdvance( uint32 ms );
+    // returns true if the simulated sensors have conversion in progress
+    bool HL_SensorBusy( void );
+    // capture the UART output in file ( NULL - stop the capture )
+    int  HL_UartCapture( const char *file );
+    // push / release a button ( BTN_xxx ) - wakes up the CPU the same way as mainw::CPUWakeUpOnEvent()
+    void HL_ButtonSet( int btn, bool pressed );
+
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif // HW_HEADLESS_H
@@ -0,0 +1,605 @@
+/*
+ *  Headless simulator - runs the firmware faster than real time
+ *
+ *  The application is driven the same way as mainw::CPULoopSimulation() does
+ *  in the Qt simulator ( 1ms system ticks, 0.5sec RTC ticks ), but when the
+ *  CPU is stopped ( pm_hold_btn, pm_hold, pm_down ) and no sensor conversion
+ *  is in progress, the simulated time jumps directly to the RTC alarm set up by
+ *  core_pwr_setup_alarm(). Months of monitoring / recording can be simulated
+ *  in seconds.
+ *
+ *  usage: simu_headless [options]
+ *      -e file         FRAM image file ( mapped, every write goes to the file ), default: eeprom.dat
+ *      -s "Y-M-D h:m:s" start date/time, default: 2016-01-01 00:00:00
+ *      -d days         simulated time in days ( can be fractional ), default: 7
+ *      -m              start the monitoring
+ *      -t t:h:p        monitoring rates for temperature, humidity and pressure ( enum EUpdateTimings values )
+ *      -r i:e:r:p:s[:d]  set up and start recording task i, with task_elems e, sample_rate r,
+ *                      mempage p, size s and deadband d ( all decimal, see struct SRecTaskInstance )
+ *      -c mAh          battery capacity for the battery life projection, default: 600
+ *      -v              random walk on the environment values ( default: constant values )
+ *      -q              quiet - print only the summary
+ *      -x file         at the end export the recordings on the simulated UART in file ( see core_op_recording_export() )
+ *      -l file         start the telemetry stream and capture the simulated UART in file ( see telemetry.h ). A raw
+ *                      pseudo-terminal can be given to feed the host decoder live ( recread -l ). With -u the
+ *                      stream is only captured, the script starts it from the setup menu
+ *      -b name         run a host benchmark instead of the simulation ( see bench.c )
+ *      -p              legacy sensor timing - pressure conversion is waited in sleep mode with the
+ *                      system tick instead of stop mode with the data ready line
+ *      -u script       push the keys from the script file ( "tour" - built in ) and report the display
+ *                      updates per ui screen ( see uiprof.c ). Without -d the simulation ends
+ *                      shortly after the script
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hw_headless.h"
+#include "core.h"
+#include "events_ui.h"
+#include "utilities.h"
+#include "bench.h"
+#include "uiprof.h"
+#include "energy.h"
+
+
+#define HL_DEFAULT_DAYS     7
+#define HL_MAX_REC_TASKS    STORAGE_RECTASK
+#define HL_UIPROF_TAIL_MS   2000            // simulated time after the ui script
+
+extern struct SCore core;
+
+struct SHeadlessScenario
+{
+    const char  *eefile;
+    uint32      start;                      // RTC counter at start
+    uint64      duration;                   // simulated time in ms
+    bool        duration_set;               // duration given in command line
+    bool        monitoring;
+    int         moni_rate[3];               // monitoring rates for temp / rh / pressure ( enum EUpdateTimings, -1 - setup default )
+    uint32      rec_tasks;                  // bitmask with the tasks to be started
+    struct SRecTaskInstance task[HL_MAX_REC_TASKS];
+    bool        quiet;
+    const char  *bench;                     // benchmark to run
+    const char  *export_file;               // recording export stream captured at the end
+    const char  *telemetry_file;            // telemetry stream captured during the simulation
+    const char  *ui_script;                 // key script for the ui profiler
+    double      battery;                    // battery capacity in mAh for the life projection
+};
+
+static struct SHeadlessScenario scen;
+
+// wake-to-sleep latency of the power-ups from down, by the kind of the wake-up
+enum EWakeKind
+{
+    wk_full = 0,                            // nonvolatile structures loaded from FRAM
+    wk_warm,                                // sensors read without FRAM ( core warm wake-up )
+    wk_batt,                                // battery check only
+    wk_kinds
+};
+
+struct SWakeLatency
+{
+    bool        active;                     // power-up from down in progress
+    bool        warm;
+    uint64      start_ms;
+    uint64      start_run_ms;
+    uint64      start_ee_us;
+    uint32      count[wk_kinds];
+    uint64      ms[wk_kinds];               // simulated time from the power-up to the power down
+    uint64      max_ms[wk_kinds];
+    uint64      run_ms[wk_kinds];           // time in run mode
+    uint64      ee_us[wk_kinds];            // FRAM SPI busy time - the CPU waits for it in run mode
+};
+
+static struct SWakeLatency lat;
+
+
+static void local_print_usage( void )
+{
+    printf( "usage: simu_headless [-e eefile] [-s \"Y-M-D h:m:s\"] [-d days] [-m] [-t t:h:p] [-r idx:elems:rate:page:size[:deadband]] [-c mAh] [-v] [-q] [-x file] [-l file] [-b name] [-p] [-u script]\n" );
+    bench_list();
+}
+
+static int local_parse_date( const char *str, uint32 *counter )
+{
+    datestruct  sdate;
+    timestruct  stime;
+    int y, m, d, h, mn, s;
+
+    h = mn = s = 0;
+    if ( sscanf( str, "%d-%d-%d %d:%d:%d", &y, &m, &d, &h, &mn, &s ) < 3 )
+        return -1;
+
+    sdate.year = (uint16)y;
+    sdate.mounth = (uint8)m;
+    sdate.day = (uint8)d;
+    stime.hour = (uint8)h;
+    stime.minute = (uint8)mn;
+    stime.second = (uint8)s;
+
+    *counter = utils_convert_date_2_counter( &sdate, &stime );
+    return 0;
+}
+
+static int local_parse_args( int argc, char *argv[] )
+{
+    int i;
+    datestruct  sdate = { 2016, 1, 1 };
+    timestruct  stime = { 0, 0, 0, 0 };
+
+    memset( &scen, 0, sizeof(scen) );
+    scen.eefile     = "eeprom.dat";
+    scen.start      = utils_convert_date_2_counter( &sdate, &stime );
+    scen.duration   = (uint64)HL_DEFAULT_DAYS * 24 * 3600 * 1000;
+    scen.moni_rate[0] = scen.moni_rate[1] = scen.moni_rate[2] = -1;
+    scen.battery    = ENERGY_DEFAULT_BATTERY;
+
+    for ( i=1; i<argc; i++ )
+    {
+        if ( argv[i][0] != '-' )
+            return -1;
+
+        switch ( argv[i][1] )
+        {
+            case 'e':
+                if ( ++i == argc )
+                    return -1;
+                scen.eefile = argv[i];
+                break;
+            case 's':
+                if ( ++i == argc )
+                    return -1;
+                if ( local_parse_date( argv[i], &scen.start ) )
+                    return -1;
+                break;
+            case 'd':
+                if ( ++i == argc )
+                    return -1;
+                scen.duration = (uint64)( atof( argv[i] ) * 24 * 3600 * 1000 );
+                scen.duration_set = true;
+                break;
+            case 'm':
+                scen.monitoring = true;
+                break;
+            case 't':
+                if ( ++i == argc )
+                    return -1;
+                if ( sscanf( argv[i], "%d:%d:%d", &scen.moni_rate[0], &scen.moni_rate[1], &scen.moni_rate[2] ) != 3 )
+                    return -1;
+                break;
+            case 'r':
+            {
+                int idx, el, rate, page, size;
+                int deadband = 0;
+                if ( ++i == argc )
+                    return -1;
+                if ( sscanf( argv[i], "%d:%d:%d:%d:%d:%d", &idx, &el, &rate, &page, &size, &deadband ) < 5 )
+                    return -1;
+                if ( (idx < 0) || (idx >= HL_MAX_REC_TASKS) || (deadband < 0) || (deadband > CORE_REC_MAXDEADBAND) )
+                    return -1;
+                scen.task[idx].task_elems = (uint8)el;
+                scen.task[idx].sample_rate = (uint8)rate;
+                scen.task[idx].mempage = (uint8)page;
+                scen.task[idx].size = (uint8)size;
+                scen.task[idx].deadband = (uint8)deadband;
+                scen.rec_tasks |= (1 << idx);
+                break;
+            }
+            case 'c':
+                if ( ++i == argc )
+                    return -1;
+                scen.battery = atof( argv[i] );
+                if ( scen.battery <= 0 )
+                    return -1;
+                break;
+            case 'v':
+                hl.sens_vary = true;
+                break;
+            case 'q':
+                scen.quiet = true;
+                break;
+            case 'b':
+                if ( ++i == argc )
+                    return -1;
+                scen.bench = argv[i];
+                break;
+            case 'x':
+                if ( ++i == argc )
+                    return -1;
+                scen.export_file = argv[i];
+                break;
+            case 'l':
+                if ( ++i == argc )
+                    return -1;
+                scen.telemetry_file = argv[i];
+                break;
+            case 'p':
+                hl.sens_polled = true;
+                break;
+            case 'u':
+                if ( ++i == argc )
+                    return -1;
+                scen.ui_script = argv[i];
+                break;
+            default:
+                return -1;
+        }
+    }
+    return 0;
+}
+
+
+// apply the scenario after the nonvolatile setup is loaded - the same calls which the UI would make
+static void local_apply_scenario( void )
+{
+    int i;
+
+    core_set_clock_counter( scen.start );
+
+    for ( i=0; i<3; i++ )
+    {
+        if ( scen.moni_rate[i] >= 0 )
+            core_op_monitoring_rate( (enum ESensorSelect)(ss_thermo + i), (enum EUpdateTimings)scen.moni_rate[i] );
+    }
+    if ( scen.monitoring )
+        core_op_monitoring_switch( true );
+
+    if ( scen.rec_tasks )
+    {
+        core_op_recording_init();
+        for ( i=0; i<HL_MAX_REC_TASKS; i++ )
+        {
+            if ( scen.rec_tasks & (1<<i) )
+            {
+                core_op_recording_setup_task( i, &scen.task[i] );
+                core_op_recording_task_run( i, true );
+            }
+        }
+        core_op_recording_switch( true );
+    }
+    if ( scen.telemetry_file && (scen.ui_script == NULL) )
+        core_op_telemetry_switch( true );       // with a ui script the stream is started from the setup menu
+    core.nv.dirty = true;
+}
+
+
+// one ms of simulated time - follows mainw::CPULoopSimulation() with tick = true
+static void local_simulate_ms( void )
+{
+    int j;
+
+    HL_InputAdvance( 1 );
+
+    // process application loop
+    if ( (hl.PwrMode == pm_sleep) || (hl.PwrMode == pm_full) )
+    {
+        for ( j=0; j<HL_FULL_LOOPS; j++ )
+        {
+            if ( scen.ui_script )
+                uiprof_loop_start();
+            main_loop();
+            if ( scen.ui_script )
+                uiprof_loop_end();
+            hl.st_mainloops++;
+
+            if ( hl.PwrMode >= pm_sleep )
+                break;
+        }
+    }
+
+    if ( lat.active && (hl.PwrMode == pm_down) )
+    {
+        enum EWakeKind kind = core.vstatus.int_op.f.nv_initted ? wk_full : (lat.warm ? wk_warm : wk_batt);
+        uint64 ms = hl.sim_ms - lat.start_ms;
+
+        lat.active = false;
+        lat.count[kind]++;
+        lat.ms[kind] += ms;
+        lat.run_ms[kind] += hl.st_mode_ms[pm_full] - lat.start_run_ms;
+        lat.ee_us[kind] += hl.st_ee_busy_us - lat.start_ee_us;
+        if ( lat.max_ms[kind] < ms )
+            lat.max_ms[kind] = ms;
+    }
+
+    hl.st_mode_ms[ hl.PwrMode ]++;
+    if ( hl.disp_on )
+    {
+        if ( hl.PwrMode == pm_down )
+            hl.disp_on = false;                 // main supply is cut
+        else
+            hl.st_disp_on_ms++;
+    }
+    if ( scen.ui_script )
+        uiprof_account( hl.PwrMode, 1 );
+    hl.sim_ms++;
+
+    // process clocks
+    if ( hl.PwrWUR == WUR_FIRST )
+        return;
+
+    hl.sec_ctr++;
+
+    // increment RTC and check for alarms
+    if ( hl.sec_ctr == HL_MS_PER_RTC )
+    {
+        hl.sec_ctr = 0;
+        hl.RTCcounter++;
+        if ( hl.RTCcounter == hl.RTCalarm )
+        {
+            bool sched = ( core.nf.next_schedule <= hl.RTCcounter );   // a sensor slot is due - not only the battery check
+
+            if ( hl.PwrMode == pm_down )        // electronics is just waking up - start it all from the beginning
+            {
+                hl.PwrWUR = WUR_RTC;
+                hl.st_resets++;
+                lat.active = true;
+                lat.start_ms = hl.sim_ms;
+                lat.start_run_ms = hl.st_mode_ms[pm_full];
+                lat.start_ee_us = hl.st_ee_busy_us;
+                main_entry( NULL );
+                lat.warm = core.vstatus.int_op.f.warm;
+            }
+            else
+                TimerRTCIntrHandler();
+
+            if ( (hl.PwrMode == pm_down) || (hl.PwrMode == pm_hold_btn) || (hl.PwrMode == pm_hold) )
+            {
+                hl.PwrWUR = WUR_RTC;
+                hl.st_wakeups++;
+                hl.st_wake_rtc++;
+                if ( sched )
+                    hl.st_wake_sched++;
+            }
+            hl.PwrMode = pm_full;
+        }
+    }
+
+    // process system timer
+    if ( (hl.PwrMode == pm_sleep) || (hl.PwrMode == pm_full) )
+    {
+        TimerSysIntrHandler();
+        hl.PwrMode = pm_full;
+    }
+
+    if ( hl.PwrMode != pm_down )
+    {
+        if ( Sensor_simu_poll() )
+        {
+            if ( (hl.PwrMode == pm_hold_btn) || (hl.PwrMode == pm_hold) )
+            {
+                hl.st_wakeups++;
+                hl.st_wake_sens++;
+            }
+            hl.PwrWUR |= WUR_SENS_IRQ;
+            hl.PwrMode = pm_full;
+        }
+    }
+}
+
+
+// skip the idle time when CPU is stopped - returns the skipped ms
+static uint64 local_skip_idle( uint64 end_ms )
+{
+    uint64 skip;
+
+    if ( (hl.PwrMode < pm_hold_btn) || (hl.PwrMode > pm_down) || HL_SensorBusy() || (hl.PwrWUR == WUR_FIRST) )
+        return 0;
+
+    if ( hl.RTCalarm <= hl.RTCcounter )
+    {
+        // alarm is not reachable ( turned off device ) - nothing will happen till the end
+        skip = end_ms - hl.sim_ms;
+    }
+    else
+    {
+        // go to 1ms before the alarm - the alarm itself is handled by the normal tick
+        skip = (uint64)(hl.RTCalarm - hl.RTCcounter - 1) * HL_MS_PER_RTC + (HL_MS_PER_RTC - 1 - hl.sec_ctr);
+        if ( skip > (end_ms - hl.sim_ms) )
+            skip = end_ms - hl.sim_ms;
+    }
+
+    if ( skip == 0 )
+        return 0;
+
+    // advance the clocks
+    {
+        uint64 tot_ms = hl.sec_ctr + skip;
+        hl.RTCcounter += (uint32)( tot_ms / HL_MS_PER_RTC );
+        hl.sec_ctr     = (int)( tot_ms % HL_MS_PER_RTC );
+    }
+
+    HL_InputAdvance( (uint32)skip );
+    hl.st_mode_ms[ hl.PwrMode ] += skip;
+    if ( hl.disp_on && (hl.PwrMode != pm_down) )
+        hl.st_disp_on_ms += skip;
+    if ( scen.ui_script )
+        uiprof_account( hl.PwrMode, skip );
+    hl.sim_ms += skip;
+    return skip;
+}
+
+
+static void local_print_time( const char *label, uint32 counter )
+{
+    uint8  mounth, day, hour, minute, second;
+    uint16 year;
+
+    utils_convert_counter_2_hms( counter, &hour, &minute, &second );
+    utils_convert_counter_2_ymd( counter, &year, &mounth, &day );
+    printf( "%s%04d-%02d-%02d %02d:%02d:%02d\n", label, year, mounth, day, hour, minute, second );
+}
+
+static void local_print_summary( double wall )
+{
+    static const char *pmname[] = { "full", "sleep", "hold_btn", "hold", "down" };
+    int     i;
+    double  hours = (double)hl.sim_ms / 3600000.0;
+
+    printf( "\n--- simulation summary ---\n" );
+    local_print_time( "end time:        ", hl.RTCcounter );
+    printf( "simulated:       %.2f hours in %.3f seconds ( x%.0f )\n", hours, wall, (wall > 0) ? (hl.sim_ms / 1000.0) / wall : 0.0 );
+    printf( "main loops:      %u\n", hl.st_mainloops );
+    printf( "wake-ups:        %u ( %.1f / hour ), power-up from down: %u\n", hl.st_wakeups, (hours > 0) ? hl.st_wakeups / hours : 0.0, hl.st_resets );
+    printf( "  rtc alarm      %12u     %8.1f / hour ( sensor schedule %u, battery check only %u )\n", hl.st_wake_rtc, (hours > 0) ? hl.st_wake_rtc / hours : 0.0,
+                                                    hl.st_wake_sched, hl.st_wake_rtc - hl.st_wake_sched );
+    for ( i=0; i<wk_kinds; i++ )
+    {
+        static const char *wkname[] = { "full", "warm", "battery" };
+
+        if ( lat.count[i] )
+            printf( "  %-8s wake   %12u     to down: avg %6.1f ms, max %6llu ms,  run %5.2f ms + FRAM SPI %5.3f ms\n", wkname[i], lat.count[i],
+                                                    (double)lat.ms[i] / lat.count[i], lat.max_ms[i], (double)lat.run_ms[i] / lat.count[i],
+                                                    lat.ee_us[i] / 1000.0 / lat.count[i] );
+    }
+    printf( "  sensor irq     %12u     %8.1f / hour\n", hl.st_wake_sens, (hours > 0) ? hl.st_wake_sens / hours : 0.0 );
+    printf( "  button         %12u     %8.1f / hour\n", hl.st_wakeups - hl.st_wake_rtc - hl.st_wake_sens,
+                                                    (hours > 0) ? (hl.st_wakeups - hl.st_wake_rtc - hl.st_wake_sens) / hours : 0.0 );
+    for ( i=0; i<=pm_down; i++ )
+        printf( "  %-10s     %12llu ms  %6.2f%%\n", pmname[i], hl.st_mode_ms[i], hl.sim_ms ? (100.0 * hl.st_mode_ms[i]) / hl.sim_ms : 0.0 );
+    printf( "FRAM:            %u reads ( %llu bytes ), %u writes ( %llu bytes ), SPI busy %.1f ms\n", hl.st_ee_reads, hl.st_ee_bytes_rd, hl.st_ee_writes, hl.st_ee_bytes_wr, hl.st_ee_busy_us / 1000.0 );
+    printf( "display updates: %u\n", hl.st_disp_updates );
+    energy_report( scen.battery );
+    printf( "monitoring:      %s,  recording: %s\n", core.nv.op.op_flags.b.op_monitoring ? "on" : "off",
+                                                    core.nv.op.op_flags.b.op_recording ? "on" : "off" );
+    for ( i=0; i<STORAGE_RECTASK; i++ )
+    {
+        if ( core.nvrec.running & (1<<i) )
+            printf( "  task %d:        elems[0x%X] rate[%d] deadband[%d] - %d samples stored\n", i, core.nvrec.task[i].task_elems,
+                                                     core.nvrec.task[i].sample_rate, core.nvrec.task[i].deadband, core.nvrec.func[i].c );
+    }
+}
+
+
+int main( int argc, char *argv[] )
+{
+    uint64  end_ms;
+    uint32  last_day;
+    uint64  tlm_bytes = 0;
+    bool    scen_applied = false;
+    clock_t wall_start;
+
+    memset( &hl, 0, sizeof(hl) );
+    if ( local_parse_args( argc, argv ) )
+    {
+        local_print_usage();
+        return 1;
+    }
+
+    if ( scen.bench )
+    {
+        if ( bench_run( scen.bench ) == 0 )
+            return 0;
+        local_print_usage();
+        return 1;
+    }
+
+    {
+        bool vary = hl.sens_vary;
+        bool polled = hl.sens_polled;
+        if ( HL_Init( scen.eefile ) )
+        {
+            printf( "can not load FRAM image: %s\n", scen.eefile );
+            return 1;
+        }
+        hl.sens_vary = vary;
+        hl.sens_polled = polled;
+    }
+    srand( 0x64892354 );
+
+    if ( scen.telemetry_file && HL_UartCapture( scen.telemetry_file ) )
+    {
+        printf( "can not open telemetry file: %s\n", scen.telemetry_file );
+        return 1;
+    }
+
+    if ( scen.ui_script )
+    {
+        if ( uiprof_load( scen.ui_script ) )
+            return 1;
+        if ( scen.duration_set == false )
+            scen.duration = uiprof_length() + HL_UIPROF_TAIL_MS;
+    }
+
+    wall_start = clock();
+    end_ms = scen.duration;
+
+    // first start-up - the same as pushing the power button in the Qt simulator
+    hl.PwrMode = pm_full;
+    main_entry( NULL );
+
+    last_day = 0;
+    while ( hl.sim_ms < end_ms )
+    {
+        if ( (scen_applied == false) && core.vstatus.int_op.f.nv_initted )
+        {
+            local_apply_scenario();
+            scen_applied = true;
+            last_day = hl.RTCcounter / DAY_TICKS;
+            if ( scen.quiet == false )
+                local_print_time( "start time:      ", hl.RTCcounter );
+        }
+
+        if ( scen.ui_script )
+        {
+            uint64 next;
+
+            uiprof_events();
+            next = uiprof_next_event();
+            if ( local_skip_idle( (next < end_ms) ? next : end_ms ) )
+                continue;
+        }
+        else if ( local_skip_idle( end_ms ) )
+            continue;
+
+        local_simulate_ms();
+
+        if ( (scen.quiet == false) && scen_applied && (hl.RTCcounter / DAY_TICKS != last_day) )
+        {
+            last_day = hl.RTCcounter / DAY_TICKS;
+            local_print_time( "  ", hl.RTCcounter );
+        }
+    }
+
+    if ( scen.telemetry_file )
+    {
+        core_op_telemetry_switch( false );
+        HL_UartCapture( NULL );
+        tlm_bytes = hl.st_uart_bytes;
+    }
+
+    // leave the device in the state it would be when turned off
+    core_nvfast_save_struct();
+    if ( core.vstatus.int_op.f.nv_initted == 0 )
+        core_setup_load( false );           // device is down - fetch the saved status for the summary
+
+    local_print_summary( (double)(clock() - wall_start) / CLOCKS_PER_SEC );
+    if ( scen.ui_script )
+        uiprof_report();
+    if ( scen.telemetry_file )
+        printf( "telemetry:       %llu bytes to %s\n", tlm_bytes, scen.telemetry_file );
+
+    if ( scen.export_file )
+    {
+        uint64 sent = hl.st_uart_bytes;
+
+        if ( HL_UartCapture( scen.export_file ) )
+        {
+            printf( "can not open export file: %s\n", scen.export_file );
+            return 1;
+        }
+        core_op_recording_export();
+        HL_UartCapture( NULL );
+        printf( "export:          %llu bytes to %s\n", hl.st_uart_bytes - sent, scen.export_file );
+    }
+
+    if ( HL_Flush( scen.eefile ) )
+    {
+        printf( "can not save FRAM image: %s\n", scen.eefile );
+        return 1;
+    }
+    return 0;
+}
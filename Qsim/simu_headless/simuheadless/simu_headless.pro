@@ -0,0 +1,73 @@
+#-------------------------------------------------
+#
+# Headless simulator - firmware without GUI, time is
+# skipped when CPU is stopped
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = simu_headless
+CONFIG   += console
+CONFIG   -= app_bundle
+CONFIG   -= qt
+
+TEMPLATE = app
+
+DEFINES += ON_QT_PLATFORM
+
+INCLUDEPATH += ../../../Prog/Project/MainProject/ \
+               ../../../Prog/Project/MainProject/func/  \
+               ../../../Prog/Project/MainProject/graphic_lib/ \
+               ../../../Qsim/simu_hygro/simuhygro
+
+
+SOURCES += main.c \
+    hw_headless.c \
+    bench.c \
+    uiprof.c \
+    energy.c \
+    ../../../Prog/Project/MainProject/func/events_ui.c \
+    ../../../Prog/Project/MainProject/mainapp.c \
+    ../../../Prog/Project/MainProject/func/ui.c \
+    ../../../Prog/Project/MainProject/func/core.c \
+    ../../../Prog/Project/MainProject/func/ui_elements.c \
+    ../../../Prog/Project/MainProject/graphic_lib/graphic_lib.c \
+    ../../../Prog/Project/MainProject/func/ui_graphics.c \
+    ../../../Prog/Project/MainProject/func/utilities.c \
+    ../../../Prog/Project/MainProject/func/ui_internals.c \
+    ../../../Prog/Project/MainProject/func/psychro.c \
+    ../../../Prog/Project/MainProject/func/recagg.c \
+    ../../../Prog/Project/MainProject/func/recdelta.c \
+    ../../../Prog/Project/MainProject/func/recpack.c \
+    ../../../Prog/Project/MainProject/func/crc16.c \
+    ../../../Prog/Project/MainProject/func/telemetry.c
+
+# MinGW provides itoa() - use the firmware's implementation on other hosts
+!win32: SOURCES += ../../../Prog/Project/MainProject/hw/stdlib_extension.c
+
+LIBS += -lm
+
+HEADERS  += hw_headless.h \
+    bench.h \
+    uiprof.h \
+    energy.h \
+    ../../../Qsim/simu_hygro/simuhygro/stm32f10x.h \
+    ../../../Qsim/simu_hygro/simuhygro/hw_stuff.h \
+    ../../../Prog/Project/MainProject/typedefs.h \
+    ../../../Prog/Project/MainProject/func/events_ui.h \
+    ../../../Prog/Project/MainProject/func/ui.h \
+    ../../../Prog/Project/MainProject/func/ui_internals.h \
+    ../../../Prog/Project/MainProject/func/core.h \
+    ../../../Prog/Project/MainProject/func/ui_elements.h \
+    ../../../Prog/Project/MainProject/func/eeprom_spi.h \
+    ../../../Prog/Project/MainProject/graphic_lib_user.h \
+    ../../../Prog/Project/MainProject/func/ui_graphics.h \
+    ../../../Prog/Project/MainProject/func/dispHAL.h \
+    ../../../Prog/Project/MainProject/func/utilities.h \
+    ../../../Prog/Project/MainProject/func/psychro.h \
+    ../../../Prog/Project/MainProject/func/recagg.h \
+    ../../../Prog/Project/MainProject/func/recdelta.h \
+    ../../../Prog/Project/MainProject/func/recpack.h \
+    ../../../Prog/Project/MainProject/func/crc16.h \
+    ../../../Prog/Project/MainProject/func/telemetry.h
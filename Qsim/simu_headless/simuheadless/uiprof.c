@@ -0,0 +1,472 @@
+/*
+ *  UI frame profiler for the headless simulator
+ *
+ *  Drives the UI state machine with a scripted key sequence ( the buttons are
+ *  pushed the same way as from the Qt simulator, the events module makes the
+ *  SEventStruct key events from them ) and collects for every display update:
+ *      - host time from the start of the main loop till DispHAL_UpdateScreen()
+ *      - pixels changed in the graphic memory since the previous update
+ *      - DispHAL_NeedUpdate() calls, their area and the SPI bytes which the
+ *        page span update of dispHAL.c would send
+ *  The frames are grouped by ui state ( set-up windows by their sub-state ) and
+ *  by the redraw type of the update ( see RDRW_xxx ). The simulated time spent in
+ *  each power mode is accounted also per ui state - this shows which screens
+ *  keep the MCU out of the sleep modes.
+ *
+ *  Script format - one command per line, '#' starts a comment:
+ *      wait <ms>                   - let the simulation run
+ *      <key> [hold_ms]             - push a key ( mode, ok, esc, up, down, left, right )
+ *                                    for hold_ms ( default 100ms ), then wait 300ms
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <time.h>
+#endif
+
+#include "hw_headless.h"
+#include "uiprof.h"
+#include "graphic_lib.h"
+#include "ui_internals.h"
+
+
+extern struct SUIstatus ui;
+
+
+#define UIPROF_MAX_EVENTS   2048
+#define UIPROF_HOLD_MS      100             // default key hold time
+#define UIPROF_GAP_MS       300             // time after the key release
+
+#define UIPROF_ROW_SET      (UI_STATE_DBG_INPUTS + 1)               // set-up windows are listed by their sub-state
+#define UIPROF_ROWS         (UIPROF_ROW_SET + UI_SET_SetupTime + 1)
+
+enum EUIProfRedraw
+{
+    uprd_content = 0,                       // RDRW_UI_CONTENT - full ui content ( state entries also )
+    uprd_dynamic,                           // RDRW_UI_DYNAMIC - dynamic elements only
+    uprd_status,                            // status bar only
+    uprd_flush,                             // no redraw flag - only the display update
+    uprd_count
+};
+
+struct SUIProfEvent
+{
+    uint64  at;                             // simulated ms
+    uint8   btn;
+    uint8   pressed;
+};
+
+struct SUIProfFrame
+{
+    uint32  frames;
+    double  host_ns;
+    double  host_max_ns;
+    uint64  pixels;                         // changed pixels
+    uint32  nu_calls;                       // DispHAL_NeedUpdate() calls
+    uint64  nu_area;                        // pixels in the update areas
+    uint64  spi_bytes;                      // bytes sent with page span update
+};
+
+static struct
+{
+    struct SUIProfEvent ev[UIPROF_MAX_EVENTS];
+    uint32  ev_nr;
+    uint32  ev_idx;
+    uint64  length;                         // script length in ms
+
+    double  loop_start;                     // host time of the current main loop start
+    double  frame_start;                    // host time from where the current frame is measured
+    uint32  nu_calls;                       // need update calls for the pending frame
+    uint64  nu_area;
+    int     span_start[GDISP_MAX_MEM_H];
+    int     span_end[GDISP_MAX_MEM_H];
+    uint8   prev[GDISP_MAX_MEMORY];
+
+    struct SUIProfFrame fr[UIPROF_ROWS][uprd_count];
+    uint64  res_ms[UIPROF_ROWS][pm_down+1];
+    uint32  loops[UIPROF_ROWS];             // main loops executed
+    double  loop_ns[UIPROF_ROWS];           // host time of the main loops
+} up;
+
+static const char *row_names[UIPROF_ROWS] = { "none", "startup", "gauge", "graph", "altimeter", "setwindow", "mode select",
+                                              "shutdown", "popup", "debug inputs",
+                                              "set: none", "set: graph select", "set: quick switch", "set: rec. task",
+                                              "set: rec. memory", "set: setup menu", "set: display", "set: time" };
+
+static const char *redraw_names[uprd_count] = { "content", "dynamic", "status", "flush" };
+
+static const struct
+{
+    const char *name;
+    int btn;
+} key_names[] = { { "mode", BTN_MODE }, { "ok", BTN_OK }, { "esc", BTN_ESC }, { "up", BTN_UP },
+                  { "down", BTN_DOWN }, { "left", BTN_LEFT }, { "right", BTN_RIGHT } };
+
+// power on and walk through the main screens - gauges, mode selector, quick switch, graph select, setup menu
+static const char tour_script[] =
+    "wait 3000\nmode 1500\nwait 2000\n"                                // power on with long press
+    "right\nwait 2000\nright\nwait 2000\nleft\nleft\nwait 2000\n"       // thermo - hygro - pressure gauges
+    "ok\nwait 1000\nright\nright\nesc\nwait 1000\n"                     // gauge focus
+    "mode\nwait 1000\nleft\nwait 1000\ndown\ndown\nup\nesc\nwait 1000\n" // mode selector - quick switch
+    "right\nwait 1000\nok\nwait 3000\n"                                 // graph select - first recording task if any
+    "right\nright\nleft\nwait 1000\nesc\nwait 1000\nesc\nwait 1000\n"
+    "ok\nwait 1000\ndown\ndown\nup\nup\nesc\nwait 1000\n"             // setup menu
+    "up\nwait 10000\n";                                               // back to the gauge, idle with screen on
+
+
+static double internal_host_ns( void )
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER ctr;
+
+    if ( freq.QuadPart == 0 )
+        QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &ctr );
+    return (double)ctr.QuadPart * 1e9 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+#endif
+}
+
+static int internal_row( void )
+{
+    if ( (ui.m_state == UI_STATE_SETWINDOW) && (ui.m_setstate <= UI_SET_SetupTime) )
+        return UIPROF_ROW_SET + ui.m_setstate;
+    if ( ui.m_state <= UI_STATE_DBG_INPUTS )
+        return ui.m_state;
+    return UI_STATE_NONE;
+}
+
+static enum EUIProfRedraw internal_redraw_type( uint32 redraw )
+{
+    if ( redraw & RDRW_UI_CONTENT )
+        return uprd_content;
+    if ( redraw & RDRW_UI_DYNAMIC )
+        return uprd_dynamic;
+    if ( redraw & RDRW_STATUSBAR )
+        return uprd_status;
+    return uprd_flush;
+}
+
+static void internal_spans_reset( void )
+{
+    int i;
+
+    for ( i=0; i<GDISP_MAX_MEM_H; i++ )
+    {
+        up.span_start[i] = GDISP_WIDTH;
+        up.span_end[i] = -1;
+    }
+    up.nu_calls = 0;
+    up.nu_area = 0;
+}
+
+static uint32 internal_popcount( uint8 val )
+{
+    uint32 cnt = 0;
+
+    while ( val )
+    {
+        val &= val - 1;
+        cnt++;
+    }
+    return cnt;
+}
+
+
+/////////////////////////////////////////////////////
+// display hooks
+/////////////////////////////////////////////////////
+
+static void uiprof_need_update( uint32 X1, uint32 Y1, uint32 X2, uint32 Y2 )
+{
+    int x1 = (int)X1, y1 = (int)Y1, x2 = (int)X2, y2 = (int)Y2;
+    int tmp;
+    int page;
+
+    if ( x1 > x2 ) { tmp = x1; x1 = x2; x2 = tmp; }
+    if ( y1 > y2 ) { tmp = y1; y1 = y2; y2 = tmp; }
+    if ( (x2 < 0) || (y2 < 0) || (x1 >= GDISP_WIDTH) || (y1 >= GDISP_HEIGHT) )
+        return;
+    if ( x1 < 0 ) x1 = 0;
+    if ( y1 < 0 ) y1 = 0;
+    if ( x2 >= GDISP_WIDTH ) x2 = GDISP_WIDTH - 1;
+    if ( y2 >= GDISP_HEIGHT ) y2 = GDISP_HEIGHT - 1;
+
+    up.nu_calls++;
+    up.nu_area += (uint64)(x2 - x1 + 1) * (y2 - y1 + 1);
+
+    for ( page = (y1 >> 3); page <= (y2 >> 3); page++ )
+    {
+        if ( up.span_start[page] > x1 )
+            up.span_start[page] = x1;
+        if ( up.span_end[page] < x2 )
+            up.span_end[page] = x2;
+    }
+}
+
+static void uiprof_disp_update( const uint8 *gmem )
+{
+    struct SUIProfFrame *fr;
+    double now = internal_host_ns();
+    double ns = now - up.frame_start;
+    int i;
+
+    fr = &up.fr[ internal_row() ][ internal_redraw_type( ui.upd_last ) ];
+    fr->frames++;
+    fr->host_ns += ns;
+    if ( fr->host_max_ns < ns )
+        fr->host_max_ns = ns;
+    fr->nu_calls += up.nu_calls;
+    fr->nu_area += up.nu_area;
+
+    for ( i=0; i<GDISP_MAX_MEM_H; i++ )
+    {
+        if ( up.span_start[i] <= up.span_end[i] )
+            fr->spi_bytes += 3 + (up.span_end[i] - up.span_start[i] + 1);       // page / column address + data
+    }
+
+    if ( gmem )
+    {
+        for ( i=0; i<GDISP_MAX_MEMORY; i++ )
+            fr->pixels += internal_popcount( gmem[i] ^ up.prev[i] );
+        memcpy( up.prev, gmem, GDISP_MAX_MEMORY );
+    }
+
+    internal_spans_reset();
+    up.frame_start = internal_host_ns();    // a second update in the same loop is measured from here
+}
+
+
+/////////////////////////////////////////////////////
+// script
+/////////////////////////////////////////////////////
+
+static int internal_add_event( uint64 at, int btn, bool pressed )
+{
+    if ( up.ev_nr == UIPROF_MAX_EVENTS )
+        return -1;
+    up.ev[up.ev_nr].at = at;
+    up.ev[up.ev_nr].btn = (uint8)btn;
+    up.ev[up.ev_nr].pressed = pressed;
+    up.ev_nr++;
+    return 0;
+}
+
+static int internal_parse_line( char *line, uint64 *time )
+{
+    char    cmd[32];
+    int     val;
+    int     args;
+    int     i;
+    char    *ptr;
+
+    ptr = strchr( line, '#' );
+    if ( ptr )
+        *ptr = 0;
+
+    args = sscanf( line, "%31s %d", cmd, &val );
+    if ( args < 1 )
+        return 0;                           // empty line
+
+    if ( strcmp( cmd, "wait" ) == 0 )
+    {
+        if ( (args != 2) || (val < 0) )
+            return -1;
+        *time += val;
+        return 0;
+    }
+
+    for ( i=0; i<(int)(sizeof(key_names)/sizeof(key_names[0])); i++ )
+    {
+        if ( strcmp( cmd, key_names[i].name ) == 0 )
+        {
+            if ( args < 2 )
+                val = UIPROF_HOLD_MS;
+            if ( val <= 0 )
+                return -1;
+            if ( internal_add_event( *time, key_names[i].btn, true ) ||
+                 internal_add_event( *time + val, key_names[i].btn, false ) )
+                return -1;
+            *time += val + UIPROF_GAP_MS;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int internal_parse_script( const char *text, const char *name )
+{
+    char    line[128];
+    uint64  time = hl.sim_ms;
+    int     lnr = 0;
+
+    while ( *text )
+    {
+        const char *end = strchr( text, '\n' );
+        size_t len = end ? (size_t)(end - text) : strlen( text );
+
+        if ( len >= sizeof(line) )
+            len = sizeof(line) - 1;
+        memcpy( line, text, len );
+        line[len] = 0;
+        lnr++;
+
+        if ( internal_parse_line( line, &time ) )
+        {
+            printf( "%s:%d: invalid command: %s\n", name, lnr, line );
+            return -1;
+        }
+        text = end ? end + 1 : text + len;
+    }
+
+    up.length = time;
+    return 0;
+}
+
+int uiprof_load( const char *script )
+{
+    int res;
+
+    memset( &up, 0, sizeof(up) );
+    internal_spans_reset();
+
+    if ( strcmp( script, "tour" ) == 0 )
+        res = internal_parse_script( tour_script, script );
+    else
+    {
+        FILE    *f;
+        char    *text;
+        long    size;
+
+        f = fopen( script, "rb" );
+        if ( f == NULL )
+        {
+            printf( "can not open ui script: %s\n", script );
+            return -1;
+        }
+        fseek( f, 0, SEEK_END );
+        size = ftell( f );
+        fseek( f, 0, SEEK_SET );
+
+        text = (char*)malloc( size + 1 );
+        if ( (text == NULL) || (fread( text, 1, size, f ) != (size_t)size) )
+        {
+            fclose( f );
+            free( text );
+            return -1;
+        }
+        text[size] = 0;
+        fclose( f );
+
+        res = internal_parse_script( text, script );
+        free( text );
+    }
+
+    if ( res )
+        return -1;
+
+    hl.on_need_update = uiprof_need_update;
+    hl.on_disp_update = uiprof_disp_update;
+    return 0;
+}
+
+uint64 uiprof_length( void )
+{
+    return up.length;
+}
+
+uint64 uiprof_next_event( void )
+{
+    if ( up.ev_idx == up.ev_nr )
+        return UIPROF_NO_EVENT;
+    return up.ev[up.ev_idx].at;
+}
+
+void uiprof_events( void )
+{
+    while ( (up.ev_idx < up.ev_nr) && (up.ev[up.ev_idx].at <= hl.sim_ms) )
+    {
+        HL_ButtonSet( up.ev[up.ev_idx].btn, up.ev[up.ev_idx].pressed );
+        up.ev_idx++;
+    }
+}
+
+void uiprof_loop_start( void )
+{
+    up.loop_start = internal_host_ns();
+    up.frame_start = up.loop_start;
+}
+
+void uiprof_loop_end( void )
+{
+    int row = internal_row();
+
+    up.loops[row]++;
+    up.loop_ns[row] += internal_host_ns() - up.loop_start;
+}
+
+void uiprof_account( int pwr_mode, uint64 ms )
+{
+    up.res_ms[ internal_row() ][ pwr_mode ] += ms;
+}
+
+
+/////////////////////////////////////////////////////
+// report
+/////////////////////////////////////////////////////
+
+void uiprof_report( void )
+{
+    static const char *pmname[] = { "full", "sleep", "hold_btn", "hold", "down" };
+    int r, t, i;
+
+    printf( "\n--- ui profile ---\n" );
+    printf( "%-18s %-8s %7s %10s %10s %10s %8s %10s %9s\n", "screen", "redraw", "frames", "avg us", "max us",
+                                                           "pixels", "upd.calls", "upd.area", "SPI bytes" );
+    for ( r=0; r<UIPROF_ROWS; r++ )
+    {
+        for ( t=0; t<uprd_count; t++ )
+        {
+            struct SUIProfFrame *fr = &up.fr[r][t];
+            if ( fr->frames == 0 )
+                continue;
+            printf( "%-18s %-8s %7u %10.1f %10.1f %10.1f %8.1f %10.1f %9.1f\n", row_names[r], redraw_names[t], fr->frames,
+                    fr->host_ns / fr->frames / 1000.0, fr->host_max_ns / 1000.0, (double)fr->pixels / fr->frames,
+                    (double)fr->nu_calls / fr->frames, (double)fr->nu_area / fr->frames, (double)fr->spi_bytes / fr->frames );
+        }
+    }
+    printf( "( host time from main loop start to display update, the rest are averages per frame )\n" );
+
+    printf( "\n%-18s", "residency [ms]" );
+    for ( i=0; i<=pm_down; i++ )
+        printf( " %10s", pmname[i] );
+    printf( " %8s %10s %10s %8s\n", "loops", "loop ms", "render ms", "full %" );
+    for ( r=0; r<UIPROF_ROWS; r++ )
+    {
+        uint64 tot = 0;
+        double render = 0;
+
+        for ( i=0; i<=pm_down; i++ )
+            tot += up.res_ms[r][i];
+        for ( t=0; t<uprd_count; t++ )
+            render += up.fr[r][t].host_ns;
+        if ( (tot == 0) && (up.loops[r] == 0) )
+            continue;
+
+        printf( "%-18s", row_names[r] );
+        for ( i=0; i<=pm_down; i++ )
+            printf( " %10llu", up.res_ms[r][i] );
+        printf( " %8u %10.3f %10.3f %8.2f\n", up.loops[r], up.loop_ns[r] / 1e6, render / 1e6,
+                tot ? (100.0 * up.res_ms[r][pm_full]) / tot : 0.0 );
+    }
+}
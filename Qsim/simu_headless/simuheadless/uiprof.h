@@ -0,0 +1,41 @@
+#ifndef UIPROF_H
+#define UIPROF_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "typedefs.h"
+
+    #define UIPROF_NO_EVENT     0xFFFFFFFFFFFFFFFFULL
+
+    // load the key script ( "tour" - built in walk through the main screens ) and hook the display.
+    // Returns 0 on success, -1 if the script can not be read or parsed
+    int  uiprof_load( const char *script );
+
+    // simulated ms at the end of the script
+    uint64 uiprof_length( void );
+
+    // simulated ms of the next scripted button change ( UIPROF_NO_EVENT if the script is finished )
+    uint64 uiprof_next_event( void );
+
+    // apply the button changes due at the current simulated time
+    void uiprof_events( void );
+
+    // to be called before each main_loop() - the redraw time is measured from here
+    void uiprof_loop_start( void );
+
+    // to be called after each main_loop() - host time of the loops is accounted for the current ui state
+    void uiprof_loop_end( void );
+
+    // account simulated time spent in the given power mode for the current ui state
+    void uiprof_account( int pwr_mode, uint64 ms );
+
+    // print the per screen report
+    void uiprof_report( void );
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif // UIPROF_H
@@ -97,6 +97,15 @@ void HW_LED_On();
 void TimerSysIntrHandler(void);
 void TimerRTCIntrHandler(void);
 
+void HW_UART_Start();
+void HW_UART_Stop();
+uint32 HW_UART_SendSingle( uint8 data );
+uint32 HW_UART_SendMulti( uint8 *data, uint32 size );
+uint32 HW_UART_SendDMA( uint8 *data, uint32 size );
+bool HW_UART_DMA_IsFinished();
+uint32 HW_UART_get_Checksum();
+void HW_UART_reset_Checksum();
+
 
 void HW_ASSERT();
 void HW_DBG_DUMP(struct SCore *core);
@@ -171,7 +180,10 @@ void HW_Buzzer_Off(void);
 #define VBAT_MAX        0x0fff                   // 3.1V
 #define VBAT_DIFF       ( VBAT_MAX - VBAT_MIN )
 
+#define TIMER_RTC_PRESCALE      ( ((32 * 1024) / 2) - 1 )   // 0.5sec pulses - RTC_GetDivider() counts down from it
+
 uint32 RTC_GetCounter(void);
+uint32 RTC_GetDivider(void);
 void RTC_SetAlarm(uint32);
 void RTC_WaitForSynchro(void);
 void RTC_SetCounter(uint32 RTCctr);
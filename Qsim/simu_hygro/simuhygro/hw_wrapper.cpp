@@ -1,3 +1,5 @@
+#include <QFile>
+
 #include "mainw.h"
 #include "ui_mainw.h"
 #include "hw_stuff.h"
@@ -22,7 +24,7 @@ char line[MAX_LINES*MAX_COLOUMNS];
 static bool disp_changed = false;
 /////////////////////////////////
 
-uint8 eeprom_cont[ EEPROM_SIZE ];
+uint8 *eeprom_cont = NULL;
 
 uint8 *dispmem = NULL;
 
@@ -166,6 +168,12 @@ uint32 RTC_GetCounter(void)
     return pClass->RTCcounter;
 }
 
+uint32 RTC_GetDivider(void)
+{
+    // sec_ctr counts the ms of the 0.5sec RTC tick
+    return TIMER_RTC_PRESCALE - ( (uint32)pClass->sec_ctr * (TIMER_RTC_PRESCALE + 1) ) / 500;
+}
+
 void RTC_SetAlarm(uint32 value)
 {
     pClass->RTCalarm = value;
@@ -192,6 +200,45 @@ uint32 HW_ADC_GetBattery(void)
 }
 
 
+// no serial port in the simulator - the transmitted data is dropped
+void HW_UART_Start()
+{
+}
+
+void HW_UART_Stop()
+{
+}
+
+uint32 HW_UART_SendSingle( uint8 data )
+{
+    return 1;
+}
+
+uint32 HW_UART_SendMulti( uint8 *data, uint32 size )
+{
+    return 1;
+}
+
+uint32 HW_UART_SendDMA( uint8 *data, uint32 size )
+{
+    return 1;
+}
+
+bool HW_UART_DMA_IsFinished()
+{
+    return true;
+}
+
+uint32 HW_UART_get_Checksum()
+{
+    return 0;
+}
+
+void HW_UART_reset_Checksum()
+{
+}
+
+
 void HW_PWR_An_On( void )
 {
 
@@ -485,86 +532,114 @@ void mainw::HW_wrapper_show_sensor_read( uint32 sensor, bool on )
 }
 
 /////////////////////////////////////////////////////
-// Sensor emulation
+// Sensor emulation - device model of func/sensors.c
+//
+//  Every I2C transfer is polled in PM_FULL ( it takes less than 1ms, accounted as one tick ),
+//  the RH/Temp power-up and conversion delays are counted on 1ms ticks in PM_SLEEP, the pressure
+//  one-shot conversion ends with the data ready line which wakes up the CPU from PM_HOLD.
 /////////////////////////////////////////////////////
 
-struct 
-{
-    int time_ctr_RH;            // result lag simulation for the Temp/RH sensor
-    int time_ctr_Press;         // result lag for Pressure sensor
-    bool RH_up;                 // if sensor is shut down - additional time is considered
-    bool Press_up;              //
-
-    uint32 ini_progress;        // sensor init in progress
-    uint32 in_progress;         // measurement in progress
-    uint32 ready;               // measurement is ready
-
+#define SENS_I2C_MS         1           // one I2C transfer
+#define SENS_P_CONV_MS      512         // pressure one-shot with 128x oversampling
+#define SENS_RH_POWERUP_MS  15
+#define SENS_RH_CONV_MS     29
+#define SENS_T_CONV_MS      85
+#define SENS_RH_POLL_MS     24          // first read-out attempt after the request ( see local_rhsensor_execute_read() )
+#define SENS_T_POLL_MS      80
+#define SENS_RETRY_MS       5           // read-out retry after NAK
+
+enum ESimuPSensor
+{
+    sp_off = 0,
+    sp_init,                            // set-up transfers
+    sp_idle,
+    sp_cmd,                             // one-shot command transfer
+    sp_conv,                            // conversion in progress, bus is free
+    sp_read                             // data ready line raised - result read-out transfer
+};
+
+enum ESimuRHSensor
+{
+    sr_off = 0,
+    sr_powerup,                         // power-up delay
+    sr_init,                            // user register read / write transfers
+    sr_idle,
+    sr_cmd,                             // measurement request transfer
+    sr_wait,                            // waiting for the read-out attempt, bus is free
+    sr_read                             // read-out transfer - NAK if the conversion is not finished
+};
+
+static struct
+{
+    enum ESimuPSensor   p;
+    enum ESimuRHSensor  r;
+    int     p_ctr;                      // ms left from the current pressure sensor phase
+    int     r_ctr;                      // ms left from the current RH sensor phase
+    int     r_conv;                     // ms left from the RH/Temp conversion inside the sensor
+    uint32  r_cur;                      // SENSOR_RH or SENSOR_TEMP in conversion
+
+    uint32  requested;                  // acquire requests not served yet
+    uint32  ready;                      // measurement is ready
 } sens;
 
 
+static bool internal_sens_bus_busy( void )
+{
+    return ( (sens.p == sp_init) || (sens.p == sp_cmd) || (sens.p == sp_read) ||
+             (sens.r == sr_init) || (sens.r == sr_cmd) || (sens.r == sr_read) );
+}
 
 void Sensor_Init()
 {
     memset( &sens, 0, sizeof(sens));
 
-    sens.ini_progress = SENSOR_PRESS | SENSOR_TEMP | SENSOR_RH;
-    sens.time_ctr_Press = 1;
-    sens.time_ctr_RH = 16;
+    sens.p = sp_init;
+    sens.p_ctr = SENS_I2C_MS;
+    sens.r = sr_powerup;
+    sens.r_ctr = SENS_RH_POWERUP_MS;
 }
 
 void Sensor_Shutdown( uint32 mask )
 {
-    if ( (mask & ( SENSOR_TEMP | SENSOR_RH )) == ( SENSOR_TEMP | SENSOR_RH ) )
+    if ( mask & (SENSOR_TEMP | SENSOR_RH) )
     {
-        sens.ready &= ~SENSOR_TEMP;
-        sens.ready &= ~SENSOR_RH;
-        sens.RH_up = false;
+        sens.ready &= ~(SENSOR_TEMP | SENSOR_RH);
+        sens.requested &= ~(SENSOR_TEMP | SENSOR_RH);
+        sens.r = sr_off;
     }
     if ( mask & SENSOR_PRESS )
     {
         sens.ready &= ~SENSOR_PRESS;
-        sens.Press_up = false;
+        sens.requested &= ~SENSOR_PRESS;
+        sens.p = sp_off;
     }
 }
 
 uint32 Sensor_Acquire( uint32 mask )
 {
-    if ( (mask & SENSOR_TEMP) && ((sens.in_progress & SENSOR_TEMP) == 0) )
+    mask &= (SENSOR_TEMP | SENSOR_RH | SENSOR_PRESS);
+
+    // sensors shut down are initialized again
+    if ( (mask & SENSOR_PRESS) && (sens.p == sp_off) )
     {
-        if ( sens.RH_up == false )
-            sens.time_ctr_RH = 16 + 85;      // 16ms start-up + 85ms read time
-        else
-            sens.time_ctr_RH = 85;           // 70ms read time
-        sens.RH_up = true;
-        sens.ini_progress &= ~(SENSOR_TEMP | SENSOR_RH);
-        sens.in_progress |= SENSOR_TEMP;
-        pClass->HW_wrapper_show_sensor_read( SENSOR_TEMP, true );
-        sens.ready &= ~SENSOR_TEMP;
+        sens.p = sp_init;
+        sens.p_ctr = SENS_I2C_MS;
     }
-    if ( (mask & SENSOR_RH) && ((sens.in_progress & SENSOR_RH) == 0) )
+    if ( (mask & (SENSOR_TEMP | SENSOR_RH)) && (sens.r == sr_off) )
     {
-        if ( sens.RH_up == false )
-            sens.time_ctr_RH = 16 + 29;      // 16ms start-up + 29ms read time
-        else
-            sens.time_ctr_RH = 29;           // 70ms read time
-        sens.RH_up = true;
-        sens.ini_progress &= ~(SENSOR_TEMP | SENSOR_RH);
-        sens.in_progress |= SENSOR_RH;
-        pClass->HW_wrapper_show_sensor_read( SENSOR_RH, true );
-        sens.ready &= ~SENSOR_RH;
+        sens.r = sr_powerup;
+        sens.r_ctr = SENS_RH_POWERUP_MS;
     }
-    if ( (mask & SENSOR_PRESS) && ((sens.in_progress & SENSOR_PRESS) == 0) )
-    {
-        if ( sens.Press_up == false )
-            sens.time_ctr_Press = 1 + 450;       // 2ms start-up + 450ms read time
-        else
-            sens.time_ctr_Press = 450;            // 450ms read time for 128x oversample
-        sens.Press_up = true;
-        sens.ini_progress &= ~SENSOR_PRESS;
-        sens.in_progress |= SENSOR_PRESS;
+
+    if ( mask & SENSOR_TEMP )
+        pClass->HW_wrapper_show_sensor_read( SENSOR_TEMP, true );
+    if ( mask & SENSOR_RH )
+        pClass->HW_wrapper_show_sensor_read( SENSOR_RH, true );
+    if ( mask & SENSOR_PRESS )
         pClass->HW_wrapper_show_sensor_read( SENSOR_PRESS, true );
-        sens.ready &= ~SENSOR_PRESS;
-    }
+
+    sens.ready &= ~mask;
+    sens.requested |= mask;
     return 0;
 }
 
@@ -575,7 +650,7 @@ uint32 Sensor_Is_Ready(void)
 
 uint32 Sensor_Is_Busy(void)
 {
-    return sens.in_progress;
+    return sens.requested;
 }
 
 uint32 Sensor_Is_Failed(void)
@@ -608,112 +683,151 @@ uint32 Sensor_Get_Value( uint32 sensor )
         default:
             return SENSOR_VALUE_FAIL;
     }
-    return SENSOR_VALUE_FAIL;
 }
 
-bool Sensor_simu_poll()
+static bool internal_sens_pressure_step( void )
 {
-    if ( sens.ini_progress & SENSOR_TEMP )
+    if ( sens.p_ctr )
+        sens.p_ctr--;
+
+    switch ( sens.p )
     {
-        if ( sens.time_ctr_RH == 0 )
-        {   
-            sens.ini_progress &= ~(SENSOR_TEMP| SENSOR_RH); 
-            sens.RH_up = true;
-        }
-        else
-            sens.time_ctr_RH --;
+        case sp_init:
+            if ( sens.p_ctr == 0 )
+                sens.p = sp_idle;
+            break;
+        case sp_cmd:
+            if ( sens.p_ctr == 0 )
+            {
+                sens.p = sp_conv;
+                sens.p_ctr = SENS_P_CONV_MS;
+            }
+            break;
+        case sp_conv:
+            if ( (sens.p_ctr == 0) && (internal_sens_bus_busy() == false) )
+            {
+                sens.p = sp_read;               // data ready line raised - CPU wakes up and reads the result
+                sens.p_ctr = SENS_I2C_MS;
+                return true;
+            }
+            break;
+        case sp_read:
+            if ( sens.p_ctr == 0 )
+            {
+                sens.p = sp_idle;
+                sens.requested &= ~SENSOR_PRESS;
+                sens.ready |= SENSOR_PRESS;
+            }
+            break;
+        default:
+            break;
     }
-    if ( sens.ini_progress & SENSOR_PRESS )
+
+    if ( (sens.p == sp_idle) && (sens.requested & SENSOR_PRESS) && (internal_sens_bus_busy() == false) )
     {
-        if ( sens.time_ctr_Press == 0 )
-        {   
-            sens.ini_progress &= ~SENSOR_PRESS; 
-            sens.Press_up = true;
-        }
-        else
-            sens.time_ctr_Press --;
+        sens.p = sp_cmd;
+        sens.p_ctr = SENS_I2C_MS;
     }
+    return false;
+}
 
+static void internal_sens_rh_step( void )
+{
+    if ( sens.r_ctr )
+        sens.r_ctr--;
+    if ( sens.r_conv )
+        sens.r_conv--;
 
-    if ( sens.in_progress & SENSOR_TEMP )
-    {
-        if ( sens.time_ctr_RH == 0 )
-        {
-            sens.in_progress &= ~SENSOR_TEMP;
-            sens.ready |= SENSOR_TEMP;
-        }
-        else
-            sens.time_ctr_RH--;
-    }
-    if ( sens.in_progress & SENSOR_RH )
+    switch ( sens.r )
     {
-        if ( sens.time_ctr_RH == 0 )
-        {
-            sens.in_progress &= ~SENSOR_RH;
-            sens.ready |= SENSOR_RH;
-        }
-        else
-            sens.time_ctr_RH--;
+        case sr_powerup:
+            if ( (sens.r_ctr == 0) && (internal_sens_bus_busy() == false) )
+            {
+                sens.r = sr_init;
+                sens.r_ctr = SENS_I2C_MS;
+            }
+            break;
+        case sr_init:
+            if ( sens.r_ctr == 0 )
+                sens.r = sr_idle;
+            break;
+        case sr_cmd:
+            if ( sens.r_ctr == 0 )
+            {
+                sens.r = sr_wait;
+                sens.r_ctr = (sens.r_cur == SENSOR_RH) ? SENS_RH_POLL_MS : SENS_T_POLL_MS;
+            }
+            break;
+        case sr_wait:
+            if ( (sens.r_ctr == 0) && (internal_sens_bus_busy() == false) )
+            {
+                sens.r = sr_read;
+                sens.r_ctr = SENS_I2C_MS;
+            }
+            break;
+        case sr_read:
+            if ( sens.r_ctr == 0 )
+            {
+                if ( sens.r_conv == 0 )
+                {
+                    sens.r = sr_idle;
+                    sens.requested &= ~sens.r_cur;
+                    sens.ready |= sens.r_cur;
+                }
+                else
+                {
+                    sens.r = sr_wait;           // NAK - conversion is not finished
+                    sens.r_ctr = SENS_RETRY_MS;
+                }
+            }
+            break;
+        default:
+            break;
     }
-    if ( sens.in_progress & SENSOR_PRESS )
+
+    // RH first, temperature after ( see _reload_operation in local_rhsensor_execute_read() )
+    if ( (sens.r == sr_idle) && (sens.requested & (SENSOR_RH | SENSOR_TEMP)) && (internal_sens_bus_busy() == false) )
     {
-        if ( sens.time_ctr_Press == 0 )
-        {
-            sens.in_progress &= ~SENSOR_PRESS;
-            sens.ready |= SENSOR_PRESS;
-            return true;
-        }
-        else
-            sens.time_ctr_Press--;
+        sens.r_cur = (sens.requested & SENSOR_RH) ? SENSOR_RH : SENSOR_TEMP;
+        sens.r_conv = (sens.r_cur == SENSOR_RH) ? SENS_RH_CONV_MS : SENS_T_CONV_MS;
+        sens.r = sr_cmd;
+        sens.r_ctr = SENS_I2C_MS;
     }
+}
 
-    return false;
+// advance the sensor model with 1ms - returns true when the pressure data ready line wakes up the CPU
+bool Sensor_simu_poll()
+{
+    bool irq;
+
+    irq = internal_sens_pressure_step();
+    internal_sens_rh_step();
+    return irq;
 }
 
 void Sensor_Poll(bool tick_ms)
 {
-
 }
 
 uint32 Sensor_GetPwrStatus(void)
 {
     uint32 pwr = PM_DOWN;
 
-    if ( sens.ini_progress & SENSOR_PRESS )
+    // bus transfers are polled
+    if ( internal_sens_bus_busy() )
+        return PM_FULL;
+    // requested operation waits to be started - sensor poll should be called as soon as possible
+    if ( ((sens.requested & SENSOR_PRESS) && (sens.p == sp_idle)) ||
+         ((sens.requested & (SENSOR_RH | SENSOR_TEMP)) && (sens.r == sr_idle)) )
         return PM_FULL;
-    if ( sens.ini_progress & SENSOR_RH )
-    {
-        if ( sens.time_ctr_RH > 15 )
-            return PM_FULL;
-        pwr |= PM_SLEEP;
-    }
-
-    if ( sens.in_progress & SENSOR_PRESS )
-    {
-        if ( sens.time_ctr_Press > (450-1) )
-            return PM_FULL;
-        if ( sens.time_ctr_Press < 1 )
-            return PM_FULL;
-        pwr |= PM_HOLD;
-    }
 
-    if ( sens.in_progress & SENSOR_TEMP )
-    {
-        if ( sens.time_ctr_RH > (85-1) )
-            return PM_FULL;
-        if ( sens.time_ctr_RH < 1 )
-            return PM_FULL;
+    // delays counted on the 1ms ticks
+    if ( (sens.r == sr_powerup) || (sens.r == sr_wait) )
         pwr |= PM_SLEEP;
-    }
 
-    if ( sens.in_progress & SENSOR_RH )
-    {
-        if ( sens.time_ctr_RH > (29-1) )
-            return PM_FULL;
-        if ( sens.time_ctr_RH < 1 )
-            return PM_FULL;
-        pwr |= PM_SLEEP;
-    }
+    // pressure conversion - the data ready line wakes up the CPU
+    if ( sens.p == sp_conv )
+        pwr |= PM_HOLD;
 
     return pwr;
 }
@@ -722,30 +836,51 @@ uint32 Sensor_GetPwrStatus(void)
 // EEPROM emulation
 /////////////////////////////////////////////////////
 
+// FM25V20A on SPI1: 8MHz HSI with prescaler 4 ( see eeprom_spi.c ). The transfer time is given in polls
+// of eeprom_is_operation_finished() - asynchronous operations are polled once in a main loop, pm_full
+// makes 1-16 main loops in a 1ms tick
+#define EE_SPI_HZ           2000000
+#define EE_CMD_BYTES        4                       // opcode + 3 address bytes
+#define EE_WREN_BYTES       1                       // write enable opcode, separate chip select
+#define EE_WAKEUP_US        450                     // tREC - recovery from the sleep mode
+#define EE_POLL_US          125
+
 // init the eeprom module
 bool ee_enabled = false;
 bool ee_deepsleep = true;
 bool ee_wren = false;
 uint32 ee_count = 0;
 
+static QFile ee_file( "eeprom.dat" );
+
+static uint32 internal_ee_polls( uint32 bytes )
+{
+    uint32 us = (uint32)( ((uint64)bytes * 8 * 1000000 + EE_SPI_HZ - 1) / EE_SPI_HZ );
+    return ( us + EE_POLL_US - 1 ) / EE_POLL_US;
+}
+
 uint32 eeprom_init()
 {
-    FILE *eefile;
+    // eeprom.dat is mapped in memory - the writes go through to the file, so the content is kept even if
+    // the simulator is killed, and the file can be inspected while the simulation runs
+    if ( eeprom_cont )
+        return 0;
 
-    eefile = fopen( "eeprom.dat", "rb" );
-    if ( eefile == NULL )
+    if ( ee_file.open( QIODevice::ReadWrite ) == false )
+        return (uint32)-1;
+    if ( ee_file.size() == 0 )
     {
-        eefile = fopen( "eeprom.dat", "wb" );
-        if ( eefile == NULL )
-            return (uint32)-1;
-        memset( eeprom_cont, 0xff, EEPROM_SIZE );
-        fwrite( eeprom_cont, 1, EEPROM_SIZE, eefile );
+        QByteArray erased( EEPROM_SIZE, (char)0xff );
+        ee_file.write( erased );
+        ee_file.flush();
     }
-    else
+    if ( ee_file.size() == EEPROM_SIZE )
+        eeprom_cont = ee_file.map( 0, EEPROM_SIZE );
+    if ( eeprom_cont == NULL )
     {
-        fread( eeprom_cont, 1, EEPROM_SIZE, eefile );
+        ee_file.close();
+        return (uint32)-1;
     }
-    fclose( eefile );
     return 0;
 }
 
@@ -763,7 +898,7 @@ uint32 eeprom_enable( bool write )
     if ( ee_deepsleep )
     {
         ee_deepsleep = false;
-        ee_count = 10;
+        ee_count = ( EE_WAKEUP_US + EE_POLL_US - 1 ) / EE_POLL_US;
     }
     return 0;
 }
@@ -773,15 +908,6 @@ uint32 eeprom_disable()
 {
     ee_enabled = false;
     ee_wren = false;
-
-    FILE *eefile;
-    eefile = fopen( "eeprom.dat", "wb" );
-    if ( eefile == NULL )
-        return (uint32)-1;
-    fwrite( eeprom_cont, 1, EEPROM_SIZE, eefile );
-    fclose(eefile);
-
-
     return 0;
 }
 
@@ -804,7 +930,7 @@ uint32 eeprom_read( uint32 address, uint32 count, uint8 *buff, bool async )
 
     memcpy( buff, eeprom_cont + address, count );
 
-    ee_count = (10 * count + 499) / 500;
+    ee_count = internal_ee_polls( EE_CMD_BYTES + count );
 
     return count;
 }
@@ -820,7 +946,7 @@ uint32 eeprom_write( uint32 address, const uint8 *buff, uint32 count, bool async
 
     memcpy( eeprom_cont + address, buff, count );
 
-    ee_count = (10 * count + 499) / 500;
+    ee_count = internal_ee_polls( EE_WREN_BYTES + EE_CMD_BYTES + count );
 
     return count;
 }
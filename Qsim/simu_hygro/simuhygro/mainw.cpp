@@ -622,43 +622,29 @@ void mainw::on_num_temperature_valueChanged(double arg1) { ms_temp = (arg1 * 100
 void mainw::on_num_humidity_valueChanged(double arg1) { ms_hum = (arg1 * 100); }
 void mainw::on_num_pressure_valueChanged(double arg1) { ms_press = (arg1 * 100); }
 
-#define MAX_BUFF_SIZE   ( 10 * 1024 * 1024 )
-uint8 dumpbuffer[ MAX_BUFF_SIZE ];
-
 void mainw::on_pb_dump_clicked()
 {
     if ( ui->pb_dump->isChecked() )
     {
+        char filename[64] = "";
+
+        // the received data is streamed in the file till the button is released
+        strncpy( filename, ui->tb_dump_filename->text().toLatin1(), sizeof(filename) - 5 );
+        strcat( filename, ".dmp" );
+
         if ( comlink->cmd_connect() )
             goto _error;
 
-        if ( comlink->cmd_read_data_dump_start( dumpbuffer, MAX_BUFF_SIZE ) )
+        if ( comlink->cmd_read_data_dump_start( filename ) )
             goto _error;
 
         dump_thread = true;
     }
     else if (dump_thread == true)
     {
-        FILE *eefile;
-        int size;
-        char filename[64] = "";
-
         comlink->cmd_read_data_stop();
         comlink->cmd_disconnect();
         dump_thread = false;
-
-        size =comlink->cmd_read_data_check_inbuffer();
-
-        strcpy( filename, ui->tb_dump_filename->text().toLatin1() );
-        strcat( filename, ".dmp" );
-
-        eefile = fopen( filename, "wb" );
-        if ( eefile == NULL )
-            goto _error;
-        fwrite( dumpbuffer, 1, size, eefile );
-        fclose(eefile);
-
-        comlink->cmd_disconnect();
     }
     return;
 _error:
@@ -12,6 +12,7 @@
 #ifdef Q_OS_WIN32
 
 #include <windows.h>
+#include <string.h>
 
 MSerialPort::MSerialPort()
 {
@@ -174,14 +175,11 @@ int MSerialPort::getBytes( uint8_t *buffer, int size )
     if (hSerial == INVALID_HANDLE_VALUE)
         return -1;
 
+    // copy and remove the bytes in one go - removing byte by byte moves the rest of the buffer for each
     size_in_buff = dataBuffer->size();
-    for (read_nr = 0; read_nr < size; read_nr++)
-    {
-        if ( read_nr == size_in_buff )
-            break;
-        buffer[read_nr] = (uint8_t)dataBuffer->at(0); // get the top most byte
-        dataBuffer->remove(0, 1); // remove top most byte
-    }
+    read_nr = (size < size_in_buff) ? size : size_in_buff;
+    memcpy( buffer, dataBuffer->constData(), read_nr );
+    dataBuffer->remove(0, read_nr);
     return read_nr;
 }
 
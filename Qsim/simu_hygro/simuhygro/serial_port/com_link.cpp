@@ -94,8 +94,11 @@ com_link::com_link()
     sig_data_avail  = false;
     sig_overflow    = false;
 
-    dataQ = 0;
-    dataMax = 0;
+    ring     = new com_ring( COM_RING_SIZE );
+    writer   = NULL;
+    dumpfile = NULL;
+    rx_peak  = 0;
+    rx_full  = 0;
 
     port_thread = new QThread();
     moveToThread( port_thread );
@@ -121,9 +124,11 @@ com_link::~com_link()
 {
     int tid = (int)QThread::currentThreadId();
 
-    t_result = 1;
+    cmd_read_data_stop();       // finish the dump file - if any
+
+    t_result.storeRelease(1);
     emit sig_disconnect();      // disconnect serial port
-    while (t_result == 1)
+    while (t_result.loadAcquire() == 1)
         QThread::yieldCurrentThread();
 
     port_thread->quit();        // exit worker thread
@@ -131,6 +136,7 @@ com_link::~com_link()
 
     if ( port )
         delete port;
+    delete ring;
 }
 
 
@@ -149,49 +155,103 @@ void com_link::pslot_connect()
 {
     if (port_opened)
     {
-        t_result = 0;
+        t_result.storeRelease(0);
         return;
     }
-    t_result = OpenCommunication();
+    t_result.storeRelease( OpenCommunication() );
 }
 
 void com_link::pslot_disconnect()
 {
     if (port_opened)
         CloseCommunication();
-    t_result = 0;
+    t_result.storeRelease(0);
 }
 
 //qqq void com_link::pslot_datadump_start(uint8 *pbuff, uint32 max_size)
 void com_link::pslot_datadump_start()
 {
-    uint8* pbuff = m_dataBuff;
-
-    dataMax = m_dataMax;
-    dataQ = 0;
+    // receiving loop - producer of the ring. The port is read directly in the free span of the ring,
+    // it sleeps only when the port has no data or the writer thread is behind ( the port buffers meanwhile )
+    uint8 *pbuff;
+    uint32 free;
+    uint32 used;
+    int sz;
 
     port->flushInQ();
+    rx_running.storeRelease(1);
 
-    while ( dataQ < dataMax )
+    while ( rx_stop.loadAcquire() == 0 )
     {
-        int sz;
         sz = port->bytesAvailable();
-        if ( sz )
+        if ( sz == 0 )
         {
-            port->getBytes( (pbuff + dataQ), sz );
-            dataQ += sz;
+            QThread::usleep( COM_IDLE_US );
+            continue;
         }
-        else
+
+        free = ring->write_span( &pbuff );
+        if ( free == 0 )
         {
-            QThread::usleep(1000);   // done for yield
+            rx_full++;
+            QThread::usleep( COM_IDLE_US );
+            continue;
         }
+        if ( (uint32)sz > free )
+            sz = free;
+
+        sz = port->getBytes( pbuff, sz );
+        if ( sz <= 0 )
+            continue;
+        ring->write_commit( sz );
+        rx_bytes.fetchAndAddRelease( sz );
+
+        used = ring->used();
+        if ( rx_peak < used )
+            rx_peak = used;
     }
+
+    rx_running.storeRelease(0);
 }
 
 void com_link::pslot_datadump_stop()
 {
-    dataMax = 0;
+    rx_stop.storeRelease(1);
+}
+
+
+void com_dumpwriter::run()
+{
+    // consumer of the ring - writes the received data in the file as it arrives
+    uint8 *pdata;
+    uint32 len;
+    bool finish = false;
+
+    while (1)
+    {
+        len = ring->read_span( &pdata );
+        if ( len == 0 )
+        {
+            if ( finish )
+                break;
+
+            // the receiving is stopped before 'stop' is set - after it is seen the ring is drained once more
+            finish = ( stop.loadAcquire() != 0 );
+            if ( finish == false )
+            {
+                fflush( file );
+                QThread::usleep( COM_IDLE_US );
+            }
+            continue;
+        }
 
+        if ( len > COM_WRITE_CHUNK )
+            len = COM_WRITE_CHUNK;
+        if ( (error.load() == 0) && (fwrite( pdata, 1, len, file ) != len) )
+            error.storeRelease(1);
+        ring->read_commit( len );
+        written.fetchAndAddRelease( len );
+    }
 }
 
 
@@ -216,59 +276,96 @@ void com_link::Serial_Overflow()
 
 int com_link::cmd_connect()
 {
-    t_result = 1;           // start with 1 - modified by worker thread
+    t_result.storeRelease(1);   // start with 1 - modified by worker thread
     emit sig_connect();
-    while (t_result == 1)
+    while (t_result.loadAcquire() == 1)
         QThread::yieldCurrentThread();
 
-    if ( t_result )
+    if ( t_result.loadAcquire() )
     {
 ////        connect(this, SIGNAL(sig_datadump_start(uint8*,uint32)), this, SLOT(pslot_datadump_start(uint8*,uint32)) );
 //        connect(this, SIGNAL(sig_datadump_start()), this, SLOT(pslot_datadump_start()) );
 //        connect(this, SIGNAL(sig_datadump_stop()), this, SLOT(pslot_datadump_stop()) );
     }
-    return t_result;
+    return t_result.loadAcquire();
 }
 
 int com_link::cmd_disconnect()
 {
-    t_result = 1;
-    dataMax = 0;        // stop the data receiving - if any
+    cmd_read_data_stop();   // stop the data receiving - if any
+
+    t_result.storeRelease(1);
     emit sig_disconnect();
-    while (t_result == 1)
+    while (t_result.loadAcquire() == 1)
         QThread::yieldCurrentThread();
 
-    return t_result;
+    return t_result.loadAcquire();
 }
 
-int com_link::cmd_read_data_dump_start(uint8 *pbuff, uint32 max_size )
+int com_link::cmd_read_data_dump_start( const char *filename )
 {
     if (port_opened == conn_disconnected )
         return -1;
-    if ( dataMax || (max_size==0) )
+    if ( writer )
+        return -1;
+
+    dumpfile = fopen( filename, "wb" );
+    if ( dumpfile == NULL )
         return -1;
 
-//qqq    emit sig_datadump_start(pbuff, max_size);
-    m_dataMax = max_size;
-    m_dataBuff = pbuff;
+    ring->reset();
+    rx_stop.storeRelease(0);
+    rx_bytes.storeRelease(0);
+    rx_peak = 0;
+    rx_full = 0;
+
+    writer = new com_dumpwriter( ring, dumpfile );
+    writer->start();
+
+    dump_time.start();
     emit sig_datadump_start();
-    while (dataMax == 0)
+    while ( rx_running.loadAcquire() == 0 )
         QThread::yieldCurrentThread();
 
+    DBG_MESSAGE_API2("Dump started in ", filename );
     return 0;
 }
 
 int com_link::cmd_read_data_check_inbuffer()
 {
-    return dataQ;   // should be atomic
+    return rx_bytes.loadAcquire();
 }
 
 int com_link::cmd_read_data_stop()
 {
-//    emit sig_datadump_stop();
-//    while (dataMax)
-//        QThread::yieldCurrentThread();
-    dataMax = 0;        // stop the data receiving
+    int res;
+    qint64 ms;
+    uint32 bytes;
+
+    if ( writer == NULL )
+        return -1;
+
+    // stop the receiving loop first, then the writer drains the ring
+    rx_stop.storeRelease(1);
+    while ( rx_running.loadAcquire() )
+        QThread::yieldCurrentThread();
+    writer->stop.storeRelease(1);
+    writer->wait();
+
+    ms = dump_time.elapsed();
+    bytes = (uint32)writer->written.loadAcquire();
+    res = writer->error.loadAcquire() ? -1 : 0;
+    if ( fclose( dumpfile ) )
+        res = -1;
+
+    DBG_MESSAGE_API3("Dump finished - bytes, ms: ", bytes, ms );
+    DBG_MESSAGE_API3("Throughput [bytes/s], peak ring fill: ", (ms ? (bytes * 1000.0 / ms) : 0.0), rx_peak );
+    DBG_MESSAGE_API3("Polls with full ring, result: ", rx_full, res );
+
+    delete writer;
+    writer = NULL;
+    dumpfile = NULL;
+    return res;
 }
 
 enum EconnectStatus com_link::is_opened()
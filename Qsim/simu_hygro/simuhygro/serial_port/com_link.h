@@ -3,6 +3,9 @@
 
 #include <QThread>
 #include <QString>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <stdio.h>
 #include "MSerialPort.hpp"
 
 
@@ -19,6 +22,77 @@ typedef unsigned char uint8;
 typedef unsigned int uint32;
 #endif
 
+
+#define COM_RING_SIZE       ( 1 << 20 )             // receive ring - power of 2, ~90 sec. of data at 115200 baud
+#define COM_WRITE_CHUNK     ( 64 * 1024 )           // max. bytes in one file write
+#define COM_IDLE_US         1000                    // sleep of the threads when there is nothing to do
+
+
+// Single producer / single consumer byte ring between the serial port thread and the dump writer thread
+//
+// 'head' is advanced only by the producer, 'tail' only by the consumer. Both are free running counters: the fill
+// level is head - tail, the position in the buffer is the counter masked with the size. A side publishes its counter
+// with release ordering after the data is written / consumed and reads the counter of the other side with acquire,
+// so the threads need no lock. Data is passed in place: the producer gets the free span to read the port in,
+// the consumer gets the filled span to write in the file.
+class com_ring
+{
+public:
+    explicit com_ring( uint32 size )    { buff = new uint8[size]; mask = size - 1; }
+    ~com_ring()                         { delete[] buff; }
+
+    void reset()                        { head.storeRelease(0); tail.storeRelease(0); }     // only when no thread uses it
+    uint32 used()                       { return (uint32)head.loadAcquire() - (uint32)tail.loadAcquire(); }
+
+    // producer: contiguous free space from the write position / publish 'len' bytes written there
+    uint32 write_span( uint8 **pbuff )
+    {
+        uint32 pos  = (uint32)head.load();
+        uint32 free = (mask + 1) - ( pos - (uint32)tail.loadAcquire() );
+        uint32 cont = (mask + 1) - ( pos & mask );
+        *pbuff = buff + (pos & mask);
+        return (free < cont) ? free : cont;
+    }
+    void write_commit( uint32 len )     { head.storeRelease( (int)((uint32)head.load() + len) ); }
+
+    // consumer: contiguous data from the read position / release 'len' bytes
+    uint32 read_span( uint8 **pbuff )
+    {
+        uint32 pos  = (uint32)tail.load();
+        uint32 fill = (uint32)head.loadAcquire() - pos;
+        uint32 cont = (mask + 1) - ( pos & mask );
+        *pbuff = buff + (pos & mask);
+        return (fill < cont) ? fill : cont;
+    }
+    void read_commit( uint32 len )      { tail.storeRelease( (int)((uint32)tail.load() + len) ); }
+
+private:
+    uint8   *buff;
+    uint32  mask;
+    QAtomicInt head;                    // bytes written - producer
+    QAtomicInt tail;                    // bytes read - consumer
+};
+
+
+// Dump writer thread - streams the received data from the ring to the dump file as it arrives
+class com_dumpwriter : public QThread
+{
+public:
+    com_dumpwriter( com_ring *pring, FILE *pfile ) : ring(pring), file(pfile) {}
+
+    QAtomicInt stop;                    // set after the receiving is stopped - the ring is drained and the thread exits
+    QAtomicInt written;                 // bytes written in the file
+    QAtomicInt error;                   // file write failed - the data is consumed further but dropped
+
+protected:
+    void run();
+
+private:
+    com_ring *ring;
+    FILE *file;
+};
+
+
 class com_link : public QObject
 {
     Q_OBJECT
@@ -30,9 +104,9 @@ public:
 
     int cmd_connect();                                                  // connect
     int cmd_disconnect();                                               // disconnect
-    int cmd_read_data_dump_start(uint8 *pbuff, uint32 max_size );      // start data dump in a buffer (give the maximum buffer size)
+    int cmd_read_data_dump_start( const char *filename );              // start data dump streamed in the given file
     int cmd_read_data_check_inbuffer();                                 // returns how many data bytes are allready read
-    int cmd_read_data_stop();                                           // stop data read. - application can use the buffer after this
+    int cmd_read_data_stop();                                           // stop data read - the file is complete and closed after this
 
 signals:
     void sig_connect();
@@ -59,16 +133,20 @@ private slots:
 private:
     QThread *port_thread;
     QMutex  mutex;
-    int  t_result;
+    QAtomicInt t_result;                        // result of a command on the port thread - 1 while it runs
 
     MSerialPort *port;                          // serial port instance
     enum EconnectStatus port_opened;            // if connection is done and which type
-    int dataQ;                                  // data quantity
-    int dataMax;                                // max to read - it is set when receiving task is started
-    uint8 *dataBuff;                            // data buffer
-
-    int m_dataMax;
-    uint8 *m_dataBuff;
+    com_ring *ring;                             // received data on the way to the dump file
+    com_dumpwriter *writer;                     // dump writer thread - NULL if no dump is running
+    FILE *dumpfile;
+    QElapsedTimer dump_time;
+
+    QAtomicInt rx_stop;                         // request to exit the receiving loop
+    QAtomicInt rx_running;                      // the receiving loop runs on the port thread
+    QAtomicInt rx_bytes;                        // bytes received
+    uint32 rx_peak;                             // max. ring fill - written by the port thread while receiving
+    uint32 rx_full;                             // port polls with full ring
 
     bool sig_overflow;
     bool sig_data_avail;
@@ -32,6 +32,12 @@ SOURCES += main.cpp\
     ../../../Prog/Project/MainProject/func/ui_graphics.c \
     ../../../Prog/Project/MainProject/func/utilities.c \
     ../../../Prog/Project/MainProject/func/ui_internals.c \
+    ../../../Prog/Project/MainProject/func/psychro.c \
+    ../../../Prog/Project/MainProject/func/recagg.c \
+    ../../../Prog/Project/MainProject/func/recdelta.c \
+    ../../../Prog/Project/MainProject/func/recpack.c \
+    ../../../Prog/Project/MainProject/func/crc16.c \
+    ../../../Prog/Project/MainProject/func/telemetry.c \
     serial_port/MSerialPort.cpp \
     serial_port/com_link.cpp
 
@@ -51,6 +57,12 @@ HEADERS  += mainw.h \
     ../../../Prog/Project/MainProject/func/ui_graphics.h \
     ../../../Prog/Project/MainProject/func/dispHAL.h \
     ../../../Prog/Project/MainProject/func/utilities.h \
+    ../../../Prog/Project/MainProject/func/psychro.h \
+    ../../../Prog/Project/MainProject/func/recagg.h \
+    ../../../Prog/Project/MainProject/func/recdelta.h \
+    ../../../Prog/Project/MainProject/func/recpack.h \
+    ../../../Prog/Project/MainProject/func/crc16.h \
+    ../../../Prog/Project/MainProject/func/telemetry.h \
     serial_port/MSerialPort_Global.hpp \
     serial_port/MSerialPort.hpp \
     serial_port/com_link.h